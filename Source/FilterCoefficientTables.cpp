@@ -0,0 +1,102 @@
+#include "FilterCoefficientTables.h"
+
+
+/**
+ * @brief Fills the frequency and decibel tables for a sample rate.
+ * @param newSampleRate Sample rate the filters run at.
+ */
+void FilterCoefficientTables::prepare(double newSampleRate)
+{
+    sampleRate = newSampleRate;
+    maxFrequency = (float) (sampleRate * maxRelativeFrequency);
+    maxPosition = (float) (std::log2((double) maxFrequency / minFrequency) * pointsPerOctave);
+
+    // One extra entry so the interpolation at maxPosition never reads past the end
+    const int numFrequencies = (int) std::ceil(maxPosition) + 2;
+    prewarpedGains.resize((size_t) numFrequencies);
+
+    for (int i = 0; i < numFrequencies; ++i)
+    {
+        const double frequency = minFrequency * std::exp2((double) i / pointsPerOctave);
+        prewarpedGains[(size_t) i] = (float) std::tan(juce::MathConstants<double>::pi
+                                                      * juce::jmin(frequency, sampleRate * 0.4999) / sampleRate);
+    }
+
+    const int numDecibels = (int) std::round((maxDecibels - minDecibels) / decibelStep) + 2;
+    decibelGains.resize((size_t) numDecibels);
+
+    for (int i = 0; i < numDecibels; ++i)
+        decibelGains[(size_t) i] = (float) std::pow(10.0, (minDecibels + i * (double) decibelStep) / 20.0);
+}
+
+
+float FilterCoefficientTables::getPosition(float frequencyHz) const noexcept
+{
+    return juce::jlimit(0.0f, maxPosition, std::log2(frequencyHz / minFrequency) * (float) pointsPerOctave);
+}
+
+
+float FilterCoefficientTables::getPrewarpedGainAt(float position) const noexcept
+{
+    if (prewarpedGains.empty())
+        return 0.0f;
+
+    position = juce::jlimit(0.0f, maxPosition, position);
+    const int index = (int) position;
+    const float fraction = position - (float) index;
+
+    return prewarpedGains[(size_t) index] + fraction * (prewarpedGains[(size_t) index + 1] - prewarpedGains[(size_t) index]);
+}
+
+
+/**
+ * @brief Notch design of juce::dsp::IIR::ArrayCoefficients::makeNotch() with the tangent taken from the table.
+ */
+std::array<float, 6> FilterCoefficientTables::makeNotchAt(float position, float q) const noexcept
+{
+    const float n = 1.0f / juce::jmax(1.0e-6f, getPrewarpedGainAt(position));
+    const float nSquared = n * n;
+    const float invQ = 1.0f / q;
+    const float c1 = 1.0f / (1.0f + n * invQ + nSquared);
+
+    const float b0 = c1 * (1.0f + nSquared);
+    const float b1 = 2.0f * c1 * (1.0f - nSquared);
+
+    return { b0, b1, b0, 1.0f, b1, c1 * (1.0f - n * invQ + nSquared) };
+}
+
+
+/**
+ * @brief Peak design of juce::dsp::IIR::ArrayCoefficients::makePeakFilter().
+ *
+ * Sine and cosine of the centre frequency follow from t = tan(omega / 2):
+ * sin(omega) = 2t / (1 + t^2) and cos(omega) = (1 - t^2) / (1 + t^2).
+ */
+std::array<float, 6> FilterCoefficientTables::makePeakFilterAt(float position, float q, float gainDecibels) const noexcept
+{
+    const float t = getPrewarpedGainAt(position);
+    const float norm = 1.0f / (1.0f + t * t);
+    const float sinOmega = 2.0f * t * norm;
+    const float cosOmega = (1.0f - t * t) * norm;
+
+    const float a = decibelsToGain(0.5f * gainDecibels);
+    const float alpha = sinOmega / (2.0f * q);
+    const float c2 = -2.0f * cosOmega;
+    const float alphaTimesA = alpha * a;
+    const float alphaOverA = alpha / a;
+
+    return { 1.0f + alphaTimesA, c2, 1.0f - alphaTimesA, 1.0f + alphaOverA, c2, 1.0f - alphaOverA };
+}
+
+
+float FilterCoefficientTables::decibelsToGain(float decibels) const noexcept
+{
+    if (decibelGains.empty())
+        return 1.0f;
+
+    const float position = juce::jlimit(0.0f, (maxDecibels - minDecibels) / decibelStep, (decibels - minDecibels) / decibelStep);
+    const int index = (int) position;
+    const float fraction = position - (float) index;
+
+    return decibelGains[(size_t) index] + fraction * (decibelGains[(size_t) index + 1] - decibelGains[(size_t) index]);
+}
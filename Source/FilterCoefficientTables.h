@@ -0,0 +1,96 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+/**
+ * @class FilterCoefficientTables
+ * @brief Per-sample-rate lookup tables for filter coefficients and decibel conversion.
+ *
+ * The frequency table holds tan(pi * f / sampleRate) on a logarithmic frequency grid with
+ * pointsPerOctave entries per octave, from minFrequency up to 0.49 times the sample rate. This value is
+ * the state variable filter's g, and the notch and peak biquad designs are derived from it as well, so a
+ * cutoff change costs a table lookup and a few multiplications. Values between grid points are
+ * interpolated linearly; the resulting cutoff error stays below maxCentsError.
+ *
+ * The decibel table covers minDecibels...maxDecibels in decibelStep steps, also interpolated linearly.
+ *
+ * prepare() allocates and must be called off the audio thread; all lookups are noexcept and allocation free.
+ */
+class FilterCoefficientTables
+{
+public:
+    /** @brief Lowest frequency in the table. Lower frequencies are clamped. */
+    static constexpr float minFrequency = 10.0f;
+
+    /** @brief Highest frequency in the table, relative to the sample rate. */
+    static constexpr double maxRelativeFrequency = 0.49;
+
+    /** @brief Resolution of the frequency table. */
+    static constexpr int pointsPerOctave = 128;
+
+    /** @brief Range and resolution of the decibel table. */
+    static constexpr float minDecibels = -60.0f;
+    static constexpr float maxDecibels = 60.0f;
+    static constexpr float decibelStep = 0.2f;
+
+    /** @brief Guaranteed accuracy of the interpolated lookups. */
+    static constexpr double maxCentsError = 1.0;
+    static constexpr double maxDecibelError = 0.001;
+
+    /**
+     * @brief Builds the tables for a sample rate.
+     * @param newSampleRate Sample rate the filters run at.
+     */
+    void prepare(double newSampleRate);
+
+    /** @brief Returns the sample rate the tables were built for, or 0 before prepare(). */
+    double getSampleRate() const noexcept { return sampleRate; }
+
+    /** @brief Returns the highest frequency covered by the table. */
+    float getMaxFrequency() const noexcept { return maxFrequency; }
+
+    /**
+     * @brief Converts a frequency to a fractional table position.
+     *
+     * Modulation that already works in octaves can add to the position directly, one octave being
+     * pointsPerOctave, and skip the logarithm.
+     */
+    float getPosition(float frequencyHz) const noexcept;
+
+    /** @brief Returns tan(pi * f / sampleRate) for a table position. */
+    float getPrewarpedGainAt(float position) const noexcept;
+
+    /** @brief Returns tan(pi * f / sampleRate) for a frequency. */
+    float getPrewarpedGain(float frequencyHz) const noexcept { return getPrewarpedGainAt(getPosition(frequencyHz)); }
+
+    /**
+     * @brief Designs a notch filter.
+     * @return b0, b1, b2, a0, a1, a2 in the layout of juce::dsp::IIR::ArrayCoefficients::makeNotch().
+     */
+    std::array<float, 6> makeNotch(float frequencyHz, float q) const noexcept { return makeNotchAt(getPosition(frequencyHz), q); }
+
+    /** @brief Designs a notch filter for a table position. */
+    std::array<float, 6> makeNotchAt(float position, float q) const noexcept;
+
+    /**
+     * @brief Designs a peak (bell) filter.
+     * @return b0, b1, b2, a0, a1, a2 in the layout of juce::dsp::IIR::ArrayCoefficients::makePeakFilter().
+     */
+    std::array<float, 6> makePeakFilter(float frequencyHz, float q, float gainDecibels) const noexcept
+    {
+        return makePeakFilterAt(getPosition(frequencyHz), q, gainDecibels);
+    }
+
+    /** @brief Designs a peak (bell) filter for a table position. */
+    std::array<float, 6> makePeakFilterAt(float position, float q, float gainDecibels) const noexcept;
+
+    /** @brief Converts decibels to a linear gain, clamped to the table range. */
+    float decibelsToGain(float decibels) const noexcept;
+
+private:
+    double sampleRate = 0.0;
+    float maxFrequency = 0.0f;
+    float maxPosition = 0.0f;
+    std::vector<float> prewarpedGains;
+    std::vector<float> decibelGains;
+};
@@ -0,0 +1,204 @@
+#include "LevelMeter.h"
+
+
+std::array<Loudness::Biquad, 2> Loudness::makeKWeighting(double sampleRate)
+{
+    std::array<Biquad, 2> stages;
+
+    {
+        // High shelf, +4 dB above about 1.7 kHz
+        const double k = std::tan(juce::MathConstants<double>::pi * 1681.974450955533 / sampleRate);
+        const double q = 0.7071752369554196;
+        const double vh = std::pow(10.0, 3.999843853973347 / 20.0);
+        const double vb = std::pow(vh, 0.4996667741545416);
+        const double a0 = 1.0 + k / q + k * k;
+
+        auto& shelf = stages[0];
+        shelf.b0 = (vh + vb * k / q + k * k) / a0;
+        shelf.b1 = 2.0 * (k * k - vh) / a0;
+        shelf.b2 = (vh - vb * k / q + k * k) / a0;
+        shelf.a1 = 2.0 * (k * k - 1.0) / a0;
+        shelf.a2 = (1.0 - k / q + k * k) / a0;
+    }
+
+    {
+        // High-pass at about 38 Hz
+        const double k = std::tan(juce::MathConstants<double>::pi * 38.13547087602444 / sampleRate);
+        const double q = 0.5003270373238773;
+        const double a0 = 1.0 + k / q + k * k;
+
+        auto& highpass = stages[1];
+        highpass.b0 = 1.0;
+        highpass.b1 = -2.0;
+        highpass.b2 = 1.0;
+        highpass.a1 = 2.0 * (k * k - 1.0) / a0;
+        highpass.a2 = (1.0 - k / q + k * k) / a0;
+    }
+
+    return stages;
+}
+
+
+void LevelMeter::prepare(double newSampleRate, int newNumChannels)
+{
+    sampleRate = newSampleRate;
+    numChannels = juce::jlimit(0, maxChannels, newNumChannels);
+    segmentLength = juce::jmax(1, juce::roundToInt(segmentSeconds * sampleRate));
+
+    rmsDecayPerFrame = sampleRate > 0.0 ? 1.0 / (rmsTimeConstantSeconds * sampleRate) : 0.0;
+    peakFallPerFrame = sampleRate > 0.0 ? peakFallDecibelsPerSecond * std::log(10.0) / 20.0 / sampleRate : 0.0;
+
+    const auto design = sampleRate > 0.0 ? Loudness::makeKWeighting(sampleRate) : std::array<Loudness::Biquad, 2> {};
+    kWeighting.fill(design);
+
+    blockPeak = 0.0f;
+    blockSumOfSquares = 0.0;
+    blockWeightedEnergy = 0.0;
+    meanSquare = 0.0;
+    heldPeak = 0.0f;
+    segmentEnergies.fill(0.0);
+    segmentIndex = 0;
+    segmentEnergy = 0.0;
+    segmentFrames = 0;
+
+    publishedPeakDb = silenceDb;
+    publishedRmsDb = silenceDb;
+    publishedLufs = silenceDb;
+    clipped = false;
+}
+
+
+LevelMeter::Reading LevelMeter::getReading() const noexcept
+{
+    return { publishedPeakDb.load(std::memory_order_relaxed),
+             publishedRmsDb.load(std::memory_order_relaxed),
+             publishedLufs.load(std::memory_order_relaxed),
+             clipped.load(std::memory_order_relaxed) };
+}
+
+
+void LevelMeter::addInterleaved(const float* samples, int numFrames, int channels, float peak, float sumOfSquares) noexcept
+{
+    blockPeak = juce::jmax(blockPeak, peak);
+    blockSumOfSquares += sumOfSquares;
+
+    if (channels != numChannels || ! isLoudnessEnabled())
+        return;
+
+    for (int channel = 0; channel < numChannels; ++channel)
+        blockWeightedEnergy += weigh(channel, samples + channel, numFrames, numChannels);
+}
+
+
+/**
+ * @brief The peak comes from FloatVectorOperations::findMinAndMax; the sum of squares shares the pass
+ * over each channel with the K-weighting when loudness is measured.
+ */
+void LevelMeter::addBuffer(const juce::AudioBuffer<float>& buffer, int startSample, int numFrames) noexcept
+{
+    const bool weighs = buffer.getNumChannels() == numChannels && isLoudnessEnabled();
+
+    for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+    {
+        const float* data = buffer.getReadPointer(channel, startSample);
+        const auto range = juce::FloatVectorOperations::findMinAndMax(data, numFrames);
+        blockPeak = juce::jmax(blockPeak, -range.getStart(), range.getEnd());
+
+        if (weighs)
+        {
+            auto& stages = kWeighting[(size_t) channel];
+            double energy = 0.0;
+            double squares = 0.0;
+
+            for (int i = 0; i < numFrames; ++i)
+            {
+                const double value = data[i];
+                const double weighted = stages[1].process(stages[0].process(value));
+                squares += value * value;
+                energy += weighted * weighted;
+            }
+
+            blockSumOfSquares += squares;
+            blockWeightedEnergy += energy;
+        }
+        else
+        {
+            float squares = 0.0f;
+
+            for (int i = 0; i < numFrames; ++i)
+                squares += data[i] * data[i];
+
+            blockSumOfSquares += squares;
+        }
+    }
+}
+
+
+/**
+ * @brief Applies the block to the running RMS and held peak, moves the loudness window on by whole
+ * segments, spreading a long block's energy evenly over the segments it covers, and publishes.
+ */
+void LevelMeter::endBlock(int numFrames) noexcept
+{
+    if (numFrames <= 0 || numChannels == 0)
+        return;
+
+    const double blockMeanSquare = blockSumOfSquares / ((double) numFrames * numChannels);
+    meanSquare += (blockMeanSquare - meanSquare) * (1.0 - std::exp(-rmsDecayPerFrame * numFrames));
+    heldPeak = juce::jmax(blockPeak, heldPeak * (float) std::exp(-peakFallPerFrame * numFrames));
+
+    if (blockPeak >= 1.0f)
+        clipped.store(true, std::memory_order_relaxed);
+
+    if (isLoudnessEnabled())
+    {
+        segmentEnergy += blockWeightedEnergy;
+        segmentFrames += numFrames;
+
+        while (segmentFrames >= segmentLength)
+        {
+            const double share = segmentEnergy * segmentLength / segmentFrames;
+            segmentEnergies[(size_t) segmentIndex] = share;
+            segmentIndex = (segmentIndex + 1) % shortTermSegments;
+            segmentEnergy -= share;
+            segmentFrames -= segmentLength;
+        }
+
+        double windowEnergy = 0.0;
+
+        for (const auto energy : segmentEnergies)
+            windowEnergy += energy;
+
+        publishedLufs.store((float) Loudness::toLufs(windowEnergy / ((double) segmentLength * shortTermSegments), silenceDb),
+                            std::memory_order_relaxed);
+    }
+    else if (segmentFrames > 0 || publishedLufs.load(std::memory_order_relaxed) > silenceDb)
+    {
+        segmentEnergies.fill(0.0);
+        segmentEnergy = 0.0;
+        segmentFrames = 0;
+        publishedLufs.store(silenceDb, std::memory_order_relaxed);
+    }
+
+    publishedPeakDb.store(juce::Decibels::gainToDecibels(heldPeak, silenceDb), std::memory_order_relaxed);
+    publishedRmsDb.store((float) juce::jmax((double) silenceDb, 10.0 * std::log10(meanSquare + 1.0e-20)), std::memory_order_relaxed);
+
+    blockPeak = 0.0f;
+    blockSumOfSquares = 0.0;
+    blockWeightedEnergy = 0.0;
+}
+
+
+double LevelMeter::weigh(int channel, const float* samples, int numFrames, int stride) noexcept
+{
+    auto& stages = kWeighting[(size_t) channel];
+    double energy = 0.0;
+
+    for (int i = 0; i < numFrames; ++i)
+    {
+        const double weighted = stages[1].process(stages[0].process((double) samples[i * stride]));
+        energy += weighted * weighted;
+    }
+
+    return energy;
+}
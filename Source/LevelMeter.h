@@ -0,0 +1,132 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+
+
+/**
+ * @brief K-weighting after ITU-R BS.1770, shared by the sample analysis and the level meters.
+ */
+namespace Loudness
+{
+    /** @brief Transposed direct form II biquad in double precision, a0 normalised to 1. */
+    struct Biquad
+    {
+        double b0 = 1.0, b1 = 0.0, b2 = 0.0, a1 = 0.0, a2 = 0.0;
+        double z1 = 0.0, z2 = 0.0;
+
+        double process(double x) noexcept
+        {
+            const double y = b0 * x + z1;
+            z1 = b1 * x - a1 * y + z2;
+            z2 = b2 * x - a2 * y;
+            return y;
+        }
+    };
+
+    /** @brief Designs the two K-weighting stages, high shelf then high-pass, for any sample rate. */
+    std::array<Biquad, 2> makeKWeighting(double sampleRate);
+
+    /** @brief Converts the mean square of K-weighted audio, summed over the channels, to LUFS. */
+    inline double toLufs(double meanSquare, double floorLufs) noexcept
+    {
+        return meanSquare > 0.0 ? juce::jmax(floorLufs, -0.691 + 10.0 * std::log10(meanSquare)) : floorLufs;
+    }
+}
+
+
+/**
+ * @class LevelMeter
+ * @brief Peak, RMS and short-term loudness of a track or the master, measured on the audio thread.
+ *
+ * The audio thread adds the frames it renders during a block and calls endBlock() once per host block,
+ * which applies the ballistics and publishes the readings through relaxed atomics: the peak holds and
+ * falls by peakFallDecibelsPerSecond, RMS is an exponential average with rmsTimeConstantSeconds, and
+ * short-term loudness is the K-weighted energy of the last three seconds in 100 ms segments. A block
+ * that reaches full scale sets a clip flag that stays until resetClip().
+ *
+ * Peak and RMS cost a reduction the caller usually fuses with its own loop over the frames. Loudness
+ * needs the K-weighting filters on every frame, so it is only measured while enabled.
+ */
+class LevelMeter
+{
+public:
+    static constexpr float silenceDb = -100.0f;
+    static constexpr double rmsTimeConstantSeconds = 0.3;
+    static constexpr double peakFallDecibelsPerSecond = 20.0;
+    static constexpr double segmentSeconds = 0.1;
+    static constexpr int shortTermSegments = 30;
+    static constexpr int maxChannels = 8;
+
+    /** @brief Published levels. */
+    struct Reading
+    {
+        float peakDb = silenceDb;           ///< Held sample peak in dBFS
+        float rmsDb = silenceDb;            ///< RMS of all channels in dBFS
+        float shortTermLufs = silenceDb;    ///< Loudness of the last three seconds, silenceDb while disabled
+        bool clipped = false;               ///< A block reached full scale since the last resetClip()
+    };
+
+    /** @brief Sets the sample rate and channel count and clears all state. Call while the audio thread is stopped. */
+    void prepare(double sampleRate, int numChannels);
+
+    /** @brief Starts or stops measuring short-term loudness. */
+    void setLoudnessEnabled(bool shouldBeEnabled) noexcept { loudnessEnabled.store(shouldBeEnabled, std::memory_order_relaxed); }
+
+    bool isLoudnessEnabled() const noexcept { return loudnessEnabled.load(std::memory_order_relaxed); }
+
+    /** @brief Returns the levels published after the last block. */
+    Reading getReading() const noexcept;
+
+    /** @brief Clears the clip flag. */
+    void resetClip() noexcept { clipped.store(false, std::memory_order_relaxed); }
+
+    //================== Audio thread ==================
+
+    /**
+     * @brief Adds interleaved frames whose peak and sum of squares the caller has already computed.
+     * @param peak Largest absolute value of the frames.
+     * @param sumOfSquares Sum of the squares of all values.
+     */
+    void addInterleaved(const float* samples, int numFrames, int numChannels, float peak, float sumOfSquares) noexcept;
+
+    /** @brief Adds a range of a buffer, computing its peak and sum of squares. */
+    void addBuffer(const juce::AudioBuffer<float>& buffer, int startSample, int numFrames) noexcept;
+
+    /**
+     * @brief Closes a host block and publishes the readings. Frames that were not added, e.g. while a
+     * track was silent, count as silence.
+     */
+    void endBlock(int numFrames) noexcept;
+
+private:
+    double sampleRate = 0.0;
+    int numChannels = 0;
+    int segmentLength = 1;
+
+    /* @brief Per-frame decay factors of the RMS average and the held peak. */
+    double rmsDecayPerFrame = 0.0;
+    double peakFallPerFrame = 0.0;
+
+    /* @brief Values added during the current block. */
+    float blockPeak = 0.0f;
+    double blockSumOfSquares = 0.0;
+    double blockWeightedEnergy = 0.0;
+
+    /* @brief Running state. Audio thread only. */
+    double meanSquare = 0.0;
+    float heldPeak = 0.0f;
+    std::array<std::array<Loudness::Biquad, 2>, maxChannels> kWeighting {};
+    std::array<double, shortTermSegments> segmentEnergies {};
+    int segmentIndex = 0;
+    double segmentEnergy = 0.0;
+    int segmentFrames = 0;
+
+    std::atomic<bool> loudnessEnabled { false };
+    std::atomic<float> publishedPeakDb { silenceDb };
+    std::atomic<float> publishedRmsDb { silenceDb };
+    std::atomic<float> publishedLufs { silenceDb };
+    std::atomic<bool> clipped { false };
+
+    /** @brief Runs one channel's K-weighting over strided values and returns the energy. */
+    double weigh(int channel, const float* samples, int numFrames, int stride) noexcept;
+};
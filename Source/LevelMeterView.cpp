@@ -0,0 +1,124 @@
+#include "LevelMeterView.h"
+#include "TraceProfiler.h"
+
+
+namespace
+{
+    /** @brief Smallest level change that is repainted. */
+    constexpr float repaintThresholdDb = 0.25f;
+
+    /** @brief Height of the clip indicator and of each printed value. */
+    constexpr int clipHeight = 4;
+    constexpr int valueHeight = 13;
+}
+
+
+LevelMeterView::LevelMeterView()
+{
+    setOpaque(true);
+}
+
+
+void LevelMeterView::setReading(const LevelMeter::Reading& reading)
+{
+    auto moved = [](float a, float b)
+    {
+        return std::abs(juce::jlimit(minDecibels, maxDecibels, a) - juce::jlimit(minDecibels, maxDecibels, b)) >= repaintThresholdDb;
+    };
+
+    const bool changed = reading.clipped != shown.clipped
+                      || moved(reading.peakDb, shown.peakDb)
+                      || moved(reading.rmsDb, shown.rmsDb)
+                      || moved(reading.shortTermLufs, shown.shortTermLufs);
+
+    if (! changed)
+        return;
+
+    shown = reading;
+    repaint();
+}
+
+
+void LevelMeterView::setShowsValues(bool shouldShowValues)
+{
+    showsValues = shouldShowValues;
+    repaint();
+}
+
+
+void LevelMeterView::paint(juce::Graphics& g)
+{
+    AUDIOPLUGIN_TRACE_ZONE("meter paint")
+
+    g.fillAll(juce::Colours::darkslategrey.darker(0.5f));
+
+    auto area = getLocalBounds();
+    auto valueArea = showsValues ? area.removeFromBottom(valueHeight * 3) : juce::Rectangle<int>();
+
+    g.setColour(shown.clipped ? juce::Colours::red : juce::Colours::grey.withAlpha(0.3f));
+    g.fillRect(area.removeFromTop(clipHeight));
+    area.removeFromTop(1);
+
+    const auto bar = area.toFloat();
+    const float zeroY = decibelsToY(0.0f, bar);
+
+    g.setColour(juce::Colours::grey.withAlpha(0.5f));
+    g.fillRect(bar.getX(), zeroY, bar.getWidth(), 1.0f);
+
+    if (shown.rmsDb > minDecibels)
+    {
+        const float top = decibelsToY(shown.rmsDb, bar);
+        g.setColour(juce::Colours::limegreen);
+        g.fillRect(bar.withTop(juce::jmax(top, zeroY)));
+
+        if (top < zeroY)
+        {
+            g.setColour(juce::Colours::orange);
+            g.fillRect(bar.withTop(top).withBottom(zeroY));
+        }
+    }
+
+    if (shown.peakDb > minDecibels)
+    {
+        g.setColour(shown.peakDb >= 0.0f ? juce::Colours::red : juce::Colours::whitesmoke);
+        g.fillRect(bar.getX(), decibelsToY(shown.peakDb, bar), bar.getWidth(), 1.5f);
+    }
+
+    if (shown.shortTermLufs > minDecibels)
+    {
+        g.setColour(juce::Colours::deepskyblue);
+        g.fillRect(bar.getX(), decibelsToY(shown.shortTermLufs, bar) - 1.0f, bar.getWidth() * 0.5f, 2.0f);
+    }
+
+    if (showsValues)
+    {
+        auto format = [](float decibels)
+        {
+            return decibels > LevelMeter::silenceDb ? juce::String(decibels, 1) : juce::String("-inf");
+        };
+
+        g.setFont(11.0f);
+        g.setColour(juce::Colours::whitesmoke);
+        g.drawText("P " + format(shown.peakDb), valueArea.removeFromTop(valueHeight), juce::Justification::centredLeft);
+        g.drawText("R " + format(shown.rmsDb), valueArea.removeFromTop(valueHeight), juce::Justification::centredLeft);
+        g.setColour(juce::Colours::deepskyblue);
+        g.drawText("S " + format(shown.shortTermLufs), valueArea, juce::Justification::centredLeft);
+    }
+}
+
+
+void LevelMeterView::mouseDown(const juce::MouseEvent&)
+{
+    if (onClipReset)
+        onClipReset();
+
+    shown.clipped = false;
+    repaint();
+}
+
+
+float LevelMeterView::decibelsToY(float decibels, juce::Rectangle<float> bar) const noexcept
+{
+    const float clamped = juce::jlimit(minDecibels, maxDecibels, decibels);
+    return bar.getY() + bar.getHeight() * (maxDecibels - clamped) / (maxDecibels - minDecibels);
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <juce_gui_basics/juce_gui_basics.h>
+
+#include "LevelMeter.h"
+
+
+/**
+ * @class LevelMeterView
+ * @brief Vertical meter of a LevelMeter reading: an RMS bar, a line at the held peak, a tick at the
+ * short-term loudness and a clip indicator at the top.
+ *
+ * setReading() repaints only when a level moves by a visible amount. With showsValues the peak, RMS and
+ * loudness are printed below the bar. Clicking the meter clears its clip indicator.
+ */
+class LevelMeterView : public juce::Component
+{
+public:
+    static constexpr float minDecibels = -60.0f;
+    static constexpr float maxDecibels = 6.0f;
+
+    LevelMeterView();
+
+    void setReading(const LevelMeter::Reading& reading);
+
+    /** @brief Prints the values below the bar, for meters wide enough to hold them. */
+    void setShowsValues(bool shouldShowValues);
+
+    /** @brief Called when the meter is clicked, to clear the clip flag at its source. */
+    std::function<void()> onClipReset;
+
+    void paint(juce::Graphics& g) override;
+    void mouseDown(const juce::MouseEvent& e) override;
+
+private:
+    LevelMeter::Reading shown;
+    bool showsValues = false;
+
+    /** @brief Returns the y position of a level within the bar area. */
+    float decibelsToY(float decibels, juce::Rectangle<float> bar) const noexcept;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LevelMeterView)
+};
@@ -0,0 +1,344 @@
+#include "ModulationMatrix.h"
+
+
+namespace
+{
+    namespace Ids
+    {
+        static const juce::Identifier modulation      { "Modulation" };
+        static const juce::Identifier lfo             { "Lfo" };
+        static const juce::Identifier random          { "Random" };
+        static const juce::Identifier slot            { "Slot" };
+        static const juce::Identifier index           { "index" };
+        static const juce::Identifier shape           { "shape" };
+        static const juce::Identifier beats           { "beats" };
+        static const juce::Identifier source          { "source" };
+        static const juce::Identifier destination     { "destination" };
+        static const juce::Identifier track           { "track" };
+        static const juce::Identifier depth           { "depth" };
+        static const juce::Identifier followerAttack  { "followerAttack" };
+        static const juce::Identifier followerRelease { "followerRelease" };
+    }
+
+    /** @brief Seed of the random sources, fixed so offline renders are repeatable. */
+    constexpr juce::int64 randomSeed = 0x5eed;
+
+    /** @brief Shortest cycle or step length accepted, in beats. */
+    constexpr float minBeats = 1.0f / 64.0f;
+}
+
+
+const char* ModulationMatrix::getDestinationName(Destination destination) noexcept
+{
+    switch (destination)
+    {
+        case lowpassCutoff:   return "lowpassCutoff";
+        case highpassCutoff:  return "highpassCutoff";
+        case bandpassCutoff:  return "bandpassCutoff";
+        case notchCutoff:     return "notchCutoff";
+        case peakCutoff:      return "peakCutoff";
+        case bandpassWidth:   return "bandpassBandwidth";
+        case notchWidth:      return "notchBandwidth";
+        case peakQ:           return "peakQ";
+        case peakGain:        return "peakGain";
+        case bitDepth:        return "bitDepth";
+        case downsampleRate:  return "downsampleRate";
+        case gain:            return "gain";
+        case numDestinations: break;
+    }
+
+    return "";
+}
+
+
+ModulationMatrix::ModulationMatrix()
+{
+    for (auto& beats : lfoBeatsPerCycle)
+        beats = 1.0f;
+
+    for (auto& beats : randomBeatsPerStep)
+        beats = 0.25f;
+
+    for (auto& source : slotSources)
+        source = -1;
+
+    for (auto& track : slotTracks)
+        track = allTracks;
+}
+
+
+void ModulationMatrix::setLfo(int lfo, LfoShape shape, float beatsPerCycle)
+{
+    if (lfo < 0 || lfo >= numLfos)
+        return;
+
+    lfoShapes[(size_t) lfo] = static_cast<int>(shape);
+    lfoBeatsPerCycle[(size_t) lfo] = juce::jmax(minBeats, beatsPerCycle);
+}
+
+
+void ModulationMatrix::setRandomRate(int randomIndex, float beatsPerStep)
+{
+    if (randomIndex >= 0 && randomIndex < numRandoms)
+        randomBeatsPerStep[(size_t) randomIndex] = juce::jmax(minBeats, beatsPerStep);
+}
+
+
+void ModulationMatrix::setFollowerTimes(float attackSeconds, float releaseSeconds)
+{
+    followerAttack = juce::jmax(0.0f, attackSeconds);
+    followerRelease = juce::jmax(0.0f, releaseSeconds);
+}
+
+
+/**
+ * @brief Stores a slot. The source is written last, so the audio thread never routes a newly enabled slot
+ * with the previous slot's depth.
+ */
+void ModulationMatrix::setSlot(int slot, const Slot& newSlot)
+{
+    if (slot < 0 || slot >= maxSlots)
+        return;
+
+    const bool isValid = newSlot.source >= 0 && newSlot.source < numSources
+                      && newSlot.destination >= 0 && newSlot.destination < numDestinations
+                      && newSlot.track >= allTracks && newSlot.track < maxTracks;
+
+    slotSources[(size_t) slot].store(-1, std::memory_order_release);
+
+    if (! isValid)
+        return;
+
+    slotDestinations[(size_t) slot] = newSlot.destination;
+    slotTracks[(size_t) slot] = newSlot.track;
+    slotDepths[(size_t) slot] = newSlot.depth;
+    slotSources[(size_t) slot].store(newSlot.source, std::memory_order_release);
+}
+
+
+ModulationMatrix::Slot ModulationMatrix::getSlot(int slot) const
+{
+    if (slot < 0 || slot >= maxSlots)
+        return {};
+
+    Slot result;
+    result.source = slotSources[(size_t) slot];
+    result.destination = static_cast<Destination>(slotDestinations[(size_t) slot].load());
+    result.track = slotTracks[(size_t) slot];
+    result.depth = slotDepths[(size_t) slot];
+    return result;
+}
+
+
+juce::ValueTree ModulationMatrix::getState() const
+{
+    juce::ValueTree state(Ids::modulation);
+    state.setProperty(Ids::followerAttack, followerAttack.load(), nullptr);
+    state.setProperty(Ids::followerRelease, followerRelease.load(), nullptr);
+
+    for (int i = 0; i < numLfos; ++i)
+    {
+        juce::ValueTree lfo(Ids::lfo);
+        lfo.setProperty(Ids::index, i, nullptr);
+        lfo.setProperty(Ids::shape, lfoShapes[(size_t) i].load(), nullptr);
+        lfo.setProperty(Ids::beats, lfoBeatsPerCycle[(size_t) i].load(), nullptr);
+        state.appendChild(lfo, nullptr);
+    }
+
+    for (int i = 0; i < numRandoms; ++i)
+    {
+        juce::ValueTree randomSource(Ids::random);
+        randomSource.setProperty(Ids::index, i, nullptr);
+        randomSource.setProperty(Ids::beats, randomBeatsPerStep[(size_t) i].load(), nullptr);
+        state.appendChild(randomSource, nullptr);
+    }
+
+    for (int i = 0; i < maxSlots; ++i)
+    {
+        const auto slot = getSlot(i);
+        if (slot.source < 0)
+            continue;
+
+        juce::ValueTree slotState(Ids::slot);
+        slotState.setProperty(Ids::index, i, nullptr);
+        slotState.setProperty(Ids::source, slot.source, nullptr);
+        slotState.setProperty(Ids::destination, getDestinationName(slot.destination), nullptr);
+        slotState.setProperty(Ids::track, slot.track, nullptr);
+        slotState.setProperty(Ids::depth, slot.depth, nullptr);
+        state.appendChild(slotState, nullptr);
+    }
+
+    return state;
+}
+
+
+void ModulationMatrix::setState(const juce::ValueTree& state)
+{
+    if (! state.hasType(Ids::modulation))
+        return;
+
+    setFollowerTimes(state.getProperty(Ids::followerAttack, followerAttack.load()),
+                     state.getProperty(Ids::followerRelease, followerRelease.load()));
+
+    for (int i = 0; i < maxSlots; ++i)
+        clearSlot(i);
+
+    for (const auto& child : state)
+    {
+        const int index = child.getProperty(Ids::index, -1);
+
+        if (child.hasType(Ids::lfo) && index >= 0 && index < numLfos)
+        {
+            setLfo(index, static_cast<LfoShape>(juce::jlimit(0, 3, (int) child.getProperty(Ids::shape, 0))),
+                   child.getProperty(Ids::beats, 1.0f));
+        }
+        else if (child.hasType(Ids::random))
+        {
+            setRandomRate(index, child.getProperty(Ids::beats, 0.25f));
+        }
+        else if (child.hasType(Ids::slot))
+        {
+            const auto destinationName = child[Ids::destination].toString();
+            Slot slot;
+            slot.source = child.getProperty(Ids::source, -1);
+            slot.track = child.getProperty(Ids::track, allTracks);
+            slot.depth = child.getProperty(Ids::depth, 0.0f);
+            slot.destination = numDestinations;
+
+            for (int d = 0; d < numDestinations; ++d)
+                if (destinationName == getDestinationName(static_cast<Destination>(d)))
+                    slot.destination = static_cast<Destination>(d);
+
+            setSlot(index, slot);
+        }
+    }
+}
+
+
+void ModulationMatrix::prepare(double newSampleRate)
+{
+    sampleRate = newSampleRate > 0.0 ? newSampleRate : 44100.0;
+    random.setSeed(randomSeed);
+
+    lfoPhases.fill(0.0f);
+    randomClocks.fill(0.0f);
+    followers.fill(0.0f);
+    sourceValues.fill(0.0f);
+
+    for (auto& destination : offsets)
+        destination.fill(0.0f);
+
+    for (int i = 0; i < numRandoms; ++i)
+        sourceValues[(size_t) (firstRandomSource + i)] = random.nextFloat() * 2.0f - 1.0f;
+
+    modulatedTracks = 0;
+    coefficientFrames = -1;
+}
+
+
+/**
+ * @brief Advances the sources by one tick and sums all slots into the offset table.
+ *
+ * The envelope followers move towards the track level with the attack coefficient on the rising and
+ * the release coefficient on the falling part of the difference, computed for all tracks at once.
+ */
+void ModulationMatrix::process(int numFrames, float bpm, const float* trackLevels) noexcept
+{
+    using FVO = juce::FloatVectorOperations;
+
+    const float beatsPerTick = (float) (numFrames * juce::jmax(1.0f, bpm) / (60.0 * sampleRate));
+
+    //================== LFOs ==================
+
+    for (int i = 0; i < numLfos; ++i)
+        lfoIncrements[(size_t) i] = beatsPerTick / lfoBeatsPerCycle[(size_t) i].load(std::memory_order_relaxed);
+
+    FVO::add(lfoPhases.data(), lfoIncrements.data(), numLfos);
+
+    for (int i = 0; i < numLfos; ++i)
+    {
+        float& phase = lfoPhases[(size_t) i];
+        phase -= std::floor(phase);
+
+        float value = 0.0f;
+
+        switch (static_cast<LfoShape>(lfoShapes[(size_t) i].load(std::memory_order_relaxed)))
+        {
+            case LfoShape::sine:     value = std::sin(juce::MathConstants<float>::twoPi * phase); break;
+            case LfoShape::triangle: value = 1.0f - 4.0f * std::abs(phase - 0.5f); break;
+            case LfoShape::saw:      value = 2.0f * phase - 1.0f; break;
+            case LfoShape::square:   value = phase < 0.5f ? 1.0f : -1.0f; break;
+        }
+
+        sourceValues[(size_t) i] = value;
+    }
+
+    //================== Random sources ==================
+
+    for (int i = 0; i < numRandoms; ++i)
+        randomIncrements[(size_t) i] = beatsPerTick / randomBeatsPerStep[(size_t) i].load(std::memory_order_relaxed);
+
+    FVO::add(randomClocks.data(), randomIncrements.data(), numRandoms);
+
+    for (int i = 0; i < numRandoms; ++i)
+    {
+        float& clock = randomClocks[(size_t) i];
+
+        if (clock >= 1.0f)
+        {
+            clock -= std::floor(clock);
+            sourceValues[(size_t) (firstRandomSource + i)] = random.nextFloat() * 2.0f - 1.0f;
+        }
+    }
+
+    //================== Envelope followers ==================
+
+    const float attack = followerAttack.load(std::memory_order_relaxed);
+    const float release = followerRelease.load(std::memory_order_relaxed);
+
+    if (numFrames != coefficientFrames || attack != coefficientAttack || release != coefficientRelease)
+    {
+        const double tickSeconds = numFrames / sampleRate;
+        attackCoefficient = attack > 0.0f ? (float) (1.0 - std::exp(-tickSeconds / attack)) : 1.0f;
+        releaseCoefficient = release > 0.0f ? (float) (1.0 - std::exp(-tickSeconds / release)) : 1.0f;
+        coefficientFrames = numFrames;
+        coefficientAttack = attack;
+        coefficientRelease = release;
+    }
+
+    FVO::subtract(rising.data(), trackLevels, followers.data(), maxTracks);
+    FVO::min(falling.data(), rising.data(), 0.0f, maxTracks);
+    FVO::max(rising.data(), rising.data(), 0.0f, maxTracks);
+    FVO::addWithMultiply(followers.data(), rising.data(), attackCoefficient, maxTracks);
+    FVO::addWithMultiply(followers.data(), falling.data(), releaseCoefficient, maxTracks);
+    FVO::copy(sourceValues.data() + firstFollowerSource, followers.data(), maxTracks);
+
+    //================== Routing ==================
+
+    for (auto& destination : offsets)
+        FVO::clear(destination.data(), maxTracks);
+
+    modulatedTracks = 0;
+
+    for (int i = 0; i < maxSlots; ++i)
+    {
+        const int source = slotSources[(size_t) i].load(std::memory_order_acquire);
+        if (source < 0)
+            continue;
+
+        auto& destination = offsets[(size_t) slotDestinations[(size_t) i].load(std::memory_order_relaxed)];
+        const int track = slotTracks[(size_t) i].load(std::memory_order_relaxed);
+        const float amount = sourceValues[(size_t) source] * slotDepths[(size_t) i].load(std::memory_order_relaxed);
+
+        if (track == allTracks)
+        {
+            FVO::add(destination.data(), amount, maxTracks);
+            modulatedTracks = (1u << maxTracks) - 1;
+        }
+        else
+        {
+            destination[(size_t) track] += amount;
+            modulatedTracks |= 1u << track;
+        }
+    }
+}
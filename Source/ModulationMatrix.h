@@ -0,0 +1,181 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <juce_data_structures/juce_data_structures.h>
+
+/**
+ * @class ModulationMatrix
+ * @brief Tempo-synced LFOs, sample-and-hold random sources and per-track envelope followers routed to track parameters.
+ *
+ * Sources are advanced once per control tick. LFO phases, random clocks and the envelope followers of
+ * all tracks are kept in parallel arrays and updated with juce::FloatVectorOperations. Every routing
+ * slot adds depth times its source value to a destination-major offset table, so the offsets of all
+ * tracks for one destination are contiguous and a slot applied to every track is a single vector add.
+ *
+ * Source settings and slots are atomics written on the message thread and read by the audio thread at
+ * every tick. process() and the getters do not allocate.
+ */
+class ModulationMatrix
+{
+public:
+    static constexpr int numLfos = 4;
+    static constexpr int numRandoms = 2;
+    static constexpr int maxTracks = 8;
+    static constexpr int maxSlots = 64;
+
+    /** @brief Source indices: the LFOs, then the random sources, then one envelope follower per track. */
+    static constexpr int firstRandomSource = numLfos;
+    static constexpr int firstFollowerSource = numLfos + numRandoms;
+    static constexpr int numSources = firstFollowerSource + maxTracks;
+
+    /** @brief Slot track that applies a slot to every track. */
+    static constexpr int allTracks = -1;
+
+    /** @brief Waveforms of the LFOs. All are bipolar, -1...1. */
+    enum class LfoShape
+    {
+        sine,
+        triangle,
+        saw,
+        square
+    };
+
+    /** @brief Modulation destinations, with the unit a depth of 1 corresponds to. */
+    enum Destination
+    {
+        lowpassCutoff,      ///< Octaves
+        highpassCutoff,     ///< Octaves
+        bandpassCutoff,     ///< Octaves
+        notchCutoff,        ///< Octaves
+        peakCutoff,         ///< Octaves
+        bandpassWidth,      ///< Octaves
+        notchWidth,         ///< Octaves
+        peakQ,              ///< Octaves
+        peakGain,           ///< Decibels
+        bitDepth,           ///< Bits
+        downsampleRate,     ///< Downsampling factor
+        gain,               ///< Decibels
+        numDestinations
+    };
+
+    /** @brief One routing from a source to a destination. */
+    struct Slot
+    {
+        int source = -1;            ///< Source index, -1 for an unused slot
+        Destination destination = lowpassCutoff;
+        int track = allTracks;      ///< Track index or allTracks
+        float depth = 0.0f;         ///< Offset at a source value of 1, in the destination's unit
+    };
+
+    /** @brief Returns the name used for a destination in the plugin state. */
+    static const char* getDestinationName(Destination destination) noexcept;
+
+    ModulationMatrix();
+
+    //================== Message thread ==================
+
+    /**
+     * @brief Configures an LFO.
+     * @param lfo LFO index.
+     * @param shape Waveform.
+     * @param beatsPerCycle Length of one cycle in beats of the global BPM, e.g. 0.25 for sixteenth notes.
+     */
+    void setLfo(int lfo, LfoShape shape, float beatsPerCycle);
+
+    LfoShape getLfoShape(int lfo) const { return static_cast<LfoShape>(lfoShapes[(size_t) lfo].load()); }
+    float getLfoBeatsPerCycle(int lfo) const { return lfoBeatsPerCycle[(size_t) lfo].load(); }
+
+    /**
+     * @brief Sets how often a random source picks a new value.
+     * @param random Random source index.
+     * @param beatsPerStep Time between new values in beats.
+     */
+    void setRandomRate(int random, float beatsPerStep);
+
+    float getRandomBeatsPerStep(int random) const { return randomBeatsPerStep[(size_t) random].load(); }
+
+    /**
+     * @brief Sets the response of the envelope followers.
+     * @param attackSeconds Time constant while the level rises.
+     * @param releaseSeconds Time constant while the level falls.
+     */
+    void setFollowerTimes(float attackSeconds, float releaseSeconds);
+
+    float getFollowerAttack() const { return followerAttack.load(); }
+    float getFollowerRelease() const { return followerRelease.load(); }
+
+    /** @brief Replaces a routing slot. */
+    void setSlot(int slot, const Slot& newSlot);
+
+    /** @brief Returns a routing slot. */
+    Slot getSlot(int slot) const;
+
+    /** @brief Disables a routing slot. */
+    void clearSlot(int slot) { setSlot(slot, {}); }
+
+    /** @brief Returns the sources and slots as a ValueTree of type Modulation. */
+    juce::ValueTree getState() const;
+
+    /** @brief Restores sources and slots from a tree created by getState(). Slots missing from the tree are cleared. */
+    void setState(const juce::ValueTree& state);
+
+    //================== Audio thread ==================
+
+    /**
+     * @brief Resets all sources. Call before playback starts.
+     * @param newSampleRate Sample rate the ticks are counted in.
+     */
+    void prepare(double newSampleRate);
+
+    /**
+     * @brief Advances all sources by one control tick and recomputes the destination offsets.
+     * @param numFrames Length of the tick.
+     * @param bpm Tempo the LFOs and random sources are synced to.
+     * @param trackLevels Peak level of each track during the previous tick, maxTracks values.
+     */
+    void process(int numFrames, float bpm, const float* trackLevels) noexcept;
+
+    /** @brief Returns the summed modulation of a destination of a track for the current tick. */
+    float getOffset(int track, Destination destination) const noexcept { return offsets[(size_t) destination][(size_t) track]; }
+
+    /** @brief Returns whether any slot was routed to a track in the current tick. */
+    bool isTrackModulated(int track) const noexcept { return (modulatedTracks & (1u << track)) != 0; }
+
+    /** @brief Returns the current value of a source. */
+    float getSourceValue(int source) const noexcept { return sourceValues[(size_t) source]; }
+
+private:
+    std::array<std::atomic<int>, numLfos> lfoShapes {};
+    std::array<std::atomic<float>, numLfos> lfoBeatsPerCycle {};
+    std::array<std::atomic<float>, numRandoms> randomBeatsPerStep {};
+    std::atomic<float> followerAttack { 0.01f };
+    std::atomic<float> followerRelease { 0.2f };
+
+    std::array<std::atomic<int>, maxSlots> slotSources {};
+    std::array<std::atomic<int>, maxSlots> slotDestinations {};
+    std::array<std::atomic<int>, maxSlots> slotTracks {};
+    std::array<std::atomic<float>, maxSlots> slotDepths {};
+
+    /* @brief Audio thread state. */
+    double sampleRate = 44100.0;
+    std::array<float, numLfos> lfoPhases {};
+    std::array<float, numLfos> lfoIncrements {};
+    std::array<float, numRandoms> randomClocks {};
+    std::array<float, numRandoms> randomIncrements {};
+    std::array<float, maxTracks> followers {};
+    std::array<float, maxTracks> rising {};
+    std::array<float, maxTracks> falling {};
+    std::array<float, numSources> sourceValues {};
+    std::array<std::array<float, maxTracks>, numDestinations> offsets {};
+    juce::uint32 modulatedTracks = 0;
+    juce::Random random;
+
+    /* @brief Follower coefficients, recomputed when the times or the tick length change. */
+    float attackCoefficient = 1.0f;
+    float releaseCoefficient = 1.0f;
+    float coefficientAttack = -1.0f;
+    float coefficientRelease = -1.0f;
+    int coefficientFrames = -1;
+
+    JUCE_DECLARE_NON_COPYABLE (ModulationMatrix)
+};
@@ -0,0 +1,84 @@
+#include "ParameterLocks.h"
+
+
+const char* ParameterLock::getTargetName(Target target) noexcept
+{
+    switch (target)
+    {
+        case cutoff:     return "cutoff";
+        case peakGain:   return "peakGain";
+        case bitDepth:   return "bitDepth";
+        case gain:       return "gain";
+        case attack:     return "attack";
+        case decay:      return "decay";
+        case release:    return "release";
+        case slice:      return "slice";
+        case pitch:      return "pitch";
+        case numTargets: break;
+    }
+
+    return "";
+}
+
+
+/**
+ * @brief Frees all compiled settings. The audio thread must no longer be running.
+ */
+StepLockTable::~StepLockTable()
+{
+    for (auto& track : compiled)
+        for (auto& settings : track)
+            delete settings.exchange(nullptr);
+}
+
+
+ParameterLock StepLockTable::getLock(int track, int step) const
+{
+    const int cell = getCell(track, step);
+    const auto it = std::lower_bound(entries.begin(), entries.end(), cell,
+                                     [](const Entry& entry, int c) { return entry.cell < c; });
+
+    return it != entries.end() && it->cell == cell ? it->lock : ParameterLock();
+}
+
+
+void StepLockTable::setLock(int track, int step, const ParameterLock& lock)
+{
+    const int cell = getCell(track, step);
+    const auto it = std::lower_bound(entries.begin(), entries.end(), cell,
+                                     [](const Entry& entry, int c) { return entry.cell < c; });
+    const bool exists = it != entries.end() && it->cell == cell;
+
+    if (lock.isEmpty())
+    {
+        if (exists)
+            entries.erase(it);
+    }
+    else if (exists)
+    {
+        it->lock = lock;
+    }
+    else
+    {
+        entries.insert(it, { cell, lock });
+    }
+}
+
+
+juce::uint32 StepLockTable::getLockedSteps(int track) const noexcept
+{
+    juce::uint32 steps = 0;
+
+    for (const auto& entry : entries)
+        if (entry.cell / numSteps == track)
+            steps |= 1u << (entry.cell % numSteps);
+
+    return steps;
+}
+
+
+void StepLockTable::publish(int track, int step, std::unique_ptr<const TrackSettings> settings)
+{
+    retired.exchange(compiled[(size_t) track][(size_t) step], std::move(settings));
+    versions[(size_t) track].fetch_add(1, std::memory_order_release);
+}
@@ -0,0 +1,184 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+
+#include "SampleInterpolator.h"
+#include "RetiredPointers.h"
+
+
+/**
+ * @brief Switches and scalar settings of one track as used while rendering.
+ */
+struct TrackControl
+{
+    bool lowpass = false;
+    bool highpass = false;
+    bool bandpass = false;
+    bool notch = false;
+    bool peak = false;
+    bool bitcrusher = false;
+    int bitDepth = 8;
+    int downsampleFactor = 1;
+    float gain = 1.0f;
+    bool slicePlayback = false;     ///< Triggers play one slice of the sample instead of all of it
+    int slice = -1;                 ///< Slice a locked step plays, or -1 for the slice of the step's number
+    float pitchRatio = 1.0f;        ///< Frames of the sample played per output frame
+    SampleInterpolator::Quality interpolation = SampleInterpolator::Quality::cubic;
+};
+
+
+/**
+ * @struct ParameterLock
+ * @brief Overrides of track parameters for a single sequencer step.
+ *
+ * Only the targets set in the mask are overridden; everything else follows the track's own settings.
+ * The cutoff target moves the centre or cutoff frequency of every filter of the track. The slice target
+ * only matters while the track plays slices. The pitch target replaces the track's pitch for the note
+ * the step starts.
+ */
+struct ParameterLock
+{
+    /** @brief Parameters a step can override. */
+    enum Target
+    {
+        cutoff,     ///< Filter cutoff in Hz
+        peakGain,   ///< Peak filter gain in dB
+        bitDepth,   ///< Bitcrusher bit depth
+        gain,       ///< Linear track gain
+        attack,     ///< Envelope attack in seconds
+        decay,      ///< Envelope decay in seconds
+        release,    ///< Envelope release in seconds
+        slice,      ///< Slice the step plays in slice playback
+        pitch,      ///< Pitch in semitones
+        numTargets
+    };
+
+    /** @brief Returns the name used for a target in the plugin state. */
+    static const char* getTargetName(Target target) noexcept;
+
+    bool has(Target target) const noexcept    { return (mask & (1u << target)) != 0; }
+    float get(Target target) const noexcept   { return values[(size_t) target]; }
+    bool isEmpty() const noexcept             { return mask == 0; }
+
+    void set(Target target, float value) noexcept
+    {
+        mask = (juce::uint16) (mask | (1u << target));
+        values[(size_t) target] = value;
+    }
+
+    void clear(Target target) noexcept
+    {
+        mask = (juce::uint16) (mask & ~(1u << target));
+        values[(size_t) target] = 0.0f;
+    }
+
+    bool operator==(const ParameterLock& other) const noexcept { return mask == other.mask && values == other.values; }
+    bool operator!=(const ParameterLock& other) const noexcept { return ! operator==(other); }
+
+    juce::uint16 mask = 0;
+    std::array<float, numTargets> values {};
+
+    static_assert(numTargets <= 16, "The mask has one bit per target");
+};
+
+
+/**
+ * @struct TrackSettings
+ * @brief Ready-made configuration of one track: controls, filter coefficients and envelope.
+ *
+ * Installing a TrackSettings on the audio thread only copies values; all coefficient design happens
+ * when it is built.
+ */
+struct TrackSettings
+{
+    TrackControl control;
+
+    /** @brief Prewarped gains of the state variable filters, tan(pi * cutoff / sampleRate). */
+    float lowpassGain = 0.0f;
+    float highpassGain = 0.0f;
+    float bandpassGain = 0.0f;
+
+    /** @brief Damping of the band-pass filter, bandwidth / cutoff. */
+    float bandpassDamping = juce::MathConstants<float>::sqrt2;
+
+    /** @brief Biquad coefficients b0, b1, b2, a0, a1, a2. */
+    std::array<float, 6> notchCoefficients { 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f };
+    std::array<float, 6> peakCoefficients { 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f };
+
+    juce::ADSR::Parameters envelope;
+
+    /** @brief Step overrides the settings were computed with, so modulation can be applied on top. */
+    ParameterLock lock;
+};
+
+
+/**
+ * @class StepLockTable
+ * @brief Parameter locks of all sequencer steps together with their compiled TrackSettings.
+ *
+ * The locks themselves are kept sparsely, sorted by cell, since most steps have none. For every locked
+ * cell the owner publishes a compiled TrackSettings; the audio thread only loads the pointer of the
+ * current step. A replaced TrackSettings is retired through RetiredPointers and freed by a later edit
+ * once the audio thread has completed the block that might still have been reading it.
+ *
+ * All methods except getCompiled(), getVersion() and markBlockCompleted() belong to the message side
+ * and must be serialised by the caller.
+ */
+class StepLockTable
+{
+public:
+    static constexpr int maxTracks = 8;
+    static constexpr int numSteps = 16;
+
+    StepLockTable() = default;
+    ~StepLockTable();
+
+    /** @brief Returns the lock of a step, empty if the step has none. */
+    ParameterLock getLock(int track, int step) const;
+
+    /** @brief Stores the lock of a step; an empty lock removes the entry. */
+    void setLock(int track, int step, const ParameterLock& lock);
+
+    /** @brief Returns a bit per step of a track that has a lock. */
+    juce::uint32 getLockedSteps(int track) const noexcept;
+
+    /**
+     * @brief Installs the compiled settings of a step for the audio thread.
+     * @param settings New settings, or nullptr if the step has no lock.
+     */
+    void publish(int track, int step, std::unique_ptr<const TrackSettings> settings);
+
+    /** @brief Frees all retired settings. Only valid while the audio thread is stopped. */
+    void releaseAllRetired() { retired.releaseAll(); }
+
+    //================== Audio thread ==================
+
+    /** @brief Returns the compiled settings of a step, or nullptr. */
+    const TrackSettings* getCompiled(int track, int step) const noexcept
+    {
+        return compiled[(size_t) track][(size_t) step].load(std::memory_order_acquire);
+    }
+
+    /** @brief Incremented whenever compiled settings of a track are published. */
+    juce::uint32 getVersion(int track) const noexcept { return versions[(size_t) track].load(std::memory_order_acquire); }
+
+    /** @brief Called by the audio thread at the end of every block. */
+    void markBlockCompleted() noexcept { retired.markBlockCompleted(); }
+
+private:
+    struct Entry
+    {
+        int cell = 0;
+        ParameterLock lock;
+    };
+
+    static int getCell(int track, int step) noexcept { return track * numSteps + step; }
+
+    std::vector<Entry> entries;
+    RetiredPointers<TrackSettings> retired;
+
+    std::array<std::array<std::atomic<const TrackSettings*>, numSteps>, maxTracks> compiled {};
+    std::array<std::atomic<juce::uint32>, maxTracks> versions {};
+
+    JUCE_DECLARE_NON_COPYABLE (StepLockTable)
+};
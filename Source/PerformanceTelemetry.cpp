@@ -0,0 +1,148 @@
+#include "PerformanceTelemetry.h"
+
+
+/**
+ * @brief Constructor. Allocates the FIFO and history storage up front.
+ */
+PerformanceTelemetry::PerformanceTelemetry()
+    : microsPerTick(1.0e6 / (double) juce::Time::getHighResolutionTicksPerSecond()),
+      fifoRecords((size_t) historySize),
+      history((size_t) historySize, 0.0f)
+{
+}
+
+
+/**
+ * @brief Starts timing a block and applies a pending statistics reset.
+ * @return Timestamp of the block start, or 0 when disabled.
+ */
+juce::int64 PerformanceTelemetry::beginBlock() noexcept
+{
+    if (! isEnabled())
+        return 0;
+
+    if (resetRequested.exchange(false, std::memory_order_relaxed))
+    {
+        peakLoad.store(0.0f, std::memory_order_relaxed);
+        maxBlockMicros.store(0.0f, std::memory_order_relaxed);
+        numBlocks.store(0, std::memory_order_relaxed);
+        numOverruns.store(0, std::memory_order_relaxed);
+    }
+
+    trackTicks.fill(0);
+    return juce::Time::getHighResolutionTicks();
+}
+
+
+/**
+ * @brief Accumulates the time spent on one track.
+ * @param track Track index.
+ * @param startTicks Timestamp taken before rendering the track.
+ */
+void PerformanceTelemetry::addTrackTime(int track, juce::int64 startTicks) noexcept
+{
+    if (startTicks == 0 || ! juce::isPositiveAndBelow(track, maxTracks))
+        return;
+
+    trackTicks[(size_t) track] += juce::Time::getHighResolutionTicks() - startTicks;
+}
+
+
+/**
+ * @brief Measures the block duration, pushes it to the FIFO and updates the published values.
+ * @param startTicks The value returned by beginBlock().
+ * @param numSamples Number of samples in the block.
+ * @param sampleRate Current sample rate.
+ */
+void PerformanceTelemetry::endBlock(juce::int64 startTicks, int numSamples, double sampleRate) noexcept
+{
+    if (startTicks == 0 || numSamples <= 0 || sampleRate <= 0.0)
+        return;
+
+    const auto micros = (float) ((double) (juce::Time::getHighResolutionTicks() - startTicks) * microsPerTick);
+    const auto deadlineMicros = (float) (numSamples * 1.0e6 / sampleRate);
+    const auto load = micros / deadlineMicros;
+
+    lastLoad.store(load, std::memory_order_relaxed);
+    numBlocks.store(numBlocks.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+    if (load > peakLoad.load(std::memory_order_relaxed))
+        peakLoad.store(load, std::memory_order_relaxed);
+
+    if (micros > maxBlockMicros.load(std::memory_order_relaxed))
+        maxBlockMicros.store(micros, std::memory_order_relaxed);
+
+    if (load > 1.0f)
+        numOverruns.store(numOverruns.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+    for (size_t i = 0; i < (size_t) maxTracks; ++i)
+    {
+        const auto trackShare = (float) ((double) trackTicks[i] * microsPerTick) / deadlineMicros;
+        const auto smoothed = trackLoad[i].load(std::memory_order_relaxed);
+        trackLoad[i].store(smoothed + 0.05f * (trackShare - smoothed), std::memory_order_relaxed);
+    }
+
+    const auto scope = fifo.write(1);
+
+    if (scope.blockSize1 > 0)
+        fifoRecords[(size_t) scope.startIndex1] = { micros, load };
+}
+
+
+/**
+ * @brief Drains the FIFO into the history and computes percentiles.
+ * @return Current statistics.
+ */
+PerformanceTelemetry::Snapshot PerformanceTelemetry::collect()
+{
+    const int numReady = fifo.getNumReady();
+
+    {
+        const auto scope = fifo.read(numReady);
+
+        auto append = [this](int start, int size)
+        {
+            for (int i = 0; i < size; ++i)
+            {
+                history[(size_t) historyWritePosition] = fifoRecords[(size_t) (start + i)].micros;
+                historyWritePosition = (historyWritePosition + 1) % historySize;
+                historyCount = juce::jmin(historyCount + 1, historySize);
+            }
+        };
+
+        append(scope.startIndex1, scope.blockSize1);
+        append(scope.startIndex2, scope.blockSize2);
+    }
+
+    Snapshot snapshot;
+    snapshot.lastLoad = lastLoad.load(std::memory_order_relaxed);
+    snapshot.peakLoad = peakLoad.load(std::memory_order_relaxed);
+    snapshot.maxBlockMicros = maxBlockMicros.load(std::memory_order_relaxed);
+    snapshot.numBlocks = numBlocks.load(std::memory_order_relaxed);
+    snapshot.numOverruns = numOverruns.load(std::memory_order_relaxed);
+
+    for (size_t i = 0; i < (size_t) maxTracks; ++i)
+        snapshot.trackLoad[i] = trackLoad[i].load(std::memory_order_relaxed);
+
+    if (historyCount > 0)
+    {
+        std::vector<float> sorted(history.begin(), history.begin() + historyCount);
+        std::sort(sorted.begin(), sorted.end());
+
+        snapshot.p50BlockMicros = sorted[(size_t) (historyCount - 1) / 2];
+        snapshot.p99BlockMicros = sorted[(size_t) ((historyCount - 1) * 99) / 100];
+    }
+
+    return snapshot;
+}
+
+
+/**
+ * @brief Clears the history immediately and asks the audio thread to clear its counters.
+ */
+void PerformanceTelemetry::resetStatistics() noexcept
+{
+    historyCount = 0;
+    historyWritePosition = 0;
+    resetRequested.store(true, std::memory_order_relaxed);
+}
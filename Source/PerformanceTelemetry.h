@@ -0,0 +1,113 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+
+/**
+ * @class PerformanceTelemetry
+ * @brief Lightweight timing of the audio callback, cheap enough to stay enabled in release builds.
+ *
+ * The audio thread records the duration of every processBlock call and the time spent per track.
+ * Per-block records are pushed into a wait-free FIFO, running values (last load, maximum block time,
+ * overruns and per-track load) are published through relaxed atomics. The message thread drains the
+ * FIFO with collect() and computes percentiles from a history of recent blocks.
+ */
+class PerformanceTelemetry
+{
+public:
+    /** @brief Maximum number of tracks that are timed individually. */
+    static constexpr int maxTracks = 8;
+
+    /** @brief Number of recent blocks kept for percentile statistics. */
+    static constexpr int historySize = 2048;
+
+    /** @brief Statistics computed on the message thread. */
+    struct Snapshot
+    {
+        float lastLoad = 0.0f;               ///< DSP load of the most recent block (1.0 = whole deadline used).
+        float peakLoad = 0.0f;               ///< Highest load since the last reset.
+        float p50BlockMicros = 0.0f;         ///< Median block time of the recent history.
+        float p99BlockMicros = 0.0f;         ///< 99th percentile block time of the recent history.
+        float maxBlockMicros = 0.0f;         ///< Longest block since the last reset.
+        juce::int64 numBlocks = 0;           ///< Blocks measured since the last reset.
+        juce::int64 numOverruns = 0;         ///< Blocks that took longer than their deadline.
+        std::array<float, maxTracks> trackLoad {}; ///< Smoothed share of the deadline used by each track.
+    };
+
+    /** @brief Constructor. */
+    PerformanceTelemetry();
+
+    /** @brief Enables or disables measuring. Disabled telemetry costs one atomic load per block. */
+    void setEnabled(bool shouldBeEnabled) noexcept { enabled.store(shouldBeEnabled, std::memory_order_relaxed); }
+
+    /** @brief Checks whether measuring is enabled. */
+    bool isEnabled() const noexcept { return enabled.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Starts timing a block. Audio thread only.
+     * @return Timestamp to pass to endBlock(), or 0 when disabled.
+     */
+    juce::int64 beginBlock() noexcept;
+
+    /**
+     * @brief Adds the time since startTicks to a track's cost in the current block. Audio thread only.
+     * @param track Track index.
+     * @param startTicks Timestamp taken with now() before the track was rendered.
+     */
+    void addTrackTime(int track, juce::int64 startTicks) noexcept;
+
+    /**
+     * @brief Finishes timing a block and publishes its statistics. Audio thread only.
+     * @param startTicks The value returned by beginBlock().
+     * @param numSamples Number of samples processed in the block.
+     * @param sampleRate Current sample rate.
+     */
+    void endBlock(juce::int64 startTicks, int numSamples, double sampleRate) noexcept;
+
+    /** @brief Returns a timestamp when enabled, 0 otherwise. */
+    juce::int64 now() const noexcept { return isEnabled() ? juce::Time::getHighResolutionTicks() : 0; }
+
+    /**
+     * @brief Drains the FIFO and computes current statistics. Message thread only.
+     * @return The current statistics.
+     */
+    Snapshot collect();
+
+    /** @brief Clears maxima, counters and history. Message thread only; the audio side is cleared at the next block. */
+    void resetStatistics() noexcept;
+
+private:
+    /** @brief One measured block as pushed through the FIFO. */
+    struct BlockRecord
+    {
+        float micros = 0.0f;
+        float load = 0.0f;
+    };
+
+    std::atomic<bool> enabled { true };
+    std::atomic<bool> resetRequested { false };
+
+    /* @brief Converts high resolution ticks to microseconds. */
+    const double microsPerTick;
+
+    /* @brief Per-track ticks accumulated during the current block (audio thread only). */
+    std::array<juce::int64, maxTracks> trackTicks {};
+
+    /* @brief Wait-free single producer, single consumer FIFO of block records. */
+    juce::AbstractFifo fifo { historySize };
+    std::vector<BlockRecord> fifoRecords;
+
+    std::atomic<float> lastLoad { 0.0f };
+    std::atomic<float> peakLoad { 0.0f };
+    std::atomic<float> maxBlockMicros { 0.0f };
+    std::atomic<juce::int64> numBlocks { 0 };
+    std::atomic<juce::int64> numOverruns { 0 };
+    std::array<std::atomic<float>, maxTracks> trackLoad {};
+
+    /* @brief Block times of the recent history (message thread only). */
+    std::vector<float> history;
+    int historyWritePosition = 0;
+    int historyCount = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PerformanceTelemetry)
+};
@@ -1,5 +1,6 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
+#include "TraceProfiler.h"
 
 /**
  * @brief Constructs the editor for the SampleAudioProcessor.
@@ -20,13 +21,17 @@ SampleAudioProcessorEditor::SampleAudioProcessorEditor (SampleAudioProcessor& p)
      * @param slider The slider to be configured.
      * @param suffix Optional suffix string to be displayed after the value.
      */
-    auto configureAsKnob = [](juce::Slider& slider, const juce::String& suffix = "")
+    auto configureAsKnob = [this](juce::Slider& slider, const juce::String& suffix = "")
     {
         slider.setSliderStyle(juce::Slider::RotaryVerticalDrag);
         slider.setTextBoxStyle(juce::Slider::TextBoxBelow, true, 80, 20);
         slider.setNumDecimalPlacesToDisplay(2);
         if (!suffix.isEmpty())
             slider.setTextValueSuffix(" " + suffix);
+
+        // A whole drag is one undo step
+        slider.onDragStart = [this] { audioProcessor.beginUndoTransaction(); };
+        slider.onDragEnd = [this] { audioProcessor.endUndoTransaction(); };
     };
 
     for (int i = 0; i < NUM_SAMPLES; ++i)
@@ -39,19 +44,27 @@ SampleAudioProcessorEditor::SampleAudioProcessorEditor (SampleAudioProcessor& p)
         sampleControlGroups[i].setColour(juce::GroupComponent::textColourId, juce::Colours::whitesmoke);
         addAndMakeVisible(sampleControlGroups[i]);
 
+        /**
+         * @brief Waveform of the loaded sample, updated by timerCallback() when the slot changes.
+         */
+        waveformViews[i].setPeaks(audioProcessor.getSampleWaveform(i));
+        waveformViews[i].setSlices(audioProcessor.getSampleSlices(i));
+        addAndMakeVisible(waveformViews[i]);
+        addChildComponent(spectrumViews[i]);
+
         /**
          * @brief Load button to choose a sample file.
          */
         loadSampleButtons[i].setButtonText("Load");
         loadSampleButtons[i].onClick = [this, i]()
         {
-            fileChooser = std::make_unique<juce::FileChooser>("Select a Sample", juce::File{}, "*.wav");
+            fileChooser = std::make_unique<juce::FileChooser>("Select a Sample", juce::File{}, sampleLibrary->getWildcard());
             fileChooser->launchAsync(juce::FileBrowserComponent::openMode | juce::FileBrowserComponent::canSelectFiles,
                 [this, i](const juce::FileChooser& chooser)
                 {
                     auto file = chooser.getResult();
                     if (file.existsAsFile())
-                        audioProcessor.loadSampleFile(file, i);
+                        audioProcessor.loadSampleFileAsync(file, i);
                 });
         };
         addAndMakeVisible(loadSampleButtons[i]);
@@ -67,13 +80,34 @@ SampleAudioProcessorEditor::SampleAudioProcessorEditor (SampleAudioProcessor& p)
 
         playSampleButtons[i].onClick = [this, i]()
         {
-            bool isPlaying = playSampleButtons[i].getToggleState();
+            updatePlayButton(i);
+            audioProcessor.setSamplePlaying(i, playSampleButtons[i].getToggleState());
+        };
 
-            playSampleButtons[i].setButtonText(isPlaying ? "pause" : "play");
-            playSampleButtons[i].setColour(juce::TextButton::buttonColourId,
-                                           isPlaying ? juce::Colours::green : juce::Colours::darkgrey);
+        /**
+         * @brief Toggle button to play the track from a background render of its effect chain.
+         */
+        setupToggleButton(freezeToggleButtons[i], "Freeze");
+        freezeToggleButtons[i].setToggleState(audioProcessor.isTrackFrozen(i), juce::dontSendNotification);
+        freezeToggleButtons[i].onClick = [this, i]() {
+            audioProcessor.setTrackFrozen(i, freezeToggleButtons[i].getToggleState());
+        };
 
-            audioProcessor.isSamplePlaying[i] = isPlaying;
+        /**
+         * @brief Toggle button to play one slice of the sample per step.
+         */
+        setupToggleButton(sliceToggleButtons[i], "Slice");
+        sliceToggleButtons[i].setToggleState(audioProcessor.getSlicePlayback(i), juce::dontSendNotification);
+        sliceToggleButtons[i].onClick = [this, i]() {
+            audioProcessor.setSlicePlayback(i, sliceToggleButtons[i].getToggleState());
+        };
+
+        /**
+         * @brief Toggle button to show the track's spectrum and filter response instead of its waveform.
+         */
+        setupToggleButton(spectrumToggleButtons[i], "FFT");
+        spectrumToggleButtons[i].onClick = [this, i]() {
+            setSpectrumShown(i, spectrumToggleButtons[i].getToggleState());
         };
 
         /**
@@ -134,8 +168,10 @@ SampleAudioProcessorEditor::SampleAudioProcessorEditor (SampleAudioProcessor& p)
         bandpassToggleButtons[i].onClick = [this, i]()
         {
             bool enabled = bandpassToggleButtons[i].getToggleState();
+            audioProcessor.beginUndoTransaction();
             audioProcessor.setBandPassEnabled(i, enabled);
             handleFilterToggleLogic(i, bandpassToggleButtons[i]);
+            audioProcessor.endUndoTransaction();
         };
 
 
@@ -161,8 +197,10 @@ SampleAudioProcessorEditor::SampleAudioProcessorEditor (SampleAudioProcessor& p)
         notchToggleButtons[i].onClick = [this, i]()
         {
             bool enabled = notchToggleButtons[i].getToggleState();
+            audioProcessor.beginUndoTransaction();
             audioProcessor.setNotchEnabled(i, enabled);
             handleFilterToggleLogic(i, notchToggleButtons[i]);
+            audioProcessor.endUndoTransaction();
         };
 
         /**
@@ -192,8 +230,10 @@ SampleAudioProcessorEditor::SampleAudioProcessorEditor (SampleAudioProcessor& p)
         peakToggleButtons[i].onClick = [this, i]()
         {
             bool enabled = peakToggleButtons[i].getToggleState();
+            audioProcessor.beginUndoTransaction();
             audioProcessor.setPeakEnabled(i, enabled);
             handleFilterToggleLogic(i, peakToggleButtons[i]);
+            audioProcessor.endUndoTransaction();
         };
 
 
@@ -235,6 +275,38 @@ SampleAudioProcessorEditor::SampleAudioProcessorEditor (SampleAudioProcessor& p)
             audioProcessor.setGainLevel(i, (float)gainSliders[i].getValue());
         };
 
+        /**
+         * @brief Level meter of the track after its gain. Loudness is only measured while an editor shows it.
+         */
+        audioProcessor.getTrackMeter(i).setLoudnessEnabled(true);
+        gainMeters[i].onClipReset = [this, i]() { audioProcessor.getTrackMeter(i).resetClip(); };
+        addAndMakeVisible(gainMeters[i]);
+
+        /**
+         * @brief Pitch of the sample and the kernel it is interpolated with.
+         */
+        configureAsKnob(pitchSliders[i], "st");
+        pitchSliders[i].setRange(-SampleAudioProcessor::maxPitch, SampleAudioProcessor::maxPitch, 0.01);
+        pitchSliders[i].setDoubleClickReturnValue(true, 0.0);
+        pitchSliders[i].setValue(audioProcessor.getPitch(i), juce::dontSendNotification);
+        addAndMakeVisible(pitchSliders[i]);
+        pitchLabels[i].setText("Pitch", juce::dontSendNotification);
+        pitchLabels[i].setJustificationType(juce::Justification::centred);
+        pitchLabels[i].setColour(juce::Label::textColourId, juce::Colours::whitesmoke);
+        addAndMakeVisible(pitchLabels[i]);
+        pitchSliders[i].onValueChange = [this, i]() {
+            audioProcessor.setPitch(i, (float) pitchSliders[i].getValue());
+        };
+
+        interpolationSelectors[i].addItem("Linear", 1 + (int) SampleInterpolator::Quality::linear);
+        interpolationSelectors[i].addItem("Cubic", 1 + (int) SampleInterpolator::Quality::cubic);
+        interpolationSelectors[i].addItem("Sinc", 1 + (int) SampleInterpolator::Quality::sinc);
+        interpolationSelectors[i].setSelectedId(1 + (int) audioProcessor.getInterpolation(i), juce::dontSendNotification);
+        addAndMakeVisible(interpolationSelectors[i]);
+        interpolationSelectors[i].onChange = [this, i]() {
+            audioProcessor.setInterpolation(i, static_cast<SampleInterpolator::Quality>(interpolationSelectors[i].getSelectedId() - 1));
+        };
+
         /**
          * @brief ADSR envelope editor for each sample.
          */
@@ -243,31 +315,32 @@ SampleAudioProcessorEditor::SampleAudioProcessorEditor (SampleAudioProcessor& p)
 
         adsrEditors[i]->onAdsrChanged = [this, i](double a, double d, double s, double r)
         {
+            audioProcessor.beginUndoTransaction();
             audioProcessor.setAdsrAttack(i, a);
             audioProcessor.setAdsrDecay(i, d);
             audioProcessor.setAdsrSustain(i, s);
             audioProcessor.setAdsrRelease(i, r);
+            audioProcessor.endUndoTransaction();
         };
+        adsrEditors[i]->onDragStart = [this] { audioProcessor.beginUndoTransaction(); };
+        adsrEditors[i]->onDragEnd = [this] { audioProcessor.endUndoTransaction(); };
 
 
     }
 
     /**
-     * @brief Initializes the step sequencer buttons.
+     * @brief Initializes the step sequencer grid. A click or drag paint is one undo step.
      */
+    stepGrid.onStepChanged = [this](int track, int step, bool isOn) { audioProcessor.setStepState(track, step, isOn); };
+    stepGrid.onLockEditRequested = [this](int track, int step) { showStepLockEditor(track, step); };
+    stepGrid.onDragStart = [this] { audioProcessor.beginUndoTransaction(); };
+    stepGrid.onDragEnd = [this] { audioProcessor.endUndoTransaction(); };
+    addAndMakeVisible(stepGrid);
+
     for (int track = 0; track < NUM_TRACKS; ++track)
     {
-        for (int step = 0; step < NUM_STEPS; ++step)
-        {
-            auto& button = stepButtons[track][step];
-            button.setClickingTogglesState(true);
-            button.onClick = [this, track, step]
-            {
-                bool isOn = stepButtons[track][step].getToggleState();
-                audioProcessor.setStepState(track, step, isOn);
-            };
-            addAndMakeVisible(button);
-        }
+        stepGrid.setSteps(track, audioProcessor.getStepPattern(track));
+        updateStepLockMarkers(track);
     }
 
     /**
@@ -305,17 +378,71 @@ SampleAudioProcessorEditor::SampleAudioProcessorEditor (SampleAudioProcessor& p)
     globalBpmSlider.onValueChange = [this]() {
         audioProcessor.setGlobalBpm(globalBpmSlider.getValue());
     };
+    globalBpmSlider.onDragStart = [this] { audioProcessor.beginUndoTransaction(); };
+    globalBpmSlider.onDragEnd = [this] { audioProcessor.endUndoTransaction(); };
     addAndMakeVisible(globalBpmSlider);
 
     /**
-     * @brief Overlay to highlight the current step in the sequencer.
+     * @brief Level meter of the output with its values, next to the BPM slider. Clicking it clears the clip indicator.
+     */
+    audioProcessor.getMasterMeter().setLoudnessEnabled(true);
+    masterMeterView.setShowsValues(true);
+    masterMeterView.onClipReset = [this]() { audioProcessor.getMasterMeter().resetClip(); };
+    addAndMakeVisible(masterMeterView);
+
+    /**
+     * @brief Audio thread timing display. Clicking it resets the statistics.
+     */
+    performancePanel.onReset = [this]() { audioProcessor.getTelemetry().resetStatistics(); };
+    addAndMakeVisible(performancePanel);
+
+    /**
+     * @brief Undo and redo of pattern, parameter, step lock and sample edits.
      */
-    addAndMakeVisible(stepHighlightOverlay);
-    stepHighlightOverlay.toFront(true);
+    undoButton.setButtonText("Undo");
+    undoButton.onClick = [this]() { audioProcessor.undo(); };
+    addAndMakeVisible(undoButton);
+
+    redoButton.setButtonText("Redo");
+    redoButton.onClick = [this]() { audioProcessor.redo(); };
+    addAndMakeVisible(redoButton);
 
     /**
-     * @brief Starts the timer to update the GUI regularly.
+     * @brief Sample library browser. Selecting a file previews it on the output; loading it goes
+     * through the same path as the Load buttons.
      */
+    setupToggleButton(libraryButton, "Library");
+    libraryButton.onClick = [this]() { setBrowserShown(libraryButton.getToggleState()); };
+
+    sampleBrowser.onAudition = [this](const juce::File& file)
+    {
+        if (file == juce::File())
+            audioProcessor.stopAudition();
+        else
+            audioProcessor.auditionSampleFile(file);
+    };
+    sampleBrowser.onLoad = [this](const juce::File& file, int track) { audioProcessor.loadSampleFileAsync(file, track); };
+    addChildComponent(sampleBrowser);
+
+    /**
+     * @brief Spectrum of the master output, analysed only while the button is on.
+     */
+    setupToggleButton(masterSpectrumButton, "Master FFT");
+    masterSpectrumButton.onClick = [this]() {
+        const bool isOn = masterSpectrumButton.getToggleState();
+        audioProcessor.getSpectrumAnalyser().setEnabled(SampleAudioProcessor::masterSpectrumSource, isOn);
+        masterSpectrumView.setVisible(isOn);
+    };
+    addChildComponent(masterSpectrumView);
+
+    lastStateRestoreCount = audioProcessor.getStateRestoreCount();
+    setWantsKeyboardFocus(true);
+
+    /**
+     * @brief Starts the timer for the timing display and undo state. The playhead follows the display
+     * refresh through playheadVBlank instead.
+     */
+    setOpaque(true);
     startTimerHz(10);
 
 
@@ -329,42 +456,36 @@ SampleAudioProcessorEditor::SampleAudioProcessorEditor (SampleAudioProcessor& p)
 /**
  * @brief Destructor for the editor.
  *
- * Resets the look and feel to nullptr.
+ * Stops the analysers and a running audition, and resets the look and feel to nullptr.
  */
 SampleAudioProcessorEditor::~SampleAudioProcessorEditor()
 {
+    // Nobody looks at the spectra and loudness any more, so the audio thread can stop copying and filtering
+    for (int source = 0; source <= SampleAudioProcessor::masterSpectrumSource; ++source)
+        audioProcessor.getSpectrumAnalyser().setEnabled(source, false);
+
+    for (int i = 0; i < NUM_SAMPLES; ++i)
+        audioProcessor.getTrackMeter(i).setLoudnessEnabled(false);
+
+    audioProcessor.getMasterMeter().setLoudnessEnabled(false);
+    audioProcessor.stopAudition();
+
     setLookAndFeel(nullptr);
 }
 
 /**
  * Paints the GUI components of the SampleAudioProcessorEditor.
  *
- * This function fills the background with the default LookAndFeel colour.
- * If the step sequencer group is visible, it calculates the current step position
- * and paints a semi-transparent yellow rectangle over the active step column.
+ * This function fills the background with the default LookAndFeel colour. The playhead is drawn
+ * by the step grid, so a step change does not repaint the editor.
  *
  * @param g Reference to the graphics context used for rendering the GUI.
  */
 void SampleAudioProcessorEditor::paint (juce::Graphics& g)
 {
-    g.fillAll(getLookAndFeel().findColour(juce::ResizableWindow::backgroundColourId));
-
-    if (stepSequencerGroup.isVisible())
-    {
-        auto sequencerArea = stepSequencerGroup.getBounds();
-        auto sequencerContentBounds = sequencerArea.reduced(10);
-        auto labelHeight = 20;
-        sequencerContentBounds.removeFromTop(labelHeight);
-
-        int stepWidth = sequencerContentBounds.getWidth() / NUM_STEPS;
-        int trackHeight = sequencerContentBounds.getHeight() / NUM_TRACKS;
-
-        auto absX = sequencerContentBounds.getX() + (currentStep * stepWidth);
-        auto absY = sequencerContentBounds.getY();
+    AUDIOPLUGIN_TRACE_ZONE("editor paint")
 
-        g.setColour(juce::Colours::yellow.withAlpha(0.8f));
-        g.fillRect(absX, absY, stepWidth, NUM_TRACKS * trackHeight);
-    }
+    g.fillAll(getLookAndFeel().findColour(juce::ResizableWindow::backgroundColourId));
 }
 
 
@@ -377,6 +498,7 @@ void SampleAudioProcessorEditor::paint (juce::Graphics& g)
  * individual control group, including gain, filters, bitcrusher and ADSR.
  *
  * Layout Overview:
+ * - Right edge: the sample library browser, while it is shown.
  * - Top area: step sequencer and global BPM control.
  * - Remaining vertical space: per-sample control sections.
  *
@@ -387,12 +509,17 @@ void SampleAudioProcessorEditor::paint (juce::Graphics& g)
  */
 void SampleAudioProcessorEditor::resized()
 {
+    AUDIOPLUGIN_TRACE_ZONE("editor resized")
+
     auto bounds = getLocalBounds().reduced(10);
 
     int knobSize = 60;
     int spacing = 5;
     int stepSeqHeight = 300;
 
+    if (sampleBrowser.isVisible())
+        sampleBrowser.setBounds(bounds.removeFromRight(SampleBrowser::preferredWidth).withTrimmedLeft(10));
+
     /**
      * @brief Layout for the step sequencer and BPM controls.
      */
@@ -400,6 +527,20 @@ void SampleAudioProcessorEditor::resized()
 
     int bpmWidth = 120;
     auto bpmArea = topArea.removeFromRight(bpmWidth);
+
+    int performanceWidth = 240;
+    auto performanceArea = topArea.removeFromRight(performanceWidth).reduced(5, 10);
+    performancePanel.setBounds(performanceArea.removeFromTop(150));
+
+    auto historyArea = performanceArea.removeFromTop(40).withTrimmedTop(10);
+    const int historyButtonWidth = historyArea.getWidth() / 3;
+    undoButton.setBounds(historyArea.removeFromLeft(historyButtonWidth).withTrimmedRight(spacing));
+    redoButton.setBounds(historyArea.removeFromLeft(historyButtonWidth).withTrimmedRight(spacing));
+    libraryButton.setBounds(historyArea);
+
+    masterSpectrumButton.setBounds(performanceArea.removeFromTop(30).withTrimmedTop(8));
+    masterSpectrumView.setBounds(performanceArea.withTrimmedTop(spacing));
+
     auto stepSequencerArea = topArea;
 
     stepSequencerGroup.setBounds(stepSequencerArea);
@@ -407,10 +548,11 @@ void SampleAudioProcessorEditor::resized()
     auto bpmSliderHeight = 250;
 
     globalBpmLabel.setBounds(bpmArea.removeFromTop(bpmLabelHeight).reduced(5));
+    masterMeterView.setBounds(bpmArea.removeFromRight(50).withSizeKeepingCentre(50, bpmSliderHeight));
     globalBpmSlider.setBounds(bpmArea.withSizeKeepingCentre(60, bpmSliderHeight));
 
     /**
-     * @brief Layout for the step labels and step buttons.
+     * @brief Layout for the step labels and the step grid.
      */
     auto sequencerContentBounds = stepSequencerGroup.getBounds().reduced(10);
     auto labelsArea = sequencerContentBounds.removeFromTop(20);
@@ -426,20 +568,8 @@ void SampleAudioProcessorEditor::resized()
                                    labelsArea.getHeight());
     }
 
-    for (int track = 0; track < NUM_TRACKS; ++track)
-    {
-        for (int step = 0; step < NUM_STEPS; ++step)
-        {
-            auto x = sequencerContentBounds.getX() + step * stepWidth;
-            auto y = sequencerContentBounds.getY() + track * trackHeight;
-            stepButtons[track][step].setBounds(x, y, stepWidth, trackHeight);
-        }
-    }
-
-    /**
-     * @brief Initializes the step highlight overlay with zero size.
-     */
-    stepHighlightOverlay.setBounds(0, 0, 0, 0);
+    stepGrid.setBounds(sequencerContentBounds.getX(), sequencerContentBounds.getY(),
+                       NUM_STEPS * stepWidth, NUM_TRACKS * trackHeight);
 
     /**
      * @brief Layout for each sample control group.
@@ -451,7 +581,7 @@ void SampleAudioProcessorEditor::resized()
     for (int i = 0; i < NUM_SAMPLES; ++i)
     {
         auto groupBounds = controlsArea.removeFromTop(groupHeight)
-            .withTrimmedRight(500)
+            .withTrimmedRight(20)
             .withTrimmedTop(5)
             .withTrimmedBottom(5);
         sampleControlGroups[i].setBounds(groupBounds);
@@ -459,13 +589,26 @@ void SampleAudioProcessorEditor::resized()
         auto contentArea = groupBounds.reduced(10);
 
         /**
-         * @brief Sample Load and Play buttons
+         * @brief Waveform overview
+         */
+        waveformViews[i].setBounds(contentArea.removeFromRight(460).withTrimmedTop(10));
+        spectrumViews[i].setBounds(waveformViews[i].getBounds());
+        contentArea.removeFromRight(spacing * 2);
+
+        /**
+         * @brief Sample Load, Play, Slice, Freeze and FFT buttons
          */
         auto sampleControlsLeft = contentArea.removeFromLeft(knobSize * 2 + spacing * 2);
         sampleControlsLeft.removeFromTop(15);
-        loadSampleButtons[i].setBounds(sampleControlsLeft.removeFromTop(30).withSizeKeepingCentre(knobSize, 25));
+        loadSampleButtons[i].setBounds(sampleControlsLeft.removeFromTop(25).withSizeKeepingCentre(knobSize, 22));
         sampleControlsLeft.removeFromTop(spacing);
-        playSampleButtons[i].setBounds(sampleControlsLeft.removeFromTop(30).withSizeKeepingCentre(knobSize, 25));
+        auto playRow = sampleControlsLeft.removeFromTop(25);
+        playSampleButtons[i].setBounds(playRow.removeFromLeft(playRow.getWidth() / 2).withSizeKeepingCentre(knobSize, 22));
+        sliceToggleButtons[i].setBounds(playRow.withSizeKeepingCentre(knobSize, 22));
+        sampleControlsLeft.removeFromTop(spacing);
+        auto toggleRow = sampleControlsLeft.removeFromTop(25);
+        freezeToggleButtons[i].setBounds(toggleRow.removeFromLeft(toggleRow.getWidth() / 2).withSizeKeepingCentre(knobSize, 22));
+        spectrumToggleButtons[i].setBounds(toggleRow.withSizeKeepingCentre(knobSize, 22));
 
         /**
          * @brief Gain control
@@ -474,6 +617,16 @@ void SampleAudioProcessorEditor::resized()
         auto gainArea = contentArea.removeFromLeft(knobSize);
         gainLabels[i].setBounds(gainArea.removeFromTop(20));
         gainSliders[i].setBounds(gainArea);
+        gainMeters[i].setBounds(contentArea.removeFromLeft(8).withTrimmedTop(20));
+        contentArea.removeFromLeft(spacing * 2);
+
+        /**
+         * @brief Pitch control and interpolation kernel
+         */
+        auto pitchArea = contentArea.removeFromLeft(knobSize + spacing * 2);
+        pitchLabels[i].setBounds(pitchArea.removeFromTop(20));
+        interpolationSelectors[i].setBounds(pitchArea.removeFromBottom(20));
+        pitchSliders[i].setBounds(pitchArea);
         contentArea.removeFromLeft(spacing * 2);
 
         /**
@@ -524,28 +677,257 @@ void SampleAudioProcessorEditor::resized()
 
 
 /**
- * @brief Updates the step sequencer highlight overlay based on the current playback step.
+ * @brief Refreshes the timing display and the waveforms of newly loaded samples, rereads the controls
+ * after a restore, enables the undo buttons and shows new library entries in the browser.
  */
 void SampleAudioProcessorEditor::timerCallback()
 {
-    currentStep = audioProcessor.getCurrentStep();
+    AUDIOPLUGIN_TRACE_ZONE("editor timerCallback")
+
+    performancePanel.setSnapshot(audioProcessor.getTelemetry().collect());
+
+    for (int i = 0; i < NUM_SAMPLES; ++i)
+    {
+        if (auto waveform = audioProcessor.getSampleWaveform(i); waveform != waveformViews[i].getPeaks())
+            waveformViews[i].setPeaks(std::move(waveform));
+
+        if (auto slices = audioProcessor.getSampleSlices(i); slices != waveformViews[i].getSlices())
+            waveformViews[i].setSlices(std::move(slices));
+    }
+
+    if (const auto restoreCount = audioProcessor.getStateRestoreCount(); restoreCount != lastStateRestoreCount)
+    {
+        lastStateRestoreCount = restoreCount;
+        refreshControls();
+    }
+
+    undoButton.setEnabled(audioProcessor.canUndo());
+    redoButton.setEnabled(audioProcessor.canRedo());
+
+    if (sampleBrowser.isVisible())
+        sampleBrowser.update();
+}
+
+
+void SampleAudioProcessorEditor::setBrowserShown(bool shouldBeShown)
+{
+    if (shouldBeShown == sampleBrowser.isVisible())
+        return;
+
+    if (! shouldBeShown)
+        audioProcessor.stopAudition();
+
+    sampleBrowser.setVisible(shouldBeShown);
+    setSize(getWidth() + (shouldBeShown ? 1 : -1) * (SampleBrowser::preferredWidth + 10), getHeight());
+
+    if (shouldBeShown)
+        sampleBrowser.update();
+}
+
+
+/**
+ * @brief Shows the step that is sounding now.
+ *
+ * The audio thread publishes a step together with the time it starts, which can lie up to a block
+ * ahead of the moment it was rendered. Before that time the previous step is still sounding; once a
+ * whole step has passed without a new one the next block is late and the next step is shown. Beyond
+ * that playback is assumed to have stopped and the last published step stays. The grid repaints only
+ * when the step changes, and each waveform only when its playhead moves by a pixel.
+ */
+void SampleAudioProcessorEditor::updatePlayhead()
+{
+    const auto position = audioProcessor.getPlayheadPosition();
+    int step = position.step;
+
+    if (position.startMs > 0.0 && position.stepMs > 0.0)
+    {
+        const double elapsedMs = juce::Time::getMillisecondCounterHiRes() - position.startMs;
+
+        if (elapsedMs < 0.0)
+            step += NUM_STEPS - 1;
+        else if (elapsedMs >= position.stepMs && elapsedMs < 2.0 * position.stepMs)
+            ++step;
+    }
+
+    stepGrid.setPlayheadStep(step % NUM_STEPS);
+
+    for (int i = 0; i < NUM_SAMPLES; ++i)
+        waveformViews[i].setPlayhead(audioProcessor.getPlayheadFrame(i));
+}
+
+
+/**
+ * @brief Reads the spectra of the visible analysers. A track's filter response is recomputed with each
+ * new spectrum, so it follows knob changes at the analysis rate without a listener on every knob.
+ */
+void SampleAudioProcessorEditor::updateSpectra()
+{
+    auto& analyser = audioProcessor.getSpectrumAnalyser();
+    const double sampleRate = analyser.getSampleRate();
+
+    for (int i = 0; i < NUM_SAMPLES; ++i)
+    {
+        if (! spectrumViews[i].isVisible() || ! analyser.readSpectrum(i, spectrumVersions[(size_t) i], spectrumScratch))
+            continue;
+
+        spectrumViews[i].setSpectrum(spectrumScratch, sampleRate);
+
+        const auto& frequencies = spectrumViews[i].getColumnFrequencies();
+        std::vector<float> response(frequencies.size());
+        audioProcessor.getFilterResponse(i, frequencies.data(), response.data(), (int) frequencies.size());
+        spectrumViews[i].setResponse(std::move(response));
+    }
+
+    if (masterSpectrumView.isVisible()
+            && analyser.readSpectrum(SampleAudioProcessor::masterSpectrumSource, spectrumVersions[NUM_SAMPLES], spectrumScratch))
+        masterSpectrumView.setSpectrum(spectrumScratch, sampleRate);
+}
+
+
+void SampleAudioProcessorEditor::updateMeters()
+{
+    for (int i = 0; i < NUM_SAMPLES; ++i)
+        gainMeters[i].setReading(audioProcessor.getTrackMeter(i).getReading());
+
+    masterMeterView.setReading(audioProcessor.getMasterMeter().getReading());
+}
+
+
+void SampleAudioProcessorEditor::setSpectrumShown(int track, bool shouldBeShown)
+{
+    audioProcessor.getSpectrumAnalyser().setEnabled(track, shouldBeShown);
+    spectrumViews[track].setVisible(shouldBeShown);
+    waveformViews[track].setVisible(! shouldBeShown);
+}
+
+
+bool SampleAudioProcessorEditor::keyPressed(const juce::KeyPress& key)
+{
+    const auto modifiers = key.getModifiers();
+
+    if (! modifiers.isCommandDown() || modifiers.isAltDown())
+        return false;
+
+    const auto keyCode = juce::CharacterFunctions::toLowerCase((juce::juce_wchar) key.getKeyCode());
+
+    if (keyCode == 'z')
+    {
+        if (modifiers.isShiftDown())
+            audioProcessor.redo();
+        else
+            audioProcessor.undo();
+
+        return true;
+    }
+
+    if (keyCode == 'y')
+    {
+        audioProcessor.redo();
+        return true;
+    }
+
+    return false;
+}
+
+
+/**
+ * @brief Sets every toggle, knob, step and ADSR editor to the processor's values without notifying
+ * their callbacks, so nothing is written back or recorded.
+ */
+void SampleAudioProcessorEditor::refreshControls()
+{
+    for (int i = 0; i < NUM_SAMPLES; ++i)
+    {
+        playSampleButtons[i].setToggleState(audioProcessor.isSamplePlaying[i], juce::dontSendNotification);
+        updatePlayButton(i);
+        freezeToggleButtons[i].setToggleState(audioProcessor.isTrackFrozen(i), juce::dontSendNotification);
+        sliceToggleButtons[i].setToggleState(audioProcessor.getSlicePlayback(i), juce::dontSendNotification);
+
+        lpfToggleButtons[i].setToggleState(audioProcessor.getFilterEnabled(i), juce::dontSendNotification);
+        lpfCutoffSliders[i].setValue(audioProcessor.getFilterCutoff(i), juce::dontSendNotification);
+        highpassToggleButtons[i].setToggleState(audioProcessor.getHighpassEnabled(i), juce::dontSendNotification);
+        highpassCutoffSliders[i].setValue(audioProcessor.getHighpassCutoff(i), juce::dontSendNotification);
+        bandpassToggleButtons[i].setToggleState(audioProcessor.getBandPassEnabled(i), juce::dontSendNotification);
+        bandpassCutoffSliders[i].setValue(audioProcessor.getBandPassCutoff(i), juce::dontSendNotification);
+        bandpassBandwidthSliders[i].setValue(audioProcessor.getBandPassBandwidth(i), juce::dontSendNotification);
+        notchToggleButtons[i].setToggleState(audioProcessor.getNotchEnabled(i), juce::dontSendNotification);
+        notchCutoffSliders[i].setValue(audioProcessor.getNotchCutoff(i), juce::dontSendNotification);
+        notchBandwidthSliders[i].setValue(audioProcessor.getNotchBandwidth(i), juce::dontSendNotification);
+        peakToggleButtons[i].setToggleState(audioProcessor.getPeakEnabled(i), juce::dontSendNotification);
+        peakCutoffSliders[i].setValue(audioProcessor.getPeakCutoff(i), juce::dontSendNotification);
+        peakGainSliders[i].setValue(audioProcessor.getPeakGain(i), juce::dontSendNotification);
+        peakQSliders[i].setValue(audioProcessor.getPeakQ(i), juce::dontSendNotification);
+        bitcrusherToggleButtons[i].setToggleState(audioProcessor.getBitcrusherEnabled(i), juce::dontSendNotification);
+        bitDepthSliders[i].setValue(audioProcessor.getBitDepth(i), juce::dontSendNotification);
+        downsampleRateSliders[i].setValue(audioProcessor.getDownsampleRate(i), juce::dontSendNotification);
+        gainSliders[i].setValue(audioProcessor.getGainLevel(i), juce::dontSendNotification);
+        pitchSliders[i].setValue(audioProcessor.getPitch(i), juce::dontSendNotification);
+        interpolationSelectors[i].setSelectedId(1 + (int) audioProcessor.getInterpolation(i), juce::dontSendNotification);
+
+        adsrEditors[i]->setAdsr(audioProcessor.getAdsrAttack(i), audioProcessor.getAdsrDecay(i),
+                                audioProcessor.getAdsrSustain(i), audioProcessor.getAdsrRelease(i));
+    }
+
+    for (int track = 0; track < NUM_TRACKS; ++track)
+    {
+        stepGrid.setSteps(track, audioProcessor.getStepPattern(track));
+        updateStepLockMarkers(track);
+    }
+
+    globalBpmSlider.setValue(audioProcessor.getGlobalBpm(), juce::dontSendNotification);
+}
+
+
+void SampleAudioProcessorEditor::updatePlayButton(int i)
+{
+    const bool isPlaying = playSampleButtons[i].getToggleState();
+
+    playSampleButtons[i].setButtonText(isPlaying ? "pause" : "play");
+    playSampleButtons[i].setColour(juce::TextButton::buttonColourId,
+                                   isPlaying ? juce::Colours::green : juce::Colours::darkgrey);
+}
+
+/**
+ * @brief Opens a call-out with the parameter locks of a step. Targets without a lock start from the
+ * track's current value.
+ *
+ * @param track Track index.
+ * @param step Step index.
+ */
+void SampleAudioProcessorEditor::showStepLockEditor(int track, int step)
+{
+    std::array<float, ParameterLock::numTargets> defaults {};
+    defaults[ParameterLock::cutoff]   = 1000.0f;
+    defaults[ParameterLock::peakGain] = (float) peakGainSliders[track].getValue();
+    defaults[ParameterLock::bitDepth] = (float) bitDepthSliders[track].getValue();
+    defaults[ParameterLock::gain]     = audioProcessor.getGainLevel(track);
+    defaults[ParameterLock::attack]   = audioProcessor.getAdsrAttack(track);
+    defaults[ParameterLock::decay]    = audioProcessor.getAdsrDecay(track);
+    defaults[ParameterLock::release]  = audioProcessor.getAdsrRelease(track);
+    defaults[ParameterLock::slice]    = (float) step;
+    defaults[ParameterLock::pitch]    = audioProcessor.getPitch(track);
+
+    auto editor = std::make_unique<StepLockEditor>(audioProcessor.getStepLock(track, step), defaults);
+    editor->onLockChanged = [this, track, step](ParameterLock::Target target, bool enabled, float value)
+    {
+        if (enabled)
+            audioProcessor.setStepLock(track, step, target, value);
+        else
+            audioProcessor.clearStepLock(track, step, target);
 
-    auto sequencerArea = stepSequencerGroup.getBounds().reduced(10);
-    auto labelHeight = 20;
-    sequencerArea.removeFromTop(labelHeight);
+        updateStepLockMarkers(track);
+    };
 
-    int stepWidth = sequencerArea.getWidth() / NUM_STEPS;
-    int trackHeight = sequencerArea.getHeight() / NUM_TRACKS;
+    juce::CallOutBox::launchAsynchronously(std::move(editor), stepGrid.localAreaToGlobal(stepGrid.getCellBounds(track, step)), nullptr);
+}
 
-    int x = sequencerArea.getX() + currentStep * stepWidth;
-    int y = sequencerArea.getY();
-    int width = stepWidth;
-    int height = NUM_TRACKS * trackHeight;
 
-    stepHighlightOverlay.setBounds(x, y, width, height);
-    stepHighlightOverlay.repaint();
+void SampleAudioProcessorEditor::updateStepLockMarkers(int track)
+{
+    stepGrid.setLockedSteps(track, audioProcessor.getLockedSteps(track));
 }
 
+
 /**
  * @brief Handles mutual exclusion logic between toggle buttons for different filter types.
  *
@@ -755,6 +1137,24 @@ void ADSREditorComponent::mouseDown(const juce::MouseEvent& e)
     draggingDecay   = !draggingAttack && isNear(click, { sustainX, sustainY });
     draggingSustain = draggingDecay;
     draggingRelease = !draggingAttack && !draggingDecay && isNear(click, { releaseX, releaseY });
+
+    if ((draggingAttack || draggingDecay || draggingRelease) && onDragStart)
+        onDragStart();
+}
+
+
+/**
+ * @brief Releases the dragged handle and reports the end of the drag.
+ *
+ * @param e The mouse event data (unused).
+ */
+void ADSREditorComponent::mouseUp(const juce::MouseEvent&)
+{
+    const bool wasDragging = draggingAttack || draggingDecay || draggingRelease;
+    draggingAttack = draggingDecay = draggingSustain = draggingRelease = false;
+
+    if (wasDragging && onDragEnd)
+        onDragEnd();
 }
 
 
@@ -857,3 +1257,170 @@ void ADSREditorComponent::drawHandle(juce::Graphics& g, float x, float y)
     g.fillEllipse(x - 4.0f, y - 4.0f, 8.0f, 8.0f);
 }
 
+
+
+namespace
+{
+    /** @brief Last knob drawn for a slider, kept in the slider's properties so it lives as long as the slider. */
+    struct KnobCache : public juce::ReferenceCountedObject
+    {
+        juce::Image image;
+        int width = 0;
+        int height = 0;
+        float scale = 0.0f;
+        float angle = 0.0f;
+        bool isHighlighted = false;
+    };
+
+    const juce::Identifier knobCacheId { "knobCache" };
+
+    const juce::Colour knobBodyColour { 0xff333333 };
+
+    /** @brief Area of the knob inside the slider's area. */
+    juce::Rectangle<float> getKnobBounds(int width, int height)
+    {
+        return juce::Rectangle<float>(0.0f, 0.0f, (float) width, (float) height).reduced(10);
+    }
+
+    /** @brief Creates an image for a knob at a display scale, with the scale applied to its graphics. */
+    juce::Image createKnobImage(int width, int height, float scale)
+    {
+        return juce::Image(juce::Image::ARGB, juce::jmax(1, juce::roundToInt((float) width * scale)),
+                           juce::jmax(1, juce::roundToInt((float) height * scale)), true);
+    }
+
+    /** @brief Draws an image rendered at a display scale into a graphics context at logical coordinates. */
+    void drawKnobImage(juce::Graphics& g, const juce::Image& image, float scale, int x, int y)
+    {
+        if (scale == 1.0f)
+            g.drawImageAt(image, x, y);
+        else
+            g.drawImageTransformed(image, juce::AffineTransform::scale(1.0f / scale).translated((float) x, (float) y));
+    }
+}
+
+
+void CustomLookAndFeel::drawRotarySlider(juce::Graphics& g, int x, int y, int width, int height, float sliderPos,
+                                         const float rotaryStartAngle, const float rotaryEndAngle, juce::Slider& slider)
+{
+    const float scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+    const float angle = rotaryStartAngle + sliderPos * (rotaryEndAngle - rotaryStartAngle);
+    const bool isHighlighted = slider.isMouseOverOrDragging();
+
+    auto* cache = dynamic_cast<KnobCache*>(slider.getProperties()[knobCacheId].getObject());
+
+    if (cache == nullptr)
+    {
+        cache = new KnobCache();
+        slider.getProperties().set(knobCacheId, juce::var(cache));
+    }
+
+    if (cache->image.isNull() || cache->width != width || cache->height != height || cache->scale != scale
+            || cache->angle != angle || cache->isHighlighted != isHighlighted)
+    {
+        AUDIOPLUGIN_TRACE_ZONE("knob render")
+
+        const auto& layers = getKnobLayers(width, height, scale, rotaryStartAngle, rotaryEndAngle);
+        const auto bounds = getKnobBounds(width, height);
+        const auto radius = juce::jmin(bounds.getWidth(), bounds.getHeight()) / 2.0f;
+
+        cache->image = createKnobImage(width, height, scale);
+        cache->width = width;
+        cache->height = height;
+        cache->scale = scale;
+        cache->angle = angle;
+        cache->isHighlighted = isHighlighted;
+
+        juce::Graphics knob(cache->image);
+        knob.drawImageAt(layers.below, 0, 0);
+
+        {
+            const juce::Graphics::ScopedSaveState state(knob);
+            knob.addTransform(juce::AffineTransform::scale(scale));
+
+            juce::Path valueArc;
+            float arcThickness = 0.15f;
+            valueArc.addPieSegment(bounds, rotaryStartAngle, angle, 1.0f - arcThickness);
+            knob.setColour(isHighlighted ? juce::Colours::deepskyblue.brighter() : juce::Colours::deepskyblue);
+            knob.fillPath(valueArc);
+
+            juce::Path p;
+            auto pointerLength = radius * 0.9f;
+            auto pointerThickness = 3.0f;
+            p.addRectangle(-pointerThickness * 0.5f, -radius, pointerThickness, pointerLength);
+            p.applyTransform(juce::AffineTransform::rotation(angle).translated(bounds.getCentreX(), bounds.getCentreY()));
+            knob.setColour(juce::Colours::whitesmoke);
+            knob.fillPath(p);
+        }
+
+        knob.drawImageAt(layers.above, 0, 0);
+    }
+
+    drawKnobImage(g, cache->image, scale, x, y);
+}
+
+
+/**
+ * @brief Returns the static layers of a knob, rendering them the first time a size, scale and rotary
+ * range is drawn.
+ */
+const CustomLookAndFeel::KnobLayers& CustomLookAndFeel::getKnobLayers(int width, int height, float scale,
+                                                                     float startAngle, float endAngle)
+{
+    for (const auto& layers : knobLayers)
+        if (layers.width == width && layers.height == height && layers.scale == scale
+                && layers.startAngle == startAngle && layers.endAngle == endAngle)
+            return layers;
+
+    AUDIOPLUGIN_TRACE_ZONE("knob layers")
+
+    KnobLayers layers;
+    layers.width = width;
+    layers.height = height;
+    layers.scale = scale;
+    layers.startAngle = startAngle;
+    layers.endAngle = endAngle;
+    layers.below = createKnobImage(width, height, scale);
+    layers.above = createKnobImage(width, height, scale);
+
+    const auto bounds = getKnobBounds(width, height);
+    const auto radius = juce::jmin(bounds.getWidth(), bounds.getHeight()) / 2.0f;
+    const auto centreX = bounds.getCentreX();
+    const auto centreY = bounds.getCentreY();
+
+    {
+        juce::Graphics g(layers.below);
+        g.addTransform(juce::AffineTransform::scale(scale));
+
+        g.setColour(juce::Colours::black.withAlpha(0.4f));
+        g.fillEllipse(bounds.translated(1.0f, 2.0f));
+
+        juce::ColourGradient gradient(knobBodyColour.brighter(0.1f), bounds.getTopLeft(), knobBodyColour.darker(0.1f), bounds.getBottomLeft(), false);
+        g.setGradientFill(gradient);
+        g.fillEllipse(bounds);
+        g.setColour(juce::Colours::black.withAlpha(0.8f));
+        g.drawEllipse(bounds, 1.5f);
+    }
+
+    {
+        juce::Graphics g(layers.above);
+        g.addTransform(juce::AffineTransform::scale(scale));
+
+        g.setColour(knobBodyColour.brighter(0.2f));
+        g.fillEllipse(centreX - 4, centreY - 4, 8, 8);
+
+        g.setColour(juce::Colours::grey);
+        for (int i = 0; i < 11; ++i)
+        {
+            float proportion = i / 10.0f;
+            float tickAngle = startAngle + proportion * (endAngle - startAngle);
+            juce::Path tick;
+            tick.addRectangle(0.0f, -radius * 1.05f, 1.5f, radius * 0.1f);
+            tick.applyTransform(juce::AffineTransform::rotation(tickAngle).translated(centreX, centreY));
+            g.fillPath(tick);
+        }
+    }
+
+    knobLayers.push_back(std::move(layers));
+    return knobLayers.back();
+}
@@ -6,6 +6,11 @@
 #include <juce_core/juce_core.h>
 
 #include "PluginProcessor.h"
+#include "StepGrid.h"
+#include "WaveformView.h"
+#include "SpectrumView.h"
+#include "LevelMeterView.h"
+#include "SampleBrowser.h"
 
 
 static constexpr int NUM_TRACKS = SampleAudioProcessor::NUM_SAMPLES;
@@ -38,6 +43,9 @@ public:
     /** @brief Handles dragging of ADSR handles. */
     void mouseDrag(const juce::MouseEvent& e) override;
 
+    /** @brief Ends a handle drag. */
+    void mouseUp(const juce::MouseEvent& e) override;
+
     /**
      * @brief Callback triggered when ADSR values change.
      * @param attack New attack value.
@@ -47,6 +55,9 @@ public:
      */
     std::function<void(double attack, double decay, double sustain, double release)> onAdsrChanged;
 
+    /** @brief Called when a handle is grabbed and when it is released. */
+    std::function<void()> onDragStart, onDragEnd;
+
 private:
     /** @brief Current ADSR values. */
     double attack = 0.1, decay = 0.1, sustain = 0.8, release = 0.2;
@@ -80,6 +91,11 @@ public:
 
     /**
      * @brief Draws a custom rotary slider with tick marks and visual feedback.
+     *
+     * Shadow, body, centre and ticks come from layers rendered once per knob size, display scale and
+     * rotary range. Each slider keeps the knob it was last drawn with and renders it again, from those
+     * layers plus its value arc and pointer, only when its angle, hover state, size or scale changed.
+     *
      * @param g Graphics context.
      * @param x X coordinate of the slider.
      * @param y Y coordinate of the slider.
@@ -91,116 +107,246 @@ public:
      * @param slider Reference to the slider.
      */
     void drawRotarySlider(juce::Graphics& g, int x, int y, int width, int height, float sliderPos,
-                          const float rotaryStartAngle, const float rotaryEndAngle, juce::Slider& slider) override
+                          const float rotaryStartAngle, const float rotaryEndAngle, juce::Slider& slider) override;
+
+private:
+    /* @brief Static layers of a knob: below the value arc (shadow, body, outline) and above it (centre, ticks). */
+    struct KnobLayers
     {
-        auto bounds = juce::Rectangle<float>(x, y, width, height).reduced(10);
-        auto radius = juce::jmin(bounds.getWidth(), bounds.getHeight()) / 2.0f;
-        auto centreX = bounds.getCentreX();
-        auto centreY = bounds.getCentreY();
-        auto angle = rotaryStartAngle + sliderPos * (rotaryEndAngle - rotaryStartAngle);
-
-        auto knobBodyColour = juce::Colour(0xff333333);
-        auto arcColour = slider.isMouseOverOrDragging() ? juce::Colours::deepskyblue.brighter() : juce::Colours::deepskyblue;
-        auto pointerColour = juce::Colours::whitesmoke;
-        auto shadowColour = juce::Colours::black.withAlpha(0.4f);
-
-        auto shadowBounds = bounds.translated(1.0f, 2.0f);
-        g.setColour(shadowColour);
-        g.fillEllipse(shadowBounds);
-
-        juce::ColourGradient gradient(knobBodyColour.brighter(0.1f), bounds.getTopLeft(), knobBodyColour.darker(0.1f), bounds.getBottomLeft(), false);
-        g.setGradientFill(gradient);
-        g.fillEllipse(bounds);
-        g.setColour(juce::Colours::black.withAlpha(0.8f));
-        g.drawEllipse(bounds, 1.5f);
-
-        juce::Path valueArc;
-        float arcThickness = 0.15f;
-        valueArc.addPieSegment(bounds, rotaryStartAngle, angle, 1.0f - arcThickness);
-        g.setColour(arcColour);
-        g.fillPath(valueArc);
-
-        juce::Path p;
-        auto pointerLength = radius * 0.9f;
-        auto pointerThickness = 3.0f;
-        p.addRectangle(-pointerThickness * 0.5f, -radius, pointerThickness, pointerLength);
-        p.applyTransform(juce::AffineTransform::rotation(angle).translated(centreX, centreY));
-        g.setColour(pointerColour);
-        g.fillPath(p);
-
-        g.setColour(knobBodyColour.brighter(0.2f));
-        g.fillEllipse(centreX - 4, centreY - 4, 8, 8);
-
-        g.setColour(juce::Colours::grey);
-        for (int i = 0; i < 11; ++i)
-        {
-            float proportion = i / 10.0f;
-            float tickAngle = rotaryStartAngle + proportion * (rotaryEndAngle - rotaryStartAngle);
-            juce::Path tick;
-            tick.addRectangle(0.0f, -radius * 1.05f, 1.5f, radius * 0.1f);
-            tick.applyTransform(juce::AffineTransform::rotation(tickAngle).translated(centreX, centreY));
-            g.fillPath(tick);
-        }
-    }
+        int width = 0;
+        int height = 0;
+        float scale = 0.0f;
+        float startAngle = 0.0f;
+        float endAngle = 0.0f;
+        juce::Image below, above;
+    };
+
+    /* @brief Layers for each knob size, scale and rotary range drawn so far. */
+    std::vector<KnobLayers> knobLayers;
+
+    /** @brief Returns the layers for a knob, rendering them on first use. */
+    const KnobLayers& getKnobLayers(int width, int height, float scale, float startAngle, float endAngle);
 };
 
 
 
-/** @class StepButton
-*  @brief Custom toggleable button used in the step sequencer.
-*/
-class StepButton : public juce::Button
+/** @class StepLockEditor
+ *  @brief Call-out content for editing the parameter locks of one sequencer step.
+ *
+ *  Each lockable parameter has a toggle that enables the override and a slider for its value.
+ */
+class StepLockEditor : public juce::Component
 {
 public:
-    /** @brief Constructor for the StepButton. */
-    StepButton() : juce::Button("Step") {}
-
+    /** @brief Callback when a lock is enabled, changed or disabled. */
+    std::function<void(ParameterLock::Target, bool enabled, float value)> onLockChanged;
 
     /**
-     * @brief Paints the button based on its toggle state and interaction.
-     * @param g Graphics context.
-     * @param shouldDrawButtonAsHighlighted Whether the button is highlighted.
-     * @param shouldDrawButtonAsDown Whether the button is pressed down.
+     * @brief Creates the rows for all lock targets.
+     * @param lock Current locks of the step.
+     * @param defaults Values a target starts from when it is enabled, indexed by target.
      */
-    void paintButton(juce::Graphics& g, bool shouldDrawButtonAsHighlighted, bool shouldDrawButtonAsDown) override
+    StepLockEditor(const ParameterLock& lock, const std::array<float, ParameterLock::numTargets>& defaults)
     {
-        auto bounds = getLocalBounds().toFloat();
-        auto cornerSize = 4.0f;
+        for (int target = 0; target < ParameterLock::numTargets; ++target)
+        {
+            const auto t = static_cast<ParameterLock::Target>(target);
+            auto& row = rows[(size_t) target];
+
+            row.toggle.setButtonText(getLabel(t));
+            row.toggle.setToggleState(lock.has(t), juce::dontSendNotification);
+            addAndMakeVisible(row.toggle);
+
+            configureSlider(row.slider, t);
+            row.slider.setValue(lock.has(t) ? lock.get(t) : defaults[(size_t) target], juce::dontSendNotification);
+            row.slider.setEnabled(lock.has(t));
+            addAndMakeVisible(row.slider);
+
+            row.toggle.onClick = [this, t, &row]
+            {
+                row.slider.setEnabled(row.toggle.getToggleState());
+                notify(t);
+            };
+            row.slider.onValueChange = [this, t] { notify(t); };
+        }
 
-        auto baseColour = getToggleState() ? juce::Colours::orange : juce::Colours::darkgrey.darker();
-        if (shouldDrawButtonAsDown)
-            baseColour = baseColour.darker();
+        setSize(300, rowHeight * ParameterLock::numTargets + 8);
+    }
 
-        g.setColour(baseColour);
-        g.fillRoundedRectangle(bounds, cornerSize);
+    /** @brief Lays out one row per target. */
+    void resized() override
+    {
+        auto area = getLocalBounds().reduced(4);
 
-        if (getToggleState())
+        for (auto& row : rows)
         {
-            g.setGradientFill(juce::ColourGradient(juce::Colours::white.withAlpha(0.3f), bounds.getCentre(), juce::Colours::white.withAlpha(0.0f), bounds.getBottomRight(), false));
-            g.fillRoundedRectangle(bounds.reduced(1.0f), cornerSize);
+            auto rowArea = area.removeFromTop(rowHeight);
+            row.toggle.setBounds(rowArea.removeFromLeft(90));
+            row.slider.setBounds(rowArea);
         }
+    }
+
+private:
+    static constexpr int rowHeight = 26;
+
+    /* @brief Controls of one lock target. */
+    struct Row
+    {
+        juce::ToggleButton toggle;
+        juce::Slider slider;
+    };
+
+    std::array<Row, ParameterLock::numTargets> rows;
 
-        g.setColour(juce::Colours::black.withAlpha(0.8f));
-        g.drawRoundedRectangle(bounds, cornerSize, 1.5f);
+    /* @brief Reports the current state of a row. */
+    void notify(ParameterLock::Target target)
+    {
+        const auto& row = rows[(size_t) target];
+
+        if (onLockChanged)
+            onLockChanged(target, row.toggle.getToggleState(), (float) row.slider.getValue());
+    }
+
+    static juce::String getLabel(ParameterLock::Target target)
+    {
+        switch (target)
+        {
+            case ParameterLock::cutoff:     return "Cutoff";
+            case ParameterLock::peakGain:   return "Peak Gain";
+            case ParameterLock::bitDepth:   return "Bit Depth";
+            case ParameterLock::gain:       return "Gain";
+            case ParameterLock::attack:     return "Attack";
+            case ParameterLock::decay:      return "Decay";
+            case ParameterLock::release:    return "Release";
+            case ParameterLock::slice:      return "Slice";
+            case ParameterLock::pitch:      return "Pitch";
+            case ParameterLock::numTargets: break;
+        }
+
+        return {};
     }
 
+    /* @brief Uses the same ranges as the track's own controls. */
+    static void configureSlider(juce::Slider& slider, ParameterLock::Target target)
+    {
+        slider.setSliderStyle(juce::Slider::LinearHorizontal);
+        slider.setTextBoxStyle(juce::Slider::TextBoxRight, false, 70, 20);
 
+        switch (target)
+        {
+            case ParameterLock::cutoff:
+                slider.setRange(20.0, 20000.0, 1.0);
+                slider.setSkewFactorFromMidPoint(1000.0);
+                slider.setTextValueSuffix(" Hz");
+                break;
+            case ParameterLock::peakGain:
+                slider.setRange(-24.0, 24.0, 0.1);
+                slider.setTextValueSuffix(" dB");
+                break;
+            case ParameterLock::bitDepth:
+                slider.setRange(1.0, 24.0, 1.0);
+                break;
+            case ParameterLock::gain:
+                slider.setRange(0.0, 2.0, 0.01);
+                break;
+            case ParameterLock::attack:
+            case ParameterLock::decay:
+            case ParameterLock::release:
+                slider.setRange(0.0, 5.0, 0.001);
+                slider.setTextValueSuffix(" s");
+                break;
+            case ParameterLock::slice:
+                slider.setRange(0.0, SliceIndex::maxSlices - 1, 1.0);
+                break;
+            case ParameterLock::pitch:
+                slider.setRange(-SampleAudioProcessor::maxPitch, SampleAudioProcessor::maxPitch, 0.01);
+                slider.setTextValueSuffix(" st");
+                break;
+            case ParameterLock::numTargets:
+                break;
+        }
+    }
 };
 
 
 
-/** @class StepHighlightOverlay
- *  @brief Visual overlay to indicate the currently active step in the sequencer.
+/** @class PerformancePanel
+ *  @brief Compact display of the audio thread timing: DSP load, block time percentiles, overruns and per-track cost.
+ *
+ *  Clicking the panel resets the statistics.
  */
-class StepHighlightOverlay : public juce::Component
+class PerformancePanel : public juce::Component
 {
 public:
-    /** @brief Paints the highlight overlay for the active step. */
+    /** @brief Callback triggered when the user clicks the panel. */
+    std::function<void()> onReset;
+
+    /**
+     * @brief Updates the displayed statistics and repaints.
+     * @param newSnapshot Statistics collected from the processor.
+     */
+    void setSnapshot(const PerformanceTelemetry::Snapshot& newSnapshot)
+    {
+        snapshot = newSnapshot;
+        repaint();
+    }
+
+    /** @brief Paints the statistics text and per-track load bars. */
     void paint(juce::Graphics& g) override
     {
-        g.setColour(juce::Colours::yellow.withAlpha(0.3f));
-        g.fillRect(getLocalBounds());
+        auto bounds = getLocalBounds().toFloat();
+        g.setColour(juce::Colours::black.withAlpha(0.3f));
+        g.fillRoundedRectangle(bounds, 4.0f);
+
+        auto area = getLocalBounds().reduced(8);
+        auto loadColour = snapshot.lastLoad < 0.5f ? juce::Colours::limegreen
+                        : snapshot.lastLoad < 0.9f ? juce::Colours::orange : juce::Colours::red;
+
+        g.setFont(14.0f);
+        g.setColour(loadColour);
+        g.drawText("DSP " + juce::String(snapshot.lastLoad * 100.0f, 1) + " %  (peak "
+                   + juce::String(snapshot.peakLoad * 100.0f, 1) + " %)", area.removeFromTop(18), juce::Justification::left);
+
+        g.setFont(12.0f);
+        g.setColour(juce::Colours::whitesmoke);
+        g.drawText("block p50 " + juce::String(snapshot.p50BlockMicros, 0) + " us  p99 "
+                   + juce::String(snapshot.p99BlockMicros, 0) + " us", area.removeFromTop(16), juce::Justification::left);
+        g.drawText("max " + juce::String(snapshot.maxBlockMicros, 0) + " us  overruns "
+                   + juce::String(snapshot.numOverruns), area.removeFromTop(16), juce::Justification::left);
+
+        area.removeFromTop(6);
+        const int rowHeight = juce::jmin(16, area.getHeight() / SampleAudioProcessor::NUM_SAMPLES);
+
+        for (int i = 0; i < SampleAudioProcessor::NUM_SAMPLES; ++i)
+        {
+            auto row = area.removeFromTop(rowHeight);
+            auto load = snapshot.trackLoad[(size_t) i];
+
+            g.setColour(juce::Colours::grey);
+            g.drawText(juce::String(i + 1), row.removeFromLeft(16), juce::Justification::centredLeft);
+
+            auto valueArea = row.removeFromRight(56);
+            auto bar = row.reduced(2, 3).toFloat();
+            g.setColour(juce::Colours::darkgrey.darker());
+            g.fillRect(bar);
+            g.setColour(juce::Colours::deepskyblue);
+            g.fillRect(bar.withWidth(bar.getWidth() * juce::jlimit(0.0f, 1.0f, load * 4.0f)));
+
+            g.setColour(juce::Colours::whitesmoke);
+            g.drawText(juce::String(load * 100.0f, 2) + " %", valueArea, juce::Justification::centredRight);
+        }
+    }
+
+    /** @brief Resets the statistics on click. */
+    void mouseDown(const juce::MouseEvent&) override
+    {
+        if (onReset)
+            onReset();
     }
+
+private:
+    /** @brief Most recently collected statistics. */
+    PerformanceTelemetry::Snapshot snapshot;
 };
 
 
@@ -230,9 +376,12 @@ public:
     /** @brief Resizes and repositions UI components. */
     void resized() override;
 
-    /** @brief Timer callback used to advance the sequencer step. */
+    /** @brief Timer callback that refreshes the timing display and the undo state. */
     void timerCallback() override;
 
+    /** @brief Handles the undo (Ctrl/Cmd+Z) and redo (Ctrl/Cmd+Shift+Z, Ctrl+Y) shortcuts. */
+    bool keyPressed(const juce::KeyPress& key) override;
+
 
 
 
@@ -244,9 +393,12 @@ private:
     static constexpr int NUM_SAMPLES = 5;
 
 
-    /** @brief Buttons to load and play individual samples. */
+    /** @brief Buttons to load, play, slice, freeze and analyse individual samples. */
     std::array<juce::TextButton, NUM_SAMPLES> loadSampleButtons;
     std::array<juce::TextButton, NUM_SAMPLES> playSampleButtons;
+    std::array<juce::TextButton, NUM_SAMPLES> sliceToggleButtons;
+    std::array<juce::TextButton, NUM_SAMPLES> freezeToggleButtons;
+    std::array<juce::TextButton, NUM_SAMPLES> spectrumToggleButtons;
 
     /** @brief Slider and label for global BPM control. */
     juce::Slider globalBpmSlider;
@@ -255,11 +407,66 @@ private:
     /** @brief File chooser for sample loading. */
     std::unique_ptr<juce::FileChooser> fileChooser;
 
-    /** @brief Grid of step sequencer buttons. */
-    StepButton stepButtons[NUM_TRACKS][NUM_STEPS];
+    /** @brief Step sequencer cells of all tracks. */
+    StepGrid stepGrid { NUM_TRACKS, NUM_STEPS };
+
+    /**
+     * @brief Opens the parameter lock editor of a step next to its cell.
+     * @param track Track index.
+     * @param step Step index.
+     */
+    void showStepLockEditor(int track, int step);
+
+    /** @brief Updates the lock markers of a track's steps. */
+    void updateStepLockMarkers(int track);
 
-    /** @brief Highlight overlay for the current sequencer step. */
-    StepHighlightOverlay stepHighlightOverlay;
+    /**
+     * @brief Moves the grid's playhead to the step that is sounding now, extrapolated from the last step
+     * the audio thread published and when it started, and the waveform playheads to their voices.
+     */
+    void updatePlayhead();
+
+    /**
+     * @brief Shows the spectra the analyser computed since the last call, with the filter response of
+     * each analysed track.
+     */
+    void updateSpectra();
+
+    /** @brief Shows a track's spectrum in place of its waveform, or the waveform again, and enables its analyser source. */
+    void setSpectrumShown(int track, bool shouldBeShown);
+
+    /** @brief Shows the levels the audio thread published for each track and the master. */
+    void updateMeters();
+
+    /** @brief Calls updatePlayhead(), updateSpectra() and updateMeters() once per display refresh. */
+    juce::VBlankAttachment playheadVBlank { this, [this] { updatePlayhead(); updateSpectra(); updateMeters(); } };
+
+    /** @brief Audio thread timing display. */
+    PerformancePanel performancePanel;
+
+    /** @brief Undo and redo buttons below the timing display, next to the library switch. */
+    juce::TextButton undoButton, redoButton;
+
+    /** @brief Sample library shared by all editors, and its browser at the right, shown by the Library button. */
+    juce::SharedResourcePointer<SampleLibrary> sampleLibrary;
+    SampleBrowser sampleBrowser { *sampleLibrary, NUM_SAMPLES };
+    juce::TextButton libraryButton;
+
+    /** @brief Shows or hides the browser, widening the editor by its width, and stops a running audition when hiding it. */
+    void setBrowserShown(bool shouldBeShown);
+
+    /** @brief Master spectrum and its switch below the undo buttons. */
+    juce::TextButton masterSpectrumButton;
+    SpectrumView masterSpectrumView;
+
+    /** @brief Processor restore count the controls were last read at, see refreshControls(). */
+    juce::uint32 lastStateRestoreCount = 0;
+
+    /** @brief Rereads every control from the processor after an undo, redo or state restore. */
+    void refreshControls();
+
+    /** @brief Sets the text and colour of a play button from its toggle state. */
+    void updatePlayButton(int i);
 
     /** @brief Labels above the steps for time indication. */
     std::array<juce::Label, NUM_STEPS> stepLabels;
@@ -267,12 +474,19 @@ private:
     /** @brief Group component containing the sequencer. */
     juce::GroupComponent stepSequencerGroup;
 
-    /** @brief Currently active step index. */
-    int currentStep = 0;
-
     /** @brief Group components wrapping controls for each sample. */
     std::array<juce::GroupComponent, NUM_SAMPLES> sampleControlGroups;
 
+    /** @brief Waveform and playhead of each sample, at the right of its group. */
+    std::array<WaveformView, NUM_SAMPLES> waveformViews;
+
+    /** @brief Spectrum of each sample, shown in place of its waveform while its analyser is on. */
+    std::array<SpectrumView, NUM_SAMPLES> spectrumViews;
+
+    /** @brief Version of the spectrum last shown per analyser source, see SpectrumAnalyser::readSpectrum(). */
+    std::array<juce::uint32, NUM_SAMPLES + 1> spectrumVersions {};
+    std::vector<float> spectrumScratch;
+
     /** @brief Toggle buttons and sliders for filters (LPF, HPF, etc.). */
     juce::TextButton lpfToggleButtons[NUM_SAMPLES];
     juce::Slider lpfCutoffSliders[NUM_SAMPLES];
@@ -294,6 +508,15 @@ private:
     std::array<juce::Slider, NUM_SAMPLES> gainSliders;
     std::array<juce::Label, NUM_SAMPLES> gainLabels;
 
+    /** @brief Pitch knob and interpolation kernel of each sample, next to its gain. */
+    std::array<juce::Slider, NUM_SAMPLES> pitchSliders;
+    std::array<juce::Label, NUM_SAMPLES> pitchLabels;
+    std::array<juce::ComboBox, NUM_SAMPLES> interpolationSelectors;
+
+    /** @brief Level of each track next to its gain knob, and of the output next to the BPM slider. */
+    std::array<LevelMeterView, NUM_SAMPLES> gainMeters;
+    LevelMeterView masterMeterView;
+
 
     int stepYStart = 0;
     int stepStartX = 480;
@@ -1,9 +1,63 @@
 #include "PluginProcessor.h"
-#include "PluginEditor.h"
+#include "RealtimeSafetyChecker.h"
+#include "TraceProfiler.h"
+
+#if ! AUDIOPLUGIN_HEADLESS
+ #include "PluginEditor.h"
+#endif
+
+#ifndef JucePlugin_Name
+ #define JucePlugin_Name "Audiovisual Plugin"
+#endif
+
+
+namespace StateIds
+{
+    static const juce::Identifier pluginState     { "AudiovisualPluginState" };
+    static const juce::Identifier bpm             { "bpm" };
+    static const juce::Identifier track           { "Track" };
+    static const juce::Identifier index           { "index" };
+    static const juce::Identifier sampleFile      { "sampleFile" };
+    static const juce::Identifier playing         { "playing" };
+    static const juce::Identifier steps           { "steps" };
+    static const juce::Identifier lowpassEnabled  { "lowpassEnabled" };
+    static const juce::Identifier lowpassCutoff   { "lowpassCutoff" };
+    static const juce::Identifier highpassEnabled { "highpassEnabled" };
+    static const juce::Identifier highpassCutoff  { "highpassCutoff" };
+    static const juce::Identifier bandpassEnabled { "bandpassEnabled" };
+    static const juce::Identifier bandpassCutoff  { "bandpassCutoff" };
+    static const juce::Identifier bandpassWidth   { "bandpassBandwidth" };
+    static const juce::Identifier notchEnabled    { "notchEnabled" };
+    static const juce::Identifier notchCutoff     { "notchCutoff" };
+    static const juce::Identifier notchWidth      { "notchBandwidth" };
+    static const juce::Identifier peakEnabled     { "peakEnabled" };
+    static const juce::Identifier peakCutoff      { "peakCutoff" };
+    static const juce::Identifier peakGain        { "peakGain" };
+    static const juce::Identifier peakQ           { "peakQ" };
+    static const juce::Identifier crusherEnabled  { "bitcrusherEnabled" };
+    static const juce::Identifier bitDepth        { "bitDepth" };
+    static const juce::Identifier downsampleRate  { "downsampleRate" };
+    static const juce::Identifier gain            { "gain" };
+    static const juce::Identifier attack          { "attack" };
+    static const juce::Identifier decay           { "decay" };
+    static const juce::Identifier sustain         { "sustain" };
+    static const juce::Identifier release         { "release" };
+    static const juce::Identifier stepLock        { "StepLock" };
+    static const juce::Identifier step            { "step" };
+    static const juce::Identifier trimSilence     { "trimSilence" };
+    static const juce::Identifier trimThreshold   { "trimThreshold" };
+    static const juce::Identifier normalisation   { "normalisation" };
+    static const juce::Identifier normaliseTarget { "normalisationTarget" };
+    static const juce::Identifier sampleStorage   { "sampleStorage" };
+    static const juce::Identifier frozen          { "frozen" };
+    static const juce::Identifier slicePlayback   { "slicePlayback" };
+    static const juce::Identifier pitch           { "pitch" };
+    static const juce::Identifier interpolation   { "interpolation" };
+}
 
 
 /**
- * @brief Constructor. Initializes the AudioProcessor and registers audio formats.
+ * @brief Constructor. Initializes the AudioProcessor and the default track settings.
  */
 
 SampleAudioProcessor::SampleAudioProcessor()
@@ -18,7 +72,19 @@ SampleAudioProcessor::SampleAudioProcessor()
                        )
 #endif
 {
-    formatManager.registerBasicFormats(); ///< Registers support for WAV, AIFF, MP3, etc.
+    for (int i = 0; i < NUM_SAMPLES; ++i)
+    {
+        gainLevels[i]   = 1.0f;
+        adsrAttacks[i]  = 0.01f;
+        adsrDecays[i]   = 0.1f;
+        adsrSustains[i] = 1.0f;
+        adsrReleases[i] = 0.1f;
+        playheadFrames[(size_t) i] = -1;
+        triggeredSteps[(size_t) i] = -1;
+        interpolationQualities[(size_t) i] = (int) SampleInterpolator::Quality::cubic;
+    }
+
+    undoHistory.reset(captureSnapshot(nullptr));
 }
 
 /**
@@ -97,330 +163,1836 @@ void SampleAudioProcessor::changeProgramName (int index, const juce::String& new
  */
 void SampleAudioProcessor::prepareToPlay(double sampleRate, int samplesPerBlock)
 {
-    if (sampleRate > 0.0)
-        globalSamplesPerBeat = static_cast<int>((60.0 / globalBpm) * sampleRate);
+    AUDIOPLUGIN_TRACE_THREAD
+    setRateAndBufferSizeDetails(sampleRate, samplesPerBlock);
 
     for (int i = 0; i < NUM_SAMPLES; ++i)
         SampleCounters[i] = 0;
 
+    const juce::dsp::ProcessSpec spec { sampleRate, static_cast<juce::uint32>(samplesPerBlock), 1 };
+
+    {
+        // The message side compiles step locks from the tables, so rebuild and recompile together
+        const juce::ScopedLock lock(stepLockEditLock);
+
+        if (sampleRate > 0.0 && sampleRate != filterTables.getSampleRate())
+            filterTables.prepare(sampleRate);
+
+        for (int i = 0; i < NUM_SAMPLES; ++i)
+            compileStepLocks(i);
+
+        stepLocks.releaseAllRetired();
+    }
 
-    //  Low-Pass
     for (int i = 0; i < NUM_SAMPLES; ++i)
     {
         sampleFilters[i].reset();
-        sampleFilters[i].prepare({ sampleRate, static_cast<juce::uint32>(samplesPerBlock), 1 });
-        sampleFilters[i].setType(juce::dsp::StateVariableTPTFilterType::lowpass);
+        sampleFilters[i].setType(StateVariableFilter::Type::lowpass);
+
+        sampleHighPassFilters[i].reset();
+        sampleHighPassFilters[i].setType(StateVariableFilter::Type::highpass);
+
+        sampleBandPassFilters[i].reset();
+        sampleBandPassFilters[i].setType(StateVariableFilter::Type::bandpass);
+
+        sampleNotchFilters[i].reset();
+        sampleNotchFilters[i].prepare(spec);
+
+        samplePeakFilters[i].reset();
+        samplePeakFilters[i].prepare(spec);
+
+        adsrEnvelopes[i].setSampleRate(sampleRate);
 
-        float cutoff = cutoffFrequencies[i] > 0.0f ? cutoffFrequencies[i] : 2000.0f;
-        sampleFilters[i].setCutoffFrequency(cutoff);
+        appliedParameterVersions[i] = parameterVersions[i].load(std::memory_order_acquire);
+        installedLockVersions[i] = stepLocks.getVersion(i);
+        installedLockSteps[i] = -1;
+        lastCheckedSteps[i] = -1;
+        baseSettings[i] = computeTrackSettings(i, {});
+        installTrackSettings(i, baseSettings[i]);
+        isModulationInstalled[i] = false;
+        currentGains[i] = baseSettings[i].control.gain;
+        noteRenders[i] = nullptr;
     }
 
-    // High-Pass
+    copyPlayedState();
+    modulation.prepare(sampleRate);
+    sliceFadeFrames = juce::roundToInt(sliceFadeSeconds * sampleRate);
+    trackLevels.fill(0.0f);
+
+    const int maxChannels = juce::jmax(2, getTotalNumInputChannels(), getTotalNumOutputChannels());
+    preparedSubBlockSize = subBlockSize;
+    trackScratch.assign((size_t) (preparedSubBlockSize * maxChannels), 0.0f);
+    sourceWindow.assign((size_t) SampleInterpolator::getWindowLength(1.0, SampleInterpolator::maxIncrement, preparedSubBlockSize), 0.0f);
+
+    // Renders made for the previous rate or channel count are out of date
+    frozenChannels = juce::jmax(1, getTotalNumInputChannels(), getTotalNumOutputChannels());
+    spectrumAnalyser.prepare(sampleRate, frozenChannels);
+
+    for (auto& meter : trackMeters)
+        meter.prepare(sampleRate, frozenChannels);
+
+    masterMeter.prepare(sampleRate, frozenChannels);
+
+    for (auto& version : sampleVersions)
+        ++version;
+
+    freezer.releaseAllRetired();
+    freezer.update();
+}
+
+
+/**
+ * @brief Computes the settings of one sample slot from its stored parameters, with a step's overrides
+ * and the current modulation applied.
+ *
+ * Unset values fall back to the same defaults the editor starts with. A cutoff override replaces the
+ * frequency of every filter of the track. Cutoff modulation is added to the table position, Q and
+ * bandwidth modulation scales by powers of two. Filter coefficients stay at their defaults until the
+ * processor has been prepared.
+ *
+ * @param index Index of the sample.
+ * @param lock Overrides to apply.
+ * @param modulationOffsets Matrix whose current offsets are added, or nullptr.
+ * @return The complete settings, ready for installTrackSettings().
+ */
+TrackSettings SampleAudioProcessor::computeTrackSettings(int index, const ParameterLock& lock,
+                                                         const ModulationMatrix* modulationOffsets) const noexcept
+{
+    auto valueOf = [&lock](ParameterLock::Target target, float value)
+    {
+        return lock.has(target) ? lock.get(target) : value;
+    };
+
+    auto offsetOf = [modulationOffsets, index](ModulationMatrix::Destination destination)
+    {
+        return modulationOffsets != nullptr ? modulationOffsets->getOffset(index, destination) : 0.0f;
+    };
+
+    auto scaleByOctaves = [](float value, float octaves)
+    {
+        return octaves != 0.0f ? value * std::exp2(octaves) : value;
+    };
+
+    TrackSettings settings;
+    settings.lock = lock;
+
+    auto& control = settings.control;
+    control.lowpass    = isFilterEnabled[index].load(std::memory_order_relaxed);
+    control.highpass   = isHighPassEnabled[index].load(std::memory_order_relaxed);
+    control.bandpass   = isBandPassEnabled[index].load(std::memory_order_relaxed);
+    control.notch      = isNotchEnabled[index].load(std::memory_order_relaxed);
+    control.peak       = isPeakEnabled[index].load(std::memory_order_relaxed);
+    control.bitcrusher = isBitcrusherEnabled[index].load(std::memory_order_relaxed);
+    control.bitDepth   = std::clamp(static_cast<int>(std::round(valueOf(ParameterLock::bitDepth, (float) bitDepths[index].load(std::memory_order_relaxed))
+                                                                + offsetOf(ModulationMatrix::bitDepth))), 1, 24);
+    control.downsampleFactor = std::max(1, static_cast<int>(downsampleRates[index].load(std::memory_order_relaxed)
+                                                            + offsetOf(ModulationMatrix::downsampleRate)));
+    control.gain       = valueOf(ParameterLock::gain, gainLevels[index].load(std::memory_order_relaxed));
+    control.slicePlayback = slicePlaybackModes[index].load(std::memory_order_relaxed);
+    control.slice      = lock.has(ParameterLock::slice) ? juce::jmax(0, juce::roundToInt(lock.get(ParameterLock::slice))) : -1;
+    control.pitchRatio = std::exp2(juce::jlimit(-maxPitch, maxPitch, valueOf(ParameterLock::pitch, pitches[index].load(std::memory_order_relaxed))) / 12.0f);
+    control.interpolation = static_cast<SampleInterpolator::Quality>(interpolationQualities[index].load(std::memory_order_relaxed));
+
+    if (const float gainOffset = offsetOf(ModulationMatrix::gain); gainOffset != 0.0f)
+        control.gain *= filterTables.decibelsToGain(gainOffset);
+
+    settings.envelope = { valueOf(ParameterLock::attack, adsrAttacks[index]),
+                          valueOf(ParameterLock::decay, adsrDecays[index]),
+                          adsrSustains[index],
+                          valueOf(ParameterLock::release, adsrReleases[index]) };
+
+    if (filterTables.getSampleRate() <= 0.0)
+        return settings;
+
+    auto cutoffOf = [&valueOf](float value, float fallback)
+    {
+        return juce::jmax(1.0f, valueOf(ParameterLock::cutoff, value > 0.0f ? value : fallback));
+    };
+
+    auto positionOf = [this, &offsetOf](float frequencyHz, ModulationMatrix::Destination destination)
+    {
+        return filterTables.getPosition(frequencyHz) + offsetOf(destination) * (float) FilterCoefficientTables::pointsPerOctave;
+    };
+
+    settings.lowpassGain = filterTables.getPrewarpedGainAt(positionOf(cutoffOf(cutoffFrequencies[index], 2000.0f), ModulationMatrix::lowpassCutoff));
+    settings.highpassGain = filterTables.getPrewarpedGainAt(positionOf(cutoffOf(highPassCutoffFrequencies[index], 1000.0f), ModulationMatrix::highpassCutoff));
+
+    const float bandPassCutoff = cutoffOf(bandPassCutoffs[index], 1000.0f);
+    const float bandPassWidth = bandPassBandwidths[index] > 1.0f ? bandPassBandwidths[index].load() : 1.0f;
+    settings.bandpassGain = filterTables.getPrewarpedGainAt(positionOf(bandPassCutoff, ModulationMatrix::bandpassCutoff));
+    settings.bandpassDamping = scaleByOctaves(bandPassWidth / bandPassCutoff,
+                                              offsetOf(ModulationMatrix::bandpassWidth) - offsetOf(ModulationMatrix::bandpassCutoff));
+
+    const float notchCutoff = cutoffOf(notchCutoffs[index], 1000.0f);
+    const float notchWidth = notchBandwidths[index] > 1.0f ? notchBandwidths[index].load() : 100.0f;
+    const float notchQ = scaleByOctaves(notchCutoff / notchWidth,
+                                        offsetOf(ModulationMatrix::notchCutoff) - offsetOf(ModulationMatrix::notchWidth));
+    settings.notchCoefficients = filterTables.makeNotchAt(positionOf(notchCutoff, ModulationMatrix::notchCutoff), notchQ);
+
+    const float peakCutoff = cutoffOf(peakCutoffs[index], 1000.0f);
+    const float peakQ = scaleByOctaves(peakQs[index] > 0.0f ? peakQs[index].load() : 1.0f, offsetOf(ModulationMatrix::peakQ));
+    settings.peakCoefficients = filterTables.makePeakFilterAt(positionOf(peakCutoff, ModulationMatrix::peakCutoff), peakQ,
+                                                              valueOf(ParameterLock::peakGain, peakGains[index]) + offsetOf(ModulationMatrix::peakGain));
+
+    return settings;
+}
+
+
+/**
+ * @brief Copies ready-made settings into a track. Biquad coefficients are written into the filters'
+ * existing storage, so nothing is allocated.
+ * @param index Index of the sample.
+ * @param settings Settings to install.
+ */
+void SampleAudioProcessor::installTrackSettings(int index, const TrackSettings& settings) noexcept
+{
+    trackControls[index] = settings.control;
+
+    sampleFilters[index].setCoefficients(settings.lowpassGain, juce::MathConstants<float>::sqrt2);
+    sampleHighPassFilters[index].setCoefficients(settings.highpassGain, juce::MathConstants<float>::sqrt2);
+    sampleBandPassFilters[index].setCoefficients(settings.bandpassGain, settings.bandpassDamping);
+    *sampleNotchFilters[index].coefficients = settings.notchCoefficients;
+    *samplePeakFilters[index].coefficients = settings.peakCoefficients;
+
+    adsrEnvelopes[index].setParameters(settings.envelope);
+}
+
+
+/**
+ * @brief Installs the settings each track should play the current sub-block with.
+ *
+ * When a track triggers on a step with a parameter lock, the lock's precompiled settings are installed
+ * as they are; on a step without one the track returns to its base settings. The base settings are
+ * recomputed when a setter has changed them, and an installed lock is re-read when the locks were
+ * recompiled. Tracks with modulation routed to them get their settings recomputed from the base or
+ * lock values plus the modulation offsets every sub-block.
+ *
+ * The step pattern, play switches and tempo are copied first, so the whole sub-block plays one
+ * consistent pattern. While a snapshot restore holds snapshotRestoreLock nothing editable is read.
+ *
+ * @param numFrames Length of the sub-block about to be rendered.
+ * @param canReadEditableState Whether this block holds snapshotRestoreLock.
+ */
+void SampleAudioProcessor::updateControlState(int numFrames, bool canReadEditableState)
+{
+    const int step = currentStep.load(std::memory_order_relaxed);
+
+    if (canReadEditableState)
+        copyPlayedState();
+
+    modulation.process(numFrames, playedBpm, trackLevels.data());
+    trackLevels.fill(0.0f);
+
+    // A snapshot is being restored: every track keeps the settings it has installed
+    if (! canReadEditableState)
+        return;
+
     for (int i = 0; i < NUM_SAMPLES; ++i)
     {
-        sampleHighPassFilters[i].reset();
-        sampleHighPassFilters[i].prepare({ sampleRate, static_cast<juce::uint32>(samplesPerBlock), 1 });
-        sampleHighPassFilters[i].setType(juce::dsp::StateVariableTPTFilterType::highpass);
+        bool needsInstall = false;
+        const auto version = parameterVersions[i].load(std::memory_order_acquire);
+
+        if (version != appliedParameterVersions[i])
+        {
+            appliedParameterVersions[i] = version;
+            baseSettings[i] = computeTrackSettings(i, {});
+            needsInstall = installedLockSteps[i] < 0;
+        }
+
+        const auto lockVersion = stepLocks.getVersion(i);
+
+        if (lockVersion != installedLockVersions[i])
+        {
+            installedLockVersions[i] = lockVersion;
+            needsInstall = needsInstall || installedLockSteps[i] >= 0;
+        }
+
+        if (step != lastCheckedSteps[i])
+        {
+            lastCheckedSteps[i] = step;
+
+            if ((playedSteps[i] & (1u << step)) != 0)
+            {
+                const int lockStep = stepLocks.getCompiled(i, step) != nullptr ? step : -1;
+                needsInstall = needsInstall || lockStep >= 0 || installedLockSteps[i] >= 0;
+                installedLockSteps[i] = lockStep;
+            }
+        }
+
+        const bool isModulated = modulation.isTrackModulated(i);
+
+        if (needsInstall || isModulated || isModulationInstalled[i])
+        {
+            const auto* locked = installedLockSteps[i] >= 0 ? stepLocks.getCompiled(i, installedLockSteps[i]) : nullptr;
+
+            if (isModulated)
+                installTrackSettings(i, computeTrackSettings(i, locked != nullptr ? locked->lock : ParameterLock(), &modulation));
+            else
+                installTrackSettings(i, locked != nullptr ? *locked : baseSettings[i]);
+        }
+
+        isModulationInstalled[i] = isModulated;
+    }
+}
+
+
+/**
+ * @brief Advances the step sequencer after a sub-block has been rendered.
+ *
+ * Tracks whose step becomes active are marked as triggered and start at the next sub-block, so steps
+ * are quantised to the sub-block size. A new step is published for displays with the time its first
+ * sub-block starts.
+ *
+ * @param numFrames Number of frames in the sub-block.
+ * @param blockFrame Frame of the host block at which the next sub-block starts.
+ */
+void SampleAudioProcessor::advanceSequencer(int numFrames, int blockFrame)
+{
+    const double samplesPerBeat = (60.0 / juce::jmax(1.0f, playedBpm)) * getSampleRate();
+    const int samplesPerStep = juce::jmax(1, static_cast<int>(samplesPerBeat) / 4);
+
+    sampleCounterForStep += numFrames;
+
+    while (sampleCounterForStep >= samplesPerStep)
+    {
+        sampleCounterForStep -= samplesPerStep;
+
+        const int step = (currentStep.load(std::memory_order_relaxed) + 1) % NUM_STEPS;
+        currentStep.store(step, std::memory_order_relaxed);
+
+        for (int i = 0; i < NUM_SAMPLES; ++i)
+        {
+            if ((playedSteps[i] & (1u << step)) != 0)
+                triggeredSteps[i] = step;
+        }
 
-        float hpfCutoff = highPassCutoffFrequencies[i] > 0.0f ? highPassCutoffFrequencies[i] : 1000.0f;
-        sampleHighPassFilters[i].setCutoffFrequency(hpfCutoff);
+        const double startMs = blockStartMs + blockFrame * 1000.0 / getSampleRate();
+        playheadStepMs.store((float) (samplesPerStep * 1000.0 / getSampleRate()), std::memory_order_relaxed);
+        playheadStamp.store(((juce::uint64) (startMs * 1000.0) << 8) | (juce::uint64) step, std::memory_order_release);
     }
+}
+
+
+SampleAudioProcessor::PlayheadPosition SampleAudioProcessor::getPlayheadPosition() const noexcept
+{
+    const auto stamp = playheadStamp.load(std::memory_order_acquire);
+
+    PlayheadPosition position;
+    position.step = (int) (stamp & 0xff);
+    position.startMs = (double) (stamp >> 8) / 1000.0;
+    position.stepMs = playheadStepMs.load(std::memory_order_relaxed);
+    return position;
+}
+
 
+/**
+ * @brief Copies the step pattern, play switches and tempo into the audio thread's own arrays.
+ */
+void SampleAudioProcessor::copyPlayedState() noexcept
+{
+    for (int track = 0; track < NUM_TRACKS; ++track)
+        playedSteps[track] = getStepPattern(track);
 
-    // Band-pass filter
     for (int i = 0; i < NUM_SAMPLES; ++i)
+        playedTracks[i] = isSamplePlaying[i].load(std::memory_order_relaxed);
+
+    playedBpm = globalBpm.load(std::memory_order_relaxed);
+}
+
+
+void SampleAudioProcessor::releaseResources()
+{
+
+}
+
+#ifndef JucePlugin_PreferredChannelConfigurations
+bool SampleAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts) const
+{
+  #if JucePlugin_IsMidiEffect
+    juce::ignoreUnused (layouts);
+    return true;
+  #else
+    // This is the place where you check if the layout is supported.
+    // In this template code we only support mono or stereo.
+    // Some plugin hosts, such as certain GarageBand versions, will only
+    // load plugins that support stereo bus layouts.
+    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
+     && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
+        return false;
+
+    // This checks if the input layout matches the output layout
+   #if ! JucePlugin_IsSynth
+    if (layouts.getMainOutputChannelSet() != layouts.getMainInputChannelSet())
+        return false;
+   #endif
+
+    return true;
+  #endif
+}
+#endif
+
+
+/**
+ * @brief Main audio processing callback.
+ * Applies filters, bitcrusher, ADSR envelope, and gain to each active sample, and mixes them into the output buffer.
+ *
+ * The host buffer is split into sub-blocks of the size set before the last prepareToPlay(), the last one
+ * possibly shorter.
+ * Parameter changes are applied and the sequencer is advanced at sub-block boundaries, so control rate
+ * and per-sample cost do not depend on the host block size. Within a sub-block the tracks are rendered
+ * one after another through a scratch buffer small enough to stay in L1 cache, followed by the preview
+ * of auditionSampleFile().
+ *
+ * @param buffer The audio buffer to fill.
+ * @param midiMessages Incoming MIDI messages (unused).
+ */
+void SampleAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer&)
+{
+    // Hosts may call prepareToPlay() on another thread; the trace buffer is created before the realtime section
+    AUDIOPLUGIN_TRACE_THREAD
+    AUDIOPLUGIN_REALTIME_SECTION
+    AUDIOPLUGIN_TRACE_ZONE("processBlock")
+    juce::ScopedNoDenormals noDenormals;
+    const auto blockStartTicks = telemetry.beginBlock();
+    blockStartMs = juce::Time::getMillisecondCounterHiRes();
+    const int bufferNumSamples = buffer.getNumSamples();
+    const int numChannels = buffer.getNumChannels();
+
+    buffer.clear();
+
+    // Fails only while undo or redo is writing a snapshot; this block then plays the state applied before
+    const juce::SpinLock::ScopedTryLockType restoreLock(snapshotRestoreLock);
+    playedInBlock.fill(false);
+
+    if (! trackScratch.empty())
     {
-        sampleBandPassFilters[i].reset();
-        sampleBandPassFilters[i].prepare({ sampleRate, static_cast<juce::uint32>(samplesPerBlock), 1 });
-        sampleBandPassFilters[i].setType(juce::dsp::StateVariableTPTFilterType::bandpass);
+        const int framesPerSubBlock = juce::jlimit(1, preparedSubBlockSize, (int) trackScratch.size() / juce::jmax(1, numChannels));
 
-        float cutoff = bandPassCutoffs[i] > 0.0f ? bandPassCutoffs[i] : 1000.0f;
-        float bandwidth = bandPassBandwidths[i] > 0.0f ? bandPassBandwidths[i] : 500.0f;
-        float q = cutoff / bandwidth;
+        for (int start = 0; start < bufferNumSamples; start += framesPerSubBlock)
+        {
+            const int numFrames = juce::jmin(framesPerSubBlock, bufferNumSamples - start);
+
+            updateControlState(numFrames, restoreLock.isLocked());
+
+            for (int i = 0; i < NUM_SAMPLES; ++i)
+            {
+                const auto trackStartTicks = telemetry.now();
+                renderTrack(i, buffer, start, numFrames);
+                telemetry.addTrackTime(i, trackStartTicks);
+            }
 
-        sampleBandPassFilters[i].setCutoffFrequency(cutoff);
-        sampleBandPassFilters[i].setResonance(q);
+            renderAudition(buffer, start, numFrames);
+
+            advanceSequencer(numFrames, start + numFrames);
+        }
     }
 
     for (int i = 0; i < NUM_SAMPLES; ++i)
+        playheadFrames[(size_t) i].store(playedInBlock[(size_t) i] ? sampleReadPositions[i] : -1, std::memory_order_relaxed);
+
+    for (auto& meter : trackMeters)
+        meter.endBlock(bufferNumSamples);
+
+    masterMeter.addBuffer(buffer, 0, bufferNumSamples);
+    masterMeter.endBlock(bufferNumSamples);
+
+    spectrumAnalyser.pushPlanar(masterSpectrumSource, buffer, 0, bufferNumSamples);
+
+    stepLocks.markBlockCompleted();
+    freezer.markBlockCompleted();
+    telemetry.endBlock(blockStartTicks, bufferNumSamples, getSampleRate());
+}
+
+
+/**
+ * @brief Renders one track into a range of the output buffer.
+ *
+ * A triggered track first starts its note. The region of the sample the note plays is gathered into
+ * the interleaved scratch buffer, frame by frame at the sample's own pitch and through the track's
+ * SampleInterpolator kernel otherwise, faded at slice borders, run through the filter,
+ * bitcrusher and envelope stages and then added to the output while its level meter is fed, and
+ * copied to the spectrum analyser if the track is analysed. A note that started on an up-to-date frozen render is mixed from
+ * that render instead, to its end, even if the render goes out of date meanwhile.
+ * The track is skipped while a newly loaded sample is being swapped in.
+ *
+ * @param index Index of the sample.
+ * @param buffer Output buffer to add to.
+ * @param startSample First sample of the range.
+ * @param numFrames Number of samples in the range.
+ */
+void SampleAudioProcessor::renderTrack(int index, juce::AudioBuffer<float>& buffer, int startSample, int numFrames)
+{
+    const juce::SpinLock::ScopedTryLockType sampleLock(sampleLocks[index]);
+
+    if (! (sampleLock.isLocked() && isSampleFileLoaded[index] && playedTracks[index]
+            && (playedSteps[index] & (1u << currentStep.load(std::memory_order_relaxed))) != 0))
+        return;
+
+    AUDIOPLUGIN_TRACE_ZONE_INDEXED("renderTrack", index)
+    const int numChannels = buffer.getNumChannels();
+
+    if (triggeredSteps[index] >= 0)
+        startNote(index, triggeredSteps[index], numChannels);
+
+    if (const auto* frozen = noteRenders[index])
     {
-        sampleNotchFilters[i].reset();
-        sampleNotchFilters[i].prepare({ sampleRate, static_cast<juce::uint32>(samplesPerBlock), 1 });
+        mixFrozenTrack(index, *frozen, buffer, startSample, numFrames);
+        return;
+    }
+
+    const auto& source = *sampleBuffers[index];
+    const int sourceChannels = source.getNumChannels();
+    const int regionEnd = juce::jmin(playRegions[index].getEnd(), source.getNumFrames());
+    const int position = sampleReadPositions[index];
+    const double fraction = sampleReadFractions[index];
+    const double increment = trackControls[index].pitchRatio;
+    const bool isResampling = increment != 1.0 || fraction != 0.0;
+
+    if (position >= regionEnd)
+        adsrEnvelopes[index].noteOff();
+
+    const int numActive = isResampling ? SampleInterpolator::getFramesBefore(regionEnd - position - fraction, increment, numFrames)
+                                       : juce::jlimit(0, numFrames, regionEnd - position);
+    if (numActive == 0)
+        return;
+
+    float* scratch = trackScratch.data();
+    const int count = numActive * numChannels;
+
+    if (isResampling)
+    {
+        AUDIOPLUGIN_TRACE_ZONE_INDEXED("interpolate", index)
+        const int windowLength = SampleInterpolator::getWindowLength(fraction, increment, numActive);
+        jassert(windowLength <= (int) sourceWindow.size());
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            source.read(channel % sourceChannels, position - SampleInterpolator::guardFrames, sourceWindow.data(), windowLength);
+            SampleInterpolator::process(trackControls[index].interpolation, sourceWindow.data() + SampleInterpolator::guardFrames,
+                                        fraction, increment, scratch + channel, numChannels, numActive);
+        }
+    }
+    else
+    {
+        // Integer storage is decoded into the source window, which is free in this path
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            const float* in = source.getReadPointer(channel % sourceChannels, position, numActive, sourceWindow.data());
 
-        updateNotchCoefficients(i);
+            for (int frame = 0; frame < numActive; ++frame)
+                scratch[frame * numChannels + channel] = in[frame];
+        }
     }
 
+    if (trackControls[index].slicePlayback)
+        applySliceFades(index, scratch, position + fraction, increment, numActive, numChannels);
 
-    for (int i = 0; i < NUM_SAMPLES; ++i)
     {
-        samplePeakFilters[i].reset();
-        samplePeakFilters[i].prepare({ sampleRate, static_cast<juce::uint32>(samplesPerBlock), 1 });
+        AUDIOPLUGIN_TRACE_ZONE_INDEXED("filters", index)
+        applyFilters(index, scratch, count);
+    }
+
+    if (trackControls[index].bitcrusher)
+    {
+        AUDIOPLUGIN_TRACE_ZONE_INDEXED("bitcrusher", index)
+        applyBitcrusher(index, scratch, count);
+    }
+
+    {
+        AUDIOPLUGIN_TRACE_ZONE_INDEXED("envelope", index)
+        applyEnvelopeAndGain(index, scratch, count);
+    }
+
+    {
+        AUDIOPLUGIN_TRACE_ZONE_INDEXED("mix", index)
+
+        const auto range = juce::FloatVectorOperations::findMinAndMax(scratch, count);
+        const float peak = juce::jmax(-range.getStart(), range.getEnd());
+        trackLevels[(size_t) index] = peak;
+        spectrumAnalyser.push(index, scratch, numActive, numChannels);
+
+        // The meter's sum of squares rides along with the mix, which reads every value anyway
+        float sumOfSquares = 0.0f;
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            float* out = buffer.getWritePointer(channel, startSample);
+
+            for (int frame = 0; frame < numActive; ++frame)
+            {
+                const float value = scratch[frame * numChannels + channel];
+                out[frame] += value;
+                sumOfSquares += value * value;
+            }
+        }
+
+        trackMeters[(size_t) index].addInterleaved(scratch, numActive, numChannels, peak, sumOfSquares);
+    }
+
+    const double end = fraction + numActive * increment;
+    sampleReadPositions[index] = position + (int) end;
+    sampleReadFractions[index] = end - (int) end;
+    playedInBlock[(size_t) index] = true;
+
+    if (numActive < numFrames)
+        adsrEnvelopes[index].noteOff();
+}
+
+
+/**
+ * @brief A render is playable if it was made from the parameters and sample the track is playing with,
+ * for the current channel count, and the track is neither on a locked step, modulated, playing slices
+ * nor pitched. Renders are made at the sample's own pitch.
+ *
+ * This is only decided when a note starts. Switching between the render and the live chain partway
+ * through a note would restart the live envelope, which does not run while the render plays, and pick
+ * up filter state from an earlier note, so an edit during the note is heard from the next trigger on.
+ */
+const FrozenTrack* SampleAudioProcessor::getPlayableFrozenTrack(int index, int numChannels) const noexcept
+{
+    const auto* frozen = freezer.getFrozen(index);
+
+    if (frozen == nullptr || installedLockSteps[index] >= 0 || isModulationInstalled[index] || trackControls[index].slicePlayback
+            || trackControls[index].pitchRatio != 1.0f || sampleReadFractions[index] != 0.0)
+        return nullptr;
+
+    if (frozen->parameterVersion != appliedParameterVersions[index]
+            || frozen->sampleVersion != sampleVersions[index].load(std::memory_order_relaxed)
+            || frozen->audio.getNumChannels() != numChannels)
+        return nullptr;
+
+    return frozen;
+}
+
+
+/**
+ * @brief Adds the render from the track's read position on and advances the position. The live
+ * envelope and filters are left untouched.
+ * @param index Index of the sample.
+ * @param frozen Render of the track.
+ * @param buffer Output buffer to add to.
+ * @param startSample First sample of the range.
+ * @param numFrames Number of samples in the range.
+ */
+void SampleAudioProcessor::mixFrozenTrack(int index, const FrozenTrack& frozen, juce::AudioBuffer<float>& buffer, int startSample, int numFrames)
+{
+    AUDIOPLUGIN_TRACE_ZONE_INDEXED("frozen", index)
+    const int position = sampleReadPositions[index];
+    const int numActive = juce::jlimit(0, numFrames, frozen.audio.getNumSamples() - position);
+
+    currentGains[index] = trackControls[index].gain;
+
+    if (numActive == 0)
+        return;
 
-        float cutoff = peakCutoffs[i] > 0.0f ? peakCutoffs[i] : 1000.0f;
-        float gain = peakGains[i]; //
-        float q = peakQs[i] > 0.0f ? peakQs[i] : 1.0f;
+    float level = 0.0f;
+
+    for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+    {
+        const float* in = frozen.audio.getReadPointer(channel, position);
+        juce::FloatVectorOperations::add(buffer.getWritePointer(channel, startSample), in, numActive);
+
+        const auto range = juce::FloatVectorOperations::findMinAndMax(in, numActive);
+        level = juce::jmax(level, -range.getStart(), range.getEnd());
+    }
+
+    trackMeters[(size_t) index].addBuffer(frozen.audio, position, numActive);
+    spectrumAnalyser.pushPlanar(index, frozen.audio, position, numActive);
+
+    trackLevels[(size_t) index] = level;
+    sampleReadPositions[index] = position + numActive;
+    playedInBlock[(size_t) index] = true;
+}
+
+
+/**
+ * @brief Evaluates the filters of the track's base settings. computeTrackSettings() reads filterTables,
+ * which prepareToPlay() rebuilds under stepLockEditLock.
+ */
+void SampleAudioProcessor::getFilterResponse(int index, const float* frequencies, float* decibels, int count) const
+{
+    const juce::ScopedLock lock(stepLockEditLock);
+    const double sampleRate = filterTables.getSampleRate();
+
+    if (index < 0 || index >= NUM_SAMPLES || sampleRate <= 0.0)
+    {
+        std::fill(decibels, decibels + count, 0.0f);
+        return;
+    }
+
+    const auto settings = computeTrackSettings(index, {});
+
+    for (int n = 0; n < count; ++n)
+        decibels[n] = TrackDsp::getFilterResponse(settings, frequencies[n], sampleRate);
+}
+
+
+/**
+ * @brief Runs the enabled filters of a track over interleaved samples.
+ * @param index Index of the sample.
+ * @param samples Interleaved samples, processed in place.
+ * @param count Number of values in samples.
+ */
+void SampleAudioProcessor::applyFilters(int index, float* samples, int count)
+{
+    TrackDsp::applyFilters(trackControls[index], sampleFilters[index], sampleHighPassFilters[index], sampleBandPassFilters[index],
+                           sampleNotchFilters[index], samplePeakFilters[index], samples, count);
+}
+
+
+/**
+ * @brief Reduces bit depth and sample rate of interleaved samples.
+ * @param index Index of the sample.
+ * @param samples Interleaved samples, processed in place.
+ * @param count Number of values in samples.
+ */
+void SampleAudioProcessor::applyBitcrusher(int index, float* samples, int count)
+{
+    TrackDsp::applyBitcrusher(trackControls[index], downsampleCounters[index], samples, count);
+}
+
+
+/**
+ * @brief Applies the ADSR envelope and the track gain to interleaved samples.
+ *
+ * A gain change, e.g. from modulation or a parameter lock, is ramped linearly over the samples.
+ *
+ * @param index Index of the sample.
+ * @param samples Interleaved samples, processed in place.
+ * @param count Number of values in samples.
+ */
+void SampleAudioProcessor::applyEnvelopeAndGain(int index, float* samples, int count)
+{
+    TrackDsp::applyEnvelopeAndGain(adsrEnvelopes[index], currentGains[index], trackControls[index].gain, samples, count);
+}
+
+
+/**
+ * @brief Mixes the preview into the output at unity gain, a mono preview into every channel. Skipped
+ * while a new preview is being swapped in.
+ */
+void SampleAudioProcessor::renderAudition(juce::AudioBuffer<float>& buffer, int startSample, int numFrames) noexcept
+{
+    const juce::SpinLock::ScopedTryLockType lock(auditionLock);
+
+    if (! (lock.isLocked() && auditionActive.load(std::memory_order_relaxed)))
+        return;
+
+    AUDIOPLUGIN_TRACE_ZONE("audition")
+    const int sourceChannels = auditionSample.getNumChannels();
+    const int numActive = juce::jlimit(0, numFrames, auditionSample.getNumFrames() - auditionPosition);
+
+    if (numActive > 0)
+    {
+        for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+        {
+            const float* in = auditionSample.getReadPointer(channel % sourceChannels, auditionPosition, numActive, sourceWindow.data());
+            juce::FloatVectorOperations::add(buffer.getWritePointer(channel, startSample), in, numActive);
+        }
+
+        auditionPosition += numActive;
+    }
+
+    if (auditionPosition >= auditionSample.getNumFrames())
+        auditionActive = false;
+}
+
+
+/**
+ * @brief Starts a note at the region of the sample the trigger selects. In slice playback that is the
+ * slice of the step's lock or, without one, of the step's number, as long as the slices belong to the
+ * buffer in the slot; otherwise the whole sample. Called with the track's sample lock held.
+ *
+ * The note plays from the track's frozen render if that is playable now, and holds it in the freezer
+ * until the next note, so a render replaced meanwhile is not freed while the note reads it.
+ *
+ * @param index Index of the sample.
+ * @param step Step the track was triggered on.
+ * @param numChannels Number of output channels.
+ */
+void SampleAudioProcessor::startNote(int index, int step, int numChannels) noexcept
+{
+    const auto& control = trackControls[index];
+    const auto* slices = sampleSlices[index].get();
+    const int sourceLength = sampleBuffers[index]->getNumFrames();
+
+    if (control.slicePlayback && slices != nullptr && slices->getNumFrames() == sourceLength)
+        playRegions[index] = slices->getSlice(control.slice >= 0 ? control.slice : step);
+    else
+        playRegions[index] = { 0, sourceLength };
+
+    sampleReadPositions[index] = playRegions[index].getStart();
+    sampleReadFractions[index] = 0.0;
+    triggeredSteps[index] = -1;
+    adsrEnvelopes[index].noteOn();
+
+    noteRenders[index] = getPlayableFrozenTrack(index, numChannels);
+    freezer.hold(index, noteRenders[index]);
+}
+
+
+/**
+ * @brief Ramps the borders a slice shares with its neighbours. The start and end of the sample itself
+ * keep their own shape.
+ * @param index Index of the sample.
+ * @param samples Interleaved samples, processed in place.
+ * @param position Position in the sample the first frame was read from.
+ * @param increment Frames of the sample per frame of samples.
+ * @param numFrames Number of frames in samples.
+ * @param numChannels Number of interleaved channels.
+ */
+void SampleAudioProcessor::applySliceFades(int index, float* samples, double position, double increment, int numFrames, int numChannels) noexcept
+{
+    const auto region = playRegions[index];
+
+    TrackDsp::applyRegionFades(region, sliceFadeFrames, region.getStart() > 0, region.getEnd() < sampleBuffers[index]->getNumFrames(),
+                               position, increment, samples, numFrames, numChannels);
+}
+
+
+//==============================================================================
+bool SampleAudioProcessor::hasEditor() const
+{
+   #if AUDIOPLUGIN_HEADLESS
+    return false;
+   #else
+    return true; // (change this to false if you choose to not supply an editor)
+   #endif
+}
+
+juce::AudioProcessorEditor* SampleAudioProcessor::createEditor()
+{
+   #if AUDIOPLUGIN_HEADLESS
+    return nullptr;
+   #else
+    return new SampleAudioProcessorEditor (*this);
+   #endif
+}
+
+//==============================================================================
+void SampleAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
+{
+    if (auto xml = getStateTree().createXml())
+        copyXmlToBinary(*xml, destData);
+}
+
+void SampleAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
+{
+    if (auto xml = getXmlFromBinary(data, sizeInBytes))
+        setStateTree(juce::ValueTree::fromXml(*xml));
+}
+
+
+/**
+ * @brief Captures the complete processor state (BPM, pattern, sample files and all effect settings).
+ * @return A ValueTree of type AudiovisualPluginState with one Track child per sample slot and a Modulation child.
+ */
+juce::ValueTree SampleAudioProcessor::getStateTree() const
+{
+    juce::ValueTree state(StateIds::pluginState);
+    state.setProperty(StateIds::bpm, globalBpm.load(), nullptr);
+
+    const auto options = getSampleLoadOptions();
+    state.setProperty(StateIds::trimSilence, options.trimSilence, nullptr);
+    state.setProperty(StateIds::trimThreshold, options.trimThresholdDb, nullptr);
+    state.setProperty(StateIds::normalisation, SampleLoadOptions::getNormalisationName(options.normalisation), nullptr);
+    state.setProperty(StateIds::normaliseTarget, options.normalisationTarget, nullptr);
+    state.setProperty(StateIds::sampleStorage, SampleStore::getFormatName(options.storage), nullptr);
+
+    const juce::ScopedLock fileLock(sampleFileLock);
+
+    for (int i = 0; i < NUM_SAMPLES; ++i)
+    {
+        juce::ValueTree track(StateIds::track);
+        track.setProperty(StateIds::index, i, nullptr);
+        track.setProperty(StateIds::sampleFile, sampleFiles[i].getFullPathName(), nullptr);
+        track.setProperty(StateIds::playing, isSamplePlaying[i].load(), nullptr);
+        track.setProperty(StateIds::frozen, isTrackFrozen(i), nullptr);
+
+        juce::String steps;
+        for (int step = 0; step < NUM_STEPS; ++step)
+            steps << (stepStates[i][step] ? "1" : "0");
+        track.setProperty(StateIds::steps, steps, nullptr);
+
+        track.setProperty(StateIds::lowpassEnabled, isFilterEnabled[i].load(), nullptr);
+        track.setProperty(StateIds::lowpassCutoff, cutoffFrequencies[i].load(), nullptr);
+        track.setProperty(StateIds::highpassEnabled, isHighPassEnabled[i].load(), nullptr);
+        track.setProperty(StateIds::highpassCutoff, highPassCutoffFrequencies[i].load(), nullptr);
+        track.setProperty(StateIds::bandpassEnabled, isBandPassEnabled[i].load(), nullptr);
+        track.setProperty(StateIds::bandpassCutoff, bandPassCutoffs[i].load(), nullptr);
+        track.setProperty(StateIds::bandpassWidth, bandPassBandwidths[i].load(), nullptr);
+        track.setProperty(StateIds::notchEnabled, isNotchEnabled[i].load(), nullptr);
+        track.setProperty(StateIds::notchCutoff, notchCutoffs[i].load(), nullptr);
+        track.setProperty(StateIds::notchWidth, notchBandwidths[i].load(), nullptr);
+        track.setProperty(StateIds::peakEnabled, isPeakEnabled[i].load(), nullptr);
+        track.setProperty(StateIds::peakCutoff, peakCutoffs[i].load(), nullptr);
+        track.setProperty(StateIds::peakGain, peakGains[i].load(), nullptr);
+        track.setProperty(StateIds::peakQ, peakQs[i].load(), nullptr);
+        track.setProperty(StateIds::crusherEnabled, isBitcrusherEnabled[i].load(), nullptr);
+        track.setProperty(StateIds::bitDepth, bitDepths[i].load(), nullptr);
+        track.setProperty(StateIds::downsampleRate, downsampleRates[i].load(), nullptr);
+        track.setProperty(StateIds::gain, gainLevels[i].load(), nullptr);
+        track.setProperty(StateIds::attack, adsrAttacks[i].load(), nullptr);
+        track.setProperty(StateIds::decay, adsrDecays[i].load(), nullptr);
+        track.setProperty(StateIds::sustain, adsrSustains[i].load(), nullptr);
+        track.setProperty(StateIds::release, adsrReleases[i].load(), nullptr);
+        track.setProperty(StateIds::slicePlayback, slicePlaybackModes[i].load(), nullptr);
+        track.setProperty(StateIds::pitch, pitches[i].load(), nullptr);
+        track.setProperty(StateIds::interpolation, SampleInterpolator::getQualityName(getInterpolation(i)), nullptr);
+
+        for (int step = 0; step < NUM_STEPS; ++step)
+        {
+            const auto lock = getStepLock(i, step);
+            if (lock.isEmpty())
+                continue;
+
+            juce::ValueTree stepLock(StateIds::stepLock);
+            stepLock.setProperty(StateIds::step, step, nullptr);
+
+            for (int target = 0; target < ParameterLock::numTargets; ++target)
+            {
+                const auto t = static_cast<ParameterLock::Target>(target);
+                if (lock.has(t))
+                    stepLock.setProperty(ParameterLock::getTargetName(t), lock.get(t), nullptr);
+            }
+
+            track.appendChild(stepLock, nullptr);
+        }
+
+        state.appendChild(track, nullptr);
+    }
+
+    state.appendChild(modulation.getState(), nullptr);
+    return state;
+}
+
+
+/**
+ * @brief Restores a state previously created by getStateTree().
+ *
+ * Sample files referenced with an absolute path are reloaded from disk, in parallel on the load
+ * pipeline's worker pool, with the load options stored in the state. Properties that are missing
+ * from the tree keep their current value; the step locks of a restored track are replaced by the
+ * StepLock children of its Track. The undo history is cleared.
+ *
+ * @param state The state to restore.
+ */
+void SampleAudioProcessor::setStateTree(const juce::ValueTree& state)
+{
+    if (! state.hasType(StateIds::pluginState))
+        return;
+
+    SampleLoadOptions options;
+    juce::Array<juce::File> filesToLoad;
+    juce::Array<int> slotsToLoad;
+    std::vector<juce::uint32> serials;
+
+    // The parameters are restored and the files assigned under undoLock, where the restored state starts a new
+    // history instead of being one undo step. Snapshots hold the assigned files, not their audio, so the files
+    // are loaded after the lock is released and undo or redo does not wait for the disk.
+    {
+        const juce::ScopedLock undo(undoLock);
+        const juce::ScopedValueSetter<bool> restoring(isRestoringSnapshot, true);
+
+        setGlobalBpm(state.getProperty(StateIds::bpm, globalBpm.load()));
+
+        options = getSampleLoadOptions();
+        options.trimSilence = state.getProperty(StateIds::trimSilence, options.trimSilence);
+        options.trimThresholdDb = state.getProperty(StateIds::trimThreshold, options.trimThresholdDb);
+        options.normalisationTarget = state.getProperty(StateIds::normaliseTarget, options.normalisationTarget);
+
+        if (state.hasProperty(StateIds::normalisation))
+            options.normalisation = SampleLoadOptions::getNormalisationFromName(state[StateIds::normalisation].toString());
+
+        if (state.hasProperty(StateIds::sampleStorage))
+            options.storage = SampleStore::getFormatFromName(state[StateIds::sampleStorage].toString());
+
+        setSampleLoadOptions(options);
+
+        auto restore = [](auto& parameter, const juce::ValueTree& track, const juce::Identifier& id)
+        {
+            using ValueType = decltype(parameter.load());
+            parameter = static_cast<ValueType>(track.getProperty(id, parameter.load()));
+        };
+
+        for (const auto& track : state)
+        {
+            if (! track.hasType(StateIds::track))
+            {
+                modulation.setState(track);
+                continue;
+            }
+
+            const int i = track.getProperty(StateIds::index, -1);
+            if (i < 0 || i >= NUM_SAMPLES)
+                continue;
+
+            const auto path = track[StateIds::sampleFile].toString();
+            if (juce::File::isAbsolutePath(path))
+            {
+                filesToLoad.add(juce::File(path));
+                slotsToLoad.add(i);
+            }
+
+            restore(isSamplePlaying[i], track, StateIds::playing);
+
+            if (track.hasProperty(StateIds::frozen))
+                setTrackFrozen(i, track[StateIds::frozen]);
+
+            if (track.hasProperty(StateIds::steps))
+            {
+                const auto steps = track[StateIds::steps].toString();
+                for (int step = 0; step < NUM_STEPS; ++step)
+                    stepStates[i][step] = step < steps.length() && steps[step] == '1';
+            }
+
+            restore(isFilterEnabled[i], track, StateIds::lowpassEnabled);
+            restore(cutoffFrequencies[i], track, StateIds::lowpassCutoff);
+            restore(isHighPassEnabled[i], track, StateIds::highpassEnabled);
+            restore(highPassCutoffFrequencies[i], track, StateIds::highpassCutoff);
+            restore(isBandPassEnabled[i], track, StateIds::bandpassEnabled);
+            restore(bandPassCutoffs[i], track, StateIds::bandpassCutoff);
+            restore(bandPassBandwidths[i], track, StateIds::bandpassWidth);
+            restore(isNotchEnabled[i], track, StateIds::notchEnabled);
+            restore(notchCutoffs[i], track, StateIds::notchCutoff);
+            restore(notchBandwidths[i], track, StateIds::notchWidth);
+            restore(isPeakEnabled[i], track, StateIds::peakEnabled);
+            restore(peakCutoffs[i], track, StateIds::peakCutoff);
+            restore(peakGains[i], track, StateIds::peakGain);
+            restore(peakQs[i], track, StateIds::peakQ);
+            restore(isBitcrusherEnabled[i], track, StateIds::crusherEnabled);
+            restore(bitDepths[i], track, StateIds::bitDepth);
+            restore(downsampleRates[i], track, StateIds::downsampleRate);
+            restore(gainLevels[i], track, StateIds::gain);
+
+            restore(adsrAttacks[i], track, StateIds::attack);
+            restore(adsrDecays[i], track, StateIds::decay);
+            restore(adsrSustains[i], track, StateIds::sustain);
+            restore(adsrReleases[i], track, StateIds::release);
+            restore(slicePlaybackModes[i], track, StateIds::slicePlayback);
+            restore(pitches[i], track, StateIds::pitch);
+
+            if (track.hasProperty(StateIds::interpolation))
+                interpolationQualities[i] = (int) SampleInterpolator::getQualityFromName(track[StateIds::interpolation].toString());
+
+            {
+                const juce::ScopedLock lock(stepLockEditLock);
+
+                for (int step = 0; step < NUM_STEPS; ++step)
+                    storeStepLock(i, step, {});
+
+                for (const auto& stepLock : track)
+                {
+                    const int step = stepLock.getProperty(StateIds::step, -1);
+                    if (! stepLock.hasType(StateIds::stepLock) || step < 0 || step >= NUM_STEPS)
+                        continue;
+
+                    ParameterLock restored;
+
+                    for (int target = 0; target < ParameterLock::numTargets; ++target)
+                    {
+                        const auto t = static_cast<ParameterLock::Target>(target);
+                        const juce::Identifier id(ParameterLock::getTargetName(t));
+
+                        if (stepLock.hasProperty(id))
+                            restored.set(t, (float) stepLock[id]);
+                    }
+
+                    stepLocks.setLock(i, step, restored);
+                }
+            }
+
+            markParametersChanged(i);
+        }
+
+        for (int i = 0; i < slotsToLoad.size(); ++i)
+            serials.push_back(beginSampleLoad(slotsToLoad[i], filesToLoad[i]));
+
+        undoHistory.reset(captureSnapshot(nullptr));
+    }
+
+    auto loaded = loadPipeline.loadAll(filesToLoad, options);
+
+    for (int i = 0; i < slotsToLoad.size(); ++i)
+    {
+        const juce::ScopedLock lock(sampleFileLock);
+
+        if (sampleLoadSerials[(size_t) slotsToLoad[i]] == serials[(size_t) i])
+            installLoadedSample(loaded[(size_t) i], filesToLoad[i], slotsToLoad[i]);
+    }
+
+    stateRestoreCount.fetch_add(1, std::memory_order_release);
+}
+
+
+
+/* @brief creates new instances of the plugin..  */
+juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
+{
+    return new SampleAudioProcessor();
+}
+
+
+/**
+ * @brief Loads a sample from file into the specified slot.
+ *
+ * Decoding, trimming, normalisation and analysis run on the calling thread.
+ *
+ * @param file The audio file to load.
+ * @param index The sample index (0 to NUM_SAMPLES - 1).
+ */
+void SampleAudioProcessor::loadSampleFile(const juce::File& file, int index)
+{
+    if (index < 0 || index >= NUM_SAMPLES)
+        return;
+
+    AUDIOPLUGIN_TRACE_ZONE_INDEXED("loadSampleFile", index)
+    const auto serial = beginSampleLoad(index, file);
+    recordUndoStep();
+
+    auto loaded = loadPipeline.load(file, getSampleLoadOptions());
+
+    const juce::ScopedLock lock(sampleFileLock);
+
+    if (sampleLoadSerials[(size_t) index] == serial)
+        installLoadedSample(loaded, file, index);
+}
+
+
+
+/**
+ * @brief Copies decoded audio into the specified slot.
+ * @param buffer The audio to load.
+ * @param index The sample index (0 to NUM_SAMPLES - 1).
+ */
+void SampleAudioProcessor::loadSampleBuffer(const juce::AudioBuffer<float>& buffer, int index)
+{
+    if (index < 0 || index >= NUM_SAMPLES)
+        return;
+
+    LoadedSample loaded;
+    const auto options = getSampleLoadOptions();
+    const double sampleRate = getSampleRate() > 0.0 ? getSampleRate() : 44100.0;
+    loaded.analysis = SampleLoadPipeline::analyse(buffer, sampleRate, options.trimThresholdDb);
+    loaded.slices = SliceIndex::detect(buffer, sampleRate);
+    loaded.storage = SampleStore(juce::AudioBuffer<float>(buffer), options.storage);
+    loaded.isValid = true;
+
+    beginSampleLoad(index, juce::File());
+    recordUndoStep();
+
+    const juce::ScopedLock lock(sampleFileLock);
+    installLoadedSample(loaded, juce::File(), index);
+}
+
+
+
+/**
+ * @brief Queues a file on the load pipeline. The result is installed only if no other load into the
+ * slot was started in the meantime.
+ * @param file The audio file to load.
+ * @param index The sample index (0 to NUM_SAMPLES - 1).
+ */
+void SampleAudioProcessor::loadSampleFileAsync(const juce::File& file, int index)
+{
+    if (index < 0 || index >= NUM_SAMPLES)
+        return;
+
+    const auto serial = beginSampleLoad(index, file);
+    recordUndoStep();
+
+    loadPipeline.loadAsync(file, getSampleLoadOptions(), [this, file, index, serial](LoadedSample& loaded)
+    {
+        const juce::ScopedLock lock(sampleFileLock);
+
+        if (sampleLoadSerials[(size_t) index] == serial)
+            installLoadedSample(loaded, file, index);
+    });
+}
+
+
+/**
+ * @brief Decodes the preview on the worker pool. Index files are left alone, so browsing a library does
+ * not write next to every file that is listened to.
+ */
+void SampleAudioProcessor::auditionSampleFile(const juce::File& file)
+{
+    auto options = getSampleLoadOptions();
+    options.useIndexFiles = false;
+    const auto serial = ++auditionSerial;
+
+    loadPipeline.loadAsync(file, options, [this, serial](LoadedSample& loaded)
+    {
+        if (serial == auditionSerial.load() && loaded.isValid)
+            swapInAudition(loaded.storage);
+    });
+}
+
+
+void SampleAudioProcessor::auditionSampleBuffer(const juce::AudioBuffer<float>& buffer)
+{
+    ++auditionSerial;
+    SampleStore sample(juce::AudioBuffer<float>(buffer), getSampleLoadOptions().storage);
+    swapInAudition(sample);
+}
+
+
+void SampleAudioProcessor::stopAudition()
+{
+    ++auditionSerial;
+    SampleStore none;
+    swapInAudition(none);
+}
+
+
+void SampleAudioProcessor::swapInAudition(SampleStore& newSample)
+{
+    const juce::SpinLock::ScopedLockType lock(auditionLock);
+
+    std::swap(auditionSample, newSample);
+    auditionPosition = 0;
+    auditionActive = auditionSample.getNumFrames() > 0 && auditionSample.getNumChannels() > 0;
+}
+
+
+juce::uint32 SampleAudioProcessor::beginSampleLoad(int index, const juce::File& file)
+{
+    const juce::ScopedLock lock(sampleFileLock);
+    assignedSampleFiles[(size_t) index] = file;
+    return ++sampleLoadSerials[(size_t) index];
+}
+
+
+/**
+ * @brief Swaps the loaded audio into the slot. A file that could not be read leaves the slot empty.
+ * Called with sampleFileLock held.
+ */
+void SampleAudioProcessor::installLoadedSample(LoadedSample& sample, const juce::File& file, int index)
+{
+    auto storage = std::make_shared<const SampleStore>(std::move(sample.storage));
+    swapInSampleBuffer(storage, sample.slices, index);
+    sampleFiles[(size_t) index] = sample.isValid ? file : juce::File();
+    sampleAnalyses[(size_t) index] = sample.isValid ? sample.analysis : SampleAnalysis();
+    sampleWaveforms[(size_t) index] = sample.isValid ? sample.peaks : nullptr;
+    freezer.update();
+
+    if (! sample.isValid)
+        DBG("Error loading sample sound into slot " + juce::String(index));
+}
+
+
+void SampleAudioProcessor::setSampleLoadOptions(const SampleLoadOptions& options)
+{
+    const juce::ScopedLock lock(sampleFileLock);
+    loadOptions = options;
+}
+
+
+SampleLoadOptions SampleAudioProcessor::getSampleLoadOptions() const
+{
+    const juce::ScopedLock lock(sampleFileLock);
+    return loadOptions;
+}
+
+
+SampleAnalysis SampleAudioProcessor::getSampleAnalysis(int index) const
+{
+    if (index < 0 || index >= NUM_SAMPLES)
+        return {};
+
+    const juce::ScopedLock lock(sampleFileLock);
+    return sampleAnalyses[(size_t) index];
+}
+
+
+std::shared_ptr<const WaveformPeaks> SampleAudioProcessor::getSampleWaveform(int index) const
+{
+    if (index < 0 || index >= NUM_SAMPLES)
+        return {};
+
+    const juce::ScopedLock lock(sampleFileLock);
+    return sampleWaveforms[(size_t) index];
+}
+
+
+std::shared_ptr<const SliceIndex> SampleAudioProcessor::getSampleSlices(int index) const
+{
+    if (index < 0 || index >= NUM_SAMPLES)
+        return {};
+
+    const juce::ScopedLock lock(sampleFileLock);
+    return isSampleFileLoaded[index] ? sampleSlices[(size_t) index] : nullptr;
+}
+
+
+int SampleAudioProcessor::getPlayheadFrame(int index) const noexcept
+{
+    return index >= 0 && index < NUM_SAMPLES ? playheadFrames[(size_t) index].load(std::memory_order_relaxed) : -1;
+}
+
+
+void SampleAudioProcessor::setTrackFrozen(int index, bool shouldBeFrozen)
+{
+    if (index >= 0 && index < NUM_SAMPLES)
+        freezer.setFrozen(index, shouldBeFrozen);
+}
+
+
+bool SampleAudioProcessor::isTrackFrozen(int index) const
+{
+    return index >= 0 && index < NUM_SAMPLES && freezer.isFrozen(index);
+}
+
+
+bool SampleAudioProcessor::isTrackFreezeReady(int index) const
+{
+    if (! isTrackFrozen(index))
+        return false;
+
+    const auto* frozen = freezer.getFrozen(index);
+
+    return frozen != nullptr
+        && frozen->parameterVersion == parameterVersions[index].load(std::memory_order_acquire)
+        && frozen->sampleVersion == sampleVersions[index].load(std::memory_order_acquire);
+}
+
+
+/**
+ * @brief Renders a frozen track again if its parameters or sample have changed since the last render.
+ *
+ * The versions are read before the settings, so a change that races with the render leaves the render
+ * marked as out of date. Settings are computed under stepLockEditLock, which prepareToPlay holds while
+ * rebuilding the coefficient tables. The sample is only looked up under sampleFileLock, which every buffer
+ * swap holds; the render runs on a shared handle to it, so loads, state queries and undo steps do not wait
+ * for a whole render.
+ */
+void SampleAudioProcessor::refreshFrozenTrack(int index)
+{
+    const auto parameterVersion = parameterVersions[index].load(std::memory_order_acquire);
+    const auto sampleVersion = sampleVersions[index].load(std::memory_order_acquire);
+
+    if (const auto* current = freezer.getFrozen(index))
+        if (current->parameterVersion == parameterVersion && current->sampleVersion == sampleVersion)
+            return;
+
+    TrackSettings settings;
+    double sampleRate = 0.0;
+
+    {
+        const juce::ScopedLock lock(stepLockEditLock);
+        settings = computeTrackSettings(index, {});
+        sampleRate = filterTables.getSampleRate();
+    }
+
+    std::shared_ptr<const SampleStore> source;
+
+    {
+        const juce::ScopedLock lock(sampleFileLock);
 
-        auto coeffs = juce::dsp::IIR::Coefficients<float>::makePeakFilter(sampleRate, cutoff, q, juce::Decibels::decibelsToGain(gain));
-        *samplePeakFilters[i].coefficients = *coeffs;
+        if (isSampleFileLoaded[index])
+            source = sampleBuffers[index];
     }
 
-    for (int i = 0; i < NUM_SAMPLES; ++i)
+    if (sampleRate <= 0.0 || source == nullptr)
     {
-        adsrEnvelopes[i].setSampleRate(sampleRate);
+        freezer.publish(index, nullptr);
+        return;
+    }
 
+    AUDIOPLUGIN_TRACE_ZONE_INDEXED("freezeTrack", index)
+    auto frozen = TrackFreezer::render(*source, settings, frozenChannels.load(), sampleRate);
+    frozen->parameterVersion = parameterVersion;
+    frozen->sampleVersion = sampleVersion;
+    freezer.publish(index, std::move(frozen));
+}
 
-        adsrParams[i].attack  = 0.01f;
-        adsrParams[i].decay   = 0.1f;
-        adsrParams[i].sustain = 1.0f;
-        adsrParams[i].release = 0.1f;
 
-        adsrEnvelopes[i].setParameters(adsrParams[i]);
-    }
 
+void SampleAudioProcessor::beginUndoTransaction()
+{
+    const juce::ScopedLock lock(undoLock);
+    undoHistory.beginTransaction();
 }
 
 
+void SampleAudioProcessor::endUndoTransaction()
+{
+    const juce::ScopedLock lock(undoLock);
+
+    if (undoHistory.endTransaction() && ! isRestoringSnapshot)
+        undoHistory.record(captureSnapshot(undoHistory.getCurrent()));
+}
 
 
-void SampleAudioProcessor::releaseResources()
+bool SampleAudioProcessor::undo()
 {
+    const juce::ScopedLock lock(undoLock);
+
+    if (undoHistory.isInTransaction())
+        return false;
+
+    const auto previous = undoHistory.getCurrent();
+    const auto target = undoHistory.undo();
+
+    if (target == nullptr)
+        return false;
 
+    restoreSnapshot(target, previous);
+    return true;
 }
 
-#ifndef JucePlugin_PreferredChannelConfigurations
-bool SampleAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts) const
+
+bool SampleAudioProcessor::redo()
 {
-  #if JucePlugin_IsMidiEffect
-    juce::ignoreUnused (layouts);
-    return true;
-  #else
-    // This is the place where you check if the layout is supported.
-    // In this template code we only support mono or stereo.
-    // Some plugin hosts, such as certain GarageBand versions, will only
-    // load plugins that support stereo bus layouts.
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-     && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
+    const juce::ScopedLock lock(undoLock);
+
+    if (undoHistory.isInTransaction())
         return false;
 
-    // This checks if the input layout matches the output layout
-   #if ! JucePlugin_IsSynth
-    if (layouts.getMainOutputChannelSet() != layouts.getMainInputChannelSet())
+    const auto previous = undoHistory.getCurrent();
+    const auto target = undoHistory.redo();
+
+    if (target == nullptr)
         return false;
-   #endif
 
+    restoreSnapshot(target, previous);
     return true;
-  #endif
 }
-#endif
+
+
+bool SampleAudioProcessor::canUndo() const
+{
+    const juce::ScopedLock lock(undoLock);
+    return undoHistory.canUndo();
+}
+
+
+bool SampleAudioProcessor::canRedo() const
+{
+    const juce::ScopedLock lock(undoLock);
+    return undoHistory.canRedo();
+}
+
+
+void SampleAudioProcessor::recordUndoStep()
+{
+    const juce::ScopedLock lock(undoLock);
+
+    if (! isRestoringSnapshot && ! undoHistory.isInTransaction())
+        undoHistory.record(captureSnapshot(undoHistory.getCurrent()));
+}
 
 
 /**
- * @brief Main audio processing callback.
- * Applies filters, bitcrusher, ADSR envelope, and gain to each active sample, and mixes them into the output buffer.
- * @param buffer The audio buffer to fill.
- * @param midiMessages Incoming MIDI messages (unused).
+ * @brief Captures the step pattern, the BPM and every track's parameters, step locks, play switch and
+ * assigned file.
+ *
+ * Each part is compared with the same part of previous and keeps previous' node when it is equal, so
+ * an edit allocates only the nodes on its own path. If nothing changed, previous itself is returned.
+ *
+ * @param previous Snapshot to share nodes with, or nullptr.
  */
-void SampleAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer&)
+UndoHistory::Snapshot SampleAudioProcessor::captureSnapshot(const UndoHistory::Snapshot& previous) const
 {
-    juce::ScopedNoDenormals noDenormals;
-    const int bufferNumSamples = buffer.getNumSamples();
-    const int numChannels = buffer.getNumChannels();
+    using namespace UndoSnapshot;
 
-    for (int sample = 0; sample < bufferNumSamples; ++sample)
-    {
+    Project project;
+    project.bpm = globalBpm.load();
 
-        for (int i = 0; i < NUM_SAMPLES; ++i)
-        {
-            if (isSampleFileLoaded[i] && isSamplePlaying[i] && stepStates[i][currentStep])
-            {
-                if (sampleReadPositions[i] == 0)
-                    adsrEnvelopes[i].noteOn();
-                else if (sampleReadPositions[i] >= sampleBuffers[i].getNumSamples())
-                    adsrEnvelopes[i].noteOff();
-            }
-        }
+    Pattern pattern;
 
+    for (int track = 0; track < NUM_TRACKS; ++track)
+        pattern.steps[(size_t) track] = getStepPattern(track);
 
-        for (int channel = 0; channel < numChannels; ++channel)
-        {
-            float& outSample = buffer.getWritePointer(channel)[sample];
-            outSample = 0.0f;
+    project.pattern = share(previous != nullptr ? previous->pattern : nullptr, pattern);
 
+    std::array<juce::File, NUM_SAMPLES> files;
 
-            for (int i = 0; i < NUM_SAMPLES; ++i)
-            {
-                if (isSampleFileLoaded[i] && isSamplePlaying[i] &&
-                    stepStates[i][currentStep] &&
-                    sampleReadPositions[i] < sampleBuffers[i].getNumSamples())
-                {
-                    float inSample = sampleBuffers[i]
-                        .getReadPointer(channel % sampleBuffers[i].getNumChannels())[sampleReadPositions[i]];
+    {
+        const juce::ScopedLock lock(sampleFileLock);
+        files = assignedSampleFiles;
+    }
 
-                    if (isNotchEnabled[i])
-                    {
-                        inSample = sampleNotchFilters[i].processSample(inSample);
-                    }
+    bool isUnchanged = previous != nullptr && previous->bpm == project.bpm && previous->pattern == project.pattern;
 
-                    else if (isBandPassEnabled[i])
-                    {
-                        float cutoff = bandPassCutoffs[i] > 0.0f ? bandPassCutoffs[i] : 1000.0f;
-                        float bandwidth = bandPassBandwidths[i] > 1.0f ? bandPassBandwidths[i] : 1.0f;
-                        float q = cutoff / bandwidth;
+    for (int i = 0; i < NUM_SAMPLES; ++i)
+    {
+        const auto& before = previous != nullptr ? previous->tracks[(size_t) i] : nullptr;
 
-                        sampleBandPassFilters[i].setCutoffFrequency(cutoff);
-                        sampleBandPassFilters[i].setResonance(q);
+        Locks locks;
 
-                        inSample = sampleBandPassFilters[i].processSample(0, inSample);
-                    }
+        {
+            const juce::ScopedLock lock(stepLockEditLock);
+            const auto lockedSteps = stepLocks.getLockedSteps(i);
 
-                    else if (isPeakEnabled[i])
-                    {
-                        float cutoff = peakCutoffs[i] > 0.0f ? peakCutoffs[i] : 1000.0f;
-                        float gain = peakGains[i];
-                        float q = peakQs[i] > 0.0f ? peakQs[i] : 1.0f;
+            for (int step = 0; step < NUM_STEPS; ++step)
+                if ((lockedSteps & (1u << step)) != 0)
+                    locks.steps[(size_t) step] = stepLocks.getLock(i, step);
+        }
 
-                        auto coeffs = juce::dsp::IIR::Coefficients<float>::makePeakFilter(getSampleRate(), cutoff, q, juce::Decibels::decibelsToGain(gain));
-                        *samplePeakFilters[i].coefficients = *coeffs;
+        Track track;
+        track.parameters = share(before != nullptr ? before->parameters : nullptr, captureParameters(i));
+        track.locks = share(before != nullptr ? before->locks : nullptr, locks);
+        track.playing = isSamplePlaying[i].load();
+        track.sampleFile = files[(size_t) i];
 
-                        inSample = samplePeakFilters[i].processSample(inSample);
-                    }
-                    else
-                    {
-                        if (isHighPassEnabled[i])
-                            inSample = sampleHighPassFilters[i].processSample(0, inSample);
+        if (before != nullptr && before->parameters == track.parameters && before->locks == track.locks
+                && before->playing == track.playing && before->sampleFile == track.sampleFile)
+        {
+            project.tracks[(size_t) i] = before;
+        }
+        else
+        {
+            project.tracks[(size_t) i] = std::make_shared<const Track>(std::move(track));
+            isUnchanged = false;
+        }
+    }
 
-                        if (isFilterEnabled[i])
-                            inSample = sampleFilters[i].processSample(0, inSample);
-                    }
+    if (isUnchanged)
+        return previous;
 
-                    if (isBitcrusherEnabled[i])
-                    {
-                        int& counter = downsampleCounters[i];
-                        int downsampleFactor = std::max(1, static_cast<int>(downsampleRates[i]));
+    return std::make_shared<const Project>(std::move(project));
+}
 
-                        if (counter == 0)
-                        {
-                            int bitDepth = std::clamp(bitDepths[i], 1, 24);
-                            float maxVal = static_cast<float>((1 << bitDepth) - 1);
-                            inSample = std::round(inSample * maxVal) / maxVal;
-                        }
 
-                        counter = (counter + 1) % downsampleFactor;
-                    }
+/**
+ * @brief Writes a snapshot back, touching only what differs from the processor's actual state.
+ *
+ * The state is captured first with previous as the base, so nodes that were not edited since are
+ * recognised by pointer. Parameters, steps, play switches and the BPM are written while
+ * snapshotRestoreLock is held, and the parameter versions are bumped before it is released, so the
+ * audio thread picks up the complete snapshot at one sub-block. Changed sample assignments are
+ * reloaded on the load pipeline afterwards.
+ *
+ * @param target Snapshot to restore.
+ * @param previous Snapshot the history held before.
+ */
+void SampleAudioProcessor::restoreSnapshot(const UndoHistory::Snapshot& target, const UndoHistory::Snapshot& previous)
+{
+    AUDIOPLUGIN_TRACE_ZONE("restoreSnapshot")
+    const juce::ScopedValueSetter<bool> restoring(isRestoringSnapshot, true);
+    const auto actual = captureSnapshot(previous);
 
-                    // ADSR and gain
-                    float envelopeValue = adsrEnvelopes[i].getNextSample();
-                    inSample *= envelopeValue * gainLevels[i];
-                    outSample += inSample;
-                }
-            }
-        }
+    juce::Array<int> slotsToLoad;
+
+    {
+        const juce::SpinLock::ScopedLockType restoreLock(snapshotRestoreLock);
 
+        globalBpm = target->bpm;
+
+        if (target->pattern != actual->pattern)
+            for (int track = 0; track < NUM_TRACKS; ++track)
+                for (int step = 0; step < NUM_STEPS; ++step)
+                    stepStates[track][step].store((target->pattern->steps[(size_t) track] & (1u << step)) != 0,
+                                                  std::memory_order_relaxed);
 
         for (int i = 0; i < NUM_SAMPLES; ++i)
         {
-            if (isSampleFileLoaded[i] && isSamplePlaying[i] &&
-                stepStates[i][currentStep] &&
-                sampleReadPositions[i] < sampleBuffers[i].getNumSamples())
+            const auto& to = target->tracks[(size_t) i];
+            const auto& from = actual->tracks[(size_t) i];
+
+            if (to == from)
+                continue;
+
+            isSamplePlaying[i] = to->playing;
+
+            if (to->locks != from->locks)
             {
-                ++sampleReadPositions[i];
+                const juce::ScopedLock lock(stepLockEditLock);
+
+                for (int step = 0; step < NUM_STEPS; ++step)
+                    storeStepLock(i, step, to->locks->steps[(size_t) step]);
             }
-        }
 
+            if (to->parameters != from->parameters)
+            {
+                restoreParameters(i, *to->parameters);
+                markParametersChanged(i);
+            }
 
+            if (to->sampleFile != from->sampleFile)
+                slotsToLoad.add(i);
+        }
     }
 
-    int samplesPerStep = globalSamplesPerBeat / 4;
-    sampleCounterForStep += bufferNumSamples;
-
-    sampleCounterForStep += bufferNumSamples;
-
-    while (sampleCounterForStep >= samplesPerStep)
+    for (const int slot : slotsToLoad)
     {
-        sampleCounterForStep -= samplesPerStep;
-        currentStep = (currentStep + 1) % NUM_STEPS;
+        const auto& file = target->tracks[(size_t) slot]->sampleFile;
 
-        for (int i = 0; i < NUM_SAMPLES; ++i)
+        if (file != juce::File())
         {
-            if (stepStates[i][currentStep])
-                sampleReadPositions[i] = 0;
+            loadSampleFileAsync(file, slot);
+            continue;
         }
+
+        beginSampleLoad(slot, file);
+
+        LoadedSample empty;
+        empty.isValid = true;
+
+        const juce::ScopedLock lock(sampleFileLock);
+        installLoadedSample(empty, file, slot);
     }
 
+    stateRestoreCount.fetch_add(1, std::memory_order_release);
 }
 
 
-//==============================================================================
-bool SampleAudioProcessor::hasEditor() const
+UndoSnapshot::Parameters SampleAudioProcessor::captureParameters(int index) const
 {
-    return true; // (change this to false if you choose to not supply an editor)
+    using namespace UndoSnapshot;
+
+    Parameters parameters;
+    auto& values = parameters.values;
+
+    values[lowpassEnabled]    = isFilterEnabled[index] ? 1.0f : 0.0f;
+    values[lowpassCutoff]     = cutoffFrequencies[index];
+    values[highpassEnabled]   = isHighPassEnabled[index] ? 1.0f : 0.0f;
+    values[highpassCutoff]    = highPassCutoffFrequencies[index];
+    values[bandpassEnabled]   = isBandPassEnabled[index] ? 1.0f : 0.0f;
+    values[bandpassCutoff]    = bandPassCutoffs[index];
+    values[bandpassWidth]     = bandPassBandwidths[index];
+    values[notchEnabled]      = isNotchEnabled[index] ? 1.0f : 0.0f;
+    values[notchCutoff]       = notchCutoffs[index];
+    values[notchWidth]        = notchBandwidths[index];
+    values[peakEnabled]       = isPeakEnabled[index] ? 1.0f : 0.0f;
+    values[peakCutoff]        = peakCutoffs[index];
+    values[peakGain]          = peakGains[index];
+    values[peakQ]             = peakQs[index];
+    values[bitcrusherEnabled] = isBitcrusherEnabled[index] ? 1.0f : 0.0f;
+    values[bitDepth]          = (float) bitDepths[index].load();
+    values[downsampleRate]    = downsampleRates[index];
+    values[gain]              = gainLevels[index];
+    values[attack]            = adsrAttacks[index];
+    values[decay]             = adsrDecays[index];
+    values[sustain]           = adsrSustains[index];
+    values[release]           = adsrReleases[index];
+    values[slicePlayback]     = slicePlaybackModes[index] ? 1.0f : 0.0f;
+    values[pitch]             = pitches[index];
+    values[interpolation]     = (float) interpolationQualities[index].load();
+
+    return parameters;
 }
 
-juce::AudioProcessorEditor* SampleAudioProcessor::createEditor()
+
+void SampleAudioProcessor::restoreParameters(int index, const UndoSnapshot::Parameters& parameters)
 {
-    return new SampleAudioProcessorEditor (*this);
+    using namespace UndoSnapshot;
+    const auto& values = parameters.values;
+
+    isFilterEnabled[index]           = values[lowpassEnabled] != 0.0f;
+    cutoffFrequencies[index]         = values[lowpassCutoff];
+    isHighPassEnabled[index]         = values[highpassEnabled] != 0.0f;
+    highPassCutoffFrequencies[index] = values[highpassCutoff];
+    isBandPassEnabled[index]         = values[bandpassEnabled] != 0.0f;
+    bandPassCutoffs[index]           = values[bandpassCutoff];
+    bandPassBandwidths[index]        = values[bandpassWidth];
+    isNotchEnabled[index]            = values[notchEnabled] != 0.0f;
+    notchCutoffs[index]              = values[notchCutoff];
+    notchBandwidths[index]           = values[notchWidth];
+    isPeakEnabled[index]             = values[peakEnabled] != 0.0f;
+    peakCutoffs[index]               = values[peakCutoff];
+    peakGains[index]                 = values[peakGain];
+    peakQs[index]                    = values[peakQ];
+    isBitcrusherEnabled[index]       = values[bitcrusherEnabled] != 0.0f;
+    bitDepths[index]                 = juce::roundToInt(values[bitDepth]);
+    downsampleRates[index]           = values[downsampleRate];
+    gainLevels[index]                = values[gain];
+    adsrAttacks[index]               = values[attack];
+    adsrDecays[index]                = values[decay];
+    adsrSustains[index]              = values[sustain];
+    adsrReleases[index]              = values[release];
+    slicePlaybackModes[index]        = values[slicePlayback] != 0.0f;
+    pitches[index]                   = values[pitch];
+    interpolationQualities[index]    = juce::roundToInt(values[interpolation]);
 }
 
-//==============================================================================
-void SampleAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
+
+/**
+ * @brief Installs a decoded buffer while the audio thread is kept out of the slot.
+ *
+ * Only the buffer and slice handles are exchanged under the lock, so the audio thread is never blocked
+ * by decoding or by freeing the previous sample. The track starts the new sample as if triggered on the
+ * current step.
+ *
+ * @param newBuffer Audio to install. Receives the previous buffer.
+ * @param newSlices Slices of the audio. Receives the previous slices.
+ * @param index The sample index (0 to NUM_SAMPLES - 1).
+ */
+void SampleAudioProcessor::swapInSampleBuffer(std::shared_ptr<const SampleStore>& newBuffer, std::shared_ptr<const SliceIndex>& newSlices, int index)
 {
-    // You should use this method to store your parameters in the memory block.
-    // You could do that either as raw data, or use the XML or ValueTree classes
-    // as intermediaries to make it easy to save and load complex data.
+    const juce::SpinLock::ScopedLockType lock(sampleLocks[index]);
+
+    std::swap(sampleBuffers[index], newBuffer);
+    std::swap(sampleSlices[(size_t) index], newSlices);
+    sampleReadPositions[index] = 0;
+    sampleReadFractions[index] = 0.0;
+    playRegions[index] = {};
+    triggeredSteps[index] = currentStep.load(std::memory_order_relaxed);
+    isSampleFileLoaded[index] = sampleBuffers[index] != nullptr && sampleBuffers[index]->getNumFrames() > 0
+                             && sampleBuffers[index]->getNumChannels() > 0;
+    sampleVersions[index].fetch_add(1, std::memory_order_release);
 }
 
-void SampleAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
+
+
+/**
+ * @brief Bumps the parameter version of a sample. Step locks of the sample are compiled against its
+ * current parameters, so they are recompiled as well.
+ * @param index Index of the sample.
+ */
+void SampleAudioProcessor::markParametersChanged(int index)
 {
-    // You should use this method to restore your parameters from this memory block,
-    // whose contents will have been created by the getStateInformation() call.
+    parameterVersions[index].fetch_add(1, std::memory_order_release);
+    freezer.update();
+
+    {
+        const juce::ScopedLock lock(stepLockEditLock);
+        compileStepLocks(index);
+    }
+
+    recordUndoStep();
 }
 
 
+void SampleAudioProcessor::compileStepLocks(int index)
+{
+    const auto lockedSteps = stepLocks.getLockedSteps(index);
+
+    for (int step = 0; step < NUM_STEPS; ++step)
+        if ((lockedSteps & (1u << step)) != 0)
+            stepLocks.publish(index, step, std::make_unique<const TrackSettings>(computeTrackSettings(index, stepLocks.getLock(index, step))));
+}
 
-/* @brief creates new instances of the plugin..  */
-juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
+
+void SampleAudioProcessor::storeStepLock(int track, int step, const ParameterLock& lock)
 {
-    return new SampleAudioProcessor();
+    if (stepLocks.getLock(track, step) == lock)
+        return;
+
+    stepLocks.setLock(track, step, lock);
+    stepLocks.publish(track, step, lock.isEmpty() ? nullptr
+                                                  : std::make_unique<const TrackSettings>(computeTrackSettings(track, lock)));
 }
 
 
 /**
- * @brief Loads a sample from file into the specified slot.
- * @param file The audio file to load.
- * @param index The sample index (0 to NUM_SAMPLES - 1).
+ * @brief Sets a parameter lock and compiles the step's settings on the calling thread.
+ * @param track Track index.
+ * @param step Step index.
+ * @param target Parameter to override.
+ * @param value Value of the parameter on this step.
  */
-void SampleAudioProcessor::loadSampleFile(const juce::File& file, int index)
+void SampleAudioProcessor::setStepLock(int track, int step, ParameterLock::Target target, float value)
 {
-    if (index < 0 || index >= NUM_SAMPLES)
+    if (track < 0 || track >= NUM_SAMPLES || step < 0 || step >= NUM_STEPS || target >= ParameterLock::numTargets)
         return;
 
-    std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(file));
-    if (reader)
     {
-        sampleBuffers[index].setSize((int)reader->numChannels, (int)reader->lengthInSamples);
-        sampleBuffers[index].clear();
-        reader->read(&sampleBuffers[index], 0, (int)reader->lengthInSamples, 0, true, true);
-        sampleReadPositions[index] = 0;
-        isSampleFileLoaded[index] = true;
+        const juce::ScopedLock lock(stepLockEditLock);
+        auto stepLock = stepLocks.getLock(track, step);
+        stepLock.set(target, value);
+        storeStepLock(track, step, stepLock);
     }
-    else
+
+    recordUndoStep();
+}
+
+
+void SampleAudioProcessor::clearStepLock(int track, int step, ParameterLock::Target target)
+{
+    if (track < 0 || track >= NUM_SAMPLES || step < 0 || step >= NUM_STEPS || target >= ParameterLock::numTargets)
+        return;
+
     {
-        isSampleFileLoaded[index] = false;
-        DBG("Error loading sample sound into slot " + juce::String(index));
+        const juce::ScopedLock lock(stepLockEditLock);
+        auto stepLock = stepLocks.getLock(track, step);
+        stepLock.clear(target);
+        storeStepLock(track, step, stepLock);
+    }
+
+    recordUndoStep();
+}
+
+
+void SampleAudioProcessor::clearStepLocks(int track, int step)
+{
+    if (track < 0 || track >= NUM_SAMPLES || step < 0 || step >= NUM_STEPS)
+        return;
+
+    {
+        const juce::ScopedLock lock(stepLockEditLock);
+        storeStepLock(track, step, {});
     }
+
+    recordUndoStep();
+}
+
+
+ParameterLock SampleAudioProcessor::getStepLock(int track, int step) const
+{
+    if (track < 0 || track >= NUM_SAMPLES || step < 0 || step >= NUM_STEPS)
+        return {};
+
+    const juce::ScopedLock lock(stepLockEditLock);
+    return stepLocks.getLock(track, step);
+}
+
+
+juce::uint32 SampleAudioProcessor::getLockedSteps(int track) const
+{
+    if (track < 0 || track >= NUM_SAMPLES)
+        return 0;
+
+    const juce::ScopedLock lock(stepLockEditLock);
+    return stepLocks.getLockedSteps(track);
 }
 
 
 
 /**
- * @brief Sets the global BPM (beats per minute) and updates timing variables.
+ * @brief Sets the global BPM (beats per minute). The sequencer picks it up at the next sub-block.
  * @param newBpm The new BPM value.
  */
 void SampleAudioProcessor::setGlobalBpm(float newBpm)
 {
     globalBpm = newBpm;
-    if (getSampleRate() > 0.0)
-        globalSamplesPerBeat = static_cast<int>((60.0 / globalBpm) * getSampleRate());
+    recordUndoStep();
+}
+
+
+void SampleAudioProcessor::setStepState(int track, int step, bool isOn)
+{
+    if (track < 0 || track >= NUM_TRACKS || step < 0 || step >= NUM_STEPS)
+        return;
+
+    stepStates[track][step].store(isOn, std::memory_order_relaxed);
+    recordUndoStep();
+}
+
+
+juce::uint32 SampleAudioProcessor::getStepPattern(int track) const
+{
+    if (track < 0 || track >= NUM_TRACKS)
+        return 0;
+
+    juce::uint32 steps = 0;
+
+    for (int step = 0; step < NUM_STEPS; ++step)
+        if (stepStates[track][step].load(std::memory_order_relaxed))
+            steps |= 1u << step;
+
+    return steps;
+}
+
+
+void SampleAudioProcessor::setSamplePlaying(int index, bool shouldPlay)
+{
+    if (index < 0 || index >= NUM_SAMPLES)
+        return;
+
+    isSamplePlaying[index] = shouldPlay;
+    recordUndoStep();
 }
 
 
@@ -437,6 +2009,8 @@ void SampleAudioProcessor::setFilterEnabled(int index, bool enabled)
 
         if (enabled)
             isBandPassEnabled[index] = false;
+
+        markParametersChanged(index);
     }
 }
 
@@ -451,9 +2025,7 @@ void SampleAudioProcessor::setFilterCutoff(int index, float cutoffHz)
     if (index >= 0 && index < NUM_SAMPLES)
     {
         cutoffFrequencies[index] = cutoffHz;
-
-
-        sampleFilters[index].setCutoffFrequency(cutoffHz);
+        markParametersChanged(index);
     }
 }
 
@@ -482,6 +2054,8 @@ void SampleAudioProcessor::setHighpassEnabled(int index, bool enabled)
 
         if (enabled)
             isBandPassEnabled[index] = false;
+
+        markParametersChanged(index);
     }
 }
 
@@ -504,7 +2078,7 @@ float SampleAudioProcessor::getHighpassCutoff(int index) const
 void SampleAudioProcessor::setHighpassCutoff(int index, float cutoff)
 {
     highPassCutoffFrequencies[index] = cutoff;
-    sampleHighPassFilters[index].setCutoffFrequency(cutoff);
+    markParametersChanged(index);
 }
 
 /**
@@ -534,6 +2108,8 @@ void SampleAudioProcessor::setBandPassEnabled(int index, bool enabled)
         isFilterEnabled[index] = false;
         isHighPassEnabled[index] = false;
     }
+
+    markParametersChanged(index);
 }
 
 /**
@@ -543,7 +2119,10 @@ void SampleAudioProcessor::setBandPassEnabled(int index, bool enabled)
  */
 void SampleAudioProcessor::setBandPassCutoff(int index, float value) {
     if (index >= 0 && index < NUM_SAMPLES)
+    {
         bandPassCutoffs[index] = value;
+        markParametersChanged(index);
+    }
 }
 
 
@@ -564,7 +2143,10 @@ float SampleAudioProcessor::getBandPassCutoff(int index) const {
  */
 void SampleAudioProcessor::setBandPassBandwidth(int index, float value) {
     if (index >= 0 && index < NUM_SAMPLES)
+    {
         bandPassBandwidths[index] = value;
+        markParametersChanged(index);
+    }
 }
 
 /**
@@ -604,11 +2186,13 @@ void SampleAudioProcessor::setNotchEnabled(int index, bool enabled)
         isHighPassEnabled[index] = false;
         isBandPassEnabled[index] = false;
     }
+
+    markParametersChanged(index);
 }
 
 
 /**
- * @brief Sets the notch filter cutoff frequency and updates its coefficients.
+ * @brief Sets the notch filter cutoff frequency.
  * @param index Index of the sample.
  * @param value Cutoff frequency in Hz.
  */
@@ -617,12 +2201,12 @@ void SampleAudioProcessor::setNotchCutoff(int index, float value)
     if (index >= 0 && index < NUM_SAMPLES)
     {
         notchCutoffs[index] = value;
-        updateNotchCoefficients(index);
+        markParametersChanged(index);
     }
 }
 
 /**
- * @brief Sets the bandwidth of the notch filter and updates its coefficients.
+ * @brief Sets the bandwidth of the notch filter.
  * @param index Index of the sample.
  * @param value Bandwidth value.
  */
@@ -631,26 +2215,10 @@ void SampleAudioProcessor::setNotchBandwidth(int index, float value)
     if (index >= 0 && index < NUM_SAMPLES)
     {
         notchBandwidths[index] = value;
-        updateNotchCoefficients(index);
+        markParametersChanged(index);
     }
 }
 
-/**
- * @brief Recalculates and applies the notch filter coefficients.
- * @param index Index of the sample.
- */
-void SampleAudioProcessor::updateNotchCoefficients(int index)
-{
-    if (index < 0 || index >= NUM_SAMPLES) return;
-
-    float cutoff = notchCutoffs[index] > 0.0f ? notchCutoffs[index] : 1000.0f;
-    float bandwidth = notchBandwidths[index] > 1.0f ? notchBandwidths[index] : 100.0f;
-    float q = cutoff / bandwidth;
-
-    auto coeffs = juce::dsp::IIR::Coefficients<float>::makeNotch(getSampleRate(), cutoff, q);
-    *sampleNotchFilters[index].coefficients = *coeffs;
-}
-
 /**
  * @brief Checks if the peak (bell) filter is enabled.
  * @param index Index of the sample.
@@ -675,6 +2243,8 @@ void SampleAudioProcessor::setPeakEnabled(int index, bool enabled)
     {
         isBandPassEnabled[index] = false;
     }
+
+    markParametersChanged(index);
 }
 
 /**
@@ -685,7 +2255,10 @@ void SampleAudioProcessor::setPeakEnabled(int index, bool enabled)
 void SampleAudioProcessor::setPeakCutoff(int index, float value)
 {
     if (index >= 0 && index < NUM_SAMPLES)
+    {
         peakCutoffs[index] = value;
+        markParametersChanged(index);
+    }
 }
 
 /**
@@ -696,7 +2269,10 @@ void SampleAudioProcessor::setPeakCutoff(int index, float value)
 void SampleAudioProcessor::setPeakGain(int index, float value)
 {
     if (index >= 0 && index < NUM_SAMPLES)
+    {
         peakGains[index] = value;
+        markParametersChanged(index);
+    }
 }
 
 /**
@@ -707,7 +2283,10 @@ void SampleAudioProcessor::setPeakGain(int index, float value)
 void SampleAudioProcessor::setPeakQ(int index, float value)
 {
     if (index >= 0 && index < NUM_SAMPLES)
+    {
         peakQs[index] = value;
+        markParametersChanged(index);
+    }
 }
 
 /**
@@ -718,6 +2297,7 @@ void SampleAudioProcessor::setPeakQ(int index, float value)
 void SampleAudioProcessor::setBitcrusherEnabled(int index, bool enabled)
 {
     isBitcrusherEnabled[index] = enabled;
+    markParametersChanged(index);
 }
 
 /**
@@ -728,6 +2308,7 @@ void SampleAudioProcessor::setBitcrusherEnabled(int index, bool enabled)
 void SampleAudioProcessor::setBitDepth(int index, int depth)
 {
     bitDepths[index] = depth;
+    markParametersChanged(index);
 }
 
 /**
@@ -738,6 +2319,49 @@ void SampleAudioProcessor::setBitDepth(int index, int depth)
 void SampleAudioProcessor::setDownsampleRate(int index, float rate)
 {
     downsampleRates[index] = rate;
+    markParametersChanged(index);
+}
+
+/**
+ * @brief Switches a track between playing its whole sample and its slices.
+ * @param index Index of the sample.
+ * @param shouldPlaySlices True to play a slice per trigger.
+ */
+void SampleAudioProcessor::setSlicePlayback(int index, bool shouldPlaySlices)
+{
+    if (index >= 0 && index < NUM_SAMPLES)
+    {
+        slicePlaybackModes[index] = shouldPlaySlices;
+        markParametersChanged(index);
+    }
+}
+
+/**
+ * @brief Sets the pitch of a track.
+ * @param index Index of the sample.
+ * @param semitones Pitch relative to the sample; limited to +-maxPitch.
+ */
+void SampleAudioProcessor::setPitch(int index, float semitones)
+{
+    if (index >= 0 && index < NUM_SAMPLES)
+    {
+        pitches[index] = juce::jlimit(-maxPitch, maxPitch, semitones);
+        markParametersChanged(index);
+    }
+}
+
+/**
+ * @brief Sets the interpolation kernel of a track.
+ * @param index Index of the sample.
+ * @param quality Kernel used while the track is pitched.
+ */
+void SampleAudioProcessor::setInterpolation(int index, SampleInterpolator::Quality quality)
+{
+    if (index >= 0 && index < NUM_SAMPLES)
+    {
+        interpolationQualities[index] = (int) quality;
+        markParametersChanged(index);
+    }
 }
 
 /**
@@ -748,7 +2372,10 @@ void SampleAudioProcessor::setDownsampleRate(int index, float rate)
 void SampleAudioProcessor::setGainLevel(int index, float gain)
 {
     if (index >= 0 && index < NUM_SAMPLES)
+    {
         gainLevels[index] = gain;
+        markParametersChanged(index);
+    }
 }
 
 /**
@@ -758,7 +2385,7 @@ void SampleAudioProcessor::setGainLevel(int index, float gain)
  */
 float SampleAudioProcessor::getGainLevel(int index) const
 {
-    return (index >= 0 && index < NUM_SAMPLES) ? gainLevels[index] : 1.0f;
+    return (index >= 0 && index < NUM_SAMPLES) ? gainLevels[index].load() : 1.0f;
 }
 
 
@@ -771,8 +2398,8 @@ void SampleAudioProcessor::setAdsrAttack(int index, float value)
 {
     if (index >= 0 && index < NUM_SAMPLES)
     {
-        adsrParams[index].attack = value;
-        adsrEnvelopes[index].setParameters(adsrParams[index]);
+        adsrAttacks[index] = value;
+        markParametersChanged(index);
     }
 }
 
@@ -785,8 +2412,8 @@ void SampleAudioProcessor::setAdsrDecay(int index, float value)
 {
     if (index >= 0 && index < NUM_SAMPLES)
     {
-        adsrParams[index].decay = value;
-        adsrEnvelopes[index].setParameters(adsrParams[index]);
+        adsrDecays[index] = value;
+        markParametersChanged(index);
     }
 }
 
@@ -799,8 +2426,8 @@ void SampleAudioProcessor::setAdsrSustain(int index, float value)
 {
     if (index >= 0 && index < NUM_SAMPLES)
     {
-        adsrParams[index].sustain = value;
-        adsrEnvelopes[index].setParameters(adsrParams[index]);
+        adsrSustains[index] = value;
+        markParametersChanged(index);
     }
 }
 
@@ -814,8 +2441,8 @@ void SampleAudioProcessor::setAdsrRelease(int index, float value)
 {
     if (index >= 0 && index < NUM_SAMPLES)
     {
-        adsrParams[index].release = value;
-        adsrEnvelopes[index].setParameters(adsrParams[index]);
+        adsrReleases[index] = value;
+        markParametersChanged(index);
     }
 }
 
@@ -826,7 +2453,7 @@ void SampleAudioProcessor::setAdsrRelease(int index, float value)
  */
 float SampleAudioProcessor::getAdsrAttack(int index) const
 {
-    return (index >= 0 && index < NUM_SAMPLES) ? adsrParams[index].attack : 0.0f;
+    return (index >= 0 && index < NUM_SAMPLES) ? adsrAttacks[index].load() : 0.0f;
 }
 
 /**
@@ -836,7 +2463,7 @@ float SampleAudioProcessor::getAdsrAttack(int index) const
  */
 float SampleAudioProcessor::getAdsrDecay(int index) const
 {
-    return (index >= 0 && index < NUM_SAMPLES) ? adsrParams[index].decay : 0.0f;
+    return (index >= 0 && index < NUM_SAMPLES) ? adsrDecays[index].load() : 0.0f;
 }
 
 /**
@@ -846,7 +2473,7 @@ float SampleAudioProcessor::getAdsrDecay(int index) const
  */
 float SampleAudioProcessor::getAdsrSustain(int index) const
 {
-    return (index >= 0 && index < NUM_SAMPLES) ? adsrParams[index].sustain : 0.0f;
+    return (index >= 0 && index < NUM_SAMPLES) ? adsrSustains[index].load() : 0.0f;
 }
 
 
@@ -857,5 +2484,5 @@ float SampleAudioProcessor::getAdsrSustain(int index) const
  */
 float SampleAudioProcessor::getAdsrRelease(int index) const
 {
-    return (index >= 0 && index < NUM_SAMPLES) ? adsrParams[index].release : 0.0f;
+    return (index >= 0 && index < NUM_SAMPLES) ? adsrReleases[index].load() : 0.0f;
 }
\ No newline at end of file
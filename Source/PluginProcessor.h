@@ -7,6 +7,17 @@
 #include <juce_audio_formats/juce_audio_formats.h>
 #include <juce_dsp/juce_dsp.h>
 
+#include "PerformanceTelemetry.h"
+#include "FilterCoefficientTables.h"
+#include "StateVariableFilter.h"
+#include "ParameterLocks.h"
+#include "ModulationMatrix.h"
+#include "SampleLoadPipeline.h"
+#include "TrackFreezer.h"
+#include "UndoHistory.h"
+#include "SpectrumAnalyser.h"
+#include "LevelMeter.h"
+
 
 /**
  * @class SampleAudioProcessor
@@ -73,14 +84,163 @@ public:
     void getStateInformation (juce::MemoryBlock& destData) override;
     void setStateInformation (const void* data, int sizeInBytes) override;
 
+    /**
+     * @brief Returns the complete processor state as a ValueTree.
+     * @return State containing BPM, step pattern, sample files and effect settings.
+     */
+    juce::ValueTree getStateTree() const;
+
+    /**
+     * @brief Restores a state created by getStateTree() and reloads the referenced sample files.
+     * @param state The state to restore.
+     */
+    void setStateTree(const juce::ValueTree& state);
+
 
     /**
      * @brief Loads an audio sample from a file into a given slot.
+     *
+     * Like every load, it records its undo step when the file is assigned to the slot, before the audio is
+     * installed; snapshots hold the assigned file, not its audio.
+     *
      * @param file Audio file to load.
      * @param index Slot index to load into (0 to NUM_SAMPLES-1).
      */
     void loadSampleFile(const juce::File& file, int index);
 
+    /**
+     * @brief Loads already decoded audio into a given slot, e.g. generated test material.
+     *
+     * The audio is installed untrimmed and at its own level; it is only analysed and kept in the storage
+     * format of the load options. The undo step is recorded when the slot is assigned, as for loadSampleFile().
+     *
+     * @param buffer Audio to copy into the slot.
+     * @param index Slot index to load into (0 to NUM_SAMPLES-1).
+     */
+    void loadSampleBuffer(const juce::AudioBuffer<float>& buffer, int index);
+
+    /**
+     * @brief Loads a sample file on the worker pool and installs it on the message thread once it is ready.
+     *
+     * Must be called on the message thread. A later load into the same slot supersedes a pending one. The
+     * undo step is recorded when the slot is assigned, as for loadSampleFile(), not when the file is ready.
+     *
+     * @param file Audio file to load.
+     * @param index Slot index to load into (0 to NUM_SAMPLES-1).
+     */
+    void loadSampleFileAsync(const juce::File& file, int index);
+
+    /**
+     * @brief Plays a file once through the output, e.g. to preview it from the sample library.
+     *
+     * The file is decoded on the worker pool with the current load options but without writing index
+     * files, and replaces the preview that is playing once it is ready. Must be called on the message thread.
+     *
+     * @param file Audio file to preview.
+     */
+    void auditionSampleFile(const juce::File& file);
+
+    /** @brief Plays already decoded audio once through the output, e.g. generated test material. */
+    void auditionSampleBuffer(const juce::AudioBuffer<float>& buffer);
+
+    /** @brief Stops the preview and discards a pending one. */
+    void stopAudition();
+
+    /** @brief True while a preview is playing. */
+    bool isAuditioning() const noexcept { return auditionActive.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Sets how sample files are trimmed, normalised and stored in memory when they are loaded.
+     *
+     * Applies to files loaded afterwards and is stored with the plugin state.
+     */
+    void setSampleLoadOptions(const SampleLoadOptions& options);
+
+    /** @brief Returns the trimming, normalisation and storage settings for sample files. */
+    SampleLoadOptions getSampleLoadOptions() const;
+
+    /** @brief Returns the analysis of the sample in a slot: audible length, peak, RMS, loudness and DC offset. */
+    SampleAnalysis getSampleAnalysis(int index) const;
+
+    /** @brief Returns the waveform peaks of the sample in a slot, or nullptr for an empty slot. */
+    std::shared_ptr<const WaveformPeaks> getSampleWaveform(int index) const;
+
+    /**
+     * @brief Returns the slices detected in the sample of a slot, or nullptr for an empty slot.
+     *
+     * Onsets are detected on the load pipeline's workers when a sample is loaded, see SliceIndex.
+     */
+    std::shared_ptr<const SliceIndex> getSampleSlices(int index) const;
+
+    /**
+     * @brief Switches a track between playing its whole sample and playing slices.
+     *
+     * In slice playback a trigger on step n plays slice n of the sample, wrapping around the number of
+     * slices, unless the step has a slice parameter lock. A slice starts at its exact frame of the sample,
+     * plays up to the next slice and is faded in and out over sliceFadeSeconds where it borders another
+     * one. Frozen tracks play live while they play slices.
+     */
+    void setSlicePlayback(int index, bool shouldPlaySlices);
+
+    /** @brief Returns whether a track plays slices. */
+    bool getSlicePlayback(int index) const { return slicePlaybackModes[index]; }
+
+    /** @brief Length of the ramps at the borders of a slice. */
+    static constexpr double sliceFadeSeconds = 0.002;
+
+    /**
+     * @brief Sets the pitch a track plays its sample at.
+     *
+     * The sample is read faster or slower, so its length changes with its pitch. Away from the sample's
+     * own pitch every frame is interpolated with the track's interpolation kernel. A step's pitch
+     * parameter lock replaces the track's pitch for the note it starts. Frozen tracks play live while
+     * they are pitched.
+     *
+     * @param index Track index.
+     * @param semitones Pitch relative to the sample, fractional for fine tuning, limited to +-maxPitch.
+     */
+    void setPitch(int index, float semitones);
+
+    /** @brief Returns the pitch of a track in semitones. */
+    float getPitch(int index) const { return pitches[index]; }
+
+    /** @brief Sets the kernel a pitched track interpolates its sample with, see SampleInterpolator. */
+    void setInterpolation(int index, SampleInterpolator::Quality quality);
+
+    /** @brief Returns the interpolation kernel of a track. */
+    SampleInterpolator::Quality getInterpolation(int index) const
+    {
+        return static_cast<SampleInterpolator::Quality>(interpolationQualities[index].load());
+    }
+
+    /** @brief Largest pitch shift in semitones either way; two octaves up reads SampleInterpolator::maxIncrement frames per frame. */
+    static constexpr float maxPitch = 24.0f;
+
+    /**
+     * @brief Returns the frame of its sample a track played up to in the last block, or -1 if it did
+     * not play. Published by the audio thread through an atomic, for displays.
+     */
+    int getPlayheadFrame(int index) const noexcept;
+
+    /**
+     * @brief Freezes or unfreezes a track.
+     *
+     * A frozen track is rendered through its filters, bitcrusher, envelope and gain once on a background
+     * thread, and every trigger plays that render. Any change of the track's parameters or sample starts
+     * a new render; until it is ready, and on steps with parameter locks or while modulation is routed to
+     * the track, the track is rendered live. Must be called on the message thread.
+     *
+     * @param index Track index.
+     * @param shouldBeFrozen Whether the track plays from its render.
+     */
+    void setTrackFrozen(int index, bool shouldBeFrozen);
+
+    /** @brief Returns whether a track is frozen. */
+    bool isTrackFrozen(int index) const;
+
+    /** @brief Returns whether a frozen track's render matches its current parameters and sample. */
+    bool isTrackFreezeReady(int index) const;
+
     /**
      * @brief Sets the global BPM value.
      * @param newBpm The new BPM to use.
@@ -91,20 +251,59 @@ public:
      * @brief Returns the current global BPM value.
      * @return Current BPM.
      */
-    float getGlobalBpm() const { return globalBpm; }
+    float getGlobalBpm() const { return globalBpm.load(); }
 
     /** @brief Total number of supported samples. */
     static constexpr int NUM_SAMPLES = 5;
 
+    /** @brief Total number of steps in the step sequencer */
+    static constexpr int NUM_STEPS = 16;
+
+    /** @brief Number of frames rendered between two control updates unless changed with setSubBlockSize(). */
+    static constexpr int defaultSubBlockSize = 32;
+
+    /**
+     * @brief Sets the number of frames the processor renders between parameter and sequencer updates.
+     *
+     * Host blocks are split into sub-blocks of this size. Takes effect with the next prepareToPlay(); the
+     * audio thread only reads the size prepareToPlay() copied. Must be called on the message thread.
+     *
+     * @param numFrames Sub-block size, limited to 1...1024.
+     */
+    void setSubBlockSize(int numFrames) { subBlockSize = juce::jlimit(1, 1024, numFrames); }
+
+    /** @brief Returns the configured sub-block size. */
+    int getSubBlockSize() const { return subBlockSize; }
+
 
     /** @brief Tracks whether each sample is currently playing. */
-    std::array<bool, NUM_SAMPLES> isSamplePlaying {};
+    std::array<std::atomic<bool>, NUM_SAMPLES> isSamplePlaying {};
+
+    /** @brief Starts or stops a sample and records the change as an undo step. */
+    void setSamplePlaying(int index, bool shouldPlay);
 
     /**
      * @brief Returns the current step in the sequencer.
      * @return Step index (0 to NUM_STEPS-1).
      */
-    int getCurrentStep() const { return currentStep; }
+    int getCurrentStep() const { return currentStep.load(std::memory_order_relaxed); }
+
+    /** @brief A sequencer step and when it started, see getPlayheadPosition(). */
+    struct PlayheadPosition
+    {
+        int step = 0;
+        double startMs = 0.0;           ///< Start of the step on the Time::getMillisecondCounterHiRes() clock; 0 before the first step
+        double stepMs = 0.0;            ///< Length of a step at the tempo it started with
+    };
+
+    /**
+     * @brief Returns the step the sequencer last moved to and when it starts to sound.
+     *
+     * Step and start time are published by the audio thread as one atomic value, so they always belong
+     * together. The start lies at the step's frame within the block, which can be later than the moment
+     * the block was rendered; displays extrapolate from it between blocks.
+     */
+    PlayheadPosition getPlayheadPosition() const noexcept;
 
     /**
      * @brief Enables or disables a step in the sequencer.
@@ -112,10 +311,38 @@ public:
      * @param step Step index.
      * @param isOn Whether the step should be active.
      */
-    void setStepState(int track, int step, bool isOn)
-    {
-        stepStates[track][step] = isOn;
-    }
+    void setStepState(int track, int step, bool isOn);
+
+    /** @brief Returns whether a step of the sequencer is active. */
+    bool getStepState(int track, int step) const { return stepStates[track][step].load(std::memory_order_relaxed); }
+
+    /** @brief Returns a bit per active step of a track. */
+    juce::uint32 getStepPattern(int track) const;
+
+    /**
+     * @brief Overrides a parameter of a track for one step (a parameter lock).
+     *
+     * The lock's filter coefficients are computed right away on the calling thread; the audio thread
+     * installs them when the step triggers.
+     *
+     * @param track Track index.
+     * @param step Step index.
+     * @param target Parameter to override.
+     * @param value Value the parameter takes on this step.
+     */
+    void setStepLock(int track, int step, ParameterLock::Target target, float value);
+
+    /** @brief Removes the override of one parameter from a step. */
+    void clearStepLock(int track, int step, ParameterLock::Target target);
+
+    /** @brief Removes all overrides from a step. */
+    void clearStepLocks(int track, int step);
+
+    /** @brief Returns the overrides of a step. */
+    ParameterLock getStepLock(int track, int step) const;
+
+    /** @brief Returns a bit per step of a track that has overrides. */
+    juce::uint32 getLockedSteps(int track) const;
 
     /** @brief Enables or disables the low-pass filter for a given sample. */
     void setFilterEnabled(int index, bool enabled);
@@ -126,6 +353,9 @@ public:
     /** @brief Checks whether the low-pass filter is enabled. */
     bool getFilterEnabled(int index) const { return isFilterEnabled[index]; }
 
+    /** @brief Returns the low-pass cutoff frequency. */
+    float getFilterCutoff(int index) const { return cutoffFrequencies[index]; }
+
     /** @brief Checks whether the high-pass filter is enabled. */
     bool getHighpassEnabled(int index) const;
 
@@ -168,6 +398,12 @@ public:
     /** @brief Sets the notch filter bandwidth. */
     void setNotchBandwidth(int index, float value);
 
+    /** @brief Returns the notch filter cutoff frequency. */
+    float getNotchCutoff(int index) const { return notchCutoffs[index]; }
+
+    /** @brief Returns the notch filter bandwidth. */
+    float getNotchBandwidth(int index) const { return notchBandwidths[index]; }
+
     /** @brief Checks whether the peak filter is enabled. */
     bool getPeakEnabled(int index) const;
 
@@ -183,6 +419,15 @@ public:
     /** @brief Sets the Q factor (width) of the peak filter. */
     void setPeakQ(int index, float value);
 
+    /** @brief Returns the peak filter cutoff frequency. */
+    float getPeakCutoff(int index) const { return peakCutoffs[index]; }
+
+    /** @brief Returns the gain of the peak filter. */
+    float getPeakGain(int index) const { return peakGains[index]; }
+
+    /** @brief Returns the Q factor of the peak filter. */
+    float getPeakQ(int index) const { return peakQs[index]; }
+
     /** @brief Enables or disables the bitcrusher effect. */
     void setBitcrusherEnabled(int index, bool enabled);
 
@@ -192,6 +437,15 @@ public:
     /** @brief Sets the downsampling rate for the bitcrusher. */
     void setDownsampleRate(int index, float rate);
 
+    /** @brief Checks whether the bitcrusher is enabled. */
+    bool getBitcrusherEnabled(int index) const { return isBitcrusherEnabled[index]; }
+
+    /** @brief Returns the bit depth of the bitcrusher. */
+    int getBitDepth(int index) const { return bitDepths[index]; }
+
+    /** @brief Returns the downsampling rate of the bitcrusher. */
+    float getDownsampleRate(int index) const { return downsampleRates[index]; }
+
     /** @brief Sets the gain level for a sample. */
     void setGainLevel(int index, float gain);
 
@@ -222,66 +476,250 @@ public:
     /** @brief Gets the ADSR release value. */
     float getAdsrRelease(int index) const;
 
+    /**
+     * @brief Returns the modulation sources and routing.
+     *
+     * Routing and source settings can be changed from any thread; the audio thread picks them up at the next sub-block.
+     */
+    ModulationMatrix& getModulationMatrix() { return modulation; }
+
+    /** @brief Returns the audio thread timing statistics. */
+    PerformanceTelemetry& getTelemetry() { return telemetry; }
+
+    /** @brief Analyser source of the master output; the tracks use their index. */
+    static constexpr int masterSpectrumSource = NUM_SAMPLES;
+
+    /**
+     * @brief Returns the spectrum analyser fed with every track after its gain and with the master output.
+     *
+     * A source costs the audio thread nothing until it is enabled, and then a copy of its frames.
+     */
+    SpectrumAnalyser& getSpectrumAnalyser() { return spectrumAnalyser; }
+
+    /**
+     * @brief Computes the magnitude response of a track's enabled filters at its current settings,
+     * without step locks or modulation. Flat before the processor has been prepared.
+     * @param index Track index.
+     * @param frequencies Frequencies in Hz.
+     * @param decibels Receives the gain at each frequency.
+     * @param count Number of frequencies.
+     */
+    void getFilterResponse(int index, const float* frequencies, float* decibels, int count) const;
+
+    /** @brief Returns the level meter of a track, measured after its gain. */
+    LevelMeter& getTrackMeter(int index) { return trackMeters[(size_t) index]; }
+
+    /** @brief Returns the level meter of the summed output. */
+    LevelMeter& getMasterMeter() { return masterMeter; }
+
+    //================== Undo ==================
+
+    /**
+     * @brief Groups all edits until the matching endUndoTransaction() into a single undo step, e.g. a knob drag.
+     *
+     * Outside a transaction every edit of the step pattern, a track parameter, a step lock, the BPM or a
+     * sample assignment is an undo step of its own. Transactions nest.
+     */
+    void beginUndoTransaction();
+
+    /** @brief Ends a transaction; the outermost one records the accumulated edits as one step. */
+    void endUndoTransaction();
+
+    /**
+     * @brief Restores the state before the last undo step.
+     *
+     * Only the tracks that differ from the current state are written, and the audio thread sees the
+     * whole change at once. Samples are reloaded asynchronously if their assignment differs.
+     *
+     * @return False if there was nothing to undo.
+     */
+    bool undo();
+
+    /** @brief Restores the state undone last. Returns false if there was nothing to redo. */
+    bool redo();
+
+    bool canUndo() const;
+    bool canRedo() const;
+
+    /**
+     * @brief Incremented after every undo, redo and setStateTree(), so an editor can tell when to reread its controls.
+     */
+    juce::uint32 getStateRestoreCount() const noexcept { return stateRestoreCount.load(std::memory_order_acquire); }
+
 
 
 
 private:
-    /* @brief Manages audio format readers and writers. */
-    juce::AudioFormatManager formatManager;
+    /* @brief Decodes, trims, normalises and analyses sample files. */
+    SampleLoadPipeline loadPipeline;
 
-    /* @brief Audio buffers for each loaded sample. */
-    std::array<juce::AudioBuffer<float>, NUM_SAMPLES> sampleBuffers;
+    /**
+     * @brief Frames of each loaded sample, in the storage format of the load options it was loaded with, or
+     * nullptr. A store is immutable once installed and shared, so the freezer can keep rendering one after
+     * it was replaced without holding sampleFileLock.
+     */
+    std::array<std::shared_ptr<const SampleStore>, NUM_SAMPLES> sampleBuffers;
 
     /* @brief  Current read positions for each sample buffer. */
     std::array<int, NUM_SAMPLES> sampleReadPositions {};
 
+    /* @brief Fraction of a frame each read position lies past sampleReadPositions while a track is pitched. */
+    std::array<double, NUM_SAMPLES> sampleReadFractions {};
+
+    /* @brief Step a track was triggered on and has not started playing yet, or -1. Set by advanceSequencer(). */
+    std::array<int, NUM_SAMPLES> triggeredSteps {};
+
+    /* @brief Frames of its sample the current note of a track plays: the whole sample or one slice. */
+    std::array<juce::Range<int>, NUM_SAMPLES> playRegions {};
+
+    /* @brief Whether each track plays slices, see setSlicePlayback(). */
+    std::array<std::atomic<bool>, NUM_SAMPLES> slicePlaybackModes {};
+
+    /* @brief Length of the slice ramps in frames at the current sample rate. */
+    int sliceFadeFrames = 0;
+
+    /* @brief Pitch of each track in semitones and its SampleInterpolator::Quality, see setPitch() and setInterpolation(). */
+    std::array<std::atomic<float>, NUM_SAMPLES> pitches {};
+    std::array<std::atomic<int>, NUM_SAMPLES> interpolationQualities {};
+
+    /* @brief Whether a track played in the current block, and the read positions published after it, see getPlayheadFrame(). */
+    std::array<bool, NUM_SAMPLES> playedInBlock {};
+    std::array<std::atomic<int>, NUM_SAMPLES> playheadFrames {};
+
+    /* @brief Files the sample buffers were loaded from, stored with the plugin state. */
+    std::array<juce::File, NUM_SAMPLES> sampleFiles;
+
     /* @brief Indicates whether a sample file has been successfully loaded. */
     std::array<bool, NUM_SAMPLES> isSampleFileLoaded {};
 
+    /* @brief Load settings, the analysis of each slot and a counter per slot that lets a newer load discard a pending one. */
+    SampleLoadOptions loadOptions;
+    std::array<SampleAnalysis, NUM_SAMPLES> sampleAnalyses;
+    std::array<std::shared_ptr<const WaveformPeaks>, NUM_SAMPLES> sampleWaveforms;
+    std::array<juce::uint32, NUM_SAMPLES> sampleLoadSerials {};
+
+    /* @brief Slices of each slot, swapped together with its buffer, so the audio thread reads them under the sample lock. */
+    std::array<std::shared_ptr<const SliceIndex>, NUM_SAMPLES> sampleSlices;
+
+    /* @brief Guards the sample files, analyses, waveforms, slices, load options and load counters. */
+    juce::CriticalSection sampleFileLock;
+
+    /* @brief Guards each sample buffer while a newly loaded one is swapped in. The audio thread only try-locks. */
+    std::array<juce::SpinLock, NUM_SAMPLES> sampleLocks;
+
+    /* @brief Preview from auditionSampleFile(), played at the sample's own pitch after the tracks, and the lock it is swapped in under. */
+    SampleStore auditionSample;
+    int auditionPosition = 0;
+    std::atomic<bool> auditionActive { false };
+    juce::SpinLock auditionLock;
+
+    /* @brief Lets a later preview or stopAudition() discard a pending one. */
+    std::atomic<juce::uint32> auditionSerial { 0 };
+
+    /**
+     * @brief Replaces the preview while the audio thread is kept out of it.
+     * @param newSample Audio to play from its start. Receives the previous preview, which the caller frees.
+     */
+    void swapInAudition(SampleStore& newSample);
+
+    /**
+     * @brief Adds the next frames of the preview to a range of the output buffer.
+     */
+    void renderAudition(juce::AudioBuffer<float>& buffer, int startSample, int numFrames) noexcept;
+
+    /**
+     * @brief Replaces the buffer and slices of a slot with already decoded audio.
+     * @param newBuffer Audio to install. Receives the previous buffer, which the caller releases.
+     * @param newSlices Slices of the audio. Receives the previous slices.
+     * @param index Slot index.
+     */
+    void swapInSampleBuffer(std::shared_ptr<const SampleStore>& newBuffer, std::shared_ptr<const SliceIndex>& newSlices, int index);
+
+    /**
+     * @brief Installs the result of the load pipeline and records where it came from.
+     * @param sample Loaded sample. Its storage is moved into the slot.
+     * @param file File the sample was loaded from.
+     * @param index Slot index.
+     */
+    void installLoadedSample(LoadedSample& sample, const juce::File& file, int index);
+
+    /**
+     * @brief Assigns a file to a slot and returns a new load counter value, invalidating pending asynchronous loads.
+     * @param index Slot index.
+     * @param file File about to be loaded, or an empty File for generated audio.
+     */
+    juce::uint32 beginSampleLoad(int index, const juce::File& file);
+
+    /* @brief Incremented whenever a slot's buffer is replaced or playback is re-prepared; frozen renders carry the value they were made from. */
+    std::array<std::atomic<juce::uint32>, NUM_SAMPLES> sampleVersions {};
+
     /* @brief  Sample playback counters, useful for synchronization. */
     std::array<int, NUM_SAMPLES> SampleCounters {};
 
     /* @brief Global BPM used for timing and sequencing.*/
-    float globalBpm = 120.0f;
+    std::atomic<float> globalBpm { 120.0f };
 
-    /* @brief Number of samples per beat, calculated from BPM and sample rate.*/
-    int globalSamplesPerBeat = 0;
-
-    /* @brief Total number of steps in the step sequencer */
-    static constexpr int NUM_STEPS = 16;
+    /* @brief File each slot was last asked to load, recorded in undo snapshots. Guarded by sampleFileLock. */
+    std::array<juce::File, NUM_SAMPLES> assignedSampleFiles;
 
     /* @brief Total number of sample slots .*/
     static constexpr int NUM_TRACKS = 6;
 
     /* @brief Sequencer state: true if a step is active, false otherwise. Accessed as [track][step].  */
-    std::array<std::array<bool, NUM_STEPS>, NUM_TRACKS> stepStates {};
+    std::array<std::array<std::atomic<bool>, NUM_STEPS>, NUM_TRACKS> stepStates {};
 
-    /* @brief Index of the current step being played. */
-    int currentStep = 0;
+    /* @brief Index of the current step being played. Written by the audio thread only. */
+    std::atomic<int> currentStep { 0 };
 
     /* @brief Internal sample counter used to trigger step advancement.*/
     int sampleCounterForStep = 0;
 
+    /* @brief Current step in the low 8 bits and its start in microseconds above them, see getPlayheadPosition(). */
+    std::atomic<juce::uint64> playheadStamp { 0 };
+    std::atomic<float> playheadStepMs { 0.0f };
+
+    /* @brief Time::getMillisecondCounterHiRes() at the start of the block being rendered. */
+    double blockStartMs = 0.0;
+
+    /* @brief Step pattern, play switches and tempo the audio thread plays, copied from the editable state in updateControlState(). */
+    std::array<juce::uint32, NUM_TRACKS> playedSteps {};
+    std::array<bool, NUM_SAMPLES> playedTracks {};
+    float playedBpm = 120.0f;
+
+    /* @brief Number of frames rendered between control updates, see setSubBlockSize(). */
+    int subBlockSize = defaultSubBlockSize;
+
+    /* @brief Sub-block size the audio thread renders with, copied from subBlockSize in prepareToPlay(). */
+    int preparedSubBlockSize = defaultSubBlockSize;
+
+
+    //================== Coefficient Tables ==================
+
+    /**
+     * @brief Frequency and decibel lookup tables for the current sample rate, built in prepareToPlay.
+     */
+    FilterCoefficientTables filterTables;
+
 
     //================== Low-Pass Filter ==================
 
     /**
      * @brief State-variable low-pass filters applied independently to each sample slot.
      *
-     * These filters remove high-frequency content from each sample using JUCE's
-     * StateVariableTPTFilter in low-pass mode.
+     * These filters remove high-frequency content from each sample using a
+     * StateVariableFilter in low-pass mode.
      */
-    std::array<juce::dsp::StateVariableTPTFilter<float>, NUM_SAMPLES> sampleFilters;
+    std::array<StateVariableFilter, NUM_SAMPLES> sampleFilters;
 
     /**
      * @brief Flags indicating whether the low-pass filter is enabled for each sample.
      */
-    std::array<bool, NUM_SAMPLES> isFilterEnabled {};
+    std::array<std::atomic<bool>, NUM_SAMPLES> isFilterEnabled {};
 
     /**
      * @brief Cutoff frequencies (in Hz) for each sample's low-pass filter.
      */
-    std::array<float, NUM_SAMPLES> cutoffFrequencies {};
+    std::array<std::atomic<float>, NUM_SAMPLES> cutoffFrequencies {};
 
 
     //================== High-Pass Filter ==================
@@ -291,17 +729,17 @@ private:
      *
      * These filters remove low-frequency content from each sample.
      */
-    std::array<juce::dsp::StateVariableTPTFilter<float>, NUM_SAMPLES> sampleHighPassFilters;
+    std::array<StateVariableFilter, NUM_SAMPLES> sampleHighPassFilters;
 
     /**
      * @brief Flags indicating whether the high-pass filter is enabled for each sample.
      */
-    std::array<bool, NUM_SAMPLES> isHighPassEnabled {};
+    std::array<std::atomic<bool>, NUM_SAMPLES> isHighPassEnabled {};
 
     /**
      * @brief Cutoff frequencies (in Hz) for each sample's high-pass filter.
      */
-    std::array<float, NUM_SAMPLES> highPassCutoffFrequencies {};
+    std::array<std::atomic<float>, NUM_SAMPLES> highPassCutoffFrequencies {};
 
 
     //================== Band-Pass Filter ==================
@@ -311,22 +749,22 @@ private:
      *
      * These filters isolate a specific frequency band from the input signal.
      */
-    std::array<juce::dsp::StateVariableTPTFilter<float>, NUM_SAMPLES> sampleBandPassFilters;
+    std::array<StateVariableFilter, NUM_SAMPLES> sampleBandPassFilters;
 
     /**
      * @brief Flags indicating whether the band-pass filter is enabled for each sample.
      */
-    std::array<bool, NUM_SAMPLES> isBandPassEnabled {};
+    std::array<std::atomic<bool>, NUM_SAMPLES> isBandPassEnabled {};
 
     /**
      * @brief Center cutoff frequencies (in Hz) for the band-pass filters.
      */
-    std::array<float, NUM_SAMPLES> bandPassCutoffs;
+    std::array<std::atomic<float>, NUM_SAMPLES> bandPassCutoffs {};
 
     /**
      * @brief Bandwidths (Q factors) for the band-pass filters.
      */
-    std::array<float, NUM_SAMPLES> bandPassBandwidths;
+    std::array<std::atomic<float>, NUM_SAMPLES> bandPassBandwidths {};
 
 
     //================== Notch Filter ==================
@@ -341,23 +779,18 @@ private:
     /**
      * @brief Flags indicating whether the notch filter is enabled for each sample.
      */
-    std::array<bool, NUM_SAMPLES> isNotchEnabled {};
+    std::array<std::atomic<bool>, NUM_SAMPLES> isNotchEnabled {};
 
     /**
      * @brief Cutoff frequencies (in Hz) for the notch filters.
      */
-    std::array<float, NUM_SAMPLES> notchCutoffs {};
+    std::array<std::atomic<float>, NUM_SAMPLES> notchCutoffs {};
 
     /**
      * @brief Bandwidths for the notch filters.
      */
-    std::array<float, NUM_SAMPLES> notchBandwidths {};
+    std::array<std::atomic<float>, NUM_SAMPLES> notchBandwidths {};
 
-    /**
-     * @brief Updates the internal filter coefficients for a notch filter.
-     * @param index The index of the sample whose notch filter should be updated.
-     */
-    void updateNotchCoefficients(int index);
 
 
     //================== Peak Filter ==================
@@ -372,22 +805,22 @@ private:
     /**
      * @brief Flags indicating whether the peak filter is enabled for each sample.
      */
-    std::array<bool, NUM_SAMPLES> isPeakEnabled;
+    std::array<std::atomic<bool>, NUM_SAMPLES> isPeakEnabled {};
 
     /**
      * @brief Center frequencies (in Hz) for the peak filters.
      */
-    std::array<float, NUM_SAMPLES> peakCutoffs;
+    std::array<std::atomic<float>, NUM_SAMPLES> peakCutoffs {};
 
     /**
      * @brief Gain values (in dB) for the peak filters.
      */
-    std::array<float, NUM_SAMPLES> peakGains;
+    std::array<std::atomic<float>, NUM_SAMPLES> peakGains {};
 
     /**
      * @brief Q values (bandwidth) for the peak filters.
      */
-    std::array<float, NUM_SAMPLES> peakQs;
+    std::array<std::atomic<float>, NUM_SAMPLES> peakQs {};
 
 
     //================== Bitcrusher ==================
@@ -395,17 +828,17 @@ private:
     /**
      * @brief Flags indicating whether the bitcrusher effect is enabled per sample.
      */
-    std::array<bool, NUM_SAMPLES> isBitcrusherEnabled {};
+    std::array<std::atomic<bool>, NUM_SAMPLES> isBitcrusherEnabled {};
 
     /**
      * @brief Bit depths used for reducing resolution in the bitcrusher effect.
      */
-    std::array<int, NUM_SAMPLES> bitDepths {};
+    std::array<std::atomic<int>, NUM_SAMPLES> bitDepths {};
 
     /**
      * @brief Downsampling rates for the bitcrusher effect.
      */
-    std::array<float, NUM_SAMPLES> downsampleRates {};
+    std::array<std::atomic<float>, NUM_SAMPLES> downsampleRates {};
 
     /**
      * @brief Internal counters used to track downsampling intervals.
@@ -418,15 +851,30 @@ private:
     /**
      * @brief Gain levels (linear scale) applied to each sample.
      */
-    std::array<float, NUM_SAMPLES> gainLevels { 1.0f };
+    std::array<std::atomic<float>, NUM_SAMPLES> gainLevels {};
 
 
     //================== ADSR ==================
 
     /**
-     * @brief ADSR parameter sets for each sample (attack, decay, sustain, release).
+     * @brief ADSR attack times (in seconds) for each sample.
+     */
+    std::array<std::atomic<float>, NUM_SAMPLES> adsrAttacks {};
+
+    /**
+     * @brief ADSR decay times (in seconds) for each sample.
+     */
+    std::array<std::atomic<float>, NUM_SAMPLES> adsrDecays {};
+
+    /**
+     * @brief ADSR sustain levels (0-1) for each sample.
+     */
+    std::array<std::atomic<float>, NUM_SAMPLES> adsrSustains {};
+
+    /**
+     * @brief ADSR release times (in seconds) for each sample.
      */
-    juce::ADSR::Parameters adsrParams[NUM_SAMPLES];
+    std::array<std::atomic<float>, NUM_SAMPLES> adsrReleases {};
 
     /**
      * @brief ADSR envelope processors for each sample.
@@ -434,6 +882,276 @@ private:
     juce::ADSR adsrEnvelopes[NUM_SAMPLES];
 
 
+    //================== Control Updates ==================
+
+    /**
+     * @brief Applied settings of each track. Owned by the audio thread.
+     */
+    std::array<TrackControl, NUM_SAMPLES> trackControls;
+
+    /**
+     * @brief Incremented by every setter of a sample; the audio thread re-applies the sample's settings when it changes.
+     */
+    std::array<std::atomic<juce::uint32>, NUM_SAMPLES> parameterVersions {};
+
+    /**
+     * @brief Parameter version last applied by the audio thread.
+     */
+    std::array<juce::uint32, NUM_SAMPLES> appliedParameterVersions {};
+
+    /**
+     * @brief Settings each track falls back to on steps without a parameter lock. Owned by the audio thread.
+     */
+    std::array<TrackSettings, NUM_SAMPLES> baseSettings;
+
+    /**
+     * @brief Step whose parameter lock is installed on a track, or -1 while the base settings are installed.
+     *
+     * A lock stays installed until the next triggered step of the track, so it shapes the whole note.
+     */
+    std::array<int, NUM_SAMPLES> installedLockSteps {};
+
+    /**
+     * @brief Step the audio thread last checked each track for a trigger.
+     */
+    std::array<int, NUM_SAMPLES> lastCheckedSteps {};
+
+    /**
+     * @brief Version of the step locks last installed on each track.
+     */
+    std::array<juce::uint32, NUM_SAMPLES> installedLockVersions {};
+
+    /**
+     * @brief Parameter locks of every step with their compiled settings.
+     */
+    StepLockTable stepLocks;
+
+    /**
+     * @brief Serialises edits of stepLocks and their compilation.
+     */
+    juce::CriticalSection stepLockEditLock;
+
+    static_assert(NUM_SAMPLES <= StepLockTable::maxTracks && NUM_STEPS == StepLockTable::numSteps,
+                  "StepLockTable is too small for the sequencer");
+
+    /**
+     * @brief LFOs, random sources and envelope followers with their routing to track parameters.
+     */
+    ModulationMatrix modulation;
+
+    /**
+     * @brief Peak level of each track in the last sub-block, the input of the envelope followers.
+     */
+    std::array<float, ModulationMatrix::maxTracks> trackLevels {};
+
+    /**
+     * @brief Whether modulated settings were installed on a track in the last sub-block.
+     */
+    std::array<bool, NUM_SAMPLES> isModulationInstalled {};
+
+    /**
+     * @brief Gain each track reached at the end of the last sub-block; gain changes are ramped from here.
+     */
+    std::array<float, NUM_SAMPLES> currentGains {};
+
+    static_assert(NUM_SAMPLES <= ModulationMatrix::maxTracks, "ModulationMatrix has too few tracks");
+
+    /**
+     * @brief Tells the audio thread that a setting of a sample has changed and recompiles the sample's step locks.
+     */
+    void markParametersChanged(int index);
+
+    /**
+     * @brief Computes the complete settings of a track from its stored parameters and a step's overrides.
+     *
+     * Filter coefficients come from filterTables. Does not allocate, so the audio thread can use it
+     * for the base settings and for modulated settings.
+     *
+     * @param index Index of the sample.
+     * @param lock Overrides to apply, empty for the base settings.
+     * @param modulationOffsets Matrix whose current offsets are added, or nullptr.
+     */
+    TrackSettings computeTrackSettings(int index, const ParameterLock& lock,
+                                       const ModulationMatrix* modulationOffsets = nullptr) const noexcept;
+
+    /**
+     * @brief Copies ready-made settings into a track's controls, filters and envelope. Audio thread only.
+     */
+    void installTrackSettings(int index, const TrackSettings& settings) noexcept;
+
+    /**
+     * @brief Number of output channels frozen tracks are rendered for, set in prepareToPlay.
+     */
+    std::atomic<int> frozenChannels { 2 };
+
+    /**
+     * @brief Renders and publishes a frozen track if its render is out of date. Called on the freezer thread.
+     */
+    void refreshFrozenTrack(int index);
+
+    /**
+     * @brief Returns the render a note starting now can play, or nullptr to render it live.
+     */
+    const FrozenTrack* getPlayableFrozenTrack(int index, int numChannels) const noexcept;
+
+    /**
+     * @brief Render the current note of each track plays from, held in the freezer until the next note, or
+     * nullptr for a live note. Audio thread only.
+     */
+    std::array<const FrozenTrack*, NUM_SAMPLES> noteRenders {};
+
+    /**
+     * @brief Adds a range of a frozen render to the output buffer.
+     */
+    void mixFrozenTrack(int index, const FrozenTrack& frozen, juce::AudioBuffer<float>& buffer, int startSample, int numFrames);
+
+    /**
+     * @brief Recompiles the settings of every locked step of a track. Caller holds stepLockEditLock.
+     */
+    void compileStepLocks(int index);
+
+    /**
+     * @brief Stores the lock of a step and publishes its compiled settings. Caller holds stepLockEditLock.
+     */
+    void storeStepLock(int track, int step, const ParameterLock& lock);
+
+    /**
+     * @brief Installs changed track settings, the parameter locks of triggered steps and modulation.
+     * Called at every sub-block boundary.
+     * @param numFrames Length of the sub-block about to be rendered.
+     * @param canReadEditableState False while a snapshot is being restored; the tracks then keep playing
+     *        what they played before.
+     */
+    void updateControlState(int numFrames, bool canReadEditableState);
+
+    /**
+     * @brief Advances the step sequencer by a number of frames and retriggers the tracks of new steps.
+     * @param numFrames Number of frames that have just been rendered.
+     * @param blockFrame Frame of the host block at which the next sub-block starts.
+     */
+    void advanceSequencer(int numFrames, int blockFrame);
+
+    /**
+     * @brief Copies the step pattern, play switches and tempo into playedSteps, playedTracks and playedBpm.
+     */
+    void copyPlayedState() noexcept;
+
+
+    //================== Rendering ==================
+
+    /**
+     * @brief Interleaved scratch buffer a track's sub-block is rendered into before it is mixed, sized in prepareToPlay.
+     */
+    std::vector<float> trackScratch;
+
+    /**
+     * @brief Source window one channel of a pitched track is interpolated from, sized in prepareToPlay
+     * for the longest sub-block at the largest pitch.
+     */
+    std::vector<float> sourceWindow;
+
+    /**
+     * @brief Block and per-track timing of the audio callback.
+     */
+    PerformanceTelemetry telemetry;
+
+    /**
+     * @brief Spectra of the tracks and the master output, see getSpectrumAnalyser().
+     */
+    SpectrumAnalyser spectrumAnalyser;
+
+    static_assert(masterSpectrumSource < SpectrumAnalyser::maxSources, "SpectrumAnalyser has too few sources");
+
+    /**
+     * @brief Levels of each track and of the output, see getTrackMeter() and getMasterMeter().
+     */
+    std::array<LevelMeter, NUM_SAMPLES> trackMeters;
+    LevelMeter masterMeter;
+
+    /**
+     * @brief Renders one track into a range of the output buffer.
+     * @param index Index of the sample.
+     * @param buffer Output buffer to add to.
+     * @param startSample First sample of the range.
+     * @param numFrames Number of samples in the range.
+     */
+    void renderTrack(int index, juce::AudioBuffer<float>& buffer, int startSample, int numFrames);
+
+    /** @brief Runs the enabled filters of a track over interleaved samples. */
+    void applyFilters(int index, float* samples, int count);
+
+    /** @brief Applies the bitcrusher of a track to interleaved samples. */
+    void applyBitcrusher(int index, float* samples, int count);
+
+    /** @brief Applies the ADSR envelope and gain of a track to interleaved samples. */
+    void applyEnvelopeAndGain(int index, float* samples, int count);
+
+    /**
+     * @brief Starts the note of a triggered track: picks the region of the sample it plays, opens the
+     * envelope and decides whether the note plays from the track's frozen render.
+     * @param index Index of the sample.
+     * @param step Step the track was triggered on.
+     * @param numChannels Number of output channels.
+     */
+    void startNote(int index, int step, int numChannels) noexcept;
+
+    /** @brief Fades interleaved frames read from a position of the sample at the borders of a slice. */
+    void applySliceFades(int index, float* samples, double position, double increment, int numFrames, int numChannels) noexcept;
+
+    //================== Undo ==================
+
+    /**
+     * @brief Snapshots before and after the current state.
+     */
+    UndoHistory undoHistory;
+
+    /**
+     * @brief Serialises recording and restoring. Taken before stepLockEditLock and sampleFileLock, never after.
+     */
+    juce::CriticalSection undoLock;
+
+    /**
+     * @brief Set while a snapshot is written back, so the setters it calls do not record. Guarded by undoLock.
+     */
+    bool isRestoringSnapshot = false;
+
+    /**
+     * @brief Held by the audio thread for a whole block and by a restore while it writes. The audio thread
+     * only tries to take it, and while a restore holds it the block plays the previously applied state.
+     */
+    juce::SpinLock snapshotRestoreLock;
+
+    std::atomic<juce::uint32> stateRestoreCount { 0 };
+
+    /**
+     * @brief Records the current state as an undo step unless a transaction or a restore is running.
+     */
+    void recordUndoStep();
+
+    /**
+     * @brief Returns a snapshot of the current state that shares every unchanged node with previous.
+     */
+    UndoHistory::Snapshot captureSnapshot(const UndoHistory::Snapshot& previous) const;
+
+    /**
+     * @brief Writes the parts of a snapshot that differ from previous back into the processor. Caller holds undoLock.
+     */
+    void restoreSnapshot(const UndoHistory::Snapshot& target, const UndoHistory::Snapshot& previous);
+
+    UndoSnapshot::Parameters captureParameters(int index) const;
+    void restoreParameters(int index, const UndoSnapshot::Parameters& parameters);
+
+    static_assert(NUM_TRACKS <= UndoSnapshot::maxTracks && NUM_STEPS == UndoSnapshot::numSteps,
+                  "Undo snapshots are too small for the sequencer");
+
+    /**
+     * @brief Background renderer of frozen tracks. Declared last, so its thread stops before anything it reads is destroyed.
+     */
+    TrackFreezer freezer { [this](int index) { refreshFrozenTrack(index); } };
+
+    static_assert(NUM_SAMPLES <= TrackFreezer::maxTracks, "TrackFreezer has too few tracks");
+
+
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SampleAudioProcessor)
 
@@ -0,0 +1,308 @@
+#include "RealtimeSafetyChecker.h"
+
+#if AUDIOPLUGIN_RT_SAFETY_CHECKS
+
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#if defined(__linux__)
+ #include <dlfcn.h>
+ #include <execinfo.h>
+ #include <pthread.h>
+ #include <semaphore.h>
+ #include <time.h>
+ #include <unistd.h>
+#endif
+
+
+namespace
+{
+    /* @brief Nesting depth of realtime sections on this thread. */
+    thread_local int realtimeDepth = 0;
+
+    /* @brief Set while a violation is being reported, so reporting itself is not trapped. */
+    thread_local bool isReporting = false;
+
+    std::atomic<int> abortMode { -1 };
+    std::atomic<int> numViolations { 0 };
+
+    /* @brief Hashes of call stacks that have already been printed. */
+    constexpr int maxReportedStacks = 256;
+    std::atomic<unsigned long> reportedStacks[maxReportedStacks] {};
+
+    bool shouldAbort() noexcept
+    {
+        int mode = abortMode.load(std::memory_order_relaxed);
+
+        if (mode < 0)
+        {
+            const char* value = std::getenv("AUDIOPLUGIN_RT_ABORT");
+            mode = (value != nullptr && value[0] == '1') ? 1 : 0;
+            abortMode.store(mode, std::memory_order_relaxed);
+        }
+
+        return mode == 1;
+    }
+
+    /**
+     * @brief Remembers a stack hash and returns true if it was not seen before.
+     */
+    bool isFirstReport(unsigned long hash) noexcept
+    {
+        for (auto& slot : reportedStacks)
+        {
+            auto existing = slot.load(std::memory_order_relaxed);
+
+            if (existing == hash)
+                return false;
+
+            if (existing == 0 && slot.compare_exchange_strong(existing, hash))
+                return true;
+
+            if (existing == hash)
+                return false;
+        }
+
+        return false;
+    }
+
+    inline bool isTrapped() noexcept
+    {
+        return realtimeDepth > 0 && ! isReporting;
+    }
+
+    /**
+     * @brief Reports a forbidden call made inside a realtime section.
+     * @param what Name of the function that was called.
+     */
+    void reportViolation(const char* what) noexcept
+    {
+        isReporting = true;
+        numViolations.fetch_add(1, std::memory_order_relaxed);
+
+       #if defined(__linux__)
+        void* frames[32];
+        const int numFrames = backtrace(frames, 32);
+
+        unsigned long hash = 1469598103934665603ul;
+        for (int i = 1; i < numFrames && i < 8; ++i)
+            hash = (hash ^ reinterpret_cast<unsigned long>(frames[i])) * 1099511628211ul;
+
+        if (isFirstReport(hash == 0 ? 1 : hash))
+        {
+            std::fprintf(stderr, "\n[realtime-safety] %s called on the audio thread:\n", what);
+            backtrace_symbols_fd(frames, numFrames, STDERR_FILENO);
+        }
+       #else
+        if (isFirstReport(reinterpret_cast<unsigned long>(what)))
+            std::fprintf(stderr, "\n[realtime-safety] %s called on the audio thread\n", what);
+       #endif
+
+        if (shouldAbort())
+            std::abort();
+
+        isReporting = false;
+    }
+
+    inline void check(const char* what) noexcept
+    {
+        if (isTrapped())
+            reportViolation(what);
+    }
+
+   #if defined(__linux__)
+    /**
+     * @brief Looks up the next definition of an interposed function.
+     */
+    template <typename Function>
+    Function findNext(Function& cache, const char* name) noexcept
+    {
+        if (cache == nullptr)
+            cache = reinterpret_cast<Function>(dlsym(RTLD_NEXT, name));
+
+        return cache;
+    }
+   #endif
+}
+
+
+namespace RealtimeSafetyChecker
+{
+    ScopedRealtimeSection::ScopedRealtimeSection() noexcept    { ++realtimeDepth; }
+    ScopedRealtimeSection::~ScopedRealtimeSection() noexcept   { --realtimeDepth; }
+
+    void setAbortOnViolation(bool shouldAbortOnViolation) noexcept
+    {
+        abortMode.store(shouldAbortOnViolation ? 1 : 0, std::memory_order_relaxed);
+    }
+
+    int getNumViolations() noexcept
+    {
+        return numViolations.load(std::memory_order_relaxed);
+    }
+}
+
+
+#if defined(__linux__)
+
+//================== Heap (glibc) ==================
+
+extern "C"
+{
+    void* __libc_malloc(size_t);
+    void* __libc_calloc(size_t, size_t);
+    void* __libc_realloc(void*, size_t);
+    void* __libc_memalign(size_t, size_t);
+    void  __libc_free(void*);
+
+    void* malloc(size_t size)
+    {
+        check("malloc");
+        return __libc_malloc(size);
+    }
+
+    void* calloc(size_t count, size_t size)
+    {
+        check("calloc");
+        return __libc_calloc(count, size);
+    }
+
+    void* realloc(void* pointer, size_t size)
+    {
+        check("realloc");
+        return __libc_realloc(pointer, size);
+    }
+
+    void free(void* pointer)
+    {
+        if (pointer != nullptr)
+            check("free");
+
+        __libc_free(pointer);
+    }
+
+    int posix_memalign(void** result, size_t alignment, size_t size)
+    {
+        check("posix_memalign");
+        *result = __libc_memalign(alignment, size);
+        return *result != nullptr ? 0 : ENOMEM;
+    }
+
+    void* aligned_alloc(size_t alignment, size_t size)
+    {
+        check("aligned_alloc");
+        return __libc_memalign(alignment, size);
+    }
+
+
+//================== Locks and blocking calls ==================
+
+    int pthread_mutex_lock(pthread_mutex_t* mutex)
+    {
+        static int (*next)(pthread_mutex_t*) = nullptr;
+        check("pthread_mutex_lock");
+        return findNext(next, "pthread_mutex_lock")(mutex);
+    }
+
+    int pthread_rwlock_rdlock(pthread_rwlock_t* lock)
+    {
+        static int (*next)(pthread_rwlock_t*) = nullptr;
+        check("pthread_rwlock_rdlock");
+        return findNext(next, "pthread_rwlock_rdlock")(lock);
+    }
+
+    int pthread_rwlock_wrlock(pthread_rwlock_t* lock)
+    {
+        static int (*next)(pthread_rwlock_t*) = nullptr;
+        check("pthread_rwlock_wrlock");
+        return findNext(next, "pthread_rwlock_wrlock")(lock);
+    }
+
+    int pthread_cond_wait(pthread_cond_t* condition, pthread_mutex_t* mutex)
+    {
+        static int (*next)(pthread_cond_t*, pthread_mutex_t*) = nullptr;
+        check("pthread_cond_wait");
+        return findNext(next, "pthread_cond_wait")(condition, mutex);
+    }
+
+    int pthread_cond_timedwait(pthread_cond_t* condition, pthread_mutex_t* mutex, const struct timespec* time)
+    {
+        static int (*next)(pthread_cond_t*, pthread_mutex_t*, const struct timespec*) = nullptr;
+        check("pthread_cond_timedwait");
+        return findNext(next, "pthread_cond_timedwait")(condition, mutex, time);
+    }
+
+    int sem_wait(sem_t* semaphore)
+    {
+        static int (*next)(sem_t*) = nullptr;
+        check("sem_wait");
+        return findNext(next, "sem_wait")(semaphore);
+    }
+
+    int nanosleep(const struct timespec* duration, struct timespec* remaining)
+    {
+        static int (*next)(const struct timespec*, struct timespec*) = nullptr;
+        check("nanosleep");
+        return findNext(next, "nanosleep")(duration, remaining);
+    }
+
+    int usleep(useconds_t microseconds)
+    {
+        static int (*next)(useconds_t) = nullptr;
+        check("usleep");
+        return findNext(next, "usleep")(microseconds);
+    }
+
+    ssize_t read(int fd, void* data, size_t size)
+    {
+        static ssize_t (*next)(int, void*, size_t) = nullptr;
+        check("read");
+        return findNext(next, "read")(fd, data, size);
+    }
+
+    ssize_t write(int fd, const void* data, size_t size)
+    {
+        static ssize_t (*next)(int, const void*, size_t) = nullptr;
+        check("write");
+        return findNext(next, "write")(fd, data, size);
+    }
+}
+
+#else
+
+//================== Heap (other platforms: C++ allocations only) ==================
+
+void* operator new(std::size_t size)
+{
+    check("operator new");
+
+    if (auto* pointer = std::malloc(size == 0 ? 1 : size))
+        return pointer;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void* pointer) noexcept
+{
+    if (pointer != nullptr)
+        check("operator delete");
+
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept
+{
+    operator delete(pointer);
+}
+
+#endif
+
+#endif
@@ -0,0 +1,44 @@
+#pragma once
+
+/**
+ * @file RealtimeSafetyChecker.h
+ * @brief Debug/test mode that traps heap allocations, mutex locks and blocking calls on the audio thread.
+ *
+ * Only active when the code is built with AUDIOPLUGIN_RT_SAFETY_CHECKS=1 (CMake option of the same name),
+ * in which case RealtimeSafetyChecker.cpp interposes malloc/free, pthread locks and blocking system calls.
+ * Code inside an AUDIOPLUGIN_REALTIME_SECTION that calls one of them is reported once per call site with
+ * a stack trace. Setting the environment variable AUDIOPLUGIN_RT_ABORT=1 aborts on the first violation.
+ */
+
+#if AUDIOPLUGIN_RT_SAFETY_CHECKS
+
+namespace RealtimeSafetyChecker
+{
+    /**
+     * @brief Marks the current thread as a realtime thread for the lifetime of the object.
+     */
+    struct ScopedRealtimeSection
+    {
+        ScopedRealtimeSection() noexcept;
+        ~ScopedRealtimeSection() noexcept;
+
+        ScopedRealtimeSection(const ScopedRealtimeSection&) = delete;
+        ScopedRealtimeSection& operator=(const ScopedRealtimeSection&) = delete;
+    };
+
+    /**
+     * @brief Chooses whether a violation aborts the process. Defaults to the AUDIOPLUGIN_RT_ABORT variable.
+     * @param shouldAbort True to abort on the first violation.
+     */
+    void setAbortOnViolation(bool shouldAbort) noexcept;
+
+    /**
+     * @brief Returns the number of violations detected so far, including repeated ones.
+     */
+    int getNumViolations() noexcept;
+}
+
+ #define AUDIOPLUGIN_REALTIME_SECTION const RealtimeSafetyChecker::ScopedRealtimeSection realtimeSafetySection;
+#else
+ #define AUDIOPLUGIN_REALTIME_SECTION
+#endif
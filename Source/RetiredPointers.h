@@ -0,0 +1,91 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+
+/**
+ * @class RetiredPointers
+ * @brief Frees objects the audio thread reads through atomic pointers once it can no longer be reading them.
+ *
+ * The message side installs a new object with exchange(), which retires the previous one instead of
+ * deleting it. A block that was running during the exchange may still read the old object. It has
+ * finished once the count of completed blocks has moved past the value read after the exchange, so
+ * retired objects are freed by a later exchange or releaseFinished() from then on.
+ *
+ * An audio thread that keeps using an object across blocks, e.g. for a whole note, holds it in one of
+ * numHolders holder slots with hold(). A held object is not freed until its holder lets go of it.
+ *
+ * Everything except hold() and markBlockCompleted() belongs to the message side and must be serialised by
+ * the caller.
+ */
+template <typename Object, int numHolders = 0>
+class RetiredPointers
+{
+public:
+    RetiredPointers() = default;
+
+    /**
+     * @brief Installs an object in a slot the audio thread loads, and retires the previous one.
+     * @param object New object, or nullptr.
+     */
+    void exchange(std::atomic<const Object*>& slot, std::unique_ptr<const Object> object)
+    {
+        if (const auto* previous = slot.exchange(object.release(), std::memory_order_acq_rel))
+            retired.push_back({ std::unique_ptr<const Object>(previous), completedBlocks.load(std::memory_order_acquire) });
+
+        releaseFinished();
+    }
+
+    /** @brief Frees retired objects the audio thread can no longer be using. */
+    void releaseFinished()
+    {
+        const auto blocks = completedBlocks.load(std::memory_order_acquire);
+
+        retired.erase(std::remove_if(retired.begin(), retired.end(),
+                                     [this, blocks](const Retired& r) { return blocks > r.retiredAfterBlock && ! isHeld(r.object.get()); }),
+                      retired.end());
+    }
+
+    /** @brief Lets go of all holds and frees all retired objects. Only valid while the audio thread is stopped. */
+    void releaseAll()
+    {
+        for (auto& held : holds)
+            held.store(nullptr, std::memory_order_relaxed);
+
+        retired.clear();
+    }
+
+    //================== Audio thread ==================
+
+    /**
+     * @brief Keeps an object alive beyond the current block, in place of the one the holder held before.
+     * @param object Object loaded from a slot in the current block, or nullptr to let go.
+     */
+    void hold(int holder, const Object* object) noexcept { holds[(size_t) holder].store(object, std::memory_order_release); }
+
+    /** @brief Called by the audio thread at the end of every block. */
+    void markBlockCompleted() noexcept { completedBlocks.fetch_add(1, std::memory_order_release); }
+
+private:
+    struct Retired
+    {
+        std::unique_ptr<const Object> object;
+        juce::uint64 retiredAfterBlock = 0;
+    };
+
+    /*
+     * @brief An object loaded in a block that has completed was held by then, if at all: the hold is
+     * published before the block's completion, so it is seen here after completedBlocks is.
+     */
+    bool isHeld(const Object* object) const noexcept
+    {
+        return std::any_of(holds.begin(), holds.end(),
+                           [object](const std::atomic<const Object*>& held) { return held.load(std::memory_order_acquire) == object; });
+    }
+
+    std::vector<Retired> retired;
+    std::array<std::atomic<const Object*>, (size_t) numHolders> holds {};
+    std::atomic<juce::uint64> completedBlocks { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE (RetiredPointers)
+};
@@ -0,0 +1,301 @@
+#include "SampleBrowser.h"
+#include "TraceProfiler.h"
+
+
+namespace
+{
+    constexpr int rowHeight = 34;
+    constexpr int thumbnailWidth = 72;
+    constexpr int controlHeight = 26;
+    constexpr int spacing = 6;
+
+    /** @brief Returns e.g. "WAV" for the reader name "WAV file". */
+    juce::String getShortFormatName(const juce::String& format)
+    {
+        return format.upToFirstOccurrenceOf(" ", false, false);
+    }
+}
+
+
+SampleBrowser::SampleBrowser(SampleLibrary& libraryToShow, int numTracks)
+    : library(libraryToShow)
+{
+    setOpaque(true);
+
+    foldersButton.onClick = [this] { showFolderMenu(); };
+    addAndMakeVisible(foldersButton);
+
+    rescanButton.onClick = [this] { library.rescan(); };
+    addAndMakeVisible(rescanButton);
+
+    searchBox.setTextToShowWhenEmpty("Search", juce::Colours::grey);
+    searchBox.onTextChange = [this] { refilter(getSelectedFile()); };
+    searchBox.onEscapeKey = [this] { searchBox.clear(); refilter(getSelectedFile()); };
+    addAndMakeVisible(searchBox);
+
+    list.setModel(this);
+    list.setRowHeight(rowHeight);
+    list.setColour(juce::ListBox::backgroundColourId, juce::Colours::black.withAlpha(0.3f));
+    addAndMakeVisible(list);
+
+    statusLabel.setFont(juce::Font(12.0f));
+    statusLabel.setColour(juce::Label::textColourId, juce::Colours::grey);
+    addAndMakeVisible(statusLabel);
+
+    for (int track = 0; track < numTracks; ++track)
+        targetSelector.addItem("Track " + juce::String(track + 1), track + 1);
+
+    targetSelector.setSelectedId(1, juce::dontSendNotification);
+    addAndMakeVisible(targetSelector);
+
+    loadButton.onClick = [this] { loadSelected(); };
+    addAndMakeVisible(loadButton);
+
+    update();
+}
+
+
+void SampleBrowser::update()
+{
+    const auto version = library.getVersion();
+
+    if (entries == nullptr || version != shownVersion)
+    {
+        const auto selectedFile = getSelectedFile();
+        shownVersion = version;
+        entries = library.getEntries();
+        refilter(selectedFile);
+    }
+
+    updateStatus();
+}
+
+
+void SampleBrowser::paint(juce::Graphics& g)
+{
+    g.fillAll(getLookAndFeel().findColour(juce::ResizableWindow::backgroundColourId));
+}
+
+
+void SampleBrowser::resized()
+{
+    auto area = getLocalBounds();
+
+    auto header = area.removeFromTop(controlHeight);
+    foldersButton.setBounds(header.removeFromLeft(70));
+    rescanButton.setBounds(header.removeFromLeft(70).withTrimmedLeft(spacing));
+    searchBox.setBounds(header.withTrimmedLeft(spacing));
+
+    auto footer = area.removeFromBottom(controlHeight);
+    loadButton.setBounds(footer.removeFromRight(60));
+    targetSelector.setBounds(footer.removeFromRight(100).withTrimmedRight(spacing));
+    statusLabel.setBounds(footer);
+
+    list.setBounds(area.reduced(0, spacing));
+}
+
+
+/**
+ * @brief Space auditions the selected file again and escape stops the audition. Keys the list does not
+ * use reach the browser, so they work while the list has the focus.
+ */
+bool SampleBrowser::keyPressed(const juce::KeyPress& key)
+{
+    if (key == juce::KeyPress::spaceKey)
+    {
+        if (onAudition && getSelectedFile() != juce::File())
+            onAudition(getSelectedFile());
+
+        return true;
+    }
+
+    if (key == juce::KeyPress::escapeKey)
+    {
+        if (onAudition)
+            onAudition(juce::File());
+
+        return true;
+    }
+
+    return false;
+}
+
+
+int SampleBrowser::getNumRows()
+{
+    return (int) matches.size();
+}
+
+
+/**
+ * @brief Draws the thumbnail as mirrored peak bars, then the file name over its length, sample rate,
+ * channels, format and loudness.
+ */
+void SampleBrowser::paintListBoxItem(int row, juce::Graphics& g, int width, int height, bool isSelected)
+{
+    const auto* entry = getEntry(row);
+
+    if (entry == nullptr)
+        return;
+
+    if (isSelected)
+        g.fillAll(juce::Colours::deepskyblue.withAlpha(0.35f));
+
+    auto area = juce::Rectangle<int>(width, height).reduced(4, 2);
+    const auto thumbnailArea = area.removeFromLeft(thumbnailWidth).toFloat();
+    const float binWidth = thumbnailArea.getWidth() / (float) SampleLibrary::thumbnailBins;
+    const float centreY = thumbnailArea.getCentreY();
+
+    g.setColour(juce::Colours::deepskyblue.withAlpha(0.8f));
+
+    for (int bin = 0; bin < SampleLibrary::thumbnailBins; ++bin)
+    {
+        const float halfHeight = juce::jmax(0.5f, entry->thumbnail[(size_t) bin] / 255.0f * thumbnailArea.getHeight() * 0.5f);
+        g.fillRect(thumbnailArea.getX() + bin * binWidth, centreY - halfHeight, juce::jmax(1.0f, binWidth - 0.5f), halfHeight * 2.0f);
+    }
+
+    area.removeFromLeft(spacing);
+
+    g.setColour(juce::Colours::whitesmoke);
+    g.setFont(14.0f);
+    g.drawText(entry->getName(), area.removeFromTop(area.getHeight() / 2), juce::Justification::centredLeft, true);
+
+    juce::String details;
+    details << juce::String(entry->getSeconds(), 2) << " s   "
+            << juce::String(entry->sampleRate / 1000.0, 1) << " kHz   "
+            << (entry->numChannels == 1 ? juce::String("mono") : entry->numChannels == 2 ? juce::String("stereo") : juce::String(entry->numChannels) + " ch") << "   "
+            << getShortFormatName(entry->format);
+
+    if (entry->loudnessLufs > SampleAnalysis::silenceDb)
+        details << "   " << juce::String(entry->loudnessLufs, 1) << " LUFS";
+
+    g.setColour(juce::Colours::grey);
+    g.setFont(12.0f);
+    g.drawText(details, area, juce::Justification::centredLeft, true);
+}
+
+
+void SampleBrowser::selectedRowsChanged(int)
+{
+    if (restoringSelection || ! onAudition)
+        return;
+
+    if (const auto file = getSelectedFile(); file != juce::File())
+        onAudition(file);
+}
+
+
+void SampleBrowser::listBoxItemDoubleClicked(int, const juce::MouseEvent&)
+{
+    loadSelected();
+}
+
+
+void SampleBrowser::returnKeyPressed(int)
+{
+    loadSelected();
+}
+
+
+const SampleLibrary::Entry* SampleBrowser::getEntry(int row) const
+{
+    if (entries == nullptr || ! juce::isPositiveAndBelow(row, (int) matches.size()))
+        return nullptr;
+
+    return &(*entries)[(size_t) matches[(size_t) row]];
+}
+
+
+juce::File SampleBrowser::getSelectedFile() const
+{
+    if (const auto* entry = getEntry(list.getSelectedRow()))
+        return juce::File(entry->path);
+
+    return {};
+}
+
+
+/**
+ * @brief Entries are sorted by path, so the file to select is found with a binary search over the matches.
+ */
+void SampleBrowser::refilter(const juce::File& fileToSelect)
+{
+    AUDIOPLUGIN_TRACE_ZONE("browser refilter")
+
+    const auto selectedPath = fileToSelect.getFullPathName();
+
+    matches = SampleLibrary::search(*entries, searchBox.getText());
+    list.updateContent();
+
+    const auto found = std::lower_bound(matches.begin(), matches.end(), selectedPath,
+                                        [this](int index, const juce::String& path) { return (*entries)[(size_t) index].path < path; });
+
+    const juce::ScopedValueSetter<bool> restoring(restoringSelection, true);
+
+    if (selectedPath.isNotEmpty() && found != matches.end() && (*entries)[(size_t) *found].path == selectedPath)
+        list.selectRow((int) std::distance(matches.begin(), found), true);
+    else
+        list.deselectAllRows();
+
+    list.repaint();
+    updateStatus();
+}
+
+
+void SampleBrowser::showFolderMenu()
+{
+    juce::PopupMenu menu;
+    menu.addItem("Add Folder...", [this] { addFolder(); });
+
+    const auto folders = library.getFolders();
+
+    if (! folders.isEmpty())
+    {
+        juce::PopupMenu removeMenu;
+
+        for (const auto& folder : folders)
+            removeMenu.addItem(folder.getFullPathName(), [this, folder] { library.removeFolder(folder); });
+
+        menu.addSubMenu("Remove Folder", removeMenu);
+    }
+
+    menu.showMenuAsync(juce::PopupMenu::Options().withTargetComponent(foldersButton));
+}
+
+
+void SampleBrowser::addFolder()
+{
+    folderChooser = std::make_unique<juce::FileChooser>("Add a Library Folder", juce::File{}, "");
+    folderChooser->launchAsync(juce::FileBrowserComponent::openMode | juce::FileBrowserComponent::canSelectDirectories,
+                               [this](const juce::FileChooser& chooser)
+                               {
+                                   const auto folder = chooser.getResult();
+
+                                   if (folder.isDirectory())
+                                       library.addFolder(folder);
+                               });
+}
+
+
+void SampleBrowser::loadSelected()
+{
+    const auto file = getSelectedFile();
+
+    if (onLoad && file != juce::File())
+        onLoad(file, targetSelector.getSelectedId() - 1);
+}
+
+
+void SampleBrowser::updateStatus()
+{
+    juce::String status;
+
+    if (library.isScanning())
+        status << "Scanning... " << library.getNumFilesChecked() << " files checked";
+    else if (library.getFolders().isEmpty())
+        status << "Add a folder to build the library";
+    else
+        status << (int) matches.size() << " of " << (int) entries->size() << " samples";
+
+    statusLabel.setText(status, juce::dontSendNotification);
+}
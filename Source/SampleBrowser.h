@@ -0,0 +1,84 @@
+#pragma once
+
+#include <juce_gui_basics/juce_gui_basics.h>
+
+#include "SampleLibrary.h"
+
+
+/**
+ * @class SampleBrowser
+ * @brief Searchable list of the files in a SampleLibrary, with a thumbnail and the measured length,
+ * format and loudness of each.
+ *
+ * Selecting a row, with the mouse or the arrow keys, auditions its file; space plays it again and escape
+ * stops it. A double click, return or the Load button loads the selected file into the target track.
+ * The Folders menu adds and removes library folders.
+ *
+ * The browser only reads published snapshots of the library. update() takes a new one when the library
+ * published it and refilters it against the search text, keeping the selected file selected.
+ */
+class SampleBrowser : public juce::Component,
+                      private juce::ListBoxModel
+{
+public:
+    /** @brief Width the editor gives the browser next to its other controls. */
+    static constexpr int preferredWidth = 380;
+
+    /**
+     * @param library Library to show; must outlive the browser.
+     * @param numTracks Number of tracks a file can be loaded into.
+     */
+    SampleBrowser(SampleLibrary& library, int numTracks);
+
+    /** @brief Called to audition a file, and with an invalid file to stop the audition. */
+    std::function<void(const juce::File&)> onAudition;
+
+    /** @brief Called to load a file into a track. */
+    std::function<void(const juce::File&, int track)> onLoad;
+
+    /** @brief Shows the library's latest snapshot and scan status; call regularly, e.g. from a timer. */
+    void update();
+
+    void paint(juce::Graphics& g) override;
+    void resized() override;
+    bool keyPressed(const juce::KeyPress& key) override;
+
+private:
+    int getNumRows() override;
+    void paintListBoxItem(int row, juce::Graphics& g, int width, int height, bool isSelected) override;
+    void selectedRowsChanged(int lastRowSelected) override;
+    void listBoxItemDoubleClicked(int row, const juce::MouseEvent&) override;
+    void returnKeyPressed(int lastRowSelected) override;
+
+    /* @brief Returns the entry shown in a row, or nullptr. */
+    const SampleLibrary::Entry* getEntry(int row) const;
+
+    /* @brief Returns the file of the selected row, or an invalid file. */
+    juce::File getSelectedFile() const;
+
+    /* @brief Matches the snapshot against the search text and selects a file again if it still matches. */
+    void refilter(const juce::File& fileToSelect);
+
+    void showFolderMenu();
+    void addFolder();
+    void loadSelected();
+    void updateStatus();
+
+    SampleLibrary& library;
+
+    std::shared_ptr<const SampleLibrary::Entries> entries;
+    std::vector<int> matches;
+    juce::uint32 shownVersion = 0;
+
+    /* @brief Set while refilter() selects a row, which is not auditioned again. */
+    bool restoringSelection = false;
+
+    juce::TextButton foldersButton { "Folders" }, rescanButton { "Rescan" }, loadButton { "Load" };
+    juce::TextEditor searchBox;
+    juce::ListBox list;
+    juce::Label statusLabel;
+    juce::ComboBox targetSelector;
+    std::unique_ptr<juce::FileChooser> folderChooser;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SampleBrowser)
+};
@@ -0,0 +1,203 @@
+#include "SampleInterpolator.h"
+
+
+namespace
+{
+    /** @brief Cutoff of the widest sinc table relative to Nyquist; the rest of the band is its transition. */
+    constexpr double sincCutoff = 0.9;
+
+    /** @brief Sinc tables, each with its cutoff half an octave below the previous one. */
+    constexpr int numSincTables = 5;
+
+    /** @brief Interpolated sums are taken in this many independent lanes, one vector register wide. */
+    constexpr int lanes = 4;
+
+    static_assert(SampleInterpolator::sincTaps % lanes == 0, "The sinc taps are summed in whole lanes");
+    static_assert(SampleInterpolator::sincTaps / 2 <= SampleInterpolator::guardFrames, "The sinc taps must stay within the guard frames");
+
+    /**
+     * @brief Polyphase coefficients of the windowed sinc at every cutoff. A table has sincPhases + 1 rows
+     * of sincTaps coefficients; the extra row lets the last phase interpolate towards a whole frame.
+     */
+    struct SincTables
+    {
+        static constexpr int rowsPerTable = SampleInterpolator::sincPhases + 1;
+
+        SincTables()
+        {
+            constexpr int taps = SampleInterpolator::sincTaps;
+            constexpr double halfSpan = taps / 2;
+            const double pi = juce::MathConstants<double>::pi;
+
+            coefficients.resize((size_t) (numSincTables * rowsPerTable * taps));
+
+            for (int table = 0; table < numSincTables; ++table)
+            {
+                // Normalised cutoff in cycles per frame
+                const double cutoff = 0.5 * sincCutoff * std::exp2(-0.5 * table);
+
+                for (int phase = 0; phase < rowsPerTable; ++phase)
+                {
+                    float* row = getRow(table, phase);
+                    double sum = 0.0;
+
+                    for (int tap = 0; tap < taps; ++tap)
+                    {
+                        // Distance of the tap's frame from the interpolated position
+                        const double x = (double) (tap - (taps / 2 - 1)) - (double) phase / SampleInterpolator::sincPhases;
+                        const double argument = 2.0 * cutoff * x;
+                        const double sinc = argument != 0.0 ? std::sin(pi * argument) / (pi * argument) : 1.0;
+                        const double window = std::abs(x) < halfSpan
+                                            ? 0.42 + 0.5 * std::cos(pi * x / halfSpan) + 0.08 * std::cos(2.0 * pi * x / halfSpan)
+                                            : 0.0;
+                        const double value = 2.0 * cutoff * sinc * window;
+
+                        row[tap] = (float) value;
+                        sum += value;
+                    }
+
+                    // Unity gain at DC for every phase, so the level does not ripple with the position
+                    for (int tap = 0; tap < taps; ++tap)
+                        row[tap] = (float) (row[tap] / sum);
+                }
+            }
+        }
+
+        float* getRow(int table, int phase) noexcept
+        {
+            return coefficients.data() + (size_t) ((table * rowsPerTable + phase) * SampleInterpolator::sincTaps);
+        }
+
+        const float* getTable(int table) const noexcept
+        {
+            return coefficients.data() + (size_t) (table * rowsPerTable * SampleInterpolator::sincTaps);
+        }
+
+        std::vector<float> coefficients;
+    };
+
+    const SincTables sincTables;
+
+    /** @brief Returns the sinc table whose cutoff suits an increment: half an octave lower per half octave up. */
+    int getSincTable(double increment) noexcept
+    {
+        if (increment <= 1.0)
+            return 0;
+
+        return juce::jlimit(0, numSincTables - 1, juce::roundToInt(2.0 * std::log2(increment)));
+    }
+}
+
+
+const char* SampleInterpolator::getQualityName(Quality quality) noexcept
+{
+    switch (quality)
+    {
+        case Quality::linear: return "linear";
+        case Quality::cubic:  return "cubic";
+        case Quality::sinc:   return "sinc";
+    }
+
+    return "";
+}
+
+
+SampleInterpolator::Quality SampleInterpolator::getQualityFromName(const juce::String& name) noexcept
+{
+    for (auto quality : { Quality::linear, Quality::sinc })
+        if (name == getQualityName(quality))
+            return quality;
+
+    return Quality::cubic;
+}
+
+
+int SampleInterpolator::getFramesBefore(double distance, double increment, int maxFrames) noexcept
+{
+    if (distance <= 0.0 || increment <= 0.0)
+        return 0;
+
+    return (int) juce::jmin((double) maxFrames, std::ceil(distance / increment));
+}
+
+
+int SampleInterpolator::getWindowLength(double fraction, double increment, int numFrames) noexcept
+{
+    if (numFrames <= 0)
+        return 0;
+
+    return (int) (fraction + (numFrames - 1) * increment) + 1 + 2 * guardFrames;
+}
+
+
+/**
+ * @brief Computes every output frame from its own position, fraction + n * increment, rather than by
+ * accumulating the increment, so long notes do not drift.
+ */
+void SampleInterpolator::process(Quality quality, const float* window, double fraction, double increment,
+                                 float* out, int outStride, int numFrames) noexcept
+{
+    switch (quality)
+    {
+        case Quality::linear:
+        {
+            for (int n = 0; n < numFrames; ++n)
+            {
+                const double x = fraction + n * increment;
+                const int i = (int) x;
+                const float t = (float) (x - i);
+
+                out[n * outStride] = window[i] + t * (window[i + 1] - window[i]);
+            }
+
+            break;
+        }
+
+        case Quality::cubic:
+        {
+            for (int n = 0; n < numFrames; ++n)
+            {
+                const double x = fraction + n * increment;
+                const int i = (int) x;
+                const float t = (float) (x - i);
+                const float* s = window + i;
+
+                const float c1 = 0.5f * (s[1] - s[-1]);
+                const float c2 = s[-1] - 2.5f * s[0] + 2.0f * s[1] - 0.5f * s[2];
+                const float c3 = 0.5f * (s[2] - s[-1]) + 1.5f * (s[0] - s[1]);
+
+                out[n * outStride] = ((c3 * t + c2) * t + c1) * t + s[0];
+            }
+
+            break;
+        }
+
+        case Quality::sinc:
+        {
+            const float* table = sincTables.getTable(getSincTable(increment));
+
+            for (int n = 0; n < numFrames; ++n)
+            {
+                const double x = fraction + n * increment;
+                const int i = (int) x;
+                const double phase = (x - i) * sincPhases;
+                const int row = (int) phase;
+                const float blend = (float) (phase - row);
+
+                const float* a = table + row * sincTaps;
+                const float* b = a + sincTaps;
+                const float* s = window + i - (sincTaps / 2 - 1);
+
+                float sums[lanes] {};
+
+                for (int tap = 0; tap < sincTaps; tap += lanes)
+                    for (int lane = 0; lane < lanes; ++lane)
+                        sums[lane] += (a[tap + lane] + blend * (b[tap + lane] - a[tap + lane])) * s[tap + lane];
+
+                out[n * outStride] = (sums[0] + sums[1]) + (sums[2] + sums[3]);
+            }
+
+            break;
+        }
+    }
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+
+
+/**
+ * @class SampleInterpolator
+ * @brief Reads a sample at fractional positions for pitched playback.
+ *
+ * A track that plays at another pitch steps through its sample by an increment other than one frame,
+ * so every output frame falls between two frames of the sample. The kernels compute these frames a
+ * block at a time from a source window: a copy of the frames the block reads plus guardFrames on either
+ * side, zero beyond the ends of the sample. SampleStore::read() fills it and does all bounds handling once
+ * per block, which leaves the kernels without a single branch on the position.
+ *
+ * - linear: two taps, cheapest, audibly dull and aliased at large shifts.
+ * - cubic: four-tap Catmull-Rom Hermite spline, the default.
+ * - sinc: sixteen-tap Blackman-windowed sinc from a polyphase table of 256 phases, interpolated linearly
+ *   between neighbouring phases. For upward shifts a table with a cutoff lowered by half an octave at a
+ *   time is used, so the shifted sample does not alias.
+ *
+ * The sinc kernel sums its taps in four independent lanes, which the compiler turns into vector
+ * multiply-adds without needing -ffast-math. Its tables are built once, when the program starts.
+ */
+class SampleInterpolator
+{
+public:
+    /** @brief Interpolation kernels, in increasing cost and quality. */
+    enum class Quality
+    {
+        linear,
+        cubic,
+        sinc
+    };
+
+    /** @brief Frames a source window has before the first and after the last frame a block reads. */
+    static constexpr int guardFrames = 8;
+
+    static constexpr int sincTaps = 16;
+    static constexpr int sincPhases = 256;
+
+    /** @brief Largest increment playback supports, two octaves up. */
+    static constexpr double maxIncrement = 4.0;
+
+    /** @brief Returns the name used for a quality in the plugin state. */
+    static const char* getQualityName(Quality quality) noexcept;
+
+    /** @brief Returns the quality of a name from getQualityName(), cubic for unknown names. */
+    static Quality getQualityFromName(const juce::String& name) noexcept;
+
+    /**
+     * @brief Returns how many output frames read from before a distance, i.e. the n with
+     * n * increment < distance, limited to maxFrames.
+     * @param distance Frames from the fractional read position to the end of what may be played.
+     */
+    static int getFramesBefore(double distance, double increment, int maxFrames) noexcept;
+
+    /**
+     * @brief Returns the length of the source window a block of output frames reads, guard frames included.
+     */
+    static int getWindowLength(double fraction, double increment, int numFrames) noexcept;
+
+    /**
+     * @brief Interpolates a block of output frames.
+     * @param window Source window, guardFrames past its start, so window[0] is the integer read position.
+     * @param fraction Fractional part of the read position, in [0, 1).
+     * @param increment Source frames per output frame.
+     * @param out Receives the frames, every outStride values, e.g. one channel of interleaved audio.
+     * @param numFrames Number of output frames.
+     */
+    static void process(Quality quality, const float* window, double fraction, double increment,
+                        float* out, int outStride, int numFrames) noexcept;
+};
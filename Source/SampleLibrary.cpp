@@ -0,0 +1,446 @@
+#include "SampleLibrary.h"
+#include "TraceProfiler.h"
+
+#include <unordered_map>
+
+
+namespace
+{
+    /** @brief Marks index files, followed by indexVersion; files with another version are ignored. */
+    constexpr int indexMagic = 0x53494c41;
+    constexpr int indexVersion = 1;
+
+    /** @brief Shortest pause between two snapshots published while a scan finds new files. */
+    constexpr juce::uint32 publishIntervalMs = 1000;
+
+    struct StringHash
+    {
+        size_t operator()(const juce::String& s) const noexcept { return (size_t) s.hash(); }
+    };
+
+    /** @brief True if a path lies inside a folder. */
+    bool isInside(const juce::String& path, const juce::File& folder)
+    {
+        return path.startsWith(folder.getFullPathName() + juce::File::getSeparatorString());
+    }
+}
+
+
+SampleLibrary::SampleLibrary()
+    : SampleLibrary(getDefaultIndexFile())
+{
+}
+
+
+SampleLibrary::SampleLibrary(const juce::File& indexFileToUse)
+    : juce::Thread("Sample library"),
+      indexFile(indexFileToUse)
+{
+    formatManager.registerBasicFormats();
+    startThread();
+}
+
+
+/**
+ * @brief Stops the scanner, which finishes the file it is measuring first, and saves folders that were
+ * changed since the last scan.
+ */
+SampleLibrary::~SampleLibrary()
+{
+    stopThread(10000);
+
+    if (foldersChanged.load())
+        writeIndex(*getEntries());
+}
+
+
+juce::File SampleLibrary::getDefaultIndexFile()
+{
+    return juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+               .getChildFile("Plugin_AcidSoundWorks")
+               .getChildFile("Audiovisual Plugin")
+               .getChildFile("SampleLibrary.index");
+}
+
+
+void SampleLibrary::addFolder(const juce::File& folder)
+{
+    {
+        const juce::ScopedLock scope(lock);
+
+        if (! folders.addIfNotAlreadyThere(folder))
+            return;
+    }
+
+    foldersChanged = true;
+    rescan();
+}
+
+
+void SampleLibrary::removeFolder(const juce::File& folder)
+{
+    {
+        const juce::ScopedLock scope(lock);
+
+        if (! folders.contains(folder))
+            return;
+
+        folders.removeFirstMatchingValue(folder);
+    }
+
+    foldersChanged = true;
+    rescan();
+}
+
+
+juce::Array<juce::File> SampleLibrary::getFolders() const
+{
+    const juce::ScopedLock scope(lock);
+    return folders;
+}
+
+
+void SampleLibrary::rescan()
+{
+    restartRequested = true;
+    notify();
+}
+
+
+std::shared_ptr<const SampleLibrary::Entries> SampleLibrary::getEntries() const
+{
+    const juce::ScopedLock scope(lock);
+    return entries;
+}
+
+
+/**
+ * @brief Splits the query into lower case words once, then tests each entry's lower case path with
+ * plain substring searches.
+ */
+std::vector<int> SampleLibrary::search(const Entries& entries, const juce::String& query)
+{
+    const auto words = juce::StringArray::fromTokens(query.toLowerCase(), true);
+    std::vector<int> matches;
+
+    for (int i = 0; i < (int) entries.size(); ++i)
+    {
+        const auto& entry = entries[(size_t) i];
+
+        if (entry.isReadable()
+                && std::all_of(words.begin(), words.end(), [&entry](const juce::String& word) { return entry.searchText.contains(word); }))
+            matches.push_back(i);
+    }
+
+    return matches;
+}
+
+
+SampleLibrary::Entry SampleLibrary::analyseFile(const juce::File& file, juce::int64 fileSize, juce::int64 modified)
+{
+    AUDIOPLUGIN_TRACE_ZONE("library analyse")
+
+    Entry entry;
+    entry.path = file.getFullPathName();
+    entry.searchText = entry.path.toLowerCase();
+    entry.fileSize = fileSize;
+    entry.modified = modified;
+
+    std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(file));
+
+    if (reader == nullptr || reader->numChannels == 0 || reader->sampleRate <= 0.0)
+        return entry;
+
+    entry.format = reader->getFormatName();
+    entry.sampleRate = reader->sampleRate;
+    entry.numChannels = (int) reader->numChannels;
+    entry.numFrames = reader->lengthInSamples;
+
+    const auto numAnalysed = (int) juce::jmin(entry.numFrames, (juce::int64) (maxAnalysedSeconds * entry.sampleRate));
+
+    if (numAnalysed <= 0)
+        return entry;
+
+    juce::AudioBuffer<float> audio(entry.numChannels, numAnalysed);
+    audio.clear();
+    reader->read(&audio, 0, numAnalysed, 0, true, true);
+
+    const auto analysis = SampleLoadPipeline::analyse(audio, entry.sampleRate, SampleLoadOptions().trimThresholdDb);
+    entry.peakDb = analysis.peakDb;
+    entry.loudnessLufs = analysis.loudnessLufs;
+
+    for (int bin = 0; bin < thumbnailBins; ++bin)
+    {
+        const auto start = (int) ((juce::int64) bin * numAnalysed / thumbnailBins);
+        const auto end = (int) ((juce::int64) (bin + 1) * numAnalysed / thumbnailBins);
+        float peak = 0.0f;
+
+        for (int channel = 0; channel < entry.numChannels; ++channel)
+            peak = juce::jmax(peak, audio.getMagnitude(channel, start, end - start));
+
+        entry.thumbnail[(size_t) bin] = (juce::uint8) juce::roundToInt(juce::jlimit(0.0f, 1.0f, peak) * 255.0f);
+    }
+
+    return entry;
+}
+
+
+/**
+ * @brief Reads the index, then scans whenever the rescan interval has passed or a scan was requested.
+ */
+void SampleLibrary::run()
+{
+    readIndex();
+
+    while (! threadShouldExit())
+    {
+        restartRequested = false;
+        scanning = true;
+        const bool finished = scan();
+        scanning = false;
+
+        if (finished && ! restartRequested.load())
+            wait(rescanSeconds * 1000);
+    }
+}
+
+
+/**
+ * @brief Updates a copy of the current entries in place, so unchanged files keep their position and
+ * only files that are new or whose size or modification time changed are opened.
+ *
+ * Entries of files that were not found again are removed at the end of a complete scan, except below a
+ * folder that is not reachable, e.g. on an unplugged drive. An interrupted scan keeps what it measured.
+ */
+bool SampleLibrary::scan()
+{
+    AUDIOPLUGIN_TRACE_ZONE("library scan")
+
+    const auto scanFolders = getFolders();
+    const auto wildcard = getWildcard();
+    Entries working(*getEntries());
+    std::vector<bool> seen(working.size(), false);
+    std::unordered_map<juce::String, size_t, StringHash> positions;
+
+    positions.reserve(working.size());
+
+    for (size_t i = 0; i < working.size(); ++i)
+        positions.emplace(working[i].path, i);
+
+    bool changed = foldersChanged.exchange(false);
+    bool interrupted = false;
+    auto lastPublishMs = juce::Time::getMillisecondCounter();
+    numFilesChecked = 0;
+
+    for (const auto& folder : scanFolders)
+    {
+        if (! folder.isDirectory())
+        {
+            for (size_t i = 0; i < working.size(); ++i)
+                if (isInside(working[i].path, folder))
+                    seen[i] = true;
+
+            continue;
+        }
+
+        for (const auto& item : juce::RangedDirectoryIterator(folder, true, wildcard, juce::File::findFiles))
+        {
+            if (threadShouldExit() || restartRequested.load())
+            {
+                interrupted = true;
+                break;
+            }
+
+            ++numFilesChecked;
+
+            const auto file = item.getFile();
+            const auto fileSize = item.getFileSize();
+            const auto modified = item.getModificationTime().toMilliseconds();
+            const auto position = positions.find(file.getFullPathName());
+
+            if (position != positions.end())
+            {
+                auto& entry = working[position->second];
+                seen[position->second] = true;
+
+                if (entry.fileSize == fileSize && entry.modified == modified)
+                    continue;
+
+                entry = analyseFile(file, fileSize, modified);
+            }
+            else
+            {
+                positions.emplace(file.getFullPathName(), working.size());
+                working.push_back(analyseFile(file, fileSize, modified));
+                seen.push_back(true);
+            }
+
+            changed = true;
+
+            if (juce::Time::getMillisecondCounter() - lastPublishMs >= publishIntervalMs)
+            {
+                publish(working);
+                lastPublishMs = juce::Time::getMillisecondCounter();
+            }
+        }
+
+        if (interrupted)
+            break;
+    }
+
+    if (! interrupted)
+    {
+        const auto numBefore = working.size();
+        size_t kept = 0;
+
+        for (size_t i = 0; i < working.size(); ++i)
+            if (seen[i])
+                working[kept++] = std::move(working[i]);
+
+        working.resize(kept);
+        changed = changed || kept != numBefore;
+    }
+
+    if (changed)
+    {
+        publish(std::move(working));
+        writeIndex(*getEntries());
+    }
+
+    return ! interrupted;
+}
+
+
+void SampleLibrary::publish(Entries newEntries)
+{
+    std::sort(newEntries.begin(), newEntries.end(), [](const Entry& a, const Entry& b) { return a.path < b.path; });
+    auto snapshot = std::make_shared<const Entries>(std::move(newEntries));
+
+    {
+        const juce::ScopedLock scope(lock);
+        std::swap(entries, snapshot);
+    }
+
+    version.fetch_add(1, std::memory_order_release);
+}
+
+
+/**
+ * @brief Reads the folders and entries of the index file. Folders added before it was read are kept.
+ */
+bool SampleLibrary::readIndex()
+{
+    AUDIOPLUGIN_TRACE_ZONE("library read index")
+
+    juce::FileInputStream file(indexFile);
+
+    if (! file.openedOk())
+        return false;
+
+    juce::BufferedInputStream input(file, 1 << 16);
+
+    if (input.readInt() != indexMagic || input.readInt() != indexVersion)
+        return false;
+
+    juce::Array<juce::File> storedFolders;
+    const int numFolders = input.readInt();
+
+    for (int i = 0; i < numFolders && ! input.isExhausted(); ++i)
+    {
+        const auto path = input.readString();
+
+        if (juce::File::isAbsolutePath(path))
+            storedFolders.add(juce::File(path));
+    }
+
+    const int numEntries = input.readInt();
+
+    if (numEntries < 0)
+        return false;
+
+    Entries stored;
+    stored.reserve((size_t) juce::jmin(numEntries, 1 << 20));
+
+    for (int i = 0; i < numEntries; ++i)
+    {
+        Entry entry;
+        entry.path = input.readString();
+        entry.format = input.readString();
+        entry.fileSize = input.readInt64();
+        entry.modified = input.readInt64();
+        entry.sampleRate = input.readDouble();
+        entry.numChannels = input.readInt();
+        entry.numFrames = input.readInt64();
+        entry.peakDb = input.readFloat();
+        entry.loudnessLufs = input.readFloat();
+
+        if (input.read(entry.thumbnail.data(), thumbnailBins) != thumbnailBins)
+            return false;
+
+        entry.searchText = entry.path.toLowerCase();
+        stored.push_back(std::move(entry));
+    }
+
+    {
+        const juce::ScopedLock scope(lock);
+
+        for (const auto& folder : storedFolders)
+            folders.addIfNotAlreadyThere(folder);
+    }
+
+    publish(std::move(stored));
+    return true;
+}
+
+
+/**
+ * @brief Writes the index through a temporary file, so a crash while writing never leaves a partial index.
+ */
+void SampleLibrary::writeIndex(const Entries& entriesToWrite) const
+{
+    AUDIOPLUGIN_TRACE_ZONE("library write index")
+
+    indexFile.getParentDirectory().createDirectory();
+
+    const juce::TemporaryFile temporary(indexFile);
+    const auto foldersToWrite = getFolders();
+    bool ok = false;
+
+    {
+        juce::FileOutputStream output(temporary.getFile());
+
+        ok = output.openedOk()
+          && output.writeInt(indexMagic)
+          && output.writeInt(indexVersion)
+          && output.writeInt(foldersToWrite.size());
+
+        for (const auto& folder : foldersToWrite)
+            ok = ok && output.writeString(folder.getFullPathName());
+
+        ok = ok && output.writeInt((int) entriesToWrite.size());
+
+        for (const auto& entry : entriesToWrite)
+        {
+            ok = ok
+              && output.writeString(entry.path)
+              && output.writeString(entry.format)
+              && output.writeInt64(entry.fileSize)
+              && output.writeInt64(entry.modified)
+              && output.writeDouble(entry.sampleRate)
+              && output.writeInt(entry.numChannels)
+              && output.writeInt64(entry.numFrames)
+              && output.writeFloat(entry.peakDb)
+              && output.writeFloat(entry.loudnessLufs)
+              && output.write(entry.thumbnail.data(), thumbnailBins);
+
+            if (! ok)
+                break;
+        }
+
+        output.flush();
+        ok = ok && output.getStatus().wasOk();
+    }
+
+    if (ok)
+        temporary.overwriteTargetFileWithTemporary();
+}
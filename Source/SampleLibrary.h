@@ -0,0 +1,138 @@
+#pragma once
+
+#include <juce_audio_formats/juce_audio_formats.h>
+
+#include "SampleLoadPipeline.h"
+
+
+/**
+ * @class SampleLibrary
+ * @brief Index of every audio file under a set of library folders, kept up to date by a background scanner.
+ *
+ * For each file the index holds its format, length, sample rate and channels, the peak and integrated
+ * loudness measured by SampleLoadPipeline::analyse() and a small peak thumbnail. It is stored in one
+ * binary file (see getDefaultIndexFile()), which the scanner reads when it starts, so a library of any
+ * size is browsable before a single folder has been visited again.
+ *
+ * The scanner then walks the folders, and again every rescanSeconds or after rescan(). A file whose size
+ * and modification time match its entry keeps it without being opened; new and changed files are decoded
+ * and measured, and files that are gone drop out. The index file is rewritten after every scan that
+ * changed something. Only the first maxAnalysedSeconds of a file are decoded, which bounds the work per
+ * file and the memory of a scan.
+ *
+ * Entries are published as immutable snapshots sorted by path: getEntries() returns the current one and
+ * getVersion() changes whenever a new one is published, during long scans about once a second. All
+ * instances of the plugin share one library through juce::SharedResourcePointer.
+ */
+class SampleLibrary : private juce::Thread
+{
+public:
+    /** @brief Peak bins in a thumbnail, spread over the analysed part of the file. */
+    static constexpr int thumbnailBins = 48;
+
+    static constexpr double maxAnalysedSeconds = 30.0;
+    static constexpr int rescanSeconds = 60;
+
+    /** @brief What the index knows about one file. */
+    struct Entry
+    {
+        juce::String path;
+        juce::String format;            ///< Name of the format reader, e.g. "WAV file"
+        juce::int64 fileSize = 0;
+        juce::int64 modified = 0;       ///< Modification time in milliseconds
+        double sampleRate = 0.0;
+        int numChannels = 0;            ///< Zero for files that could not be read
+        juce::int64 numFrames = 0;
+        float peakDb = SampleAnalysis::silenceDb;
+        float loudnessLufs = SampleAnalysis::silenceDb;
+        std::array<juce::uint8, thumbnailBins> thumbnail {};   ///< Peak magnitude per bin, 255 at full scale
+
+        /** @brief Lower case path that search() matches against; not stored in the index file. */
+        juce::String searchText;
+
+        bool isReadable() const noexcept { return numChannels > 0; }
+        double getSeconds() const noexcept { return sampleRate > 0.0 ? (double) numFrames / sampleRate : 0.0; }
+        juce::String getName() const { return path.fromLastOccurrenceOf(juce::File::getSeparatorString(), false, false); }
+    };
+
+    using Entries = std::vector<Entry>;
+
+    /** @brief Uses the default index file. */
+    SampleLibrary();
+
+    /** @brief Uses the given index file, e.g. a temporary one for tests. */
+    explicit SampleLibrary(const juce::File& indexFile);
+
+    ~SampleLibrary() override;
+
+    /** @brief Returns the index shared by all instances, in the user's application data folder. */
+    static juce::File getDefaultIndexFile();
+
+    /** @brief Adds a folder, which is scanned with all its subfolders. */
+    void addFolder(const juce::File& folder);
+
+    /** @brief Removes a folder; its files drop out of the index with the next scan. */
+    void removeFolder(const juce::File& folder);
+
+    juce::Array<juce::File> getFolders() const;
+
+    /** @brief Starts a scan at once, restarting one that is running. */
+    void rescan();
+
+    /** @brief Returns the current entries, sorted by path. Never nullptr. */
+    std::shared_ptr<const Entries> getEntries() const;
+
+    /** @brief Changes whenever new entries are published. */
+    juce::uint32 getVersion() const noexcept { return version.load(std::memory_order_acquire); }
+
+    bool isScanning() const noexcept { return scanning.load(std::memory_order_relaxed); }
+
+    /** @brief Files visited by the running or last scan. */
+    int getNumFilesChecked() const noexcept { return numFilesChecked.load(std::memory_order_relaxed); }
+
+    /** @brief Returns the file patterns of every format the library reads, e.g. for a file chooser. */
+    juce::String getWildcard() const { return formatManager.getWildcardForAllFormats(); }
+
+    /**
+     * @brief Returns the readable entries whose path contains every word of a query, ignoring case.
+     * @return Indices into entries, in their order.
+     */
+    static std::vector<int> search(const Entries& entries, const juce::String& query);
+
+    /**
+     * @brief Decodes the start of a file and measures it.
+     * @param file File to measure.
+     * @param fileSize Size of the file as found by the scan.
+     * @param modified Modification time in milliseconds as found by the scan.
+     * @return The entry; unreadable files get one without channels, so they are not opened again while unchanged.
+     */
+    Entry analyseFile(const juce::File& file, juce::int64 fileSize, juce::int64 modified);
+
+private:
+    void run() override;
+
+    /* @brief Visits every folder and updates the entries; false if it was interrupted. */
+    bool scan();
+
+    /* @brief Installs new entries as the current snapshot. */
+    void publish(Entries entries);
+
+    bool readIndex();
+    void writeIndex(const Entries& entries) const;
+
+    const juce::File indexFile;
+    juce::AudioFormatManager formatManager;
+
+    /* @brief Guards the folders and the current snapshot. */
+    mutable juce::CriticalSection lock;
+    juce::Array<juce::File> folders;
+    std::shared_ptr<const Entries> entries = std::make_shared<const Entries>();
+
+    std::atomic<juce::uint32> version { 0 };
+    std::atomic<bool> scanning { false };
+    std::atomic<bool> restartRequested { false };
+    std::atomic<bool> foldersChanged { false };
+    std::atomic<int> numFilesChecked { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE (SampleLibrary)
+};
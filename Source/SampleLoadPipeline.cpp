@@ -0,0 +1,566 @@
+#include "SampleLoadPipeline.h"
+#include "LevelMeter.h"
+
+
+namespace
+{
+    namespace Ids
+    {
+        static const juce::Identifier sampleIndex  { "SampleIndex" };
+        static const juce::Identifier version      { "version" };
+        static const juce::Identifier fileSize     { "fileSize" };
+        static const juce::Identifier modified     { "modified" };
+        static const juce::Identifier threshold    { "threshold" };
+        static const juce::Identifier sampleRate   { "sampleRate" };
+        static const juce::Identifier channels     { "channels" };
+        static const juce::Identifier frames       { "frames" };
+        static const juce::Identifier audibleStart { "audibleStart" };
+        static const juce::Identifier audibleEnd   { "audibleEnd" };
+        static const juce::Identifier peak         { "peak" };
+        static const juce::Identifier rms          { "rms" };
+        static const juce::Identifier loudness     { "loudness" };
+        static const juce::Identifier dcOffset     { "dcOffset" };
+    }
+
+    /** @brief Bumped whenever the analysis changes, so indexes written by older versions are ignored. */
+    constexpr int indexVersion = 1;
+
+    /** @brief Loudness measurement after ITU-R BS.1770: 400 ms blocks in 100 ms steps, gated at -70 LUFS and -10 LU. */
+    constexpr double segmentSeconds = 0.1;
+    constexpr int segmentsPerBlock = 4;
+    constexpr double absoluteGateLufs = -70.0;
+    constexpr double relativeGateLu = -10.0;
+
+    double toDecibels(double value)
+    {
+        return value > 0.0 ? juce::jmax((double) SampleAnalysis::silenceDb, 10.0 * std::log10(value))
+                           : (double) SampleAnalysis::silenceDb;
+    }
+
+    double toLoudness(double meanSquare)
+    {
+        return Loudness::toLufs(meanSquare, (double) SampleAnalysis::silenceDb);
+    }
+
+    /**
+     * @brief Integrated loudness of a region in LUFS.
+     *
+     * The K-weighted energy of all channels is summed per 100 ms segment, and every four consecutive
+     * segments form a gating block. Regions shorter than one block are measured as a single block.
+     */
+    float measureLoudness(const juce::AudioBuffer<float>& audio, int start, int length, double sampleRate)
+    {
+        const int segmentLength = juce::jmax(1, juce::roundToInt(segmentSeconds * sampleRate));
+        const int numSegments = length / segmentLength;
+        std::vector<double> segmentEnergy((size_t) numSegments + 1, 0.0);
+        double totalEnergy = 0.0;
+
+        for (int channel = 0; channel < audio.getNumChannels(); ++channel)
+        {
+            auto stages = Loudness::makeKWeighting(sampleRate);
+            const float* data = audio.getReadPointer(channel, start);
+
+            for (int i = 0; i < length; ++i)
+            {
+                const double weighted = stages[1].process(stages[0].process((double) data[i]));
+                segmentEnergy[(size_t) (i / segmentLength)] += weighted * weighted;
+            }
+        }
+
+        for (const auto energy : segmentEnergy)
+            totalEnergy += energy;
+
+        if (numSegments < segmentsPerBlock)
+            return (float) toLoudness(totalEnergy / juce::jmax(1, length));
+
+        const int numBlocks = numSegments - segmentsPerBlock + 1;
+        const double blockLength = (double) segmentLength * segmentsPerBlock;
+        std::vector<double> blockPowers((size_t) numBlocks);
+
+        for (int block = 0; block < numBlocks; ++block)
+        {
+            double energy = 0.0;
+
+            for (int segment = block; segment < block + segmentsPerBlock; ++segment)
+                energy += segmentEnergy[(size_t) segment];
+
+            blockPowers[(size_t) block] = energy / blockLength;
+        }
+
+        auto gatedMean = [&blockPowers](double gateLufs)
+        {
+            double sum = 0.0;
+            int count = 0;
+
+            for (const auto power : blockPowers)
+            {
+                if (toLoudness(power) > gateLufs)
+                {
+                    sum += power;
+                    ++count;
+                }
+            }
+
+            return count > 0 ? sum / count : 0.0;
+        };
+
+        const double absoluteGated = gatedMean(absoluteGateLufs);
+        if (absoluteGated <= 0.0)
+            return SampleAnalysis::silenceDb;
+
+        return (float) toLoudness(gatedMean(toLoudness(absoluteGated) + relativeGateLu));
+    }
+}
+
+
+const char* SampleLoadOptions::getNormalisationName(Normalisation mode) noexcept
+{
+    switch (mode)
+    {
+        case Normalisation::none:     return "none";
+        case Normalisation::peak:     return "peak";
+        case Normalisation::loudness: return "loudness";
+    }
+
+    return "";
+}
+
+
+SampleLoadOptions::Normalisation SampleLoadOptions::getNormalisationFromName(const juce::String& name) noexcept
+{
+    for (auto mode : { Normalisation::peak, Normalisation::loudness })
+        if (name == getNormalisationName(mode))
+            return mode;
+
+    return Normalisation::none;
+}
+
+
+SampleLoadPipeline::WorkerPool::WorkerPool()
+    : threads(juce::jlimit(1, 4, juce::SystemStats::getNumCpus() - 1))
+{
+    formatManager.registerBasicFormats();
+}
+
+
+LoadedSample SampleLoadPipeline::load(const juce::File& file, const SampleLoadOptions& options) const
+{
+    return loadWith(workerPool->formatManager, file, options);
+}
+
+
+std::vector<LoadedSample> SampleLoadPipeline::loadAll(const juce::Array<juce::File>& files, const SampleLoadOptions& options) const
+{
+    struct Batch
+    {
+        std::vector<LoadedSample> results;
+        std::atomic<int> numRemaining { 0 };
+        juce::WaitableEvent finished;
+    };
+
+    if (files.isEmpty())
+        return {};
+
+    auto batch = std::make_shared<Batch>();
+    batch->results.resize((size_t) files.size());
+    batch->numRemaining = files.size();
+
+    auto& formats = workerPool->formatManager;
+
+    for (int i = 0; i < files.size(); ++i)
+    {
+        workerPool->threads.addJob([batch, &formats, file = files[i], options, i]
+        {
+            batch->results[(size_t) i] = loadWith(formats, file, options);
+
+            if (--batch->numRemaining == 0)
+                batch->finished.signal();
+        });
+    }
+
+    batch->finished.wait();
+    return std::move(batch->results);
+}
+
+
+void SampleLoadPipeline::loadAsync(const juce::File& file, const SampleLoadOptions& options, std::function<void(LoadedSample&)> onLoaded)
+{
+    juce::WeakReference<SampleLoadPipeline> pipeline(this);
+    auto& formats = workerPool->formatManager;
+
+    workerPool->threads.addJob([pipeline, &formats, file, options, onLoaded = std::move(onLoaded)]
+    {
+        auto result = std::make_shared<LoadedSample>(loadWith(formats, file, options));
+
+        juce::MessageManager::callAsync([pipeline, result, onLoaded]
+        {
+            if (pipeline != nullptr)
+                onLoaded(*result);
+        });
+    });
+}
+
+
+/**
+ * @brief Decodes a file and runs it through the pipeline.
+ *
+ * With a valid index only the audible region is decoded when trimming, otherwise the whole file is
+ * decoded, analysed and the analysis written back as index.
+ */
+LoadedSample SampleLoadPipeline::loadWith(juce::AudioFormatManager& formats, const juce::File& file, const SampleLoadOptions& options)
+{
+    LoadedSample sample;
+    std::unique_ptr<juce::AudioFormatReader> reader(formats.createReaderFor(file));
+
+    if (reader == nullptr || reader->numChannels == 0 || reader->lengthInSamples > std::numeric_limits<int>::max())
+        return sample;
+
+    const int numChannels = (int) reader->numChannels;
+    const auto numFrames = reader->lengthInSamples;
+    auto& analysis = sample.analysis;
+
+    sample.wasIndexed = options.useIndexFiles && readIndex(file, options.trimThresholdDb, analysis)
+                     && analysis.sampleRate == reader->sampleRate
+                     && analysis.numChannels == numChannels
+                     && analysis.numFrames == numFrames;
+
+    juce::int64 bufferStart = 0;
+    juce::int64 bufferLength = numFrames;
+
+    if (sample.wasIndexed && options.trimSilence && ! analysis.isSilent())
+    {
+        bufferStart = analysis.audibleStart;
+        bufferLength = analysis.getAudibleLength();
+    }
+
+    sample.audio.setSize(numChannels, (int) bufferLength);
+    sample.audio.clear();
+    reader->read(&sample.audio, 0, (int) bufferLength, bufferStart, true, true);
+
+    if (! sample.wasIndexed)
+    {
+        analysis = analyse(sample.audio, reader->sampleRate, options.trimThresholdDb);
+
+        if (options.useIndexFiles)
+            writeIndex(file, options.trimThresholdDb, analysis);
+    }
+
+    sample.isValid = true;
+    applyOptions(sample, bufferStart, options);
+
+    if (! (options.useIndexFiles && readPeaks(file, options, sample)))
+    {
+        sample.peaks = WaveformPeaks::build(sample.audio);
+
+        if (options.useIndexFiles)
+            writePeaks(file, options, sample);
+    }
+
+    sample.slices = SliceIndex::detect(sample.audio, reader->sampleRate);
+    sample.storage = SampleStore(std::move(sample.audio), options.storage, getStorageStepSize(*reader, sample.gainDb, options.storage));
+    return sample;
+}
+
+
+LoadedSample SampleLoadPipeline::process(const juce::AudioBuffer<float>& audio, double sampleRate, const SampleLoadOptions& options)
+{
+    LoadedSample sample;
+    sample.audio.makeCopyOf(audio);
+    sample.analysis = analyse(audio, sampleRate, options.trimThresholdDb);
+    sample.isValid = true;
+
+    applyOptions(sample, 0, options);
+    sample.peaks = WaveformPeaks::build(sample.audio);
+    sample.slices = SliceIndex::detect(sample.audio, sampleRate);
+    sample.storage = SampleStore(std::move(sample.audio), options.storage);
+    return sample;
+}
+
+
+/**
+ * @brief Finds the audible region from both ends, then measures peak, RMS, DC offset and loudness over it.
+ */
+SampleAnalysis SampleLoadPipeline::analyse(const juce::AudioBuffer<float>& audio, double sampleRate, float thresholdDb)
+{
+    SampleAnalysis analysis;
+    analysis.sampleRate = sampleRate;
+    analysis.numChannels = audio.getNumChannels();
+    analysis.numFrames = audio.getNumSamples();
+
+    const int numChannels = audio.getNumChannels();
+    const int numFrames = audio.getNumSamples();
+    const float threshold = juce::Decibels::decibelsToGain(thresholdDb, SampleAnalysis::silenceDb);
+
+    int start = numFrames;
+    int end = 0;
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        const float* data = audio.getReadPointer(channel);
+
+        for (int i = 0; i < start; ++i)
+        {
+            if (std::abs(data[i]) > threshold)
+            {
+                start = i;
+                break;
+            }
+        }
+
+        for (int i = numFrames; i > juce::jmax(end, start); --i)
+        {
+            if (std::abs(data[i - 1]) > threshold)
+            {
+                end = i;
+                break;
+            }
+        }
+    }
+
+    if (end <= start)
+        return analysis;
+
+    analysis.audibleStart = start;
+    analysis.audibleEnd = end;
+
+    const int length = end - start;
+    float peak = 0.0f;
+    double sumOfSquares = 0.0;
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        const float* data = audio.getReadPointer(channel, start);
+        const auto range = juce::FloatVectorOperations::findMinAndMax(data, length);
+        peak = juce::jmax(peak, std::abs(range.getStart()), std::abs(range.getEnd()));
+
+        double sum = 0.0;
+        double channelSquares = 0.0;
+
+        for (int i = 0; i < length; ++i)
+        {
+            sum += data[i];
+            channelSquares += (double) data[i] * data[i];
+        }
+
+        sumOfSquares += channelSquares;
+
+        const auto mean = (float) (sum / length);
+        if (std::abs(mean) > std::abs(analysis.dcOffset))
+            analysis.dcOffset = mean;
+    }
+
+    analysis.peakDb = juce::Decibels::gainToDecibels(peak, SampleAnalysis::silenceDb);
+    analysis.rmsDb = (float) toDecibels(sumOfSquares / ((double) length * numChannels));
+    analysis.loudnessLufs = sampleRate > 0.0 ? measureLoudness(audio, start, length, sampleRate) : SampleAnalysis::silenceDb;
+    return analysis;
+}
+
+
+float SampleLoadPipeline::getNormalisationGainDb(const SampleAnalysis& analysis, const SampleLoadOptions& options) noexcept
+{
+    if (analysis.peakDb <= SampleAnalysis::silenceDb)
+        return 0.0f;
+
+    switch (options.normalisation)
+    {
+        case SampleLoadOptions::Normalisation::peak:
+            return options.normalisationTarget - analysis.peakDb;
+
+        case SampleLoadOptions::Normalisation::loudness:
+            if (analysis.loudnessLufs <= SampleAnalysis::silenceDb)
+                return 0.0f;
+
+            return juce::jmin(options.normalisationTarget - analysis.loudnessLufs, -analysis.peakDb);
+
+        case SampleLoadOptions::Normalisation::none:
+            break;
+    }
+
+    return 0.0f;
+}
+
+
+juce::File SampleLoadPipeline::getIndexFile(const juce::File& sampleFile)
+{
+    return sampleFile.getSiblingFile(sampleFile.getFileName() + ".analysis");
+}
+
+
+juce::File SampleLoadPipeline::getPeaksFile(const juce::File& sampleFile)
+{
+    return sampleFile.getSiblingFile(sampleFile.getFileName() + ".peaks");
+}
+
+
+/**
+ * @brief An index is valid if it was written by this version with the same threshold for a file of the
+ * same size and modification time.
+ */
+bool SampleLoadPipeline::readIndex(const juce::File& file, float thresholdDb, SampleAnalysis& analysis)
+{
+    const auto indexFile = getIndexFile(file);
+    if (! indexFile.existsAsFile())
+        return false;
+
+    const auto xml = juce::XmlDocument::parse(indexFile);
+    if (xml == nullptr)
+        return false;
+
+    const auto index = juce::ValueTree::fromXml(*xml);
+
+    if (! index.hasType(Ids::sampleIndex)
+            || (int) index.getProperty(Ids::version, 0) != indexVersion
+            || (juce::int64) index.getProperty(Ids::fileSize, -1) != file.getSize()
+            || (juce::int64) index.getProperty(Ids::modified, -1) != file.getLastModificationTime().toMilliseconds()
+            || (float) index.getProperty(Ids::threshold, 0.0f) != thresholdDb)
+        return false;
+
+    analysis.sampleRate = index.getProperty(Ids::sampleRate, 0.0);
+    analysis.numChannels = index.getProperty(Ids::channels, 0);
+    analysis.numFrames = index.getProperty(Ids::frames, 0);
+    analysis.audibleStart = index.getProperty(Ids::audibleStart, 0);
+    analysis.audibleEnd = index.getProperty(Ids::audibleEnd, 0);
+    analysis.peakDb = index.getProperty(Ids::peak, SampleAnalysis::silenceDb);
+    analysis.rmsDb = index.getProperty(Ids::rms, SampleAnalysis::silenceDb);
+    analysis.loudnessLufs = index.getProperty(Ids::loudness, SampleAnalysis::silenceDb);
+    analysis.dcOffset = index.getProperty(Ids::dcOffset, 0.0f);
+
+    return analysis.audibleStart >= 0 && analysis.audibleEnd <= analysis.numFrames;
+}
+
+
+/**
+ * @brief Writes the index through a temporary file, so concurrent loads of the same sample never read
+ * a partly written index.
+ */
+void SampleLoadPipeline::writeIndex(const juce::File& file, float thresholdDb, const SampleAnalysis& analysis)
+{
+    juce::ValueTree index(Ids::sampleIndex);
+    index.setProperty(Ids::version, indexVersion, nullptr);
+    index.setProperty(Ids::fileSize, file.getSize(), nullptr);
+    index.setProperty(Ids::modified, file.getLastModificationTime().toMilliseconds(), nullptr);
+    index.setProperty(Ids::threshold, thresholdDb, nullptr);
+    index.setProperty(Ids::sampleRate, analysis.sampleRate, nullptr);
+    index.setProperty(Ids::channels, analysis.numChannels, nullptr);
+    index.setProperty(Ids::frames, analysis.numFrames, nullptr);
+    index.setProperty(Ids::audibleStart, analysis.audibleStart, nullptr);
+    index.setProperty(Ids::audibleEnd, analysis.audibleEnd, nullptr);
+    index.setProperty(Ids::peak, analysis.peakDb, nullptr);
+    index.setProperty(Ids::rms, analysis.rmsDb, nullptr);
+    index.setProperty(Ids::loudness, analysis.loudnessLufs, nullptr);
+    index.setProperty(Ids::dcOffset, analysis.dcOffset, nullptr);
+
+    const auto xml = index.createXml();
+    if (xml == nullptr)
+        return;
+
+    const juce::TemporaryFile temporary(getIndexFile(file));
+
+    if (xml->writeTo(temporary.getFile()))
+        temporary.overwriteTargetFileWithTemporary();
+}
+
+
+/**
+ * @brief Peaks are valid if they were written for a file of the same size and modification time and for a
+ * processed sample of the same length, trimming and gain.
+ */
+bool SampleLoadPipeline::readPeaks(const juce::File& file, const SampleLoadOptions& options, LoadedSample& sample)
+{
+    juce::FileInputStream input(getPeaksFile(file));
+
+    if (! input.openedOk()
+            || input.readInt() != indexVersion
+            || input.readInt64() != file.getSize()
+            || input.readInt64() != file.getLastModificationTime().toMilliseconds()
+            || input.readFloat() != options.trimThresholdDb
+            || input.readBool() != options.trimSilence
+            || input.readFloat() != sample.gainDb)
+        return false;
+
+    auto peaks = WaveformPeaks::read(input);
+
+    if (peaks == nullptr || peaks->getNumFrames() != sample.audio.getNumSamples())
+        return false;
+
+    sample.peaks = std::move(peaks);
+    return true;
+}
+
+
+/**
+ * @brief Writes the peaks through a temporary file, like writeIndex().
+ */
+void SampleLoadPipeline::writePeaks(const juce::File& file, const SampleLoadOptions& options, const LoadedSample& sample)
+{
+    const juce::TemporaryFile temporary(getPeaksFile(file));
+    bool ok = false;
+
+    {
+        juce::FileOutputStream output(temporary.getFile());
+
+        ok = output.openedOk()
+          && output.writeInt(indexVersion)
+          && output.writeInt64(file.getSize())
+          && output.writeInt64(file.getLastModificationTime().toMilliseconds())
+          && output.writeFloat(options.trimThresholdDb)
+          && output.writeBool(options.trimSilence)
+          && output.writeFloat(sample.gainDb)
+          && sample.peaks->write(output);
+    }
+
+    if (ok)
+        temporary.overwriteTargetFileWithTemporary();
+}
+
+
+/**
+ * @brief Format readers scale integer values by one step of their bit depth, e.g. 1 / 32768 for 16 bits.
+ */
+float SampleLoadPipeline::getStorageStepSize(const juce::AudioFormatReader& reader, float gainDb, SampleStore::Format format) noexcept
+{
+    const int bits = (int) reader.bitsPerSample;
+
+    if (format == SampleStore::Format::float32 || reader.usesFloatingPointData || bits <= 0 || bits > SampleStore::getBitsPerValue(format))
+        return 0.0f;
+
+    return juce::Decibels::decibelsToGain(gainDb) * std::exp2(1.0f - (float) bits);
+}
+
+
+/**
+ * @brief Cuts the buffer down to the audible region and applies the normalisation gain.
+ *
+ * A silent sample is kept as it is. The trimmed audio is copied into a buffer of its own size, so the
+ * memory of the silence is released.
+ *
+ * @param sample Sample whose analysis is complete.
+ * @param bufferStart Frame of the file the buffer starts at.
+ * @param options Trimming and normalisation settings.
+ */
+void SampleLoadPipeline::applyOptions(LoadedSample& sample, juce::int64 bufferStart, const SampleLoadOptions& options)
+{
+    const auto& analysis = sample.analysis;
+    auto& audio = sample.audio;
+
+    if (options.trimSilence && ! analysis.isSilent())
+    {
+        const int start = (int) (analysis.audibleStart - bufferStart);
+        const int length = (int) analysis.getAudibleLength();
+
+        if (start != 0 || length != audio.getNumSamples())
+        {
+            juce::AudioBuffer<float> trimmed(audio.getNumChannels(), length);
+
+            for (int channel = 0; channel < audio.getNumChannels(); ++channel)
+                trimmed.copyFrom(channel, 0, audio, channel, start, length);
+
+            std::swap(audio, trimmed);
+        }
+    }
+
+    sample.gainDb = getNormalisationGainDb(analysis, options);
+
+    if (sample.gainDb != 0.0f)
+        audio.applyGain(juce::Decibels::decibelsToGain(sample.gainDb));
+}
@@ -0,0 +1,194 @@
+#pragma once
+
+#include <juce_audio_formats/juce_audio_formats.h>
+#include <juce_data_structures/juce_data_structures.h>
+
+#include "WaveformPeaks.h"
+#include "SliceIndex.h"
+#include "SampleStore.h"
+
+
+/**
+ * @struct SampleAnalysis
+ * @brief Measurements of a sample, taken over its audible region.
+ *
+ * The audible region runs from the first to the last frame whose level exceeds the trim threshold
+ * in any channel. Frame positions refer to the file as decoded.
+ */
+struct SampleAnalysis
+{
+    /** @brief Level reported for silence and for regions without any audible frame. */
+    static constexpr float silenceDb = -100.0f;
+
+    double sampleRate = 0.0;
+    int numChannels = 0;
+    juce::int64 numFrames = 0;      ///< Length of the decoded file
+    juce::int64 audibleStart = 0;   ///< First frame above the threshold
+    juce::int64 audibleEnd = 0;     ///< One past the last frame above the threshold
+
+    float peakDb = silenceDb;       ///< Sample peak in dBFS
+    float rmsDb = silenceDb;        ///< RMS level of all channels in dBFS
+    float loudnessLufs = silenceDb; ///< Integrated loudness after ITU-R BS.1770
+    float dcOffset = 0.0f;          ///< Mean of the channel with the largest offset
+
+    juce::int64 getAudibleLength() const noexcept { return audibleEnd - audibleStart; }
+    double getAudibleSeconds() const noexcept { return sampleRate > 0.0 ? (double) getAudibleLength() / sampleRate : 0.0; }
+    bool isSilent() const noexcept { return audibleEnd <= audibleStart; }
+};
+
+
+/**
+ * @struct SampleLoadOptions
+ * @brief What the load pipeline does to a sample after decoding it.
+ */
+struct SampleLoadOptions
+{
+    enum class Normalisation
+    {
+        none,
+        peak,       ///< Scale the sample peak to the target in dBFS
+        loudness    ///< Scale the integrated loudness to the target in LUFS, without exceeding 0 dBFS peak
+    };
+
+    /** @brief Returns the name used for a normalisation mode in the plugin state. */
+    static const char* getNormalisationName(Normalisation mode) noexcept;
+
+    /** @brief Returns the mode with the given name, or none. */
+    static Normalisation getNormalisationFromName(const juce::String& name) noexcept;
+
+    bool trimSilence = true;
+    float trimThresholdDb = -60.0f;
+    Normalisation normalisation = Normalisation::none;
+    float normalisationTarget = -1.0f;
+    bool useIndexFiles = true;
+    SampleStore::Format storage = SampleStore::Format::float32;    ///< How the processed audio is kept in memory
+
+    bool operator==(const SampleLoadOptions& other) const noexcept
+    {
+        return trimSilence == other.trimSilence && trimThresholdDb == other.trimThresholdDb
+            && normalisation == other.normalisation && normalisationTarget == other.normalisationTarget
+            && useIndexFiles == other.useIndexFiles && storage == other.storage;
+    }
+
+    bool operator!=(const SampleLoadOptions& other) const noexcept { return ! operator==(other); }
+};
+
+
+/**
+ * @struct LoadedSample
+ * @brief Result of the load pipeline: the audio ready to be installed and what was measured.
+ *
+ * The pipeline processes and measures the audio as floats and then moves it into storage, in the format
+ * of the load options, which leaves audio empty.
+ */
+struct LoadedSample
+{
+    juce::AudioBuffer<float> audio;
+    SampleStore storage;
+    SampleAnalysis analysis;
+    std::shared_ptr<const WaveformPeaks> peaks;     ///< Waveform of the processed audio
+    std::shared_ptr<const SliceIndex> slices;       ///< Onsets of the processed audio
+    float gainDb = 0.0f;        ///< Normalisation gain applied to the audio
+    bool isValid = false;       ///< False if the file could not be read
+    bool wasIndexed = false;    ///< True if the analysis came from the sidecar index
+};
+
+
+/**
+ * @class SampleLoadPipeline
+ * @brief Decodes sample files and trims, normalises and analyses them on a worker pool.
+ *
+ * The analysis of a file is written to a small sidecar index next to it (see getIndexFile()). A later
+ * load of the unchanged file reads the index instead of analysing again and decodes only the audible
+ * region. The waveform peaks of the processed audio are cached the same way (see getPeaksFile()). Index
+ * files that cannot be written, e.g. in read-only directories, are skipped silently. The slice index of
+ * the processed audio is detected on every load, on the same worker as the rest of the pipeline, which
+ * finally packs the audio into the storage format of the options.
+ *
+ * All instances share one thread pool and one set of format readers. load() and analyse() are
+ * thread-safe; loadAsync() must be called on the message thread and delivers its result there.
+ */
+class SampleLoadPipeline
+{
+public:
+    SampleLoadPipeline() = default;
+
+    /**
+     * @brief Decodes and processes a file on the calling thread.
+     * @param file Audio file to load.
+     * @param options Trimming, normalisation and index settings.
+     */
+    LoadedSample load(const juce::File& file, const SampleLoadOptions& options) const;
+
+    /**
+     * @brief Loads several files in parallel on the worker pool and waits until all are done.
+     * @return One result per file, in the same order.
+     */
+    std::vector<LoadedSample> loadAll(const juce::Array<juce::File>& files, const SampleLoadOptions& options) const;
+
+    /**
+     * @brief Loads a file on the worker pool.
+     *
+     * The callback runs on the message thread, and not at all if the pipeline has been destroyed by then.
+     */
+    void loadAsync(const juce::File& file, const SampleLoadOptions& options, std::function<void(LoadedSample&)> onLoaded);
+
+    /**
+     * @brief Processes already decoded audio with the same steps as a file, without an index.
+     * @param audio Audio to process.
+     * @param sampleRate Sample rate of the audio, used for the loudness filter.
+     * @param options Trimming and normalisation settings.
+     */
+    static LoadedSample process(const juce::AudioBuffer<float>& audio, double sampleRate, const SampleLoadOptions& options);
+
+    /**
+     * @brief Finds the audible region of a buffer and measures it.
+     * @param audio Audio to analyse.
+     * @param sampleRate Sample rate of the audio.
+     * @param thresholdDb Level a frame has to exceed to count as audible.
+     */
+    static SampleAnalysis analyse(const juce::AudioBuffer<float>& audio, double sampleRate, float thresholdDb);
+
+    /** @brief Returns the gain normalisation applies to a sample with the given analysis. */
+    static float getNormalisationGainDb(const SampleAnalysis& analysis, const SampleLoadOptions& options) noexcept;
+
+    /** @brief Returns the sidecar index of a sample file, e.g. kick.wav.analysis for kick.wav. */
+    static juce::File getIndexFile(const juce::File& sampleFile);
+
+    /** @brief Returns the sidecar waveform cache of a sample file, e.g. kick.wav.peaks for kick.wav. */
+    static juce::File getPeaksFile(const juce::File& sampleFile);
+
+private:
+    /** @brief Threads and format readers shared by all pipelines. */
+    struct WorkerPool
+    {
+        WorkerPool();
+
+        juce::AudioFormatManager formatManager;
+        juce::ThreadPool threads;
+    };
+
+    static LoadedSample loadWith(juce::AudioFormatManager& formats, const juce::File& file, const SampleLoadOptions& options);
+
+    /** @brief Reads a valid index of the file into analysis. */
+    static bool readIndex(const juce::File& file, float thresholdDb, SampleAnalysis& analysis);
+    static void writeIndex(const juce::File& file, float thresholdDb, const SampleAnalysis& analysis);
+
+    /** @brief Reads cached peaks of the file that match the processed sample into sample.peaks. */
+    static bool readPeaks(const juce::File& file, const SampleLoadOptions& options, LoadedSample& sample);
+    static void writePeaks(const juce::File& file, const SampleLoadOptions& options, const LoadedSample& sample);
+
+    /**
+     * @brief Returns the storage step that keeps audio decoded from an integer file exact: one step of
+     * the file scaled by the normalisation gain. Zero if the file's values do not fit the format.
+     */
+    static float getStorageStepSize(const juce::AudioFormatReader& reader, float gainDb, SampleStore::Format format) noexcept;
+
+    /** @brief Trims and normalises decoded audio whose analysis is known. */
+    static void applyOptions(LoadedSample& sample, juce::int64 bufferStart, const SampleLoadOptions& options);
+
+    juce::SharedResourcePointer<WorkerPool> workerPool;
+
+    JUCE_DECLARE_WEAK_REFERENCEABLE (SampleLoadPipeline)
+    JUCE_DECLARE_NON_COPYABLE (SampleLoadPipeline)
+};
@@ -0,0 +1,148 @@
+#include "SampleStore.h"
+
+
+const char* SampleStore::getFormatName(Format format) noexcept
+{
+    switch (format)
+    {
+        case Format::float32: return "float32";
+        case Format::int16:   return "int16";
+        case Format::int24:   return "int24";
+    }
+
+    return "";
+}
+
+
+SampleStore::Format SampleStore::getFormatFromName(const juce::String& name) noexcept
+{
+    for (auto format : { Format::int16, Format::int24 })
+        if (name == getFormatName(format))
+            return format;
+
+    return Format::float32;
+}
+
+
+int SampleStore::getBitsPerValue(Format format) noexcept
+{
+    switch (format)
+    {
+        case Format::int16:   return 16;
+        case Format::int24:   return 24;
+        case Format::float32: break;
+    }
+
+    return 32;
+}
+
+
+/**
+ * @brief Rounds every value to a whole number of steps, limited to the integer range.
+ */
+SampleStore::SampleStore(juce::AudioBuffer<float> audio, Format newFormat, float newStepSize)
+    : format(newFormat), numChannels(audio.getNumChannels()), numFrames(audio.getNumSamples())
+{
+    if (format == Format::float32)
+    {
+        floats = std::move(audio);
+        return;
+    }
+
+    const int bits = getBitsPerValue(format);
+    const int bytesPerValue = bits / 8;
+    const int maxValue = (1 << (bits - 1)) - 1;
+    float peak = 0.0f;
+
+    for (int channel = 0; channel < numChannels; ++channel)
+        peak = juce::jmax(peak, audio.getMagnitude(channel, 0, numFrames));
+
+    // A given step that cannot reach the peak would clip, e.g. after a gain above 0 dB
+    stepSize = newStepSize > 0.0f && peak / newStepSize <= (float) maxValue + 1.0f ? newStepSize
+             : (peak > 0.0f ? peak / (float) maxValue : 1.0f);
+
+    packed.resize((size_t) numChannels * (size_t) numFrames * (size_t) bytesPerValue);
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        const float* in = audio.getReadPointer(channel);
+        juce::uint8* out = packed.data() + (size_t) channel * (size_t) numFrames * (size_t) bytesPerValue;
+
+        for (int i = 0; i < numFrames; ++i)
+        {
+            const auto value = (juce::uint32) juce::jlimit(-maxValue - 1, maxValue, juce::roundToInt(in[i] / stepSize));
+
+            for (int byte = 0; byte < bytesPerValue; ++byte)
+                out[i * bytesPerValue + byte] = (juce::uint8) (value >> (8 * byte));
+        }
+    }
+}
+
+
+size_t SampleStore::getNumBytes() const noexcept
+{
+    return format == Format::float32 ? (size_t) numChannels * (size_t) numFrames * sizeof(float) : packed.size();
+}
+
+
+const float* SampleStore::getReadPointer(int channel, int start, int count, float* scratch) const noexcept
+{
+    if (format == Format::float32)
+        return floats.getReadPointer(channel, start);
+
+    decode(channel, start, scratch, count);
+    return scratch;
+}
+
+
+void SampleStore::read(int channel, int first, float* destination, int count) const noexcept
+{
+    const int from = juce::jlimit(0, count, -first);
+    const int to = juce::jlimit(from, count, numFrames - first);
+
+    juce::FloatVectorOperations::clear(destination, from);
+
+    if (to > from)
+    {
+        if (format == Format::float32)
+            juce::FloatVectorOperations::copy(destination + from, floats.getReadPointer(channel, first + from), to - from);
+        else
+            decode(channel, first + from, destination + from, to - from);
+    }
+
+    juce::FloatVectorOperations::clear(destination + to, count - to);
+}
+
+
+/**
+ * @brief Assembles the little-endian bytes of each value, sign-extends and scales it, so the result does
+ * not depend on the host's byte order. The loops have no branches and no dependencies between iterations,
+ * so they compile to vector conversions and multiplies; on little-endian hosts the 16-bit assembly is a
+ * plain load. The byte shuffles of the 24-bit loop need SSE4.1 or NEON; plain SSE2 builds run it scalar.
+ */
+void SampleStore::decode(int channel, int start, float* destination, int count) const noexcept
+{
+    const float step = stepSize;
+
+    if (format == Format::int16)
+    {
+        const juce::uint8* in = packed.data() + ((size_t) channel * (size_t) numFrames + (size_t) start) * 2;
+
+        for (int i = 0; i < count; ++i)
+        {
+            const auto bits = (juce::uint32) in[2 * i] << 16 | (juce::uint32) in[2 * i + 1] << 24;
+            destination[i] = (float) ((juce::int32) bits >> 16) * step;
+        }
+    }
+    else
+    {
+        const juce::uint8* in = packed.data() + ((size_t) channel * (size_t) numFrames + (size_t) start) * 3;
+
+        for (int i = 0; i < count; ++i)
+        {
+            // The top byte lands in the sign bit, and the arithmetic shift extends it
+            const auto bits = (juce::uint32) in[3 * i] << 8 | (juce::uint32) in[3 * i + 1] << 16 | (juce::uint32) in[3 * i + 2] << 24;
+            destination[i] = (float) ((juce::int32) bits >> 8) * step;
+        }
+    }
+}
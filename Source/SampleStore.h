@@ -0,0 +1,87 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+
+
+/**
+ * @class SampleStore
+ * @brief The frames of a loaded sample in memory, as 32-bit floats or as packed 16- or 24-bit integers.
+ *
+ * Integer storage takes a half or three quarters of the memory of floats. Every integer step stands for
+ * the same value, the step size. Audio decoded from an integer file and scaled by one gain is stored with
+ * exactly its original steps, so it comes back as loaded, to within float rounding of the gain. Other
+ * audio spreads the integer range over its peak.
+ *
+ * Playback never needs the whole sample as floats: getReadPointer() and read() decode just the frames
+ * of one block, in a plain conversion loop the compiler vectorises. Float storage is read in place at no
+ * cost. A store is immutable once built, so the audio thread and the freezer can read it concurrently.
+ */
+class SampleStore
+{
+public:
+    /** @brief How the frames are kept in memory. */
+    enum class Format
+    {
+        float32,
+        int16,
+        int24       ///< Three bytes per value, little endian
+    };
+
+    /** @brief Returns the name used for a format in the plugin state. */
+    static const char* getFormatName(Format format) noexcept;
+
+    /** @brief Returns the format with the given name, or float32. */
+    static Format getFormatFromName(const juce::String& name) noexcept;
+
+    /** @brief Returns the bits of an integer format, or 32 for float32. */
+    static int getBitsPerValue(Format format) noexcept;
+
+    SampleStore() = default;
+
+    /**
+     * @brief Stores audio in a format.
+     * @param audio Audio to store; float storage takes over its memory.
+     * @param format Format to keep the frames in.
+     * @param stepSize Value of one integer step, e.g. 1 / 32768 for audio decoded from a 16-bit file.
+     *        Zero, or a step too small for the audio's peak, spreads the integer range over the peak.
+     */
+    SampleStore(juce::AudioBuffer<float> audio, Format format, float stepSize = 0.0f);
+
+    Format getFormat() const noexcept    { return format; }
+    int getNumChannels() const noexcept  { return numChannels; }
+    int getNumFrames() const noexcept    { return numFrames; }
+
+    /** @brief Returns the memory taken by the frames. */
+    size_t getNumBytes() const noexcept;
+
+    /**
+     * @brief Returns frames of a channel as floats.
+     *
+     * Float storage is returned in place; otherwise the frames are decoded into scratch. The range must
+     * lie inside the sample.
+     *
+     * @param scratch Receives numFrames decoded frames if needed.
+     */
+    const float* getReadPointer(int channel, int start, int numFrames, float* scratch) const noexcept;
+
+    /**
+     * @brief Decodes frames of a channel, zero outside the sample.
+     * @param first Frame of the sample the destination starts at; may be negative.
+     */
+    void read(int channel, int first, float* destination, int numFrames) const noexcept;
+
+private:
+    Format format = Format::float32;
+    int numChannels = 0;
+    int numFrames = 0;
+    float stepSize = 1.0f;
+
+    /* @brief Frames of float32 storage. */
+    juce::AudioBuffer<float> floats;
+
+    /* @brief Frames of integer storage, one channel after the other. */
+    std::vector<juce::uint8> packed;
+
+    /* @brief Converts frames of integer storage that lie inside the sample. */
+    void decode(int channel, int start, float* destination, int count) const noexcept;
+};
@@ -0,0 +1,199 @@
+#include "SliceIndex.h"
+#include "TraceProfiler.h"
+
+#include <juce_dsp/juce_dsp.h>
+
+
+namespace
+{
+    /** @brief Scale of the log compression of the magnitudes, log(1 + compression * |X|). */
+    constexpr float compression = 100.0f;
+
+    /** @brief Hops on either side an onset must be the maximum of. */
+    constexpr int maximumRadius = 3;
+
+    /** @brief Hops before and after an onset its flux is compared with. */
+    constexpr int averageBefore = 10;
+    constexpr int averageAfter = 3;
+
+    /** @brief Frames of the windows the envelope is followed back with when refining an onset. */
+    constexpr int refineWindow = 32;
+
+    /** @brief Level relative to the attack's peak below which the envelope counts as not yet risen. */
+    constexpr float riseLevel = 0.1f;
+}
+
+
+/**
+ * @brief Computes the flux of frames centred on every hop, picks its peaks and refines them to frames.
+ * If more than maxSlices onsets are found, the strongest are kept.
+ */
+std::shared_ptr<const SliceIndex> SliceIndex::detect(const juce::AudioBuffer<float>& audio, double sampleRate, float threshold)
+{
+    AUDIOPLUGIN_TRACE_ZONE("detectOnsets")
+
+    auto index = std::make_shared<SliceIndex>();
+    const int length = audio.getNumSamples();
+    const int numChannels = audio.getNumChannels();
+
+    index->numFrames = length;
+
+    if (length == 0 || numChannels == 0)
+        return index;
+
+    index->starts.push_back(0);
+
+    std::vector<float> mono((size_t) length, 0.0f);
+
+    for (int channel = 0; channel < numChannels; ++channel)
+        juce::FloatVectorOperations::addWithMultiply(mono.data(), audio.getReadPointer(channel), 1.0f / (float) numChannels, length);
+
+    const int numHops = length / hopSize + 1;
+
+    if (numHops <= 2 * maximumRadius)
+        return index;
+
+    juce::dsp::FFT fft(fftOrder);
+    juce::dsp::WindowingFunction<float> window((size_t) fftSize, juce::dsp::WindowingFunction<float>::hann, false);
+    std::vector<float> frame((size_t) fftSize * 2);
+    std::vector<float> previous((size_t) fftSize / 2 + 1, 0.0f);
+    std::vector<float> flux((size_t) numHops, 0.0f);
+
+    for (int hop = 0; hop < numHops; ++hop)
+    {
+        // Frame centred on the hop, zero beyond the ends of the sample
+        const int first = hop * hopSize - fftSize / 2;
+        const int from = juce::jmax(0, first);
+        const int to = juce::jmin(length, first + fftSize);
+
+        std::fill(frame.begin(), frame.end(), 0.0f);
+        std::copy(mono.begin() + from, mono.begin() + to, frame.begin() + (from - first));
+
+        window.multiplyWithWindowingTable(frame.data(), (size_t) fftSize);
+        fft.performFrequencyOnlyForwardTransform(frame.data(), true);
+
+        float rise = 0.0f;
+
+        for (size_t bin = 0; bin < previous.size(); ++bin)
+        {
+            const float magnitude = std::log1p(compression * frame[bin]);
+            rise += juce::jmax(0.0f, magnitude - previous[bin]);
+            previous[bin] = magnitude;
+        }
+
+        flux[(size_t) hop] = rise;
+    }
+
+    const float largest = *std::max_element(flux.begin(), flux.end());
+
+    if (largest <= 0.0f)
+        return index;
+
+    juce::FloatVectorOperations::multiply(flux.data(), 1.0f / largest, numHops);
+
+    struct Onset
+    {
+        int hop = 0;
+        float strength = 0.0f;
+    };
+
+    std::vector<Onset> onsets;
+    const int minGapHops = juce::jmax(1, juce::roundToInt(minGapSeconds * sampleRate / hopSize));
+    int lastHop = 0;
+
+    for (int hop = 1; hop < numHops; ++hop)
+    {
+        const float value = flux[(size_t) hop];
+        const int maxFrom = juce::jmax(0, hop - maximumRadius);
+        const int maxTo = juce::jmin(numHops, hop + maximumRadius + 1);
+
+        if (hop - lastHop < minGapHops || value < *std::max_element(flux.begin() + maxFrom, flux.begin() + maxTo))
+            continue;
+
+        const int averageFrom = juce::jmax(0, hop - averageBefore);
+        const int averageTo = juce::jmin(numHops, hop + averageAfter + 1);
+        const float average = std::accumulate(flux.begin() + averageFrom, flux.begin() + averageTo, 0.0f) / (float) (averageTo - averageFrom);
+
+        if (value < average + threshold)
+            continue;
+
+        onsets.push_back({ hop, value - average });
+        lastHop = hop;
+    }
+
+    if ((int) onsets.size() > maxSlices - 1)
+    {
+        std::partial_sort(onsets.begin(), onsets.begin() + (maxSlices - 1), onsets.end(),
+                          [](const Onset& a, const Onset& b) { return a.strength > b.strength; });
+        onsets.resize((size_t) maxSlices - 1);
+        std::sort(onsets.begin(), onsets.end(), [](const Onset& a, const Onset& b) { return a.hop < b.hop; });
+    }
+
+    for (const auto& onset : onsets)
+    {
+        const int start = refineOnset(mono.data(), length, onset.hop * hopSize, index->starts.back() + 1);
+
+        if (start > index->starts.back() && start < length)
+            index->starts.push_back(start);
+    }
+
+    return index;
+}
+
+
+/**
+ * @brief Finds the loudest frame within half an FFT frame of the estimate, then follows the envelope
+ * back in short windows until one stays below riseLevel of that peak. If none does, e.g. under the
+ * tail of a previous note, the quietest window is used.
+ * @param mono Mono mix of the sample.
+ * @param numFrames Length of the sample.
+ * @param estimate Centre of the onset's FFT frame.
+ * @param earliest First frame the onset may be placed at.
+ */
+int SliceIndex::refineOnset(const float* mono, int numFrames, int estimate, int earliest) noexcept
+{
+    const int searchStart = juce::jlimit(0, numFrames, juce::jmax(earliest, estimate - fftSize / 2));
+    const int searchEnd = juce::jmin(numFrames, estimate + fftSize / 2);
+
+    if (searchEnd <= searchStart)
+        return juce::jlimit(0, numFrames, estimate);
+
+    int peakFrame = searchStart;
+    float peak = 0.0f;
+
+    for (int i = searchStart; i < searchEnd; ++i)
+    {
+        if (std::abs(mono[i]) > peak)
+        {
+            peak = std::abs(mono[i]);
+            peakFrame = i;
+        }
+    }
+
+    if (peak <= 0.0f)
+        return juce::jlimit(searchStart, searchEnd - 1, estimate);
+
+    int position = peakFrame;
+    int quietest = peakFrame;
+    float quietestLevel = peak;
+
+    while (position > searchStart)
+    {
+        const int from = juce::jmax(searchStart, position - refineWindow);
+        const auto range = juce::FloatVectorOperations::findMinAndMax(mono + from, position - from);
+        const float level = juce::jmax(-range.getStart(), range.getEnd());
+
+        if (level < peak * riseLevel)
+            return position;
+
+        if (level < quietestLevel)
+        {
+            quietestLevel = level;
+            quietest = position;
+        }
+
+        position = from;
+    }
+
+    return quietest;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+
+
+/**
+ * @class SliceIndex
+ * @brief Start frames of the slices of a sample, found by onset detection.
+ *
+ * detect() looks for onsets with the spectral flux of short, overlapping FFT frames: the summed rise of
+ * the log-compressed magnitude of every bin from one frame to the next. A frame is an onset if its flux
+ * is the local maximum and stands out from the moving average around it by a threshold, and is at least
+ * minGapSeconds after the previous one. The frame position is then refined to the frame where the
+ * attack's envelope starts to rise, so a slice starts just before its transient.
+ *
+ * The first slice always starts at frame 0, and a slice ends where the next one starts. Slices are
+ * offsets into the sample they were detected in; playing one never copies audio. Indices are immutable
+ * once built and shared between threads through std::shared_ptr.
+ */
+class SliceIndex
+{
+public:
+    static constexpr int fftOrder = 10;
+    static constexpr int fftSize = 1 << fftOrder;
+    static constexpr int hopSize = fftSize / 4;
+    static constexpr int maxSlices = 64;
+    static constexpr double minGapSeconds = 0.05;
+
+    /**
+     * @brief Detects the onsets of a buffer.
+     * @param audio Audio to slice; the channels are mixed to mono.
+     * @param sampleRate Sample rate of the audio, for the minimum gap between onsets.
+     * @param threshold Normalised flux an onset has to exceed its surroundings by; lower finds more slices.
+     */
+    static std::shared_ptr<const SliceIndex> detect(const juce::AudioBuffer<float>& audio, double sampleRate,
+                                                    float threshold = 0.1f);
+
+    int getNumSlices() const noexcept { return (int) starts.size(); }
+    int getNumFrames() const noexcept { return numFrames; }
+
+    /** @brief Returns the start frame of every slice, in ascending order. */
+    const std::vector<int>& getStarts() const noexcept { return starts; }
+
+    /** @brief Returns the frames of a slice; the index wraps around, so any step number selects a slice. */
+    juce::Range<int> getSlice(int index) const noexcept
+    {
+        if (starts.empty())
+            return { 0, numFrames };
+
+        const int slice = ((index % getNumSlices()) + getNumSlices()) % getNumSlices();
+        return { starts[(size_t) slice], slice + 1 < getNumSlices() ? starts[(size_t) slice + 1] : numFrames };
+    }
+
+private:
+    int numFrames = 0;
+    std::vector<int> starts;
+
+    /** @brief Moves an onset estimate back to where the envelope rises out of what precedes it. */
+    static int refineOnset(const float* mono, int numFrames, int estimate, int earliest) noexcept;
+};
@@ -0,0 +1,293 @@
+#include "SpectrumAnalyser.h"
+#include "TraceProfiler.h"
+
+
+namespace
+{
+    /** @brief Frames each FIFO holds, enough for several drain intervals at any common sample rate. */
+    constexpr int fifoFrames = SpectrumAnalyser::fftSize * 4;
+
+    /** @brief Longest pause between two drains of the FIFOs, whatever the analysis rate. */
+    constexpr double drainIntervalMs = 20.0;
+
+    /** @brief Time without new frames after which a source counts as silent, longer than any host block. */
+    constexpr double quietAfterMs = 150.0;
+}
+
+
+SpectrumAnalyser::SpectrumAnalyser()
+    : juce::Thread("Spectrum analyser")
+{
+    fftBuffer.assign((size_t) fftSize * 2, 0.0f);
+
+    // A full scale sine gives a peak of sum(window) / 2
+    std::fill(fftBuffer.begin(), fftBuffer.begin() + fftSize, 1.0f);
+    window.multiplyWithWindowingTable(fftBuffer.data(), (size_t) fftSize);
+    magnitudeScale = 2.0f / std::accumulate(fftBuffer.begin(), fftBuffer.begin() + fftSize, 0.0f);
+
+    for (auto& source : sources)
+    {
+        source.history.assign((size_t) fftSize, 0.0f);
+        source.smoothed.assign((size_t) numBins, minDecibels);
+        source.published.assign((size_t) numBins, minDecibels);
+    }
+}
+
+
+SpectrumAnalyser::~SpectrumAnalyser()
+{
+    stopThread(2000);
+}
+
+
+void SpectrumAnalyser::prepare(double sampleRate, int newNumChannels)
+{
+    const juce::ScopedLock lock(analysisLock);
+
+    numChannels = juce::jmax(1, newNumChannels);
+    preparedSampleRate = sampleRate;
+
+    for (auto& source : sources)
+    {
+        // A multiple of the channel count, so frames never wrap around the end of the ring
+        source.ring.assign((size_t) (fifoFrames * numChannels), 0.0f);
+        source.fifo.setTotalSize((int) source.ring.size());
+
+        std::fill(source.history.begin(), source.history.end(), 0.0f);
+        source.historyPosition = 0;
+        std::fill(source.smoothed.begin(), source.smoothed.end(), minDecibels);
+
+        const juce::ScopedLock resultScope(resultLock);
+        std::fill(source.published.begin(), source.published.end(), minDecibels);
+        ++source.version;
+    }
+}
+
+
+void SpectrumAnalyser::setEnabled(int source, bool shouldBeEnabled)
+{
+    if (! juce::isPositiveAndBelow(source, maxSources))
+        return;
+
+    auto& s = sources[(size_t) source];
+    s.enabled = shouldBeEnabled;
+
+    if (! shouldBeEnabled)
+    {
+        const juce::ScopedLock lock(resultLock);
+        std::fill(s.published.begin(), s.published.end(), minDecibels);
+        ++s.version;
+    }
+    else if (! isThreadRunning())
+    {
+        startThread();
+    }
+
+    notify();
+}
+
+
+void SpectrumAnalyser::setRate(int analysesPerSecond)
+{
+    rateHz = juce::jlimit(1, 60, analysesPerSecond);
+    notify();
+}
+
+
+bool SpectrumAnalyser::readSpectrum(int source, juce::uint32& version, std::vector<float>& decibels) const
+{
+    if (! juce::isPositiveAndBelow(source, maxSources))
+        return false;
+
+    const auto& s = sources[(size_t) source];
+    const juce::ScopedLock lock(resultLock);
+
+    if (s.version == version)
+        return false;
+
+    decibels = s.published;
+    version = s.version;
+    return true;
+}
+
+
+/**
+ * @brief Copies the frames into the ring, or drops them if they do not fit. A whole block is dropped
+ * rather than part of it, so the ring keeps holding whole frames.
+ */
+void SpectrumAnalyser::push(int source, const float* interleaved, int numFrames, int channels) noexcept
+{
+    if (! isEnabled(source) || channels != numChannels)
+        return;
+
+    auto& s = sources[(size_t) source];
+    const int count = numFrames * channels;
+
+    if (count <= 0 || s.fifo.getFreeSpace() < count)
+        return;
+
+    int start1, size1, start2, size2;
+    s.fifo.prepareToWrite(count, start1, size1, start2, size2);
+
+    std::copy(interleaved, interleaved + size1, s.ring.data() + start1);
+    std::copy(interleaved + size1, interleaved + size1 + size2, s.ring.data() + start2);
+
+    s.fifo.finishedWrite(size1 + size2);
+}
+
+
+void SpectrumAnalyser::pushPlanar(int source, const juce::AudioBuffer<float>& buffer, int startSample, int numFrames) noexcept
+{
+    if (! isEnabled(source) || buffer.getNumChannels() != numChannels)
+        return;
+
+    auto& s = sources[(size_t) source];
+    const int count = numFrames * numChannels;
+
+    if (count <= 0 || s.fifo.getFreeSpace() < count)
+        return;
+
+    int start1, size1, start2, size2;
+    s.fifo.prepareToWrite(count, start1, size1, start2, size2);
+
+    auto interleave = [&](int ringStart, int ringSize, int firstFrame)
+    {
+        const int frames = ringSize / numChannels;
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            const float* in = buffer.getReadPointer(channel, startSample + firstFrame);
+            float* out = s.ring.data() + ringStart + channel;
+
+            for (int frame = 0; frame < frames; ++frame)
+                out[frame * numChannels] = in[frame];
+        }
+    };
+
+    interleave(start1, size1, 0);
+    interleave(start2, size2, size1 / numChannels);
+
+    s.fifo.finishedWrite(size1 + size2);
+}
+
+
+/**
+ * @brief Drains the FIFOs every few milliseconds, so they never fill up at a low analysis rate, and
+ * analyses the enabled sources whenever an analysis is due. Sleeps while no source is enabled.
+ */
+void SpectrumAnalyser::run()
+{
+    auto lastAnalysisMs = juce::Time::getMillisecondCounterHiRes();
+
+    while (! threadShouldExit())
+    {
+        const double intervalMs = 1000.0 / getRate();
+        const auto nowMs = juce::Time::getMillisecondCounterHiRes();
+        const bool isAnalysisDue = nowMs - lastAnalysisMs >= intervalMs;
+        bool anyEnabled = false;
+
+        {
+            const juce::ScopedLock lock(analysisLock);
+
+            for (int i = 0; i < maxSources; ++i)
+            {
+                anyEnabled = anyEnabled || isEnabled(i);
+                analyse(i, nowMs, isAnalysisDue ? (float) ((nowMs - lastAnalysisMs) * 0.001) : 0.0f);
+            }
+        }
+
+        if (isAnalysisDue)
+            lastAnalysisMs = nowMs;
+
+        if (! anyEnabled)
+        {
+            wait(-1);
+            lastAnalysisMs = juce::Time::getMillisecondCounterHiRes();
+            continue;
+        }
+
+        const double untilAnalysisMs = lastAnalysisMs + intervalMs - juce::Time::getMillisecondCounterHiRes();
+        wait(juce::jlimit(1, (int) drainIntervalMs, (int) std::ceil(untilAnalysisMs)));
+    }
+}
+
+
+/**
+ * @brief Moves the source's new frames into its mono history, then recomputes the spectrum if
+ * elapsedSeconds is positive. Once no frames have arrived for quietAfterMs the source has stopped
+ * playing, so the history is cleared and the spectrum starts to fall. A disabled source only has its
+ * FIFO drained, and its state is cleared once.
+ */
+void SpectrumAnalyser::analyse(int source, double nowMs, float elapsedSeconds)
+{
+    auto& s = sources[(size_t) source];
+    const int ready = s.fifo.getNumReady() / numChannels * numChannels;
+
+    int start1, size1, start2, size2;
+    s.fifo.prepareToRead(ready, start1, size1, start2, size2);
+
+    auto append = [&s, this](int ringStart, int ringSize)
+    {
+        const float channelScale = 1.0f / (float) numChannels;
+
+        for (int value = ringStart; value < ringStart + ringSize; value += numChannels)
+        {
+            float sum = 0.0f;
+
+            for (int channel = 0; channel < numChannels; ++channel)
+                sum += s.ring[(size_t) (value + channel)];
+
+            s.history[(size_t) s.historyPosition] = sum * channelScale;
+            s.historyPosition = (s.historyPosition + 1) % fftSize;
+        }
+    };
+
+    append(start1, size1);
+    append(start2, size2);
+    s.fifo.finishedRead(size1 + size2);
+
+    if (! isEnabled(source))
+    {
+        if (s.isActive)
+        {
+            std::fill(s.history.begin(), s.history.end(), 0.0f);
+            std::fill(s.smoothed.begin(), s.smoothed.end(), minDecibels);
+            s.isActive = false;
+        }
+
+        return;
+    }
+
+    s.isActive = true;
+
+    if (ready > 0)
+        s.lastFramesMs = nowMs;
+    else if (nowMs - s.lastFramesMs > quietAfterMs)
+        std::fill(s.history.begin(), s.history.end(), 0.0f);
+
+    if (elapsedSeconds <= 0.0f)
+        return;
+
+    AUDIOPLUGIN_TRACE_ZONE_INDEXED("spectrum", source)
+
+    // Oldest frame first, so the window is centred on the middle of the history
+    const auto oldest = s.history.begin() + s.historyPosition;
+    std::copy(oldest, s.history.end(), fftBuffer.begin());
+    std::copy(s.history.begin(), oldest, fftBuffer.begin() + (s.history.end() - oldest));
+    std::fill(fftBuffer.begin() + fftSize, fftBuffer.end(), 0.0f);
+
+    window.multiplyWithWindowingTable(fftBuffer.data(), (size_t) fftSize);
+    fft.performFrequencyOnlyForwardTransform(fftBuffer.data(), true);
+
+    const float release = releaseDecibelsPerSecond * elapsedSeconds;
+
+    for (int bin = 0; bin < numBins; ++bin)
+    {
+        const float level = juce::Decibels::gainToDecibels(fftBuffer[(size_t) bin] * magnitudeScale, minDecibels);
+        s.smoothed[(size_t) bin] = juce::jmax(level, s.smoothed[(size_t) bin] - release);
+    }
+
+    const juce::ScopedLock lock(resultLock);
+    s.published = s.smoothed;
+    ++s.version;
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <juce_dsp/juce_dsp.h>
+
+
+/**
+ * @class SpectrumAnalyser
+ * @brief Magnitude spectra of several audio streams, computed on a background thread.
+ *
+ * Each source, e.g. a track or the master output, has a single producer, single consumer FIFO. The
+ * audio thread copies its frames in with push() or pushPlanar(); both return at once when the source is
+ * disabled, and drop the frames instead of waiting when the FIFO is full. The analyser thread drains
+ * the FIFOs at the configured rate, keeps the last fftSize frames of each source mixed to mono, and
+ * runs a Hann windowed FFT over them. The spectrum follows rises at once and falls by at most
+ * releaseDecibelsPerSecond, so it settles smoothly once a source goes quiet.
+ *
+ * The thread starts when the first source is enabled. Spectra are read with readSpectrum().
+ */
+class SpectrumAnalyser : private juce::Thread
+{
+public:
+    static constexpr int maxSources = 8;
+    static constexpr int fftOrder = 11;
+    static constexpr int fftSize = 1 << fftOrder;
+
+    /** @brief Number of values in a spectrum, from 0 Hz to half the sample rate. */
+    static constexpr int numBins = fftSize / 2 + 1;
+
+    /** @brief Level of silence in a spectrum. */
+    static constexpr float minDecibels = -100.0f;
+
+    static constexpr float releaseDecibelsPerSecond = 60.0f;
+    static constexpr int defaultRateHz = 30;
+
+    SpectrumAnalyser();
+    ~SpectrumAnalyser() override;
+
+    /**
+     * @brief Sizes the FIFOs for a sample rate and channel count and clears all spectra.
+     *
+     * Allocates, so it must be called while the audio thread is stopped, e.g. from prepareToPlay().
+     */
+    void prepare(double sampleRate, int numChannels);
+
+    /** @brief Starts or stops collecting and analysing a source. A disabled source's spectrum falls back to silence. */
+    void setEnabled(int source, bool shouldBeEnabled);
+
+    bool isEnabled(int source) const noexcept
+    {
+        return juce::isPositiveAndBelow(source, maxSources) && sources[(size_t) source].enabled.load(std::memory_order_relaxed);
+    }
+
+    /** @brief Sets how often per second the spectra are recomputed, limited to 1...60. */
+    void setRate(int analysesPerSecond);
+
+    int getRate() const noexcept { return rateHz.load(std::memory_order_relaxed); }
+
+    /** @brief Returns the sample rate of the last prepare(), which sets the frequency of each bin. */
+    double getSampleRate() const noexcept { return preparedSampleRate.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Copies the spectrum of a source if it changed since it was last read.
+     * @param source Source index.
+     * @param version Version of the caller's copy, 0 for none. Updated when a newer spectrum is copied.
+     * @param decibels Receives numBins levels in decibels.
+     * @return True if a newer spectrum was copied.
+     */
+    bool readSpectrum(int source, juce::uint32& version, std::vector<float>& decibels) const;
+
+    //================== Audio thread ==================
+
+    /**
+     * @brief Copies interleaved frames into a source's FIFO.
+     * @param numChannels Channels per frame; frames with another channel count than prepared are ignored.
+     */
+    void push(int source, const float* interleaved, int numFrames, int numChannels) noexcept;
+
+    /** @brief Copies a range of a buffer into a source's FIFO, interleaving its channels. */
+    void pushPlanar(int source, const juce::AudioBuffer<float>& buffer, int startSample, int numFrames) noexcept;
+
+private:
+    void run() override;
+
+    /** @brief Drains a source's FIFO and recomputes its spectrum if one is due. Called on the analyser thread. */
+    void analyse(int source, double nowMs, float elapsedSeconds);
+
+    struct Source
+    {
+        std::atomic<bool> enabled { false };
+
+        /* @brief Interleaved frames from the audio thread. The ring holds whole frames, so a frame never wraps. */
+        juce::AbstractFifo fifo { 1 };
+        std::vector<float> ring;
+
+        /* @brief Last fftSize mono frames, the smoothed spectrum and when frames last arrived. Analyser thread only. */
+        std::vector<float> history;
+        int historyPosition = 0;
+        std::vector<float> smoothed;
+        double lastFramesMs = 0.0;
+        bool isActive = false;
+
+        /* @brief Spectrum handed to readers, guarded by resultLock. */
+        std::vector<float> published;
+        juce::uint32 version = 1;
+    };
+
+    std::array<Source, maxSources> sources;
+
+    juce::dsp::FFT fft { fftOrder };
+    juce::dsp::WindowingFunction<float> window { (size_t) fftSize, juce::dsp::WindowingFunction<float>::hann, false };
+    std::vector<float> fftBuffer;
+
+    /* @brief Converts FFT magnitudes to the amplitude of a full scale sine, which reads 0 dB. */
+    float magnitudeScale = 1.0f;
+
+    int numChannels = 2;
+    std::atomic<double> preparedSampleRate { 0.0 };
+    std::atomic<int> rateHz { defaultRateHz };
+
+    /* @brief Held by the analyser thread while it analyses and by prepare() while it resizes. */
+    juce::CriticalSection analysisLock;
+
+    /* @brief Guards the published spectra and their versions. */
+    juce::CriticalSection resultLock;
+
+    JUCE_DECLARE_NON_COPYABLE (SpectrumAnalyser)
+};
@@ -0,0 +1,133 @@
+#include "SpectrumView.h"
+#include "TraceProfiler.h"
+
+
+SpectrumView::SpectrumView()
+{
+    setOpaque(true);
+}
+
+
+/**
+ * @brief Reduces the bins to one level per pixel column. Columns that contain no bin centre, at the
+ * low end of the axis, interpolate between the two bins around their frequency.
+ */
+void SpectrumView::setSpectrum(const std::vector<float>& binDecibels, double sampleRate)
+{
+    const int numBins = (int) binDecibels.size();
+    const int width = (int) columnFrequencies.size();
+
+    spectrum.assign((size_t) width, minDecibels);
+
+    if (numBins < 2 || sampleRate <= 0.0)
+    {
+        repaint();
+        return;
+    }
+
+    const double binsPerHz = (double) (numBins - 1) * 2.0 / sampleRate;
+    const float ratio = std::pow(maxFrequency / minFrequency, 0.5f / (float) juce::jmax(1, width));
+
+    for (int x = 0; x < width; ++x)
+    {
+        const double centre = columnFrequencies[(size_t) x] * binsPerHz;
+        const int first = (int) std::ceil(columnFrequencies[(size_t) x] / ratio * binsPerHz);
+        const int last = juce::jmin(numBins - 1, (int) std::floor(columnFrequencies[(size_t) x] * ratio * binsPerHz));
+
+        if (centre >= numBins - 1)
+            break;
+
+        if (first <= last)
+        {
+            spectrum[(size_t) x] = *std::max_element(binDecibels.begin() + first, binDecibels.begin() + last + 1);
+        }
+        else
+        {
+            const int below = (int) centre;
+            const float fraction = (float) (centre - below);
+            spectrum[(size_t) x] = binDecibels[(size_t) below] + fraction * (binDecibels[(size_t) below + 1] - binDecibels[(size_t) below]);
+        }
+    }
+
+    repaint();
+}
+
+
+void SpectrumView::setResponse(std::vector<float> columnDecibels)
+{
+    response = std::move(columnDecibels);
+    repaint();
+}
+
+
+void SpectrumView::paint(juce::Graphics& g)
+{
+    AUDIOPLUGIN_TRACE_ZONE("spectrum paint")
+
+    g.fillAll(juce::Colours::darkslategrey.darker(0.5f));
+
+    const float height = (float) getHeight();
+    const float width = (float) getWidth();
+
+    // Decade lines and the 0 dB line
+    g.setColour(juce::Colours::grey.withAlpha(0.3f));
+
+    for (float frequency : { 100.0f, 1000.0f, 10000.0f })
+    {
+        const float x = width * std::log(frequency / minFrequency) / std::log(maxFrequency / minFrequency);
+        g.fillRect(x, 0.0f, 1.0f, height);
+    }
+
+    g.fillRect(0.0f, decibelsToY(0.0f), width, 1.0f);
+
+    if (! spectrum.empty())
+    {
+        juce::Path path;
+        path.startNewSubPath(0.0f, height);
+
+        for (size_t x = 0; x < spectrum.size(); ++x)
+            path.lineTo((float) x + 0.5f, decibelsToY(spectrum[x]));
+
+        path.lineTo(width, height);
+        path.closeSubPath();
+
+        g.setColour(juce::Colours::deepskyblue.withAlpha(0.6f));
+        g.fillPath(path);
+    }
+
+    if (response.size() == columnFrequencies.size() && ! response.empty())
+    {
+        juce::Path path;
+        path.startNewSubPath(0.5f, decibelsToY(response.front()));
+
+        for (size_t x = 1; x < response.size(); ++x)
+            path.lineTo((float) x + 0.5f, decibelsToY(response[x]));
+
+        g.setColour(juce::Colours::orange);
+        g.strokePath(path, juce::PathStrokeType(1.5f));
+    }
+}
+
+
+/**
+ * @brief Recomputes the column frequencies. The spectrum and response belong to the old columns and
+ * are dropped until the next ones are set.
+ */
+void SpectrumView::resized()
+{
+    const int width = getWidth();
+    columnFrequencies.resize((size_t) juce::jmax(0, width));
+
+    for (int x = 0; x < width; ++x)
+        columnFrequencies[(size_t) x] = minFrequency * std::pow(maxFrequency / minFrequency, ((float) x + 0.5f) / (float) width);
+
+    spectrum.clear();
+    response.clear();
+}
+
+
+float SpectrumView::decibelsToY(float decibels) const noexcept
+{
+    const float clamped = juce::jlimit(minDecibels, maxDecibels, decibels);
+    return (float) getHeight() * (maxDecibels - clamped) / (maxDecibels - minDecibels);
+}
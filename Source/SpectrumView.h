@@ -0,0 +1,55 @@
+#pragma once
+
+#include <juce_gui_basics/juce_gui_basics.h>
+
+
+/**
+ * @class SpectrumView
+ * @brief Spectrum of a track or the master on a logarithmic frequency axis, with an optional filter
+ * magnitude response drawn over it.
+ *
+ * The view maps a SpectrumAnalyser spectrum to one level per pixel column when it is set: the loudest
+ * bin within the column, or the level interpolated between the neighbouring bins where bins are wider
+ * than a column. Painting only draws those columns, so it does not depend on the FFT size.
+ */
+class SpectrumView : public juce::Component
+{
+public:
+    static constexpr float minFrequency = 20.0f;
+    static constexpr float maxFrequency = 20000.0f;
+    static constexpr float minDecibels = -90.0f;
+    static constexpr float maxDecibels = 12.0f;
+
+    SpectrumView();
+
+    /**
+     * @brief Shows a new spectrum.
+     * @param binDecibels Level of each bin from 0 Hz up to half the sample rate.
+     * @param sampleRate Sample rate the spectrum was computed at.
+     */
+    void setSpectrum(const std::vector<float>& binDecibels, double sampleRate);
+
+    /**
+     * @brief Shows a magnitude response over the spectrum.
+     * @param columnDecibels Gain at each of getColumnFrequencies(), or empty to hide the response.
+     */
+    void setResponse(std::vector<float> columnDecibels);
+
+    /** @brief Returns the frequency at the centre of each pixel column. */
+    const std::vector<float>& getColumnFrequencies() const noexcept { return columnFrequencies; }
+
+    void paint(juce::Graphics& g) override;
+    void resized() override;
+
+private:
+    std::vector<float> columnFrequencies;
+
+    /* @brief Spectrum level and response of each pixel column. */
+    std::vector<float> spectrum;
+    std::vector<float> response;
+
+    /** @brief Returns the y position of a level. */
+    float decibelsToY(float decibels) const noexcept;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SpectrumView)
+};
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+/**
+ * @class StateVariableFilter
+ * @brief Topology-preserving transform state variable filter with directly set coefficients.
+ *
+ * Same structure as juce::dsp::StateVariableTPTFilter. The prewarped gain g and the damping k are
+ * passed in ready-made, so they can come from FilterCoefficientTables and no tan() runs on the
+ * audio thread. Holds the state of a single channel.
+ */
+class StateVariableFilter
+{
+public:
+    /** @brief Output of the filter. */
+    enum class Type
+    {
+        lowpass,
+        bandpass,
+        highpass
+    };
+
+    /** @brief Selects the filter output. */
+    void setType(Type newType) noexcept { type = newType; }
+
+    /**
+     * @brief Sets the filter coefficients.
+     * @param newG Prewarped gain, tan(pi * cutoff / sampleRate).
+     * @param newK Damping, 1 / Q.
+     */
+    void setCoefficients(float newG, float newK) noexcept
+    {
+        g = newG;
+        k = newK;
+        h = 1.0f / (1.0f + k * g + g * g);
+    }
+
+    /** @brief Clears the filter state. */
+    void reset() noexcept
+    {
+        s1 = 0.0f;
+        s2 = 0.0f;
+    }
+
+    /**
+     * @brief Processes one sample.
+     * @param input Input sample.
+     * @return The selected filter output.
+     */
+    float processSample(float input) noexcept
+    {
+        const float highpass = h * (input - s1 * (g + k) - s2);
+        const float bandpass = highpass * g + s1;
+        s1 = highpass * g + bandpass;
+
+        const float lowpass = bandpass * g + s2;
+        s2 = bandpass * g + lowpass;
+
+        switch (type)
+        {
+            case Type::lowpass:  return lowpass;
+            case Type::bandpass: return bandpass;
+            case Type::highpass: return highpass;
+        }
+
+        return lowpass;
+    }
+
+private:
+    Type type = Type::lowpass;
+    float g = 0.0f;
+    float k = juce::MathConstants<float>::sqrt2;
+    float h = 1.0f;
+    float s1 = 0.0f;
+    float s2 = 0.0f;
+};
@@ -0,0 +1,323 @@
+#include "StepGrid.h"
+#include "TraceProfiler.h"
+
+
+namespace
+{
+    /** @brief Returns a mask with the lowest count bits set. */
+    juce::uint64 lowBits(int count) noexcept
+    {
+        return count >= 64 ? ~(juce::uint64) 0 : (((juce::uint64) 1 << count) - 1);
+    }
+
+    /** @brief Returns the bit of a step. */
+    juce::uint64 stepBit(int step) noexcept
+    {
+        return (juce::uint64) 1 << step;
+    }
+}
+
+
+StepGrid::StepGrid(int numTracksToUse, int numStepsToUse)
+{
+    setGridSize(numTracksToUse, numStepsToUse);
+    setRepaintsOnMouseActivity(false);
+    setOpaque(true);
+}
+
+
+void StepGrid::setGridSize(int newNumTracks, int newNumSteps)
+{
+    numTracks = juce::jlimit(1, maxTracks, newNumTracks);
+    numSteps = juce::jlimit(1, maxSteps, newNumSteps);
+
+    for (int track = 0; track < maxTracks; ++track)
+    {
+        const auto mask = track < numTracks ? lowBits(numSteps) : 0;
+        steps[(size_t) track] &= mask;
+        lockedSteps[(size_t) track] &= mask;
+    }
+
+    if (playheadStep >= numSteps)
+        playheadStep = -1;
+
+    resized();
+    repaint();
+}
+
+
+void StepGrid::setSteps(int track, juce::uint64 newSteps)
+{
+    if (track < 0 || track >= numTracks)
+        return;
+
+    newSteps &= lowBits(numSteps);
+    const auto changed = steps[(size_t) track] ^ newSteps;
+    steps[(size_t) track] = newSteps;
+    repaintCells(track, changed);
+}
+
+
+juce::uint64 StepGrid::getSteps(int track) const noexcept
+{
+    return track >= 0 && track < numTracks ? steps[(size_t) track] : 0;
+}
+
+
+void StepGrid::setLockedSteps(int track, juce::uint64 newLockedSteps)
+{
+    if (track < 0 || track >= numTracks)
+        return;
+
+    newLockedSteps &= lowBits(numSteps);
+    const auto changed = lockedSteps[(size_t) track] ^ newLockedSteps;
+    lockedSteps[(size_t) track] = newLockedSteps;
+    repaintCells(track, changed);
+}
+
+
+void StepGrid::setPlayheadStep(int step)
+{
+    step = step >= 0 && step < numSteps ? step : -1;
+
+    if (step == playheadStep)
+        return;
+
+    if (playheadStep >= 0)
+        repaint(getColumnBounds(playheadStep));
+
+    playheadStep = step;
+
+    if (playheadStep >= 0)
+        repaint(getColumnBounds(playheadStep));
+}
+
+
+juce::Rectangle<int> StepGrid::getCellBounds(int track, int step) const noexcept
+{
+    return { step * cellWidth, track * cellHeight, cellWidth, cellHeight };
+}
+
+
+juce::Rectangle<int> StepGrid::getColumnBounds(int step) const noexcept
+{
+    return { step * cellWidth, 0, cellWidth, getHeight() };
+}
+
+
+/**
+ * @brief Blits the sprite of every cell inside the clip region.
+ *
+ * The visible range of rows and columns is computed from the clip bounds, so repainting a few dirty
+ * cells only touches those cells no matter how large the grid is. The playhead column is filled over
+ * the cells.
+ */
+void StepGrid::paint(juce::Graphics& g)
+{
+    AUDIOPLUGIN_TRACE_ZONE("step grid paint")
+
+    g.fillAll(getLookAndFeel().findColour(juce::ResizableWindow::backgroundColourId));
+
+    if (cellWidth <= 0 || cellHeight <= 0)
+        return;
+
+    const float scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+    updateSprites(scale);
+
+    const auto clip = g.getClipBounds();
+    const int firstStep = juce::jmax(0, clip.getX() / cellWidth);
+    const int lastStep = juce::jmin(numSteps - 1, (clip.getRight() - 1) / cellWidth);
+    const int firstTrack = juce::jmax(0, clip.getY() / cellHeight);
+    const int lastTrack = juce::jmin(numTracks - 1, (clip.getBottom() - 1) / cellHeight);
+
+    const bool isUnscaled = spriteScale == 1.0f;
+
+    for (int track = firstTrack; track <= lastTrack; ++track)
+    {
+        const auto rowSteps = steps[(size_t) track];
+        const auto rowLocks = lockedSteps[(size_t) track];
+
+        for (int step = firstStep; step <= lastStep; ++step)
+        {
+            const int sprite = ((rowSteps & stepBit(step)) != 0 ? 1 : 0) | ((rowLocks & stepBit(step)) != 0 ? 2 : 0);
+            const int x = step * cellWidth;
+            const int y = track * cellHeight;
+
+            if (isUnscaled)
+                g.drawImageAt(sprites[(size_t) sprite], x, y);
+            else
+                g.drawImageTransformed(sprites[(size_t) sprite],
+                                       juce::AffineTransform::scale(1.0f / spriteScale).translated((float) x, (float) y));
+        }
+    }
+
+    if (playheadStep >= firstStep && playheadStep <= lastStep)
+    {
+        g.setColour(juce::Colours::yellow.withAlpha(0.3f));
+        g.fillRect(getColumnBounds(playheadStep).withHeight(numTracks * cellHeight));
+    }
+}
+
+
+void StepGrid::resized()
+{
+    cellWidth = getWidth() / numSteps;
+    cellHeight = getHeight() / numTracks;
+}
+
+
+void StepGrid::mouseDown(const juce::MouseEvent& e)
+{
+    const auto cell = getCellAt(e.position);
+
+    if (cell.x < 0)
+        return;
+
+    if (e.mods.isPopupMenu())
+    {
+        if (onLockEditRequested)
+            onLockEditRequested(cell.y, cell.x);
+
+        return;
+    }
+
+    if (onDragStart)
+        onDragStart();
+
+    isPainting = true;
+    paintValue = (steps[(size_t) cell.y] & stepBit(cell.x)) == 0;
+    lastPaintedCell = cell;
+    paintCell(cell);
+}
+
+
+/**
+ * @brief Paints every cell on the line from the last painted cell to the one under the mouse, so a
+ * fast drag does not skip cells.
+ */
+void StepGrid::mouseDrag(const juce::MouseEvent& e)
+{
+    if (! isPainting)
+        return;
+
+    const auto cell = getCellAt(e.position);
+
+    if (cell.x < 0 || cell == lastPaintedCell)
+        return;
+
+    const auto delta = cell - lastPaintedCell;
+    const int count = juce::jmax(std::abs(delta.x), std::abs(delta.y));
+
+    for (int i = 1; i <= count; ++i)
+        paintCell({ lastPaintedCell.x + juce::roundToInt((float) (delta.x * i) / (float) count),
+                    lastPaintedCell.y + juce::roundToInt((float) (delta.y * i) / (float) count) });
+
+    lastPaintedCell = cell;
+}
+
+
+void StepGrid::mouseUp(const juce::MouseEvent&)
+{
+    if (! isPainting)
+        return;
+
+    isPainting = false;
+
+    if (onDragEnd)
+        onDragEnd();
+}
+
+
+juce::Point<int> StepGrid::getCellAt(juce::Point<float> position) const noexcept
+{
+    if (cellWidth <= 0 || cellHeight <= 0 || position.x < 0.0f || position.y < 0.0f)
+        return { -1, -1 };
+
+    const int step = (int) position.x / cellWidth;
+    const int track = (int) position.y / cellHeight;
+
+    if (step >= numSteps || track >= numTracks)
+        return { -1, -1 };
+
+    return { step, track };
+}
+
+
+void StepGrid::paintCell(juce::Point<int> cell)
+{
+    auto& row = steps[(size_t) cell.y];
+    const auto bit = stepBit(cell.x);
+
+    if (((row & bit) != 0) == paintValue)
+        return;
+
+    row ^= bit;
+    repaintCells(cell.y, bit);
+
+    if (onStepChanged)
+        onStepChanged(cell.y, cell.x, paintValue);
+}
+
+
+void StepGrid::repaintCells(int track, juce::uint64 changedSteps)
+{
+    if (changedSteps == 0)
+        return;
+
+    int first = 0;
+    while ((changedSteps & stepBit(first)) == 0)
+        ++first;
+
+    int last = numSteps - 1;
+    while ((changedSteps & stepBit(last)) == 0)
+        --last;
+
+    repaint(getCellBounds(track, first).getUnion(getCellBounds(track, last)));
+}
+
+
+void StepGrid::updateSprites(float scale)
+{
+    if (spriteWidth == cellWidth && spriteHeight == cellHeight && spriteScale == scale)
+        return;
+
+    AUDIOPLUGIN_TRACE_ZONE("step grid sprites")
+
+    spriteWidth = cellWidth;
+    spriteHeight = cellHeight;
+    spriteScale = scale;
+
+    const auto bounds = juce::Rectangle<int>(cellWidth, cellHeight).toFloat();
+    const float cornerSize = 4.0f;
+
+    for (int sprite = 0; sprite < numSprites; ++sprite)
+    {
+        const bool isOn = (sprite & 1) != 0;
+        const bool hasLock = (sprite & 2) != 0;
+
+        juce::Image image(juce::Image::ARGB, juce::jmax(1, juce::roundToInt((float) cellWidth * scale)),
+                          juce::jmax(1, juce::roundToInt((float) cellHeight * scale)), true);
+        juce::Graphics g(image);
+        g.addTransform(juce::AffineTransform::scale(scale));
+
+        g.setColour(isOn ? juce::Colours::orange : juce::Colours::darkgrey.darker());
+        g.fillRoundedRectangle(bounds, cornerSize);
+
+        if (isOn)
+        {
+            g.setGradientFill(juce::ColourGradient(juce::Colours::white.withAlpha(0.3f), bounds.getCentre(), juce::Colours::white.withAlpha(0.0f), bounds.getBottomRight(), false));
+            g.fillRoundedRectangle(bounds.reduced(1.0f), cornerSize);
+        }
+
+        g.setColour(juce::Colours::black.withAlpha(0.8f));
+        g.drawRoundedRectangle(bounds, cornerSize, 1.5f);
+
+        if (hasLock)
+        {
+            g.setColour(juce::Colours::deepskyblue);
+            g.fillEllipse(bounds.getRight() - 8.0f, bounds.getY() + 3.0f, 5.0f, 5.0f);
+        }
+
+        sprites[(size_t) sprite] = image;
+    }
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <juce_gui_basics/juce_gui_basics.h>
+
+
+/**
+ * @class StepGrid
+ * @brief The step sequencer as a single component: draws every cell from per-track step bitmasks and
+ *        handles clicking, drag painting and lock editing itself.
+ *
+ * Cells are not components. The grid keeps one bit per step for the pattern and for the lock markers,
+ * repaints only the cells whose bits changed and, in paint(), draws only the cells inside the clip region.
+ * Each cell is a blit of one of four pre-rendered sprites (off/on, with or without lock marker), which are
+ * rebuilt when the cell size or the display scale changes, so painting costs the same per cell at any
+ * grid size up to maxTracks x maxSteps.
+ *
+ * The playhead is drawn over its column; moving it repaints the column it leaves and the one it enters.
+ * The grid is opaque, so none of this repaints the components behind it.
+ *
+ * Pressing a cell toggles it and dragging sets every cell the mouse crosses to the same state, so one
+ * gesture paints or erases a run of steps. A right click requests the lock editor of a cell instead.
+ */
+class StepGrid : public juce::Component
+{
+public:
+    static constexpr int maxTracks = 64;
+    static constexpr int maxSteps = 64;
+
+    /**
+     * @param numTracks Number of rows.
+     * @param numSteps Number of columns.
+     */
+    StepGrid(int numTracks, int numSteps);
+
+    /** @brief Changes the number of rows and columns. Steps outside the new size are dropped. */
+    void setGridSize(int numTracks, int numSteps);
+
+    int getNumTracks() const noexcept { return numTracks; }
+    int getNumSteps() const noexcept { return numSteps; }
+
+    /** @brief Sets the active steps of a row, one bit per step, and repaints the cells that changed. */
+    void setSteps(int track, juce::uint64 steps);
+
+    /** @brief Returns the active steps of a row, one bit per step. */
+    juce::uint64 getSteps(int track) const noexcept;
+
+    /** @brief Sets the steps of a row that show a lock marker and repaints the cells that changed. */
+    void setLockedSteps(int track, juce::uint64 steps);
+
+    /** @brief Highlights a column as the playing step, or none for -1. */
+    void setPlayheadStep(int step);
+
+    int getPlayheadStep() const noexcept { return playheadStep; }
+
+    /** @brief Returns the area of a cell in the grid's coordinates. */
+    juce::Rectangle<int> getCellBounds(int track, int step) const noexcept;
+
+    /** @brief Called for every cell the user switches on or off. */
+    std::function<void(int track, int step, bool isOn)> onStepChanged;
+
+    /** @brief Called on a right click on a cell. */
+    std::function<void(int track, int step)> onLockEditRequested;
+
+    /** @brief Called when a click or drag paint starts and when it ends. */
+    std::function<void()> onDragStart, onDragEnd;
+
+    void paint(juce::Graphics& g) override;
+    void resized() override;
+    void mouseDown(const juce::MouseEvent& e) override;
+    void mouseDrag(const juce::MouseEvent& e) override;
+    void mouseUp(const juce::MouseEvent& e) override;
+
+private:
+    /* @brief Sprite indices: bit 0 is the step state, bit 1 the lock marker. */
+    enum Sprite { spriteOff, spriteOn, spriteOffLocked, spriteOnLocked, numSprites };
+
+    int numTracks = 0;
+    int numSteps = 0;
+
+    /* @brief One bit per step and row. */
+    std::array<juce::uint64, maxTracks> steps {};
+    std::array<juce::uint64, maxTracks> lockedSteps {};
+
+    int playheadStep = -1;
+
+    /* @brief Cell size from the last resized(). Columns and rows share the remainder pixels at the end. */
+    int cellWidth = 0;
+    int cellHeight = 0;
+
+    /* @brief Pre-rendered cells and the cell size and display scale they were rendered at. */
+    std::array<juce::Image, numSprites> sprites;
+    int spriteWidth = 0;
+    int spriteHeight = 0;
+    float spriteScale = 0.0f;
+
+    /* @brief State of the current drag: the value being painted and the last cell it reached. */
+    bool isPainting = false;
+    bool paintValue = false;
+    juce::Point<int> lastPaintedCell;
+
+    /** @brief Returns the cell (x = step, y = track) under a position, or {-1, -1} outside the grid. */
+    juce::Point<int> getCellAt(juce::Point<float> position) const noexcept;
+
+    /** @brief Sets one cell to paintValue and reports it if it changed. */
+    void paintCell(juce::Point<int> cell);
+
+    /** @brief Returns the area of a column in the grid's coordinates. */
+    juce::Rectangle<int> getColumnBounds(int step) const noexcept;
+
+    /** @brief Repaints the span of a row covering the bits set in changedSteps. */
+    void repaintCells(int track, juce::uint64 changedSteps);
+
+    /** @brief Renders the sprites for the current cell size at a display scale. */
+    void updateSprites(float scale);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (StepGrid)
+};
@@ -0,0 +1,162 @@
+#include "TraceProfiler.h"
+
+#include <juce_events/juce_events.h>
+
+#if AUDIOPLUGIN_ENABLE_TRACING
+
+namespace
+{
+    /** @brief One finished zone. */
+    struct Event
+    {
+        const char* name = nullptr;
+        int index = -1;
+        juce::uint64 start = 0;
+        juce::uint64 end = 0;
+    };
+
+    /**
+     * @brief Ring of events written by exactly one thread.
+     *
+     * When the ring is full the oldest events are overwritten, so a trace always holds the most recent activity.
+     */
+    struct ThreadBuffer
+    {
+        static constexpr juce::uint64 capacity = 1 << 16;
+
+        std::vector<Event> events = std::vector<Event>((size_t) capacity);
+        std::atomic<juce::uint64> numWritten { 0 };
+        juce::String threadName;
+        int threadIndex = 0;
+    };
+
+    /** @brief All thread buffers and the clock calibration. */
+    struct Registry
+    {
+        std::mutex lock;
+        std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+
+        const juce::uint64 startTicks = TraceProfiler::now();
+        const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+        ThreadBuffer* createBufferForCurrentThread()
+        {
+            auto buffer = std::make_unique<ThreadBuffer>();
+
+            if (auto* thread = juce::Thread::getCurrentThread())
+                buffer->threadName = thread->getThreadName();
+            else if (juce::MessageManager::getInstanceWithoutCreating() != nullptr
+                     && juce::MessageManager::getInstanceWithoutCreating()->isThisTheMessageThread())
+                buffer->threadName = "Message Thread";
+
+            const std::lock_guard<std::mutex> scope(lock);
+            buffer->threadIndex = (int) buffers.size() + 1;
+
+            if (buffer->threadName.isEmpty())
+                buffer->threadName = "Thread " + juce::String(buffer->threadIndex);
+
+            buffers.push_back(std::move(buffer));
+            return buffers.back().get();
+        }
+    };
+
+    Registry& getRegistry()
+    {
+        static Registry registry;
+        return registry;
+    }
+
+    thread_local ThreadBuffer* currentThreadBuffer = nullptr;
+
+    /** @brief Writes the trace on shutdown. */
+    struct WriteTraceOnExit
+    {
+        /* Creating the registry first guarantees it is destroyed after this object. */
+        WriteTraceOnExit()  { getRegistry(); }
+
+        ~WriteTraceOnExit()
+        {
+            const char* path = std::getenv("AUDIOPLUGIN_TRACE_FILE");
+            auto file = path != nullptr ? juce::File(juce::String::fromUTF8(path))
+                                        : juce::File::getSpecialLocation(juce::File::tempDirectory)
+                                              .getChildFile("AudiovisualPluginTrace.json");
+            TraceProfiler::writeChromeTrace(file);
+        }
+    };
+}
+
+
+namespace TraceProfiler
+{
+    void record(const char* name, int index, juce::uint64 start, juce::uint64 end) noexcept
+    {
+        prepareCurrentThread();
+        auto* buffer = currentThreadBuffer;
+
+        const auto position = buffer->numWritten.load(std::memory_order_relaxed);
+        buffer->events[(size_t) (position & (ThreadBuffer::capacity - 1))] = { name, index, start, end };
+        buffer->numWritten.store(position + 1, std::memory_order_release);
+    }
+
+
+    void prepareCurrentThread()
+    {
+        if (currentThreadBuffer == nullptr)
+            currentThreadBuffer = getRegistry().createBufferForCurrentThread();
+    }
+
+
+    bool writeChromeTrace(const juce::File& file)
+    {
+        auto& registry = getRegistry();
+        const std::lock_guard<std::mutex> scope(registry.lock);
+
+        const auto elapsedTicks = (double) (now() - registry.startTicks);
+        const auto elapsedMicros = (double) std::chrono::duration_cast<std::chrono::microseconds>(
+                                       std::chrono::steady_clock::now() - registry.startTime).count();
+        const double microsPerTick = elapsedTicks > 0.0 ? elapsedMicros / elapsedTicks : 0.0;
+
+        juce::MemoryOutputStream json;
+        json << "{\"traceEvents\":[\n";
+        bool first = true;
+
+        for (const auto& buffer : registry.buffers)
+        {
+            if (! first)
+                json << ",\n";
+
+            first = false;
+            json << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->threadIndex
+                 << ",\"args\":{\"name\":" << juce::JSON::toString(buffer->threadName) << "}}";
+
+            const auto numWritten = buffer->numWritten.load(std::memory_order_acquire);
+            const auto numEvents = juce::jmin(numWritten, ThreadBuffer::capacity);
+
+            for (auto i = numWritten - numEvents; i < numWritten; ++i)
+            {
+                const auto& event = buffer->events[(size_t) (i & (ThreadBuffer::capacity - 1))];
+                const auto startMicros = (double) (event.start - registry.startTicks) * microsPerTick;
+                const auto durationMicros = (double) (event.end - event.start) * microsPerTick;
+
+                json << ",\n{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->threadIndex
+                     << ",\"ts\":" << juce::String(startMicros, 3) << ",\"dur\":" << juce::String(durationMicros, 3);
+
+                if (event.index >= 0)
+                    json << ",\"args\":{\"index\":" << event.index << "}";
+
+                json << "}";
+            }
+        }
+
+        json << "\n]}\n";
+        return file.replaceWithData(json.getData(), json.getDataSize());
+    }
+}
+
+
+namespace
+{
+    const WriteTraceOnExit writeTraceOnExit;
+}
+
+#endif
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+/**
+ * @file TraceProfiler.h
+ * @brief Optional scoped trace zones exported as Chrome/Perfetto trace JSON.
+ *
+ * Zones only exist when the code is built with AUDIOPLUGIN_ENABLE_TRACING=1 (CMake option of the same name,
+ * Debug builds only). Otherwise the macros expand to nothing. Each thread writes its events into its
+ * own lock-free ring buffer; the only lock is taken once per thread when its buffer is created. The audio
+ * thread creates its buffer with AUDIOPLUGIN_TRACE_THREAD outside processBlock's realtime section, so no
+ * zone inside it allocates or locks.
+ *
+ * On exit the collected events are written to the file named by the AUDIOPLUGIN_TRACE_FILE environment
+ * variable, or to AudiovisualPluginTrace.json in the temporary directory. Open it in chrome://tracing or
+ * https://ui.perfetto.dev.
+ */
+
+#if AUDIOPLUGIN_ENABLE_TRACING
+
+#if JUCE_INTEL
+ #if JUCE_MSVC
+  #include <intrin.h>
+ #else
+  #include <x86intrin.h>
+ #endif
+#endif
+
+namespace TraceProfiler
+{
+    /** @brief Returns a raw timestamp. Uses the time stamp counter where available. */
+    inline juce::uint64 now() noexcept
+    {
+       #if JUCE_INTEL
+        return (juce::uint64) __rdtsc();
+       #else
+        return (juce::uint64) std::chrono::steady_clock::now().time_since_epoch().count();
+       #endif
+    }
+
+    /**
+     * @brief Stores a finished zone in the calling thread's buffer.
+     * @param name Zone name. Must be a string literal or otherwise outlive the profiler.
+     * @param index Optional index shown as an argument (e.g. the track), or -1.
+     * @param start Timestamp taken with now() when the zone was entered.
+     * @param end Timestamp taken with now() when the zone was left.
+     */
+    void record(const char* name, int index, juce::uint64 start, juce::uint64 end) noexcept;
+
+    /** @brief Creates the calling thread's event buffer unless it has one, so its later zones never allocate. */
+    void prepareCurrentThread();
+
+    /**
+     * @brief Writes all collected events as Chrome trace JSON.
+     * @param file Destination file.
+     * @return true on success.
+     */
+    bool writeChromeTrace(const juce::File& file);
+
+    /** @brief Records the time between its construction and destruction as one zone. */
+    class ScopedZone
+    {
+    public:
+        explicit ScopedZone(const char* zoneName, int zoneIndex = -1) noexcept
+            : name(zoneName), index(zoneIndex), start(now()) {}
+
+        ~ScopedZone() noexcept { record(name, index, start, now()); }
+
+    private:
+        const char* name;
+        int index;
+        juce::uint64 start;
+
+        JUCE_DECLARE_NON_COPYABLE (ScopedZone)
+    };
+}
+
+ #define AUDIOPLUGIN_TRACE_ZONE(name)                 const TraceProfiler::ScopedZone JUCE_JOIN_MACRO (traceZone, __LINE__) (name);
+ #define AUDIOPLUGIN_TRACE_ZONE_INDEXED(name, index)  const TraceProfiler::ScopedZone JUCE_JOIN_MACRO (traceZone, __LINE__) (name, index);
+ #define AUDIOPLUGIN_TRACE_THREAD                     TraceProfiler::prepareCurrentThread();
+#else
+ #define AUDIOPLUGIN_TRACE_ZONE(name)
+ #define AUDIOPLUGIN_TRACE_ZONE_INDEXED(name, index)
+ #define AUDIOPLUGIN_TRACE_THREAD
+#endif
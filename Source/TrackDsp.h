@@ -0,0 +1,179 @@
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+
+#include <complex>
+
+#include "ParameterLocks.h"
+#include "StateVariableFilter.h"
+
+/**
+ * @brief Effect stages of a track, shared by live rendering and the track freezer.
+ *
+ * Every stage processes interleaved samples in place and keeps its state in the objects passed in,
+ * so a frozen render runs exactly the code the audio thread runs.
+ */
+namespace TrackDsp
+{
+    /**
+     * @brief Runs the enabled filters of a track. Notch, band-pass and peak are exclusive; otherwise
+     * high-pass and low-pass run in series.
+     */
+    inline void applyFilters(const TrackControl& control,
+                             StateVariableFilter& lowpass, StateVariableFilter& highpass, StateVariableFilter& bandpass,
+                             juce::dsp::IIR::Filter<float>& notch, juce::dsp::IIR::Filter<float>& peak,
+                             float* samples, int count) noexcept
+    {
+        if (control.notch)
+        {
+            for (int n = 0; n < count; ++n)
+                samples[n] = notch.processSample(samples[n]);
+        }
+        else if (control.bandpass)
+        {
+            for (int n = 0; n < count; ++n)
+                samples[n] = bandpass.processSample(samples[n]);
+        }
+        else if (control.peak)
+        {
+            for (int n = 0; n < count; ++n)
+                samples[n] = peak.processSample(samples[n]);
+        }
+        else
+        {
+            if (control.highpass)
+                for (int n = 0; n < count; ++n)
+                    samples[n] = highpass.processSample(samples[n]);
+
+            if (control.lowpass)
+                for (int n = 0; n < count; ++n)
+                    samples[n] = lowpass.processSample(samples[n]);
+        }
+    }
+
+    /**
+     * @brief Returns the gain in decibels the filters of applyFilters() apply at a frequency, for displays.
+     *
+     * The state variable filters are evaluated on their analog prototypes, whose frequency axis the
+     * bilinear transform warps to tan(pi * f / sampleRate); the biquads are evaluated on the unit circle.
+     */
+    inline float getFilterResponse(const TrackSettings& settings, float frequencyHz, double sampleRate) noexcept
+    {
+        const auto& control = settings.control;
+        const double halfAngle = juce::MathConstants<double>::pi * juce::jlimit(0.0, 0.4999 * sampleRate, (double) frequencyHz) / sampleRate;
+        const double prewarped = std::tan(halfAngle);
+
+        auto stateVariable = [prewarped](float g, float k, int numeratorOrder)
+        {
+            const double omega = prewarped / juce::jmax(1.0e-9, (double) g);
+            const double real = 1.0 - omega * omega;
+            const double imag = (double) k * omega;
+            return std::pow(omega, numeratorOrder) / std::sqrt(real * real + imag * imag);
+        };
+
+        auto biquad = [halfAngle](const std::array<float, 6>& c)
+        {
+            const auto z = std::polar(1.0, -2.0 * halfAngle);
+            const auto numerator = (double) c[0] + (double) c[1] * z + (double) c[2] * z * z;
+            const auto denominator = (double) c[3] + (double) c[4] * z + (double) c[5] * z * z;
+            return std::abs(numerator / denominator);
+        };
+
+        double magnitude = 1.0;
+
+        if (control.notch)
+            magnitude = biquad(settings.notchCoefficients);
+        else if (control.bandpass)
+            magnitude = stateVariable(settings.bandpassGain, settings.bandpassDamping, 1);
+        else if (control.peak)
+            magnitude = biquad(settings.peakCoefficients);
+        else
+        {
+            if (control.highpass)
+                magnitude *= stateVariable(settings.highpassGain, juce::MathConstants<float>::sqrt2, 2);
+
+            if (control.lowpass)
+                magnitude *= stateVariable(settings.lowpassGain, juce::MathConstants<float>::sqrt2, 0);
+        }
+
+        return juce::Decibels::gainToDecibels((float) magnitude, -100.0f);
+    }
+
+    /**
+     * @brief Reduces bit depth and sample rate.
+     * @param counter Position within the current downsampling interval, carried across calls.
+     */
+    inline void applyBitcrusher(const TrackControl& control, int& counter, float* samples, int count) noexcept
+    {
+        const int downsampleFactor = control.downsampleFactor;
+        const float maxVal = static_cast<float>((1 << control.bitDepth) - 1);
+
+        for (int n = 0; n < count; ++n)
+        {
+            if (counter == 0)
+                samples[n] = std::round(samples[n] * maxVal) / maxVal;
+
+            counter = (counter + 1) % downsampleFactor;
+        }
+    }
+
+    /**
+     * @brief Fades the frames of a region of the sample in over its first fadeFrames and out over its last.
+     *
+     * Only the frames inside the two ramps are touched, so a call for the middle of a region costs nothing.
+     *
+     * @param region Frames of the sample being played.
+     * @param fadeIn, fadeOut Whether each end of the region is faded.
+     * @param position Position in the sample the first frame of samples was read from.
+     * @param increment Frames of the sample per frame of samples, other than one for pitched playback.
+     */
+    inline void applyRegionFades(juce::Range<int> region, int fadeFrames, bool fadeIn, bool fadeOut, double position, double increment,
+                                 float* samples, int numFrames, int numChannels) noexcept
+    {
+        fadeFrames = juce::jmin(fadeFrames, region.getLength() / 2);
+
+        if (fadeFrames <= 0)
+            return;
+
+        const float step = 1.0f / (float) fadeFrames;
+
+        if (fadeIn)
+        {
+            const int rampEnd = SampleInterpolator::getFramesBefore(region.getStart() + fadeFrames - position, increment, numFrames);
+
+            for (int frame = 0; frame < rampEnd; ++frame)
+                juce::FloatVectorOperations::multiply(samples + frame * numChannels,
+                                                      juce::jmax(0.0f, (float) (position + frame * increment - region.getStart() + 0.5)) * step,
+                                                      numChannels);
+        }
+
+        if (fadeOut)
+        {
+            const int rampStart = SampleInterpolator::getFramesBefore(region.getEnd() - fadeFrames - position, increment, numFrames);
+
+            for (int frame = rampStart; frame < numFrames; ++frame)
+                juce::FloatVectorOperations::multiply(samples + frame * numChannels,
+                                                      juce::jmax(0.0f, (float) (region.getEnd() - (position + frame * increment) - 0.5)) * step,
+                                                      numChannels);
+        }
+    }
+
+    /**
+     * @brief Applies the envelope and the gain, ramping linearly from currentGain to targetGain.
+     * @param currentGain Gain reached by the previous call; set to targetGain on return.
+     */
+    inline void applyEnvelopeAndGain(juce::ADSR& envelope, float& currentGain, float targetGain, float* samples, int count) noexcept
+    {
+        float gain = currentGain;
+        const float gainStep = (targetGain - gain) / (float) count;
+
+        for (int n = 0; n < count; ++n)
+        {
+            gain += gainStep;
+            float envelopeValue = envelope.getNextSample();
+            samples[n] *= envelopeValue * gain;
+        }
+
+        currentGain = targetGain;
+    }
+}
@@ -0,0 +1,166 @@
+#include "TrackFreezer.h"
+
+
+namespace
+{
+    /** @brief Pause after a wake-up, so a burst of edits such as a knob drag leads to one render. */
+    constexpr int settleMilliseconds = 20;
+
+    /** @brief Frames rendered per pass through the effect stages. */
+    constexpr int renderChunkFrames = 256;
+}
+
+
+TrackFreezer::TrackFreezer(std::function<void(int track)> refreshTrackToUse)
+    : juce::Thread("Track freezer"),
+      refreshTrack(std::move(refreshTrackToUse))
+{
+}
+
+
+/**
+ * @brief Stops the thread and frees all renders. The audio thread must no longer be running.
+ */
+TrackFreezer::~TrackFreezer()
+{
+    stopThread(2000);
+
+    for (auto& render : renders)
+        delete render.exchange(nullptr);
+}
+
+
+void TrackFreezer::setFrozen(int track, bool shouldBeFrozen)
+{
+    if (track < 0 || track >= maxTracks)
+        return;
+
+    frozen[(size_t) track] = shouldBeFrozen;
+
+    if (! shouldBeFrozen)
+        publish(track, nullptr);
+    else if (! isThreadRunning())
+        startThread();
+
+    update();
+}
+
+
+void TrackFreezer::update()
+{
+    notify();
+}
+
+
+/**
+ * @brief Swaps in a new render and retires the previous one. setFrozen() clears the flag before it
+ * publishes nullptr, so a render that completes while a track is being unfrozen cannot be installed.
+ */
+void TrackFreezer::publish(int track, std::unique_ptr<const FrozenTrack> render)
+{
+    const juce::ScopedLock lock(publishLock);
+
+    // A render finished after the track was unfrozen is dropped
+    if (render != nullptr && ! isFrozen(track))
+        return;
+
+    retired.exchange(renders[(size_t) track], std::move(render));
+}
+
+
+void TrackFreezer::releaseAllRetired()
+{
+    const juce::ScopedLock lock(publishLock);
+    retired.releaseAll();
+}
+
+
+std::unique_ptr<FrozenTrack> TrackFreezer::render(const SampleStore& source, const TrackSettings& settings,
+                                                  int numChannels, double sampleRate)
+{
+    auto result = std::make_unique<FrozenTrack>();
+    const int length = source.getNumFrames();
+    const int sourceChannels = source.getNumChannels();
+
+    if (length == 0 || sourceChannels == 0 || numChannels <= 0)
+        return result;
+
+    result->audio.setSize(numChannels, length);
+
+    StateVariableFilter lowpass, highpass, bandpass;
+    lowpass.setType(StateVariableFilter::Type::lowpass);
+    highpass.setType(StateVariableFilter::Type::highpass);
+    bandpass.setType(StateVariableFilter::Type::bandpass);
+    lowpass.setCoefficients(settings.lowpassGain, juce::MathConstants<float>::sqrt2);
+    highpass.setCoefficients(settings.highpassGain, juce::MathConstants<float>::sqrt2);
+    bandpass.setCoefficients(settings.bandpassGain, settings.bandpassDamping);
+
+    juce::dsp::IIR::Filter<float> notch, peak;
+    *notch.coefficients = settings.notchCoefficients;
+    *peak.coefficients = settings.peakCoefficients;
+    notch.reset();
+    peak.reset();
+
+    juce::ADSR envelope;
+    envelope.setSampleRate(sampleRate);
+    envelope.setParameters(settings.envelope);
+    envelope.noteOn();
+
+    int downsampleCounter = 0;
+    float gain = settings.control.gain;
+    std::vector<float> scratch((size_t) (renderChunkFrames * numChannels));
+    std::vector<float> decoded((size_t) renderChunkFrames);
+
+    for (int start = 0; start < length; start += renderChunkFrames)
+    {
+        const int numFrames = juce::jmin(renderChunkFrames, length - start);
+        const int count = numFrames * numChannels;
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            const float* in = source.getReadPointer(channel % sourceChannels, start, numFrames, decoded.data());
+
+            for (int frame = 0; frame < numFrames; ++frame)
+                scratch[(size_t) (frame * numChannels + channel)] = in[frame];
+        }
+
+        TrackDsp::applyFilters(settings.control, lowpass, highpass, bandpass, notch, peak, scratch.data(), count);
+
+        if (settings.control.bitcrusher)
+            TrackDsp::applyBitcrusher(settings.control, downsampleCounter, scratch.data(), count);
+
+        TrackDsp::applyEnvelopeAndGain(envelope, gain, settings.control.gain, scratch.data(), count);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            float* out = result->audio.getWritePointer(channel, start);
+
+            for (int frame = 0; frame < numFrames; ++frame)
+                out[frame] = scratch[(size_t) (frame * numChannels + channel)];
+        }
+    }
+
+    return result;
+}
+
+
+void TrackFreezer::run()
+{
+    while (! threadShouldExit())
+    {
+        for (int track = 0; track < maxTracks && ! threadShouldExit(); ++track)
+            if (isFrozen(track))
+                refreshTrack(track);
+
+        {
+            // Renders replaced while a note held them are freed once the note has let go
+            const juce::ScopedLock lock(publishLock);
+            retired.releaseFinished();
+        }
+
+        wait(-1);
+
+        if (! threadShouldExit())
+            sleep(settleMilliseconds);
+    }
+}
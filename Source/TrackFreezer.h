@@ -0,0 +1,106 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+
+#include "TrackDsp.h"
+#include "SampleStore.h"
+#include "RetiredPointers.h"
+
+
+/**
+ * @struct FrozenTrack
+ * @brief One trigger of a track rendered through its whole effect chain, with the versions it was rendered from.
+ */
+struct FrozenTrack
+{
+    juce::AudioBuffer<float> audio;         ///< One channel per output channel, as long as the sample
+    juce::uint32 parameterVersion = 0;      ///< Parameter version of the track the settings were computed at
+    juce::uint32 sampleVersion = 0;         ///< Version of the sample buffer and playback configuration
+};
+
+
+/**
+ * @class TrackFreezer
+ * @brief Renders frozen tracks on a background thread and hands the results to the audio thread.
+ *
+ * The thread starts when the first track is frozen. Whenever it is woken with update() it calls the
+ * owner's refresh callback for every frozen track; the callback decides whether the track's render is
+ * out of date and publishes a new one. Published renders are exchanged through atomic pointers, and a
+ * replaced render is freed once the audio thread has completed the block that might still be reading it
+ * and no note holds it any more.
+ */
+class TrackFreezer : private juce::Thread
+{
+public:
+    static constexpr int maxTracks = 8;
+
+    /**
+     * @param refreshTrack Called on the freezer thread with the index of each frozen track.
+     */
+    explicit TrackFreezer(std::function<void(int track)> refreshTrack);
+    ~TrackFreezer() override;
+
+    /** @brief Freezes or unfreezes a track. Unfreezing drops its render right away. */
+    void setFrozen(int track, bool shouldBeFrozen);
+
+    bool isFrozen(int track) const noexcept { return frozen[(size_t) track].load(std::memory_order_relaxed); }
+
+    /** @brief Wakes the freezer thread to check its tracks, e.g. after a parameter or sample change. */
+    void update();
+
+    /**
+     * @brief Installs the render of a track for the audio thread.
+     * @param render New render, or nullptr to play the track live.
+     */
+    void publish(int track, std::unique_ptr<const FrozenTrack> render);
+
+    /** @brief Frees all replaced renders. Only valid while the audio thread is stopped. */
+    void releaseAllRetired();
+
+    /**
+     * @brief Renders one trigger of a sample through filters, bitcrusher, envelope and gain, starting from
+     * cleared filter and envelope state.
+     *
+     * Channels are interleaved exactly as on the audio thread, so the render matches a live trigger that
+     * starts from silence.
+     *
+     * @param source The sample, decoded a chunk at a time.
+     * @param settings Settings of the track.
+     * @param numChannels Number of output channels.
+     * @param sampleRate Sample rate of the envelope.
+     */
+    static std::unique_ptr<FrozenTrack> render(const SampleStore& source, const TrackSettings& settings,
+                                               int numChannels, double sampleRate);
+
+    //================== Audio thread ==================
+
+    /** @brief Returns the render of a track, or nullptr. */
+    const FrozenTrack* getFrozen(int track) const noexcept
+    {
+        return renders[(size_t) track].load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief Keeps a render a note plays alive until the track holds another one or nullptr, even if it is
+     * replaced meanwhile.
+     * @param render Render loaded with getFrozen() in the current block, or nullptr.
+     */
+    void hold(int track, const FrozenTrack* render) noexcept { retired.hold(track, render); }
+
+    /** @brief Called by the audio thread at the end of every block. */
+    void markBlockCompleted() noexcept { retired.markBlockCompleted(); }
+
+private:
+    void run() override;
+
+    std::function<void(int)> refreshTrack;
+
+    std::array<std::atomic<bool>, maxTracks> frozen {};
+    std::array<std::atomic<const FrozenTrack*>, maxTracks> renders {};
+
+    /* @brief Guards the retire list; renders are published from the freezer and the message thread. */
+    juce::CriticalSection publishLock;
+    RetiredPointers<FrozenTrack, maxTracks> retired;
+
+    JUCE_DECLARE_NON_COPYABLE (TrackFreezer)
+};
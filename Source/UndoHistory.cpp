@@ -0,0 +1,67 @@
+#include "UndoHistory.h"
+
+
+UndoHistory::UndoHistory(int maxStepsToKeep)
+    : maxSteps(juce::jmax(1, maxStepsToKeep))
+{
+}
+
+
+void UndoHistory::reset(Snapshot newCurrent)
+{
+    undoSteps.clear();
+    redoSteps.clear();
+    current = std::move(newCurrent);
+}
+
+
+bool UndoHistory::record(Snapshot next)
+{
+    if (next == nullptr || next == current)
+        return false;
+
+    if (current != nullptr)
+    {
+        if ((int) undoSteps.size() >= maxSteps)
+            undoSteps.erase(undoSteps.begin());
+
+        undoSteps.push_back(std::move(current));
+    }
+
+    redoSteps.clear();
+    current = std::move(next);
+    return true;
+}
+
+
+bool UndoHistory::endTransaction() noexcept
+{
+    if (transactionDepth == 0)
+        return false;
+
+    return --transactionDepth == 0;
+}
+
+
+UndoHistory::Snapshot UndoHistory::undo()
+{
+    if (undoSteps.empty())
+        return nullptr;
+
+    redoSteps.push_back(std::move(current));
+    current = std::move(undoSteps.back());
+    undoSteps.pop_back();
+    return current;
+}
+
+
+UndoHistory::Snapshot UndoHistory::redo()
+{
+    if (redoSteps.empty())
+        return nullptr;
+
+    undoSteps.push_back(std::move(current));
+    current = std::move(redoSteps.back());
+    redoSteps.pop_back();
+    return current;
+}
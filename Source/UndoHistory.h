@@ -0,0 +1,171 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+#include "ParameterLocks.h"
+
+
+/**
+ * @file UndoHistory.h
+ * @brief Immutable, structurally shared snapshots of the editable processor state and the undo/redo
+ *        stacks built on them.
+ *
+ * A snapshot is a small tree of shared, never modified nodes. Recording a change builds new nodes only
+ * along the path to what changed and shares everything else with the previous snapshot, so keeping a
+ * snapshot costs one pointer and the memory of a history grows with the size of its edits rather than
+ * with the size of the state. Two snapshots can be compared node by node with pointer equality, which
+ * lets a restore skip every track that did not change.
+ */
+namespace UndoSnapshot
+{
+    static constexpr int maxTracks = 8;
+    static constexpr int numSteps = 16;
+
+    /** @brief Editable parameters of a track. Switches are stored as 0 or 1. */
+    enum Parameter
+    {
+        lowpassEnabled,
+        lowpassCutoff,
+        highpassEnabled,
+        highpassCutoff,
+        bandpassEnabled,
+        bandpassCutoff,
+        bandpassWidth,
+        notchEnabled,
+        notchCutoff,
+        notchWidth,
+        peakEnabled,
+        peakCutoff,
+        peakGain,
+        peakQ,
+        bitcrusherEnabled,
+        bitDepth,
+        downsampleRate,
+        gain,
+        attack,
+        decay,
+        sustain,
+        release,
+        slicePlayback,
+        pitch,
+        interpolation,          ///< SampleInterpolator::Quality
+        numParameters
+    };
+
+    /** @brief Parameter values of one track. */
+    struct Parameters
+    {
+        std::array<float, numParameters> values {};
+
+        bool operator==(const Parameters& other) const noexcept { return values == other.values; }
+        bool operator!=(const Parameters& other) const noexcept { return ! operator==(other); }
+    };
+
+    /** @brief Parameter locks of every step of one track. */
+    struct Locks
+    {
+        std::array<ParameterLock, numSteps> steps {};
+
+        bool operator==(const Locks& other) const noexcept { return steps == other.steps; }
+        bool operator!=(const Locks& other) const noexcept { return ! operator==(other); }
+    };
+
+    /** @brief One track: shared parameter and lock nodes plus its play switch and sample assignment. */
+    struct Track
+    {
+        std::shared_ptr<const Parameters> parameters;
+        std::shared_ptr<const Locks> locks;
+        bool playing = false;
+        juce::File sampleFile;              ///< File assigned to the slot; empty for an empty or generated slot
+    };
+
+    /** @brief Step pattern of all sequencer rows, one bit per step. */
+    struct Pattern
+    {
+        std::array<juce::uint32, maxTracks> steps {};
+
+        bool operator==(const Pattern& other) const noexcept { return steps == other.steps; }
+        bool operator!=(const Pattern& other) const noexcept { return ! operator==(other); }
+    };
+
+    /** @brief Root of a snapshot. */
+    struct Project
+    {
+        float bpm = 120.0f;
+        std::shared_ptr<const Pattern> pattern;
+        std::array<std::shared_ptr<const Track>, maxTracks> tracks {};
+    };
+
+    /**
+     * @brief Returns a node holding value, or previous itself if it already holds an equal value.
+     *
+     * This is what makes snapshots share structure: an unchanged part keeps its node.
+     */
+    template <typename Node>
+    std::shared_ptr<const Node> share(const std::shared_ptr<const Node>& previous, const Node& value)
+    {
+        if (previous != nullptr && *previous == value)
+            return previous;
+
+        return std::make_shared<const Node>(value);
+    }
+}
+
+
+/**
+ * @class UndoHistory
+ * @brief Undo and redo stacks of snapshots, with transactions that merge several edits into one step.
+ *
+ * The history holds the snapshot of the current state and the snapshots before and after it. Recording
+ * a snapshot that is identical to the current one does nothing, so edits that end where they started
+ * leave no step. Not thread safe; the owner serialises access.
+ */
+class UndoHistory
+{
+public:
+    using Snapshot = std::shared_ptr<const UndoSnapshot::Project>;
+
+    /** @param maxSteps Number of undo steps kept; the oldest ones are dropped. */
+    explicit UndoHistory(int maxSteps = 256);
+
+    /** @brief Drops all steps and makes a snapshot the current state. */
+    void reset(Snapshot current);
+
+    /** @brief Returns the snapshot of the current state. */
+    const Snapshot& getCurrent() const noexcept { return current; }
+
+    /**
+     * @brief Makes a snapshot the current state and pushes the previous one as an undo step.
+     * @return False if the snapshot equals the current one and nothing was recorded.
+     */
+    bool record(Snapshot next);
+
+    /**
+     * @brief Starts a transaction. Until the outermost transaction ends, the owner should not record.
+     * Transactions nest.
+     */
+    void beginTransaction() noexcept { ++transactionDepth; }
+
+    /** @brief Ends a transaction. Returns true when the outermost one ended and the owner should record. */
+    bool endTransaction() noexcept;
+
+    bool isInTransaction() const noexcept { return transactionDepth > 0; }
+
+    /** @brief Moves one step back and returns the snapshot to restore, or nullptr if there is none. */
+    Snapshot undo();
+
+    /** @brief Moves one step forward and returns the snapshot to restore, or nullptr if there is none. */
+    Snapshot redo();
+
+    bool canUndo() const noexcept { return ! undoSteps.empty(); }
+    bool canRedo() const noexcept { return ! redoSteps.empty(); }
+
+private:
+    std::vector<Snapshot> undoSteps;
+    std::vector<Snapshot> redoSteps;
+    Snapshot current;
+    int transactionDepth = 0;
+    int maxSteps;
+
+    JUCE_DECLARE_NON_COPYABLE (UndoHistory)
+};
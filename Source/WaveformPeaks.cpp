@@ -0,0 +1,150 @@
+#include "WaveformPeaks.h"
+
+
+namespace
+{
+    /** @brief Identifies a peaks stream and the version of its layout. */
+    constexpr int peaksMagic = 0x57504b31;   // "WPK1"
+
+    /** @brief Upper bound for the number of bins a level read from a stream may claim. */
+    constexpr juce::int64 maxBinsPerLevel = (juce::int64) std::numeric_limits<int>::max() / 8;
+}
+
+
+std::shared_ptr<const WaveformPeaks> WaveformPeaks::build(const juce::AudioBuffer<float>& audio)
+{
+    auto peaks = std::make_shared<WaveformPeaks>();
+    const int length = audio.getNumSamples();
+    const int numChannels = audio.getNumChannels();
+
+    peaks->numFrames = length;
+
+    auto& base = peaks->levels.emplace_back();
+    base.resize((size_t) ((length + framesPerBin - 1) / framesPerBin));
+
+    for (size_t bin = 0; bin < base.size(); ++bin)
+    {
+        const int start = (int) bin * framesPerBin;
+        const int count = juce::jmin(framesPerBin, length - start);
+        juce::Range<float> range;
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            const auto channelRange = juce::FloatVectorOperations::findMinAndMax(audio.getReadPointer(channel, start), count);
+            range = channel == 0 ? channelRange : range.getUnionWith(channelRange);
+        }
+
+        base[bin] = { range.getStart(), range.getEnd() };
+    }
+
+    peaks->buildUpperLevels();
+    return peaks;
+}
+
+
+void WaveformPeaks::buildUpperLevels()
+{
+    while (! levels.empty() && levels.back().size() > 1)
+    {
+        const auto& below = levels.back();
+        std::vector<Bin> level((below.size() + levelFactor - 1) / levelFactor);
+
+        for (size_t bin = 0; bin < level.size(); ++bin)
+        {
+            const size_t first = bin * levelFactor;
+            const size_t last = juce::jmin(below.size(), first + levelFactor);
+            Bin merged = below[first];
+
+            for (size_t i = first + 1; i < last; ++i)
+            {
+                merged.min = juce::jmin(merged.min, below[i].min);
+                merged.max = juce::jmax(merged.max, below[i].max);
+            }
+
+            level[bin] = merged;
+        }
+
+        levels.push_back(std::move(level));
+    }
+}
+
+
+std::shared_ptr<const WaveformPeaks> WaveformPeaks::read(juce::InputStream& input)
+{
+    if (input.readInt() != peaksMagic)
+        return nullptr;
+
+    auto peaks = std::make_shared<WaveformPeaks>();
+    peaks->numFrames = input.readInt64();
+
+    const auto numBins = (juce::int64) input.readInt();
+    const auto expectedBins = (peaks->numFrames + framesPerBin - 1) / framesPerBin;
+
+    if (peaks->numFrames < 0 || numBins != expectedBins || numBins > maxBinsPerLevel
+            || input.getNumBytesRemaining() < numBins * 8)
+        return nullptr;
+
+    auto& base = peaks->levels.emplace_back((size_t) numBins);
+
+    for (auto& bin : base)
+    {
+        bin.min = input.readFloat();
+        bin.max = input.readFloat();
+    }
+
+    peaks->buildUpperLevels();
+    return peaks;
+}
+
+
+/**
+ * @brief Only level 0 is written; the upper levels are rebuilt on reading, which takes a fraction of
+ * the time of decoding the sample.
+ */
+bool WaveformPeaks::write(juce::OutputStream& output) const
+{
+    const auto& base = levels.empty() ? std::vector<Bin>() : levels.front();
+
+    bool ok = output.writeInt(peaksMagic)
+           && output.writeInt64(numFrames)
+           && output.writeInt((int) base.size());
+
+    for (const auto& bin : base)
+        ok = ok && output.writeFloat(bin.min) && output.writeFloat(bin.max);
+
+    return ok;
+}
+
+
+juce::Range<float> WaveformPeaks::getRange(juce::int64 startFrame, juce::int64 endFrame) const noexcept
+{
+    startFrame = juce::jmax((juce::int64) 0, startFrame);
+    endFrame = juce::jmin(numFrames, endFrame);
+
+    if (endFrame <= startFrame || levels.empty())
+        return {};
+
+    const auto span = endFrame - startFrame;
+    juce::int64 binFrames = framesPerBin;
+    size_t level = 0;
+
+    while (level + 1 < levels.size() && binFrames * levelFactor <= span)
+    {
+        binFrames *= levelFactor;
+        ++level;
+    }
+
+    const auto& bins = levels[level];
+    const auto first = (size_t) (startFrame / binFrames);
+    const auto last = juce::jmin(bins.size(), (size_t) ((endFrame + binFrames - 1) / binFrames));
+
+    Bin merged = bins[first];
+
+    for (size_t i = first + 1; i < last; ++i)
+    {
+        merged.min = juce::jmin(merged.min, bins[i].min);
+        merged.max = juce::jmax(merged.max, bins[i].max);
+    }
+
+    return { merged.min, merged.max };
+}
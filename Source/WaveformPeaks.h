@@ -0,0 +1,55 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+
+
+/**
+ * @class WaveformPeaks
+ * @brief Min/max pyramid of a sample for drawing its waveform at any zoom.
+ *
+ * Level 0 holds the minimum and maximum over all channels of every framesPerBin frames; each further
+ * level merges levelFactor bins of the one below, up to a single bin. getRange() answers a frame range
+ * from the coarsest level whose bins are not longer than the range, so it reads at most a handful of
+ * bins however long the range is, and drawing a waveform costs a fixed amount per pixel.
+ *
+ * Peaks are immutable once built and shared between threads through std::shared_ptr.
+ */
+class WaveformPeaks
+{
+public:
+    static constexpr int framesPerBin = 32;
+    static constexpr int levelFactor = 4;
+
+    /** @brief Builds the pyramid of a buffer. */
+    static std::shared_ptr<const WaveformPeaks> build(const juce::AudioBuffer<float>& audio);
+
+    /** @brief Reads peaks written by write(), or returns nullptr if the stream does not hold valid peaks. */
+    static std::shared_ptr<const WaveformPeaks> read(juce::InputStream& input);
+
+    /** @brief Writes the pyramid in a compact binary form. */
+    bool write(juce::OutputStream& output) const;
+
+    juce::int64 getNumFrames() const noexcept { return numFrames; }
+    int getNumLevels() const noexcept { return (int) levels.size(); }
+
+    /**
+     * @brief Returns the lowest and highest sample value in a frame range.
+     *
+     * The range is widened to whole bins of the level used, so a short range may include a few frames
+     * beside it. An empty range or one outside the sample returns an empty range at 0.
+     */
+    juce::Range<float> getRange(juce::int64 startFrame, juce::int64 endFrame) const noexcept;
+
+private:
+    struct Bin
+    {
+        float min = 0.0f;
+        float max = 0.0f;
+    };
+
+    juce::int64 numFrames = 0;
+    std::vector<std::vector<Bin>> levels;
+
+    /** @brief Adds levels above the last one until a level has a single bin. */
+    void buildUpperLevels();
+};
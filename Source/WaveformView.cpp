@@ -0,0 +1,171 @@
+#include "WaveformView.h"
+#include "TraceProfiler.h"
+
+
+WaveformView::WaveformView()
+{
+    setOpaque(true);
+}
+
+
+void WaveformView::setPeaks(std::shared_ptr<const WaveformPeaks> newPeaks)
+{
+    peaks = std::move(newPeaks);
+    setView(0, peaks != nullptr ? peaks->getNumFrames() : 0);
+}
+
+
+void WaveformView::setSlices(std::shared_ptr<const SliceIndex> newSlices)
+{
+    slices = std::move(newSlices);
+    repaint();
+}
+
+
+void WaveformView::setPlayhead(int frame)
+{
+    playheadFrame = frame;
+    const int x = frame >= 0 ? frameToX(frame) : -1;
+
+    if (x == playheadX)
+        return;
+
+    repaintPlayhead(playheadX);
+    playheadX = x;
+    repaintPlayhead(playheadX);
+}
+
+
+/**
+ * @brief Draws the min/max range of every pixel column in the clip region, then the slice starts and
+ * the playhead.
+ */
+void WaveformView::paint(juce::Graphics& g)
+{
+    AUDIOPLUGIN_TRACE_ZONE("waveform paint")
+
+    g.fillAll(juce::Colours::darkslategrey.darker(0.5f));
+
+    const auto clip = g.getClipBounds();
+    const float centreY = (float) getHeight() * 0.5f;
+    const float halfHeight = (float) getHeight() * 0.45f;
+
+    g.setColour(juce::Colours::grey.withAlpha(0.5f));
+    g.fillRect((float) clip.getX(), centreY, (float) clip.getWidth(), 1.0f);
+
+    if (peaks == nullptr || viewLength <= 0)
+        return;
+
+    g.setColour(juce::Colours::deepskyblue);
+
+    for (int x = clip.getX(); x < clip.getRight(); ++x)
+    {
+        const auto range = peaks->getRange(xToFrame(x), xToFrame(x + 1));
+        const float top = centreY - juce::jlimit(-1.0f, 1.0f, range.getEnd()) * halfHeight;
+        const float bottom = centreY - juce::jlimit(-1.0f, 1.0f, range.getStart()) * halfHeight;
+        g.fillRect((float) x, top, 1.0f, juce::jmax(1.0f, bottom - top));
+    }
+
+    if (slices != nullptr && slices->getNumFrames() == peaks->getNumFrames())
+    {
+        const auto& starts = slices->getStarts();
+        const auto first = std::lower_bound(starts.begin(), starts.end(), (int) juce::jmax((juce::int64) 1, xToFrame(clip.getX())));
+
+        g.setColour(juce::Colours::orange.withAlpha(0.8f));
+
+        for (auto it = first; it != starts.end(); ++it)
+        {
+            const int x = frameToX(*it);
+
+            if (x < 0 || x >= clip.getRight())
+                break;
+
+            g.fillRect((float) x, 0.0f, 1.0f, (float) getHeight());
+        }
+    }
+
+    if (playheadX >= clip.getX() - 1 && playheadX <= clip.getRight())
+    {
+        g.setColour(juce::Colours::whitesmoke);
+        g.fillRect((float) playheadX, 0.0f, 1.5f, (float) getHeight());
+    }
+}
+
+
+void WaveformView::resized()
+{
+    setView(viewStart, viewLength);
+}
+
+
+void WaveformView::mouseDown(const juce::MouseEvent&)
+{
+    dragStartView = viewStart;
+}
+
+
+void WaveformView::mouseDrag(const juce::MouseEvent& e)
+{
+    if (getWidth() <= 0)
+        return;
+
+    const auto framesPerPixel = (double) viewLength / getWidth();
+    setView(dragStartView - (juce::int64) (e.getDistanceFromDragStartX() * framesPerPixel), viewLength);
+}
+
+
+void WaveformView::mouseDoubleClick(const juce::MouseEvent&)
+{
+    setView(0, peaks != nullptr ? peaks->getNumFrames() : 0);
+}
+
+
+/**
+ * @brief Zooms in or out around the frame under the mouse, which stays where it is.
+ */
+void WaveformView::mouseWheelMove(const juce::MouseEvent& e, const juce::MouseWheelDetails& wheel)
+{
+    if (peaks == nullptr || getWidth() <= 0)
+        return;
+
+    const auto anchor = xToFrame(e.position.x);
+    const double proportion = (double) e.position.x / getWidth();
+    const double factor = std::pow(2.0, -wheel.deltaY * 2.0);
+    const auto length = (juce::int64) ((double) viewLength * factor);
+
+    setView(anchor - (juce::int64) (proportion * (double) length), length);
+}
+
+
+void WaveformView::setView(juce::int64 start, juce::int64 length)
+{
+    const auto numFrames = peaks != nullptr ? peaks->getNumFrames() : 0;
+    const auto minLength = juce::jmin(numFrames, (juce::int64) juce::jmax(1, getWidth()) * WaveformPeaks::framesPerBin);
+
+    viewLength = juce::jlimit(minLength, numFrames, length);
+    viewStart = juce::jlimit((juce::int64) 0, numFrames - viewLength, start);
+    playheadX = playheadFrame >= 0 ? frameToX(playheadFrame) : -1;
+    repaint();
+}
+
+
+juce::int64 WaveformView::xToFrame(double x) const noexcept
+{
+    return getWidth() > 0 ? viewStart + (juce::int64) (x * (double) viewLength / getWidth()) : viewStart;
+}
+
+
+int WaveformView::frameToX(juce::int64 frame) const noexcept
+{
+    if (viewLength <= 0 || frame < viewStart || frame >= viewStart + viewLength)
+        return -1;
+
+    return (int) ((frame - viewStart) * getWidth() / viewLength);
+}
+
+
+void WaveformView::repaintPlayhead(int x)
+{
+    if (x >= 0)
+        repaint(x - 1, 0, 4, getHeight());
+}
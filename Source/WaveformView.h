@@ -0,0 +1,73 @@
+#pragma once
+
+#include <juce_gui_basics/juce_gui_basics.h>
+
+#include "WaveformPeaks.h"
+#include "SliceIndex.h"
+
+
+/**
+ * @class WaveformView
+ * @brief Waveform overview of a sample with its playhead and slice starts, drawn from a WaveformPeaks pyramid.
+ *
+ * Each pixel column draws the min/max range of its frames, which the pyramid answers from a few bins,
+ * so painting costs the same per pixel at any zoom and never touches the sample data. Only the columns
+ * inside the clip region are drawn, and moving the playhead repaints the columns it leaves and enters.
+ *
+ * The mouse wheel zooms around the mouse position, down to WaveformPeaks::framesPerBin frames per
+ * pixel; dragging scrolls and a double click shows the whole sample again.
+ */
+class WaveformView : public juce::Component
+{
+public:
+    WaveformView();
+
+    /** @brief Shows new peaks, zoomed out to the whole sample. */
+    void setPeaks(std::shared_ptr<const WaveformPeaks> peaks);
+
+    const std::shared_ptr<const WaveformPeaks>& getPeaks() const noexcept { return peaks; }
+
+    /** @brief Marks the start of every slice after the first, or nothing for nullptr. */
+    void setSlices(std::shared_ptr<const SliceIndex> slices);
+
+    const std::shared_ptr<const SliceIndex>& getSlices() const noexcept { return slices; }
+
+    /** @brief Moves the playhead to a frame of the sample, or hides it for -1. */
+    void setPlayhead(int frame);
+
+    void paint(juce::Graphics& g) override;
+    void resized() override;
+    void mouseDown(const juce::MouseEvent& e) override;
+    void mouseDrag(const juce::MouseEvent& e) override;
+    void mouseDoubleClick(const juce::MouseEvent& e) override;
+    void mouseWheelMove(const juce::MouseEvent& e, const juce::MouseWheelDetails& wheel) override;
+
+private:
+    std::shared_ptr<const WaveformPeaks> peaks;
+    std::shared_ptr<const SliceIndex> slices;
+
+    /* @brief Visible frame range. */
+    juce::int64 viewStart = 0;
+    juce::int64 viewLength = 0;
+
+    /* @brief Frame and pixel column of the playhead, -1 while hidden. */
+    int playheadFrame = -1;
+    int playheadX = -1;
+
+    /* @brief View start when a scroll drag began. */
+    juce::int64 dragStartView = 0;
+
+    /** @brief Sets the visible range, limited to the sample and to the zoom the peaks can resolve. */
+    void setView(juce::int64 start, juce::int64 length);
+
+    /** @brief Returns the first frame shown at a pixel position. */
+    juce::int64 xToFrame(double x) const noexcept;
+
+    /** @brief Returns the pixel column of a frame, or -1 if it is outside the view. */
+    int frameToX(juce::int64 frame) const noexcept;
+
+    /** @brief Repaints the pixel columns around a playhead position. */
+    void repaintPlayhead(int x);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (WaveformView)
+};
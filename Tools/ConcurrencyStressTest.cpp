@@ -0,0 +1,459 @@
+#include "PluginProcessor.h"
+#include "ToolScenarios.h"
+#include "RealtimeSafetyChecker.h"
+
+#include <thread>
+
+/**
+ * @file ConcurrencyStressTest.cpp
+ * @brief Runs processBlock in a realtime-paced loop while other threads call the public setters with
+ *        randomized values, the way the editor does from the message thread.
+ *
+ * The audio output is checked for NaN, infinite and denormal values and every block is timed against
+ * its deadline. Data races are found by building with -DAUDIOPLUGIN_SANITIZER=thread; use-after-free
+ * and overflows with -DAUDIOPLUGIN_SANITIZER=address.
+ *
+ * Usage:
+ *   Audiovisual_StressTest [options]
+ *
+ * Options:
+ *   --seconds <s>     Duration of the run (default 10).
+ *   --seed <n>        Seed for all randomized parameter values (default 1).
+ *   --threads <n>     Number of setter threads (default 3).
+ *   --rate <hz>       Sample rate (default 48000).
+ *   --block <n>       Maximum block size (default 256).
+ *   --variable        Use a random block size between 1 and the maximum for every block.
+ *   --freerun         Render blocks back to back instead of at the realtime rate.
+ *   --spike <factor>  Report blocks slower than this fraction of their deadline (default 0.5).
+ */
+
+namespace
+{
+    using namespace ToolScenarios;
+
+    /** @brief Settings of one stress run. */
+    struct StressSettings
+    {
+        double seconds = 10.0;
+        juce::int64 seed = 1;
+        int numSetterThreads = 3;
+        double sampleRate = 48000.0;
+        int maxBlockSize = 256;
+        bool variableBlockSize = false;
+        bool freeRunning = false;
+        double spikeFactor = 0.5;
+    };
+
+    /** @brief Everything the audio thread found, written by the audio thread only. */
+    struct AudioThreadResults
+    {
+        juce::int64 numBlocks = 0;
+        juce::int64 numNaNs = 0;
+        juce::int64 numInfinities = 0;
+        juce::int64 numDenormals = 0;
+        juce::int64 numSpikes = 0;
+        juce::int64 numOverruns = 0;
+        double maxBlockLoad = 0.0;
+        std::vector<double> blockLoads;
+    };
+
+    /** @brief Returns a random value between two limits on a logarithmic scale. */
+    float nextLogarithmic(juce::Random& random, float minimum, float maximum)
+    {
+        return minimum * std::pow(maximum / minimum, random.nextFloat());
+    }
+
+    /** @brief Returns a random value between two limits. */
+    float nextLinear(juce::Random& random, float minimum, float maximum)
+    {
+        return minimum + (maximum - minimum) * random.nextFloat();
+    }
+
+    /**
+     * @brief Writes a few generated samples to disk so loadSampleFile can be exercised.
+     * @return The written files.
+     */
+    juce::Array<juce::File> writeSampleFiles(const juce::File& directory, double sampleRate)
+    {
+        juce::Array<juce::File> files;
+        directory.createDirectory();
+
+        for (int i = 0; i < 4; ++i)
+        {
+            auto file = directory.getChildFile("stress_" + juce::String(i) + ".wav");
+            file.deleteFile();
+
+            std::unique_ptr<juce::OutputStream> stream(file.createOutputStream());
+            if (stream == nullptr)
+                continue;
+
+            const auto sample = makeTestSample(100 + i, sampleRate, 0.05 + 0.3 * i);
+
+            juce::WavAudioFormat format;
+            std::unique_ptr<juce::AudioFormatWriter> writer(format.createWriterFor(stream.get(), sampleRate,
+                                                                                   (unsigned int) sample.getNumChannels(),
+                                                                                   24, {}, 0));
+            if (writer == nullptr)
+                continue;
+
+            stream.release();
+            writer->writeFromAudioSampleBuffer(sample, 0, sample.getNumSamples());
+            files.add(file);
+        }
+
+        return files;
+    }
+
+    /**
+     * @brief Sets or clears a random parameter lock of a track.
+     */
+    void setRandomStepLock(SampleAudioProcessor& processor, juce::Random& random, int track)
+    {
+        const int step = random.nextInt(SampleAudioProcessor::NUM_STEPS);
+        const auto target = static_cast<ParameterLock::Target>(random.nextInt(ParameterLock::numTargets));
+
+        if (random.nextInt(4) == 0)
+        {
+            processor.clearStepLock(track, step, target);
+            return;
+        }
+
+        float value = 0.0f;
+
+        switch (target)
+        {
+            case ParameterLock::cutoff:   value = nextLogarithmic(random, 20.0f, 20000.0f); break;
+            case ParameterLock::peakGain: value = nextLinear(random, -24.0f, 24.0f); break;
+            case ParameterLock::bitDepth: value = (float) (1 + random.nextInt(24)); break;
+            case ParameterLock::gain:     value = nextLinear(random, 0.0f, 2.0f); break;
+            case ParameterLock::slice:    value = (float) random.nextInt(SliceIndex::maxSlices); break;
+            case ParameterLock::pitch:    value = nextLinear(random, -SampleAudioProcessor::maxPitch, SampleAudioProcessor::maxPitch); break;
+            default:                      value = nextLogarithmic(random, 0.001f, 2.0f); break;
+        }
+
+        processor.setStepLock(track, step, target, value);
+    }
+
+    /**
+     * @brief Replaces or clears a random modulation slot, or changes a modulation source.
+     */
+    void setRandomModulation(SampleAudioProcessor& processor, juce::Random& random, int track)
+    {
+        auto& matrix = processor.getModulationMatrix();
+        const int slot = random.nextInt(ModulationMatrix::maxSlots);
+
+        switch (random.nextInt(4))
+        {
+            case 0:
+                matrix.clearSlot(slot);
+                break;
+
+            case 1:
+                matrix.setLfo(random.nextInt(ModulationMatrix::numLfos), static_cast<ModulationMatrix::LfoShape>(random.nextInt(4)),
+                              nextLogarithmic(random, 0.0625f, 16.0f));
+                break;
+
+            default:
+            {
+                ModulationMatrix::Slot routing;
+                routing.source = random.nextInt(ModulationMatrix::numSources);
+                routing.destination = static_cast<ModulationMatrix::Destination>(random.nextInt(ModulationMatrix::numDestinations));
+                routing.track = random.nextBool() ? track : ModulationMatrix::allTracks;
+                routing.depth = nextLinear(random, -8.0f, 8.0f);
+                matrix.setSlot(slot, routing);
+                break;
+            }
+        }
+    }
+
+    /**
+     * @brief Switches a random analyser source, or reads a spectrum and a filter response the way the
+     * editor does.
+     */
+    void exerciseSpectrumAnalyser(SampleAudioProcessor& processor, juce::Random& random, int track)
+    {
+        auto& analyser = processor.getSpectrumAnalyser();
+        const int source = random.nextBool() ? track : SampleAudioProcessor::masterSpectrumSource;
+
+        if (random.nextBool())
+        {
+            analyser.setEnabled(source, random.nextBool());
+            return;
+        }
+
+        juce::uint32 version = 0;
+        std::vector<float> spectrum;
+        analyser.readSpectrum(source, version, spectrum);
+
+        const std::array<float, 3> frequencies { 100.0f, 1000.0f, 10000.0f };
+        std::array<float, 3> response {};
+        processor.getFilterResponse(track, frequencies.data(), response.data(), (int) frequencies.size());
+    }
+
+    /**
+     * @brief Switches loudness measurement, clears the clip flag or reads a meter, as the editor does.
+     */
+    void exerciseLevelMeter(LevelMeter& meter, juce::Random& random)
+    {
+        switch (random.nextInt(3))
+        {
+            case 0:  meter.setLoudnessEnabled(random.nextBool()); break;
+            case 1:  meter.resetClip(); break;
+            default: juce::ignoreUnused(meter.getReading()); break;
+        }
+    }
+
+    /**
+     * @brief Calls one randomly chosen setter with random arguments.
+     * @param processor The processor under test.
+     * @param random Random source of the calling thread.
+     * @param sampleFiles Files that may be loaded.
+     * @param sampleRate Sample rate used for generated buffers.
+     */
+    void callRandomSetter(SampleAudioProcessor& processor, juce::Random& random,
+                          const juce::Array<juce::File>& sampleFiles, double sampleRate)
+    {
+        const int track = random.nextInt(SampleAudioProcessor::NUM_SAMPLES);
+
+        switch (random.nextInt(33))
+        {
+            case 0:  processor.setStepState(track, random.nextInt(SampleAudioProcessor::NUM_STEPS), random.nextBool()); break;
+            case 1:  processor.setFilterEnabled(track, random.nextBool()); break;
+            case 2:  processor.setFilterCutoff(track, nextLogarithmic(random, 20.0f, 20000.0f)); break;
+            case 3:  processor.setHighpassEnabled(track, random.nextBool()); break;
+            case 4:  processor.setHighpassCutoff(track, nextLogarithmic(random, 20.0f, 20000.0f)); break;
+            case 5:  processor.setBandPassEnabled(track, random.nextBool()); break;
+            case 6:  processor.setBandPassCutoff(track, nextLogarithmic(random, 20.0f, 20000.0f)); break;
+            case 7:  processor.setBandPassBandwidth(track, nextLogarithmic(random, 1.0f, 5000.0f)); break;
+            case 8:  processor.setNotchEnabled(track, random.nextBool()); break;
+            case 9:  processor.setNotchCutoff(track, nextLogarithmic(random, 20.0f, 20000.0f)); break;
+            case 10: processor.setNotchBandwidth(track, nextLogarithmic(random, 1.0f, 5000.0f)); break;
+            case 11: processor.setPeakEnabled(track, random.nextBool()); break;
+            case 12: processor.setPeakCutoff(track, nextLogarithmic(random, 20.0f, 20000.0f)); break;
+            case 13: processor.setPeakGain(track, nextLinear(random, -24.0f, 24.0f)); break;
+            case 14: processor.setPeakQ(track, nextLogarithmic(random, 0.1f, 10.0f)); break;
+            case 15: processor.setBitcrusherEnabled(track, random.nextBool()); break;
+            case 16: processor.setBitDepth(track, 1 + random.nextInt(24)); break;
+            case 17: processor.setDownsampleRate(track, nextLinear(random, 1.0f, 32.0f)); break;
+            case 18: processor.setGainLevel(track, nextLinear(random, 0.0f, 2.0f)); break;
+            case 19: processor.setAdsrAttack(track, nextLogarithmic(random, 0.001f, 2.0f)); break;
+            case 20: processor.setAdsrDecay(track, nextLogarithmic(random, 0.001f, 2.0f)); break;
+            case 21: processor.setAdsrSustain(track, random.nextFloat()); break;
+            case 22: processor.setAdsrRelease(track, nextLogarithmic(random, 0.001f, 2.0f)); break;
+            case 23: setRandomStepLock(processor, random, track); break;
+            case 24: setRandomModulation(processor, random, track); break;
+            case 25: if (random.nextBool()) processor.undo(); else processor.redo(); break;
+            case 26: exerciseSpectrumAnalyser(processor, random, track); break;
+            case 27: exerciseLevelMeter(random.nextBool() ? processor.getTrackMeter(track) : processor.getMasterMeter(), random); break;
+            case 28: processor.setSlicePlayback(track, random.nextBool()); break;
+            case 29: processor.setPitch(track, nextLinear(random, -SampleAudioProcessor::maxPitch, SampleAudioProcessor::maxPitch)); break;
+            case 30: processor.setInterpolation(track, static_cast<SampleInterpolator::Quality>(random.nextInt(3))); break;
+            case 31:
+                if (random.nextBool())
+                    processor.auditionSampleBuffer(makeTestSample(random.nextInt(64), sampleRate, nextLinear(random, 0.01f, 0.5f)));
+                else
+                    processor.stopAudition();
+                break;
+
+            default:
+                switch (random.nextInt(4))
+                {
+                    case 0:
+                        if (! sampleFiles.isEmpty())
+                            processor.loadSampleFile(sampleFiles[random.nextInt(sampleFiles.size())], track);
+                        break;
+
+                    case 1:
+                        processor.loadSampleBuffer(makeTestSample(random.nextInt(64), sampleRate, nextLinear(random, 0.01f, 1.0f)), track);
+                        break;
+
+                    case 2:
+                    {
+                        // Later loads keep their frames in the new format while older ones still play
+                        auto options = processor.getSampleLoadOptions();
+                        options.storage = static_cast<SampleStore::Format>(random.nextInt(3));
+                        processor.setSampleLoadOptions(options);
+                        break;
+                    }
+
+                    default:
+                        processor.setGlobalBpm(nextLinear(random, 40.0f, 300.0f));
+                        break;
+                }
+                break;
+        }
+    }
+
+    /**
+     * @brief Counts NaN, infinite and denormal values in a block.
+     */
+    void checkOutput(const juce::AudioBuffer<float>& buffer, int numSamples, AudioThreadResults& results)
+    {
+        for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+        {
+            const float* data = buffer.getReadPointer(channel);
+
+            for (int i = 0; i < numSamples; ++i)
+            {
+                const float value = data[i];
+
+                if (std::isnan(value))
+                    ++results.numNaNs;
+                else if (std::isinf(value))
+                    ++results.numInfinities;
+                else if (value != 0.0f && std::abs(value) < std::numeric_limits<float>::min())
+                    ++results.numDenormals;
+            }
+        }
+    }
+
+    /**
+     * @brief Renders blocks until the run time is over.
+     */
+    void runAudioThread(SampleAudioProcessor& processor, const StressSettings& settings, AudioThreadResults& results)
+    {
+        juce::Random random(settings.seed);
+        juce::AudioBuffer<float> buffer(2, settings.maxBlockSize);
+        juce::MidiBuffer midi;
+
+        const auto clockStart = std::chrono::steady_clock::now();
+        const auto totalSamples = (juce::int64) (settings.seconds * settings.sampleRate);
+        juce::int64 renderedSamples = 0;
+
+        while (renderedSamples < totalSamples)
+        {
+            const int numSamples = settings.variableBlockSize ? 1 + random.nextInt(settings.maxBlockSize)
+                                                              : settings.maxBlockSize;
+            buffer.setSize(2, numSamples, false, false, true);
+
+            const auto start = juce::Time::getHighResolutionTicks();
+            processor.processBlock(buffer, midi);
+            const auto end = juce::Time::getHighResolutionTicks();
+
+            const double load = juce::Time::highResolutionTicksToSeconds(end - start) * settings.sampleRate / numSamples;
+            results.blockLoads.push_back(load);
+            results.maxBlockLoad = juce::jmax(results.maxBlockLoad, load);
+
+            if (load > settings.spikeFactor)
+                ++results.numSpikes;
+
+            if (load > 1.0)
+                ++results.numOverruns;
+
+            checkOutput(buffer, numSamples, results);
+            ++results.numBlocks;
+            renderedSamples += numSamples;
+
+            if (! settings.freeRunning)
+            {
+                const auto deadline = clockStart + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                                       std::chrono::duration<double>((double) renderedSamples / settings.sampleRate));
+                std::this_thread::sleep_until(deadline);
+            }
+        }
+    }
+
+    void printUsage()
+    {
+        std::cout << "Usage: Audiovisual_StressTest [--seconds <s>] [--seed <n>] [--threads <n>] [--rate <hz>]\n"
+                     "                              [--block <n>] [--variable] [--freerun] [--spike <factor>]"
+                  << std::endl;
+    }
+}
+
+
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    StressSettings settings;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const juce::String arg(juce::CharPointer_UTF8(argv[i]));
+        const bool hasValue = i + 1 < argc;
+        auto nextValue = [&] { return juce::String(juce::CharPointer_UTF8(argv[++i])); };
+
+        if (arg == "--help" || arg == "-h")         { printUsage(); return 0; }
+        else if (arg == "--seconds" && hasValue)    settings.seconds = juce::jmax(0.1, nextValue().getDoubleValue());
+        else if (arg == "--seed" && hasValue)       settings.seed = nextValue().getLargeIntValue();
+        else if (arg == "--threads" && hasValue)    settings.numSetterThreads = juce::jlimit(1, 64, nextValue().getIntValue());
+        else if (arg == "--rate" && hasValue)       settings.sampleRate = juce::jlimit(8000.0, 384000.0, nextValue().getDoubleValue());
+        else if (arg == "--block" && hasValue)      settings.maxBlockSize = juce::jlimit(1, 8192, nextValue().getIntValue());
+        else if (arg == "--variable")               settings.variableBlockSize = true;
+        else if (arg == "--freerun")                settings.freeRunning = true;
+        else if (arg == "--spike" && hasValue)      settings.spikeFactor = nextValue().getDoubleValue();
+        else                                        { printUsage(); return 1; }
+    }
+
+    const auto sampleDirectory = juce::File::getSpecialLocation(juce::File::tempDirectory).getChildFile("AudiovisualStress");
+    const auto sampleFiles = writeSampleFiles(sampleDirectory, settings.sampleRate);
+
+    SampleAudioProcessor processor;
+    processor.setRateAndBufferSizeDetails(settings.sampleRate, settings.maxBlockSize);
+
+    for (int track = 0; track < SampleAudioProcessor::NUM_SAMPLES; ++track)
+        activateTrack(processor, track, settings.sampleRate);
+
+    processor.prepareToPlay(settings.sampleRate, settings.maxBlockSize);
+
+    std::atomic<bool> isRunning { true };
+    std::vector<juce::int64> setterCalls((size_t) settings.numSetterThreads, 0);
+    std::vector<std::thread> setterThreads;
+
+    for (int i = 0; i < settings.numSetterThreads; ++i)
+    {
+        setterThreads.emplace_back([&, i]
+        {
+            juce::Random random(settings.seed * 7919 + i + 1);
+
+            while (isRunning.load(std::memory_order_relaxed))
+            {
+                callRandomSetter(processor, random, sampleFiles, settings.sampleRate);
+                ++setterCalls[(size_t) i];
+
+                if (random.nextInt(8) == 0)
+                    std::this_thread::sleep_for(std::chrono::microseconds(random.nextInt(2000)));
+                else
+                    std::this_thread::yield();
+            }
+        });
+    }
+
+    AudioThreadResults results;
+    std::thread audioThread([&] { runAudioThread(processor, settings, results); });
+
+    audioThread.join();
+    isRunning = false;
+
+    for (auto& thread : setterThreads)
+        thread.join();
+
+    sampleDirectory.deleteRecursively();
+
+    std::sort(results.blockLoads.begin(), results.blockLoads.end());
+    const double p99Load = results.blockLoads.empty() ? 0.0
+                         : results.blockLoads[(size_t) ((double) (results.blockLoads.size() - 1) * 0.99)];
+
+    std::cout << "blocks:        " << results.numBlocks << "\n"
+              << "setter calls:  " << std::accumulate(setterCalls.begin(), setterCalls.end(), (juce::int64) 0) << "\n"
+              << "NaN samples:   " << results.numNaNs << "\n"
+              << "inf samples:   " << results.numInfinities << "\n"
+              << "denormals:     " << results.numDenormals << "\n"
+              << "spikes:        " << results.numSpikes << " (load > " << settings.spikeFactor << ")\n"
+              << "overruns:      " << results.numOverruns << "\n"
+              << "p99 load:      " << p99Load << "\n"
+              << "max load:      " << results.maxBlockLoad << std::endl;
+
+    bool failed = results.numNaNs > 0 || results.numInfinities > 0 || results.numDenormals > 0;
+
+   #if AUDIOPLUGIN_RT_SAFETY_CHECKS
+    if (RealtimeSafetyChecker::getNumViolations() > 0)
+    {
+        std::cerr << RealtimeSafetyChecker::getNumViolations() << " realtime-safety violations in processBlock" << std::endl;
+        failed = true;
+    }
+   #endif
+
+    return failed ? 1 : 0;
+}
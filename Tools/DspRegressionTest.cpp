@@ -0,0 +1,634 @@
+#include "PluginProcessor.h"
+#include "ToolScenarios.h"
+#include "RealtimeSafetyChecker.h"
+
+/**
+ * @file DspRegressionTest.cpp
+ * @brief Golden-output regression test for the audio path.
+ *
+ * Renders deterministic scenarios (filter types, bitcrusher settings, ADSR shapes, sequencer patterns,
+ * pitch shifts, interpolation kernels, sample storage formats, block sizes and sample rates) and compares them against reference renders stored as 32-bit float WAV
+ * files. Each render must pass a null test, a maximum absolute error check and a spectral difference
+ * check. Intentional DSP changes are accepted by re-blessing the references with --bless.
+ *
+ * Before the renders, the filter coefficient lookup tables are checked against exact designs at
+ * several sample rates (scenario name "coefficient_tables"), and the kit is rendered unpitched with every
+ * interpolation kernel, which must be bit-identical to the default render (scenario name "pitch_zero").
+ * 16- and 24-bit files loaded into integer storage must decode back to exactly the values read from the
+ * file (scenario name "storage_roundtrip").
+ *
+ * Usage:
+ *   Audiovisual_DspRegression [options]
+ *
+ * Options:
+ *   --bless              Overwrite the reference renders with the current output.
+ *   --golden <dir>       Directory of the reference renders (default Tools/GoldenRenders).
+ *   --only <text>        Only run scenarios whose name contains the text.
+ *   --null-db <dB>       Maximum residual level relative to the reference (default -90).
+ *   --max-abs <value>    Maximum absolute sample difference (default 1e-5).
+ *   --spectral-db <dB>   Maximum mean magnitude difference per spectral frame (default 0.1).
+ *   --failures <dir>     Write the renders of failing scenarios into a directory.
+ */
+
+#ifndef AUDIOPLUGIN_GOLDEN_DIR
+ #define AUDIOPLUGIN_GOLDEN_DIR "GoldenRenders"
+#endif
+
+namespace
+{
+    using namespace ToolScenarios;
+
+    /** @brief Effect and pattern settings of one track in a scenario. */
+    struct TrackSetup
+    {
+        FilterMode filter = FilterMode::none;
+        bool bitcrusher = false;
+        int bitDepth = 8;
+        float downsample = 1.0f;
+        EnvelopeShape envelope = EnvelopeShape::sustained;
+        juce::uint32 pattern = 0x1111;
+        float pitch = 0.0f;
+        SampleInterpolator::Quality interpolation = SampleInterpolator::Quality::cubic;
+    };
+
+    /** @brief A complete, deterministic render configuration. */
+    struct Scenario
+    {
+        juce::String name;
+        double sampleRate = 48000.0;
+        int blockSize = 512;
+        float bpm = 120.0f;
+        std::vector<TrackSetup> tracks;
+        SampleStore::Format storage = SampleStore::Format::float32;
+    };
+
+    /** @brief Comparison tolerances. */
+    struct Tolerances
+    {
+        double nullDb = -90.0;
+        double maxAbs = 1.0e-5;
+        double spectralDb = 0.1;
+    };
+
+    constexpr double renderSeconds = 1.0;
+
+    std::vector<Scenario> createScenarios()
+    {
+        std::vector<Scenario> scenarios;
+
+        for (auto mode : allFilterModes)
+        {
+            TrackSetup track;
+            track.filter = mode;
+            scenarios.push_back({ "filter_" + getFilterModeName(mode).replace("+", "_"), 48000.0, 512, 120.0f, { track } });
+        }
+
+        const std::array<std::pair<int, float>, 3> crusherSettings {{ { 12, 1.0f }, { 8, 2.0f }, { 4, 8.0f } }};
+        for (const auto& [bits, downsample] : crusherSettings)
+        {
+            TrackSetup track;
+            track.bitcrusher = true;
+            track.bitDepth = bits;
+            track.downsample = downsample;
+            scenarios.push_back({ "crush_" + juce::String(bits) + "bit_x" + juce::String((int) downsample), 48000.0, 512, 120.0f, { track } });
+        }
+
+        for (auto shape : allEnvelopeShapes)
+        {
+            TrackSetup track;
+            track.envelope = shape;
+            scenarios.push_back({ "adsr_" + getEnvelopeShapeName(shape), 48000.0, 512, 120.0f, { track } });
+        }
+
+        const std::array<std::pair<const char*, juce::uint32>, 3> patterns {{ { "four", 0x1111 }, { "offbeat", 0x4444 }, { "broken", 0x8a29 } }};
+        for (const auto& [name, pattern] : patterns)
+        {
+            TrackSetup track;
+            track.pattern = pattern;
+            scenarios.push_back({ juce::String("pattern_") + name, 48000.0, 512, 97.0f, { track } });
+        }
+
+        const std::array<std::pair<const char*, float>, 4> pitches {{ { "up7", 7.0f }, { "down12", -12.0f }, { "fine", 0.37f },
+                                                                       { "up24", SampleAudioProcessor::maxPitch } }};
+        for (const auto& [name, semitones] : pitches)
+        {
+            TrackSetup track;
+            track.pitch = semitones;
+            scenarios.push_back({ juce::String("pitch_") + name, 48000.0, 512, 120.0f, { track } });
+        }
+
+        for (auto quality : { SampleInterpolator::Quality::linear, SampleInterpolator::Quality::cubic, SampleInterpolator::Quality::sinc })
+        {
+            TrackSetup track;
+            track.pitch = -7.0f;
+            track.interpolation = quality;
+            scenarios.push_back({ juce::String("interp_") + SampleInterpolator::getQualityName(quality), 48000.0, 512, 120.0f, { track } });
+        }
+
+        Scenario kit { "kit_full", 48000.0, 512, 128.0f, {} };
+        for (int i = 0; i < SampleAudioProcessor::NUM_SAMPLES; ++i)
+        {
+            TrackSetup track;
+            track.filter = allFilterModes[(size_t) (i + 1) % std::size(allFilterModes)];
+            track.bitcrusher = i % 2 == 1;
+            track.envelope = (EnvelopeShape) (i % 3);
+            track.pattern = 0x1111u << (i % 4);
+            kit.tracks.push_back(track);
+        }
+        scenarios.push_back(kit);
+
+        for (int blockSize : { 1, 17, 64, 333, 4096 })
+        {
+            auto scenario = kit;
+            scenario.name = "kit_block" + juce::String(blockSize);
+            scenario.blockSize = blockSize;
+            scenarios.push_back(scenario);
+        }
+
+        for (double sampleRate : { 44100.0, 96000.0 })
+        {
+            auto scenario = kit;
+            scenario.name = "kit_" + juce::String((int) sampleRate);
+            scenario.sampleRate = sampleRate;
+            scenarios.push_back(scenario);
+        }
+
+        for (auto format : { SampleStore::Format::int16, SampleStore::Format::int24 })
+        {
+            auto scenario = kit;
+            scenario.name = juce::String("storage_") + SampleStore::getFormatName(format);
+            scenario.storage = format;
+            scenarios.push_back(scenario);
+        }
+
+        return scenarios;
+    }
+
+    /** @brief Renders a scenario into a stereo buffer. */
+    juce::AudioBuffer<float> render(const Scenario& scenario)
+    {
+        SampleAudioProcessor processor;
+        processor.setRateAndBufferSizeDetails(scenario.sampleRate, scenario.blockSize);
+        processor.setGlobalBpm(scenario.bpm);
+
+        auto options = processor.getSampleLoadOptions();
+        options.storage = scenario.storage;
+        processor.setSampleLoadOptions(options);
+
+        for (int i = 0; i < (int) scenario.tracks.size(); ++i)
+        {
+            const auto& track = scenario.tracks[(size_t) i];
+            activateTrack(processor, i, scenario.sampleRate, track.pattern);
+            applyFilterMode(processor, i, track.filter);
+            applyBitcrusher(processor, i, track.bitcrusher, track.bitDepth, track.downsample);
+            applyEnvelopeShape(processor, i, track.envelope);
+            processor.setPitch(i, track.pitch);
+            processor.setInterpolation(i, track.interpolation);
+        }
+
+        processor.prepareToPlay(scenario.sampleRate, scenario.blockSize);
+
+        const int totalSamples = (int) (renderSeconds * scenario.sampleRate);
+        juce::AudioBuffer<float> output(2, totalSamples);
+        juce::MidiBuffer midi;
+
+        for (int position = 0; position < totalSamples; position += scenario.blockSize)
+        {
+            const int numSamples = juce::jmin(scenario.blockSize, totalSamples - position);
+            float* channels[] = { output.getWritePointer(0, position), output.getWritePointer(1, position) };
+            juce::AudioBuffer<float> view(channels, 2, numSamples);
+
+            view.clear();
+            processor.processBlock(view, midi);
+        }
+
+        return output;
+    }
+
+    /**
+     * @brief Checks that an unpitched kit renders bit-identically with every interpolation kernel, since
+     * pitch 0 reads the sample frame by frame without interpolating.
+     *
+     * @param report Receives the largest difference from the default render.
+     * @return true if every render is identical.
+     */
+    bool checkUnpitchedIdentity(const Scenario& kit, juce::String& report)
+    {
+        const auto expected = render(kit);
+        float worst = 0.0f;
+
+        for (auto quality : { SampleInterpolator::Quality::linear, SampleInterpolator::Quality::cubic, SampleInterpolator::Quality::sinc })
+        {
+            auto scenario = kit;
+            for (auto& track : scenario.tracks)
+                track.interpolation = quality;
+
+            const auto output = render(scenario);
+
+            for (int channel = 0; channel < output.getNumChannels(); ++channel)
+                for (int i = 0; i < output.getNumSamples(); ++i)
+                    worst = juce::jmax(worst, std::abs(output.getSample(channel, i) - expected.getSample(channel, i)));
+        }
+
+        report = "max abs " + juce::String(worst, 9) + " across linear, cubic and sinc";
+        return worst == 0.0f;
+    }
+
+    double getRms(const juce::AudioBuffer<float>& buffer)
+    {
+        double sum = 0.0;
+        for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+            sum += juce::square((double) buffer.getRMSLevel(channel, 0, buffer.getNumSamples()));
+
+        return std::sqrt(sum / juce::jmax(1, buffer.getNumChannels()));
+    }
+
+    /**
+     * @brief Mean absolute difference of the magnitude spectra in dB, worst frame over all channels.
+     */
+    double getSpectralDifferenceDb(const juce::AudioBuffer<float>& actual, const juce::AudioBuffer<float>& reference)
+    {
+        constexpr int fftOrder = 11;
+        constexpr int fftSize = 1 << fftOrder;
+        constexpr float floorDb = -120.0f;
+
+        juce::dsp::FFT fft(fftOrder);
+        juce::dsp::WindowingFunction<float> window(fftSize, juce::dsp::WindowingFunction<float>::hann, false);
+        std::vector<float> actualFrame((size_t) fftSize * 2), referenceFrame((size_t) fftSize * 2);
+        double worst = 0.0;
+
+        for (int channel = 0; channel < reference.getNumChannels(); ++channel)
+        {
+            for (int start = 0; start + fftSize <= reference.getNumSamples(); start += fftSize / 2)
+            {
+                std::fill(actualFrame.begin(), actualFrame.end(), 0.0f);
+                std::fill(referenceFrame.begin(), referenceFrame.end(), 0.0f);
+                std::copy_n(actual.getReadPointer(channel, start), fftSize, actualFrame.begin());
+                std::copy_n(reference.getReadPointer(channel, start), fftSize, referenceFrame.begin());
+
+                window.multiplyWithWindowingTable(actualFrame.data(), (size_t) fftSize);
+                window.multiplyWithWindowingTable(referenceFrame.data(), (size_t) fftSize);
+                fft.performFrequencyOnlyForwardTransform(actualFrame.data());
+                fft.performFrequencyOnlyForwardTransform(referenceFrame.data());
+
+                double sum = 0.0;
+                int counted = 0;
+
+                for (int bin = 0; bin <= fftSize / 2; ++bin)
+                {
+                    const auto referenceDb = juce::Decibels::gainToDecibels(referenceFrame[(size_t) bin], floorDb);
+                    if (referenceDb <= floorDb + 20.0f)
+                        continue;
+
+                    const auto actualDb = juce::Decibels::gainToDecibels(actualFrame[(size_t) bin], floorDb);
+                    sum += std::abs(actualDb - referenceDb);
+                    ++counted;
+                }
+
+                if (counted > 0)
+                    worst = juce::jmax(worst, sum / counted);
+            }
+        }
+
+        return worst;
+    }
+
+    bool writeWav(const juce::File& file, const juce::AudioBuffer<float>& buffer, double sampleRate, int bitsPerSample = 32)
+    {
+        file.getParentDirectory().createDirectory();
+        file.deleteFile();
+
+        std::unique_ptr<juce::OutputStream> stream(file.createOutputStream());
+        if (stream == nullptr)
+            return false;
+
+        juce::WavAudioFormat format;
+        std::unique_ptr<juce::AudioFormatWriter> writer(format.createWriterFor(stream.get(), sampleRate,
+                                                                               (unsigned int) buffer.getNumChannels(),
+                                                                               bitsPerSample, {}, 0));
+        if (writer == nullptr)
+            return false;
+
+        stream.release();
+        return writer->writeFromAudioSampleBuffer(buffer, 0, buffer.getNumSamples());
+    }
+
+    bool readWav(const juce::File& file, juce::AudioBuffer<float>& buffer)
+    {
+        juce::WavAudioFormat format;
+        std::unique_ptr<juce::AudioFormatReader> reader(format.createReaderFor(file.createInputStream().release(), true));
+        if (reader == nullptr)
+            return false;
+
+        buffer.setSize((int) reader->numChannels, (int) reader->lengthInSamples);
+        return reader->read(&buffer, 0, (int) reader->lengthInSamples, 0, true, true);
+    }
+
+    /**
+     * @brief Compares a render against its reference.
+     * @param actual Current output.
+     * @param reference Blessed output.
+     * @param tolerances Thresholds to apply.
+     * @param report Receives the measured values.
+     * @return true if all checks pass.
+     */
+    bool compare(const juce::AudioBuffer<float>& actual, const juce::AudioBuffer<float>& reference,
+                 const Tolerances& tolerances, juce::String& report)
+    {
+        if (actual.getNumChannels() != reference.getNumChannels() || actual.getNumSamples() != reference.getNumSamples())
+        {
+            report = "length or channel count differs from reference";
+            return false;
+        }
+
+        juce::AudioBuffer<float> residual;
+        residual.makeCopyOf(actual);
+
+        double maxAbs = 0.0;
+        for (int channel = 0; channel < residual.getNumChannels(); ++channel)
+        {
+            residual.addFrom(channel, 0, reference, channel, 0, reference.getNumSamples(), -1.0f);
+            maxAbs = juce::jmax(maxAbs, (double) residual.getMagnitude(channel, 0, residual.getNumSamples()));
+        }
+
+        const double referenceRms = getRms(reference);
+        const double residualRms = getRms(residual);
+        const double nullDb = residualRms <= 0.0 ? -300.0
+                                                 : 20.0 * std::log10(residualRms / juce::jmax(referenceRms, 1.0e-12));
+        const double spectralDb = getSpectralDifferenceDb(actual, reference);
+
+        report = "null " + juce::String(nullDb, 1) + " dB, max abs " + juce::String(maxAbs, 9)
+               + ", spectral " + juce::String(spectralDb, 4) + " dB";
+
+        return nullDb <= tolerances.nullDb && maxAbs <= tolerances.maxAbs && spectralDb <= tolerances.spectralDb;
+    }
+
+    /**
+     * @brief Checks the interpolated filter tables against exact coefficient designs.
+     *
+     * The cutoff implied by the interpolated tangent must be within FilterCoefficientTables::maxCentsError,
+     * decibel conversion within maxDecibelError, and the notch and peak designs must match the exact JUCE
+     * designs at that cutoff.
+     *
+     * @param report Receives the measured worst-case errors.
+     * @return true if all errors are within their bounds.
+     */
+    bool checkCoefficientTables(juce::String& report)
+    {
+        constexpr double maxCoefficientError = 1.0e-3;
+        double worstCents = 0.0, worstDecibels = 0.0, worstCoefficient = 0.0;
+
+        auto getNormalisedError = [](const std::array<float, 6>& actual, const std::array<double, 6>& expected)
+        {
+            double error = 0.0;
+
+            for (size_t i = 0; i < 6; ++i)
+                error = juce::jmax(error, std::abs(actual[i] / actual[3] - expected[i] / expected[3]));
+
+            return error;
+        };
+
+        for (double sampleRate : { 22050.0, 44100.0, 48000.0, 88200.0, 96000.0, 192000.0 })
+        {
+            FilterCoefficientTables tables;
+            tables.prepare(sampleRate);
+
+            for (int i = 0; i < 4000; ++i)
+            {
+                const double frequency = FilterCoefficientTables::minFrequency
+                                       * std::pow(tables.getMaxFrequency() / FilterCoefficientTables::minFrequency, i / 3999.0);
+                const double prewarpedGain = tables.getPrewarpedGain((float) frequency);
+                const double impliedFrequency = std::atan(prewarpedGain) * sampleRate / juce::MathConstants<double>::pi;
+                worstCents = juce::jmax(worstCents, std::abs(1200.0 * std::log2(impliedFrequency / frequency)));
+
+                for (double q : { 0.3, 0.707, 2.0, 10.0 })
+                {
+                    using Exact = juce::dsp::IIR::ArrayCoefficients<double>;
+                    worstCoefficient = juce::jmax(worstCoefficient,
+                                                  getNormalisedError(tables.makeNotch((float) frequency, (float) q),
+                                                                     Exact::makeNotch(sampleRate, impliedFrequency, q)));
+
+                    for (double decibels : { -24.0, -6.0, 0.0, 9.0, 24.0 })
+                        worstCoefficient = juce::jmax(worstCoefficient,
+                                                      getNormalisedError(tables.makePeakFilter((float) frequency, (float) q, (float) decibels),
+                                                                         Exact::makePeakFilter(sampleRate, impliedFrequency, q,
+                                                                                               juce::Decibels::decibelsToGain(decibels))));
+                }
+            }
+
+            for (int i = 0; i < 10000; ++i)
+            {
+                const double decibels = FilterCoefficientTables::minDecibels
+                                      + (FilterCoefficientTables::maxDecibels - FilterCoefficientTables::minDecibels) * i / 9999.0;
+                const double gain = tables.decibelsToGain((float) decibels);
+                worstDecibels = juce::jmax(worstDecibels, std::abs(juce::Decibels::gainToDecibels(gain, -300.0) - decibels));
+            }
+        }
+
+        report = "cutoff " + juce::String(worstCents, 3) + " cents, gain " + juce::String(worstDecibels, 5)
+               + " dB, coefficients " + juce::String(worstCoefficient, 7);
+
+        return worstCents <= FilterCoefficientTables::maxCentsError
+            && worstDecibels <= FilterCoefficientTables::maxDecibelError
+            && worstCoefficient <= maxCoefficientError;
+    }
+
+    /**
+     * @brief Writes integer files, loads them through the load pipeline into integer storage and checks
+     * that every stored frame decodes to exactly the value the format reader decodes from the file.
+     *
+     * @param report Receives the number of frames that differ.
+     * @return true if all frames match.
+     */
+    bool checkStorageRoundTrip(juce::String& report)
+    {
+        const auto directory = juce::File::createTempFile("storage_roundtrip");
+        const std::array<std::pair<int, SampleStore::Format>, 3> cases {{ { 16, SampleStore::Format::int16 },
+                                                                          { 16, SampleStore::Format::int24 },
+                                                                          { 24, SampleStore::Format::int24 } }};
+        SampleLoadPipeline pipeline;
+        SampleLoadOptions options;
+        options.trimSilence = false;
+        options.useIndexFiles = false;
+
+        int numDiffering = 0;
+        juce::StringArray failures;
+
+        for (const auto& [bits, format] : cases)
+        {
+            const auto file = directory.getChildFile(juce::String(bits) + "bit.wav");
+            juce::AudioBuffer<float> expected;
+            options.storage = format;
+
+            if (! writeWav(file, makeTestSample(bits, 48000.0), 48000.0, bits) || ! readWav(file, expected))
+            {
+                failures.add(juce::String(bits) + "-bit file not written");
+                continue;
+            }
+
+            const auto loaded = pipeline.load(file, options);
+            const auto& storage = loaded.storage;
+
+            if (! loaded.isValid || storage.getFormat() != format
+                || storage.getNumChannels() != expected.getNumChannels() || storage.getNumFrames() != expected.getNumSamples())
+            {
+                failures.add(juce::String(bits) + "-bit file as " + SampleStore::getFormatName(format) + " not loaded");
+                continue;
+            }
+
+            std::vector<float> decoded((size_t) storage.getNumFrames());
+
+            for (int channel = 0; channel < storage.getNumChannels(); ++channel)
+            {
+                storage.read(channel, 0, decoded.data(), storage.getNumFrames());
+
+                for (int i = 0; i < storage.getNumFrames(); ++i)
+                    numDiffering += decoded[(size_t) i] != expected.getSample(channel, i) ? 1 : 0;
+            }
+        }
+
+        directory.deleteRecursively();
+
+        report = juce::String(numDiffering) + " frames differ from the file";
+        if (! failures.isEmpty())
+            report << ", " << failures.joinIntoString(", ");
+
+        return numDiffering == 0 && failures.isEmpty();
+    }
+
+    void printUsage()
+    {
+        std::cout << "Usage: Audiovisual_DspRegression [--bless] [--golden <dir>] [--only <text>] [--null-db <dB>]\n"
+                     "                                 [--max-abs <value>] [--spectral-db <dB>] [--failures <dir>]"
+                  << std::endl;
+    }
+}
+
+
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    bool bless = false;
+    juce::String only;
+    Tolerances tolerances;
+    juce::File goldenDirectory(juce::File::getCurrentWorkingDirectory().getChildFile(AUDIOPLUGIN_GOLDEN_DIR));
+    juce::File failureDirectory;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const juce::String arg(juce::CharPointer_UTF8(argv[i]));
+        const bool hasValue = i + 1 < argc;
+        auto nextValue = [&] { return juce::String(juce::CharPointer_UTF8(argv[++i])); };
+        auto nextFile = [&] { return juce::File::getCurrentWorkingDirectory().getChildFile(nextValue()); };
+
+        if (arg == "--help" || arg == "-h")           { printUsage(); return 0; }
+        else if (arg == "--bless")                    bless = true;
+        else if (arg == "--golden" && hasValue)       goldenDirectory = nextFile();
+        else if (arg == "--failures" && hasValue)     failureDirectory = nextFile();
+        else if (arg == "--only" && hasValue)         only = nextValue();
+        else if (arg == "--null-db" && hasValue)      tolerances.nullDb = nextValue().getDoubleValue();
+        else if (arg == "--max-abs" && hasValue)      tolerances.maxAbs = nextValue().getDoubleValue();
+        else if (arg == "--spectral-db" && hasValue)  tolerances.spectralDb = nextValue().getDoubleValue();
+        else                                          { printUsage(); return 1; }
+    }
+
+    int numFailed = 0, numRun = 0;
+
+    if (only.isEmpty() || juce::String("coefficient_tables").contains(only))
+    {
+        juce::String report;
+        const bool passed = checkCoefficientTables(report);
+        std::cout << (passed ? "ok       " : "FAILED   ") << "coefficient_tables: " << report << std::endl;
+
+        ++numRun;
+        numFailed += passed ? 0 : 1;
+    }
+
+    if (only.isEmpty() || juce::String("storage_roundtrip").contains(only))
+    {
+        juce::String report;
+        const bool passed = checkStorageRoundTrip(report);
+        std::cout << (passed ? "ok       " : "FAILED   ") << "storage_roundtrip: " << report << std::endl;
+
+        ++numRun;
+        numFailed += passed ? 0 : 1;
+    }
+
+    const auto scenarios = createScenarios();
+
+    if (only.isEmpty() || juce::String("pitch_zero").contains(only))
+    {
+        const auto kit = std::find_if(scenarios.begin(), scenarios.end(), [](const Scenario& s) { return s.name == "kit_full"; });
+        juce::String report;
+        const bool passed = checkUnpitchedIdentity(*kit, report);
+        std::cout << (passed ? "ok       " : "FAILED   ") << "pitch_zero: " << report << std::endl;
+
+        ++numRun;
+        numFailed += passed ? 0 : 1;
+    }
+
+    // The checks above need no references; without any, the renders are reported missing unrendered
+    const bool hasReferences = ! goldenDirectory.findChildFiles(juce::File::findFiles, false, "*.wav").isEmpty();
+
+    if (! bless && ! hasReferences)
+        std::cout << "No reference renders in " << goldenDirectory.getFullPathName()
+                  << "; bless them from a known-good build with --bless" << std::endl;
+
+    for (const auto& scenario : scenarios)
+    {
+        if (only.isNotEmpty() && ! scenario.name.contains(only))
+            continue;
+
+        ++numRun;
+
+        if (! bless && ! hasReferences)
+        {
+            std::cout << "FAILED   " << scenario.name << ": missing reference" << std::endl;
+            ++numFailed;
+            continue;
+        }
+
+        const auto output = render(scenario);
+        const auto referenceFile = goldenDirectory.getChildFile(scenario.name + ".wav");
+
+        if (bless)
+        {
+            const bool written = writeWav(referenceFile, output, scenario.sampleRate);
+            std::cout << (written ? "blessed  " : "FAILED   ") << scenario.name << std::endl;
+            numFailed += written ? 0 : 1;
+            continue;
+        }
+
+        juce::AudioBuffer<float> reference;
+        juce::String report;
+        bool passed = false;
+
+        if (! referenceFile.existsAsFile() || ! readWav(referenceFile, reference))
+            report = "missing reference " + referenceFile.getFullPathName() + " (run with --bless)";
+        else
+            passed = compare(output, reference, tolerances, report);
+
+        std::cout << (passed ? "ok       " : "FAILED   ") << scenario.name << ": " << report << std::endl;
+
+        if (! passed)
+        {
+            ++numFailed;
+
+            if (failureDirectory != juce::File())
+                writeWav(failureDirectory.getChildFile(scenario.name + ".wav"), output, scenario.sampleRate);
+        }
+    }
+
+    std::cout << numRun - numFailed << " of " << numRun << " scenarios passed" << std::endl;
+
+   #if AUDIOPLUGIN_RT_SAFETY_CHECKS
+    if (RealtimeSafetyChecker::getNumViolations() > 0)
+    {
+        std::cout << RealtimeSafetyChecker::getNumViolations() << " realtime-safety violations in processBlock" << std::endl;
+        return 1;
+    }
+   #endif
+
+    return numFailed == 0 ? 0 : 1;
+}
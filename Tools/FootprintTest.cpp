@@ -0,0 +1,370 @@
+#include "PluginProcessor.h"
+#include "ToolScenarios.h"
+
+#if JUCE_LINUX || JUCE_MAC
+ #include <sys/resource.h>
+ #include <unistd.h>
+#endif
+
+#if JUCE_MAC
+ #include <mach/mach.h>
+#endif
+
+/**
+ * @file FootprintTest.cpp
+ * @brief Creates many SampleAudioProcessor instances the way a large session does and reports what each one costs:
+ *        construction time, resident memory, time to first audio and CPU while idle and while playing.
+ *
+ * Every instance is constructed (optionally with its editor), prepared, loaded with a kit and rendered once.
+ * Afterwards all instances render at the realtime rate, first with every track stopped (idle) and then with
+ * every track playing (busy). CPU is the process CPU time during a phase, so it includes editor timers and
+ * any background threads.
+ *
+ * Usage:
+ *   Audiovisual_Footprint [options]
+ *
+ * Options:
+ *   --instances <n>        Number of processor instances (default 16).
+ *   --editors              Also create the editor of every instance.
+ *   --kit <dir>            Load the first audio files of a directory into every instance (default: generated samples).
+ *   --storage <format>     Keep samples in memory as float32, int16 or int24 (default float32).
+ *   --rate <hz>            Sample rate (default 48000).
+ *   --block <n>            Block size (default 256).
+ *   --seconds <s>          Length of the idle and of the busy phase (default 2).
+ *   --max-rss-kb <n>       Fail if the resident memory per instance after the kit load exceeds this.
+ *   --max-idle-cpu <pct>   Fail if the idle CPU per instance exceeds this percentage of one core.
+ *   --label <text>         Free text stored in the report, e.g. a commit hash.
+ *   --out <file>           Write the JSON report to a file instead of stdout.
+ */
+
+namespace
+{
+    using namespace ToolScenarios;
+
+    /** @brief Settings of one run. */
+    struct FootprintSettings
+    {
+        int numInstances = 16;
+        bool withEditors = false;
+        juce::File kitDirectory;
+        SampleStore::Format storage = SampleStore::Format::float32;
+        double sampleRate = 48000.0;
+        int blockSize = 256;
+        double phaseSeconds = 2.0;
+        double maxRssKiloBytes = 0.0;
+        double maxIdleCpuPercent = 0.0;
+    };
+
+    /** @brief Resident set size of the process in bytes, or -1 where it cannot be read. */
+    juce::int64 getResidentBytes()
+    {
+       #if JUCE_LINUX
+        juce::int64 totalPages = 0, residentPages = 0;
+
+        if (auto* statm = std::fopen("/proc/self/statm", "r"))
+        {
+            const int numRead = std::fscanf(statm, "%lld %lld", &totalPages, &residentPages);
+            std::fclose(statm);
+
+            if (numRead == 2)
+                return residentPages * (juce::int64) sysconf(_SC_PAGESIZE);
+        }
+
+        return -1;
+       #elif JUCE_MAC
+        mach_task_basic_info info;
+        mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+
+        if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t) &info, &count) == KERN_SUCCESS)
+            return (juce::int64) info.resident_size;
+
+        return -1;
+       #else
+        return -1;
+       #endif
+    }
+
+    /** @brief User plus system CPU time of all threads of the process in seconds, or -1 where it cannot be read. */
+    double getProcessCpuSeconds()
+    {
+       #if JUCE_LINUX || JUCE_MAC
+        rusage usage {};
+        getrusage(RUSAGE_SELF, &usage);
+
+        return (double) usage.ru_utime.tv_sec + usage.ru_utime.tv_usec * 1.0e-6
+             + (double) usage.ru_stime.tv_sec + usage.ru_stime.tv_usec * 1.0e-6;
+       #else
+        return -1.0;
+       #endif
+    }
+
+    double getMilliseconds()
+    {
+        return juce::Time::getMillisecondCounterHiRes();
+    }
+
+    /** @brief Returns mean and maximum of a list of values as a JSON object. */
+    juce::var summarise(const std::vector<double>& values)
+    {
+        auto* summary = new juce::DynamicObject();
+        const double total = std::accumulate(values.begin(), values.end(), 0.0);
+
+        summary->setProperty("mean", values.empty() ? 0.0 : total / (double) values.size());
+        summary->setProperty("max", values.empty() ? 0.0 : *std::max_element(values.begin(), values.end()));
+        return juce::var(summary);
+    }
+
+    /** @brief Memory growth per instance in kB, or -1 if the resident size is unavailable. */
+    double getKiloBytesPerInstance(juce::int64 before, juce::int64 after, int numInstances)
+    {
+        if (before < 0 || after < 0)
+            return -1.0;
+
+        return (double) (after - before) / 1024.0 / juce::jmax(1, numInstances);
+    }
+
+    /** @brief One processor with its optional editor. */
+    struct Instance
+    {
+        std::unique_ptr<SampleAudioProcessor> processor;
+        std::unique_ptr<juce::AudioProcessorEditor> editor;
+    };
+
+    /** @brief Loads the kit, or generated material when no kit directory is given, and sets every step. */
+    void loadKit(SampleAudioProcessor& processor, const juce::Array<juce::File>& kit, const FootprintSettings& settings)
+    {
+        const double sampleRate = settings.sampleRate;
+        auto options = processor.getSampleLoadOptions();
+        options.storage = settings.storage;
+        processor.setSampleLoadOptions(options);
+
+        for (int track = 0; track < SampleAudioProcessor::NUM_SAMPLES; ++track)
+        {
+            if (kit.isEmpty())
+                processor.loadSampleBuffer(makeTestSample(track + 1, sampleRate), track);
+            else
+                processor.loadSampleFile(kit[track % kit.size()], track);
+
+            for (int step = 0; step < SampleAudioProcessor::NUM_STEPS; ++step)
+                processor.setStepState(track, step, true);
+        }
+    }
+
+    /**
+     * @brief Renders one block per instance at the realtime rate for a while.
+     *
+     * Between blocks the message loop runs when editors exist, so their timers and repaints are part of
+     * the measurement; otherwise the thread sleeps.
+     *
+     * @return Process CPU time per instance as a percentage of one core, or -1 if unavailable.
+     */
+    double runPhase(std::vector<Instance>& instances, const FootprintSettings& settings)
+    {
+        juce::AudioBuffer<float> buffer(2, settings.blockSize);
+        juce::MidiBuffer midi;
+
+        const double blockMilliseconds = settings.blockSize * 1000.0 / settings.sampleRate;
+        const double startMilliseconds = getMilliseconds();
+        const double startCpuSeconds = getProcessCpuSeconds();
+        double deadline = startMilliseconds;
+
+        while (deadline - startMilliseconds < settings.phaseSeconds * 1000.0)
+        {
+            for (auto& instance : instances)
+                instance.processor->processBlock(buffer, midi);
+
+            deadline += blockMilliseconds;
+            const double now = getMilliseconds();
+
+            if (deadline > now)
+            {
+               #if JUCE_MODAL_LOOPS_PERMITTED
+                if (settings.withEditors)
+                    juce::MessageManager::getInstance()->runDispatchLoopUntil(juce::jmax(1, (int) (deadline - now)));
+                else
+               #endif
+                    juce::Thread::sleep((int) (deadline - now));
+            }
+        }
+
+        const double wallSeconds = (getMilliseconds() - startMilliseconds) / 1000.0;
+        const double cpuSeconds = getProcessCpuSeconds() - startCpuSeconds;
+
+        if (startCpuSeconds < 0.0 || wallSeconds <= 0.0)
+            return -1.0;
+
+        return cpuSeconds / wallSeconds / (double) instances.size() * 100.0;
+    }
+
+    void printUsage()
+    {
+        std::cout << "Usage: Audiovisual_Footprint [--instances <n>] [--editors] [--kit <dir>] [--storage <format>]\n"
+                     "                             [--rate <hz>] [--block <n>] [--seconds <s>] [--max-rss-kb <n>] [--max-idle-cpu <pct>]\n"
+                     "                             [--label <text>] [--out <file>]" << std::endl;
+    }
+}
+
+
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    FootprintSettings settings;
+    juce::String label;
+    juce::File outputFile;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const juce::String arg(juce::CharPointer_UTF8(argv[i]));
+        const bool hasValue = i + 1 < argc;
+        auto nextValue = [&] { return juce::String(juce::CharPointer_UTF8(argv[++i])); };
+        auto toFile = [](const juce::String& path) { return juce::File::getCurrentWorkingDirectory().getChildFile(path.unquoted()); };
+
+        if (arg == "--help" || arg == "-h")             { printUsage(); return 0; }
+        else if (arg == "--instances" && hasValue)      settings.numInstances = juce::jlimit(1, 1024, nextValue().getIntValue());
+        else if (arg == "--editors")                    settings.withEditors = true;
+        else if (arg == "--kit" && hasValue)            settings.kitDirectory = toFile(nextValue());
+        else if (arg == "--storage" && hasValue)        settings.storage = SampleStore::getFormatFromName(nextValue());
+        else if (arg == "--rate" && hasValue)           settings.sampleRate = nextValue().getDoubleValue();
+        else if (arg == "--block" && hasValue)          settings.blockSize = nextValue().getIntValue();
+        else if (arg == "--seconds" && hasValue)        settings.phaseSeconds = nextValue().getDoubleValue();
+        else if (arg == "--max-rss-kb" && hasValue)     settings.maxRssKiloBytes = nextValue().getDoubleValue();
+        else if (arg == "--max-idle-cpu" && hasValue)   settings.maxIdleCpuPercent = nextValue().getDoubleValue();
+        else if (arg == "--label" && hasValue)          label = nextValue();
+        else if (arg == "--out" && hasValue)            outputFile = toFile(nextValue());
+        else                                            { printUsage(); return 1; }
+    }
+
+    if (settings.sampleRate <= 0.0 || settings.blockSize <= 0)
+    {
+        printUsage();
+        return 1;
+    }
+
+    juce::Array<juce::File> kit;
+
+    if (settings.kitDirectory.isDirectory())
+    {
+        kit = settings.kitDirectory.findChildFiles(juce::File::findFiles, false, "*.wav;*.aif;*.aiff;*.flac");
+        kit.sort();
+    }
+
+    std::vector<Instance> instances;
+    instances.reserve((size_t) settings.numInstances);
+
+    std::vector<double> constructionMilliseconds, editorMilliseconds, firstAudioMilliseconds;
+    juce::AudioBuffer<float> buffer(2, settings.blockSize);
+    juce::MidiBuffer midi;
+
+    //================== Construction ==================
+
+    const auto baselineBytes = getResidentBytes();
+
+    for (int i = 0; i < settings.numInstances; ++i)
+    {
+        const double start = getMilliseconds();
+        Instance instance;
+        instance.processor = std::make_unique<SampleAudioProcessor>();
+        constructionMilliseconds.push_back(getMilliseconds() - start);
+
+        if (settings.withEditors)
+        {
+            const double editorStart = getMilliseconds();
+            instance.editor.reset(instance.processor->createEditorAndMakeActive());
+            editorMilliseconds.push_back(getMilliseconds() - editorStart);
+        }
+
+        instances.push_back(std::move(instance));
+    }
+
+    const auto constructedBytes = getResidentBytes();
+
+    //================== Prepare, kit and first block ==================
+
+    for (size_t i = 0; i < instances.size(); ++i)
+    {
+        auto& processor = *instances[i].processor;
+        const double start = getMilliseconds();
+
+        processor.setRateAndBufferSizeDetails(settings.sampleRate, settings.blockSize);
+        processor.prepareToPlay(settings.sampleRate, settings.blockSize);
+        loadKit(processor, kit, settings);
+        processor.processBlock(buffer, midi);
+
+        const double editorTime = settings.withEditors ? editorMilliseconds[i] : 0.0;
+        firstAudioMilliseconds.push_back(constructionMilliseconds[i] + editorTime + getMilliseconds() - start);
+    }
+
+    const auto loadedBytes = getResidentBytes();
+
+    //================== Idle and busy phases ==================
+
+    const double idleCpuPercent = runPhase(instances, settings);
+
+    for (auto& instance : instances)
+        for (int track = 0; track < SampleAudioProcessor::NUM_SAMPLES; ++track)
+            instance.processor->isSamplePlaying[track] = true;
+
+    const double busyCpuPercent = runPhase(instances, settings);
+    const auto finalBytes = getResidentBytes();
+
+    //================== Report ==================
+
+    const double loadedKiloBytesPerInstance = getKiloBytesPerInstance(baselineBytes, loadedBytes, settings.numInstances);
+
+    auto* memory = new juce::DynamicObject();
+    memory->setProperty("baselineKB", baselineBytes >= 0 ? (double) baselineBytes / 1024.0 : -1.0);
+    memory->setProperty("constructedKBPerInstance", getKiloBytesPerInstance(baselineBytes, constructedBytes, settings.numInstances));
+    memory->setProperty("loadedKBPerInstance", loadedKiloBytesPerInstance);
+    memory->setProperty("afterRunKBPerInstance", getKiloBytesPerInstance(baselineBytes, finalBytes, settings.numInstances));
+
+    auto* report = new juce::DynamicObject();
+    report->setProperty("label", label);
+    report->setProperty("date", juce::Time::getCurrentTime().toISO8601(true));
+    report->setProperty("cpu", juce::SystemStats::getCpuModel());
+    report->setProperty("os", juce::SystemStats::getOperatingSystemName());
+    report->setProperty("instances", settings.numInstances);
+    report->setProperty("editors", settings.withEditors);
+    report->setProperty("kit", kit.isEmpty() ? juce::String("generated") : settings.kitDirectory.getFullPathName());
+    report->setProperty("storage", SampleStore::getFormatName(settings.storage));
+    report->setProperty("sampleRate", settings.sampleRate);
+    report->setProperty("blockSize", settings.blockSize);
+    report->setProperty("constructionMs", summarise(constructionMilliseconds));
+
+    if (settings.withEditors)
+        report->setProperty("editorMs", summarise(editorMilliseconds));
+
+    report->setProperty("timeToFirstAudioMs", summarise(firstAudioMilliseconds));
+    report->setProperty("memory", juce::var(memory));
+    report->setProperty("idleCpuPercentPerInstance", idleCpuPercent);
+    report->setProperty("busyCpuPercentPerInstance", busyCpuPercent);
+
+    const auto json = juce::JSON::toString(juce::var(report));
+
+    if (outputFile == juce::File())
+        std::cout << json << std::endl;
+    else if (! outputFile.replaceWithText(json))
+        return 1;
+
+    // Editors have to go before their processors
+    for (auto& instance : instances)
+        instance.editor.reset();
+
+    instances.clear();
+
+    bool failed = false;
+
+    if (settings.maxRssKiloBytes > 0.0 && loadedKiloBytesPerInstance > settings.maxRssKiloBytes)
+    {
+        std::cerr << "resident memory per instance " << loadedKiloBytesPerInstance << " kB exceeds " << settings.maxRssKiloBytes << " kB" << std::endl;
+        failed = true;
+    }
+
+    if (settings.maxIdleCpuPercent > 0.0 && idleCpuPercent > settings.maxIdleCpuPercent)
+    {
+        std::cerr << "idle CPU per instance " << idleCpuPercent << " % exceeds " << settings.maxIdleCpuPercent << " %" << std::endl;
+        failed = true;
+    }
+
+    return failed ? 1 : 0;
+}
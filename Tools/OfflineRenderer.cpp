@@ -0,0 +1,236 @@
+#include "PluginProcessor.h"
+
+/**
+ * @file OfflineRenderer.cpp
+ * @brief Headless batch renderer: loads saved plugin states and bounces N bars of each to WAV or FLAC.
+ *
+ * Usage:
+ *   Audiovisual_Render [options] <state> [<state> ...]
+ *
+ * Options:
+ *   --kit <dir>        Load the first audio files of a directory (sorted by name) into the sample slots.
+ *   --bars <n>         Number of 4/4 bars to render (default 4).
+ *   --rate <hz>        Sample rate (default 48000).
+ *   --block <n>        Block size handed to processBlock (default 512).
+ *   --bits <n>         Output bit depth, 16 or 24 (default 24).
+ *   --format <wav|flac> Output format (default wav).
+ *   --out <dir>        Output directory (default: next to each state file).
+ *   --jobs <n>         Number of states rendered in parallel (default: number of CPU cores).
+ *
+ * State files are either XML written from getStateTree() or binary plugin state as stored by a host.
+ * Relative sample paths inside a state are resolved against the directory of the state file.
+ */
+
+namespace
+{
+    /** @brief Options shared by all render jobs. */
+    struct RenderSettings
+    {
+        juce::File kitDirectory;
+        juce::File outputDirectory;
+        double sampleRate = 48000.0;
+        int blockSize = 512;
+        int bitsPerSample = 24;
+        double bars = 4.0;
+        bool useFlac = false;
+        int numJobs = juce::SystemStats::getNumCpus();
+    };
+
+
+    /**
+     * @brief Reads a state file and resolves relative sample paths against the file's directory.
+     * @param stateFile XML or binary state file.
+     * @return The state tree, or an invalid tree if the file could not be parsed.
+     */
+    juce::ValueTree loadStateFile(const juce::File& stateFile)
+    {
+        juce::ValueTree state;
+
+        if (auto xml = juce::parseXML(stateFile))
+        {
+            state = juce::ValueTree::fromXml(*xml);
+        }
+        else
+        {
+            juce::MemoryBlock data;
+            if (stateFile.loadFileAsData(data))
+                if (auto binaryXml = juce::AudioProcessor::getXmlFromBinary(data.getData(), (int) data.getSize()))
+                    state = juce::ValueTree::fromXml(*binaryXml);
+        }
+
+        for (auto track : state)
+        {
+            const auto path = track["sampleFile"].toString();
+            if (path.isNotEmpty() && ! juce::File::isAbsolutePath(path))
+                track.setProperty("sampleFile", stateFile.getParentDirectory().getChildFile(path).getFullPathName(), nullptr);
+        }
+
+        return state;
+    }
+
+
+    /**
+     * @brief Renders one state file to disk.
+     * @param settings Render options.
+     * @param stateFile The state to render.
+     * @param message Receives a one-line result description.
+     * @return true on success.
+     */
+    bool renderState(const RenderSettings& settings, const juce::File& stateFile, juce::String& message)
+    {
+        auto state = loadStateFile(stateFile);
+        if (! state.isValid())
+        {
+            message = "cannot read state " + stateFile.getFullPathName();
+            return false;
+        }
+
+        SampleAudioProcessor processor;
+        processor.setRateAndBufferSizeDetails(settings.sampleRate, settings.blockSize);
+        processor.setStateTree(state);
+
+        if (settings.kitDirectory.isDirectory())
+        {
+            auto kit = settings.kitDirectory.findChildFiles(juce::File::findFiles, false, "*.wav;*.aif;*.aiff;*.flac");
+            kit.sort();
+
+            for (int i = 0; i < juce::jmin(kit.size(), SampleAudioProcessor::NUM_SAMPLES); ++i)
+                processor.loadSampleFile(kit[i], i);
+        }
+
+        processor.prepareToPlay(settings.sampleRate, settings.blockSize);
+
+        const int numChannels = 2;
+        const double secondsPerBar = 4.0 * 60.0 / processor.getGlobalBpm();
+        const auto totalSamples = (juce::int64) std::ceil(settings.bars * secondsPerBar * settings.sampleRate);
+
+        auto outputDirectory = settings.outputDirectory == juce::File() ? stateFile.getParentDirectory()
+                                                                       : settings.outputDirectory;
+        auto outputFile = outputDirectory.getChildFile(stateFile.getFileNameWithoutExtension())
+                                         .withFileExtension(settings.useFlac ? "flac" : "wav");
+        outputFile.deleteFile();
+
+        std::unique_ptr<juce::AudioFormat> format;
+        if (settings.useFlac)
+            format = std::make_unique<juce::FlacAudioFormat>();
+        else
+            format = std::make_unique<juce::WavAudioFormat>();
+
+        std::unique_ptr<juce::OutputStream> stream(outputFile.createOutputStream());
+        if (stream == nullptr)
+        {
+            message = "cannot write " + outputFile.getFullPathName();
+            return false;
+        }
+
+        std::unique_ptr<juce::AudioFormatWriter> writer(format->createWriterFor(stream.get(), settings.sampleRate,
+                                                                                (unsigned int) numChannels,
+                                                                                settings.bitsPerSample, {}, 0));
+        if (writer == nullptr)
+        {
+            message = "unsupported output format for " + outputFile.getFullPathName();
+            return false;
+        }
+
+        stream.release(); // now owned by the writer
+
+        juce::AudioBuffer<float> block(numChannels, settings.blockSize);
+        juce::MidiBuffer midi;
+        const auto startTime = juce::Time::getMillisecondCounterHiRes();
+
+        for (juce::int64 position = 0; position < totalSamples; position += settings.blockSize)
+        {
+            const int numSamples = (int) juce::jmin((juce::int64) settings.blockSize, totalSamples - position);
+            juce::AudioBuffer<float> view(block.getArrayOfWritePointers(), numChannels, numSamples);
+
+            view.clear();
+            midi.clear();
+            processor.processBlock(view, midi);
+            writer->writeFromAudioSampleBuffer(view, 0, numSamples);
+        }
+
+        const auto elapsedSeconds = (juce::Time::getMillisecondCounterHiRes() - startTime) / 1000.0;
+        const auto audioSeconds = (double) totalSamples / settings.sampleRate;
+
+        message = outputFile.getFullPathName() + " (" + juce::String(audioSeconds, 2) + " s audio, "
+                + juce::String(audioSeconds / juce::jmax(elapsedSeconds, 1.0e-6), 1) + "x realtime)";
+        return true;
+    }
+
+
+    void printUsage()
+    {
+        std::cout << "Usage: Audiovisual_Render [--kit <dir>] [--bars <n>] [--rate <hz>] [--block <n>]\n"
+                     "                          [--bits 16|24] [--format wav|flac] [--out <dir>] [--jobs <n>]\n"
+                     "                          <state> [<state> ...]" << std::endl;
+    }
+}
+
+
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    RenderSettings settings;
+    juce::Array<juce::File> stateFiles;
+
+    juce::StringArray args;
+    for (int i = 1; i < argc; ++i)
+        args.add(juce::CharPointer_UTF8(argv[i]));
+
+    auto toFile = [](const juce::String& path)
+    {
+        return juce::File::getCurrentWorkingDirectory().getChildFile(path.unquoted());
+    };
+
+    for (int i = 0; i < args.size(); ++i)
+    {
+        const auto& arg = args[i];
+        const bool hasValue = i + 1 < args.size();
+
+        if (arg == "--help" || arg == "-h")        { printUsage(); return 0; }
+        else if (arg == "--kit" && hasValue)       settings.kitDirectory = toFile(args[++i]);
+        else if (arg == "--out" && hasValue)       settings.outputDirectory = toFile(args[++i]);
+        else if (arg == "--bars" && hasValue)      settings.bars = args[++i].getDoubleValue();
+        else if (arg == "--rate" && hasValue)      settings.sampleRate = args[++i].getDoubleValue();
+        else if (arg == "--block" && hasValue)     settings.blockSize = args[++i].getIntValue();
+        else if (arg == "--bits" && hasValue)      settings.bitsPerSample = args[++i].getIntValue();
+        else if (arg == "--jobs" && hasValue)      settings.numJobs = args[++i].getIntValue();
+        else if (arg == "--format" && hasValue)    settings.useFlac = args[++i].equalsIgnoreCase("flac");
+        else if (arg.startsWith("--"))             { printUsage(); return 1; }
+        else                                       stateFiles.add(toFile(arg));
+    }
+
+    if (stateFiles.isEmpty() || settings.sampleRate <= 0.0 || settings.blockSize <= 0 || settings.bars <= 0.0)
+    {
+        printUsage();
+        return 1;
+    }
+
+    if (settings.outputDirectory != juce::File())
+        settings.outputDirectory.createDirectory();
+
+    std::atomic<int> failures { 0 };
+    juce::CriticalSection outputLock;
+    juce::ThreadPool pool(juce::jlimit(1, stateFiles.size(), settings.numJobs));
+
+    for (const auto& stateFile : stateFiles)
+    {
+        pool.addJob([&settings, &failures, &outputLock, stateFile]
+        {
+            juce::String message;
+            const bool ok = renderState(settings, stateFile, message);
+
+            if (! ok)
+                ++failures;
+
+            const juce::ScopedLock sl(outputLock);
+            std::cout << (ok ? "rendered " : "FAILED   ") << message << std::endl;
+        });
+    }
+
+    while (pool.getNumJobs() > 0)
+        juce::Thread::sleep(10);
+
+    return failures.load() == 0 ? 0 : 1;
+}
@@ -0,0 +1,285 @@
+#include "PluginProcessor.h"
+#include "ToolScenarios.h"
+#include "RealtimeSafetyChecker.h"
+
+/**
+ * @file ProcessBlockBenchmark.cpp
+ * @brief Microbenchmark for SampleAudioProcessor::processBlock across block sizes, sample rates,
+ *        active track counts and effect combinations. Results are written as JSON.
+ *
+ * Usage:
+ *   Audiovisual_Benchmark [options]
+ *
+ * Options:
+ *   --blocks <list>   Comma separated block sizes (default 16,32,64,128,256,512,1024,2048,4096).
+ *   --rates <list>    Comma separated sample rates (default 44100,48000,96000).
+ *   --tracks <list>   Comma separated active track counts (default 1,3,5).
+ *   --filters <list>  Filter modes to run: none,lpf,hpf,lpf+hpf,bpf,notch,peak (default all).
+ *   --subblock <n>    Internal sub-block size of the processor (default 32).
+ *   --modulations <n> Number of modulation slots routed over the active tracks (default 0).
+ *   --freeze          Freeze the active tracks and measure playback from their renders.
+ *   --pitch <st>      Pitch of the active tracks in semitones (default 0, the unresampled path).
+ *   --interpolation <name>  Kernel of pitched tracks: linear, cubic or sinc (default cubic).
+ *   --storage <format> Keep samples in memory as float32, int16 or int24 (default float32).
+ *   --seconds <s>     Audio rendered per measurement (default 0.5).
+ *   --label <text>    Free text stored in the report, e.g. a commit hash.
+ *   --out <file>      Write the JSON report to a file instead of stdout.
+ */
+
+namespace
+{
+    using namespace ToolScenarios;
+
+    /** @brief One point of the sweep. */
+    struct BenchmarkCase
+    {
+        int blockSize = 512;
+        double sampleRate = 48000.0;
+        int numTracks = 1;
+        int subBlockSize = SampleAudioProcessor::defaultSubBlockSize;
+        int numModulations = 0;
+        bool frozen = false;
+        float pitch = 0.0f;
+        SampleInterpolator::Quality interpolation = SampleInterpolator::Quality::cubic;
+        SampleStore::Format storage = SampleStore::Format::float32;
+        FilterMode filterMode = FilterMode::none;
+        bool bitcrusher = false;
+        EnvelopeShape envelope = EnvelopeShape::sustained;
+    };
+
+    /** @brief Returns the value at a given percentile of an already sorted array. */
+    double getPercentile(const std::vector<double>& sorted, double percentile)
+    {
+        if (sorted.empty())
+            return 0.0;
+
+        const auto index = (size_t) juce::jlimit(0.0, (double) sorted.size() - 1.0,
+                                                 std::ceil(percentile / 100.0 * (double) sorted.size()) - 1.0);
+        return sorted[index];
+    }
+
+    /**
+     * @brief Runs one benchmark case and returns its measurements.
+     * @param benchmarkCase The configuration to measure.
+     * @param seconds Amount of audio to render.
+     * @return A JSON object with configuration and timing results.
+     */
+    juce::var runCase(const BenchmarkCase& benchmarkCase, double seconds)
+    {
+        SampleAudioProcessor processor;
+        processor.setSubBlockSize(benchmarkCase.subBlockSize);
+        processor.setRateAndBufferSizeDetails(benchmarkCase.sampleRate, benchmarkCase.blockSize);
+
+        auto options = processor.getSampleLoadOptions();
+        options.storage = benchmarkCase.storage;
+        processor.setSampleLoadOptions(options);
+
+        for (int track = 0; track < benchmarkCase.numTracks; ++track)
+        {
+            activateTrack(processor, track, benchmarkCase.sampleRate);
+            applyFilterMode(processor, track, benchmarkCase.filterMode);
+            applyBitcrusher(processor, track, benchmarkCase.bitcrusher);
+            applyEnvelopeShape(processor, track, benchmarkCase.envelope);
+            processor.setPitch(track, benchmarkCase.pitch);
+            processor.setInterpolation(track, benchmarkCase.interpolation);
+        }
+
+        applyModulations(processor, benchmarkCase.numModulations, benchmarkCase.numTracks);
+
+        processor.prepareToPlay(benchmarkCase.sampleRate, benchmarkCase.blockSize);
+
+        if (benchmarkCase.frozen)
+        {
+            for (int track = 0; track < benchmarkCase.numTracks; ++track)
+                processor.setTrackFrozen(track, true);
+
+            // Renders are made on the freezer thread; measure only once they are all in place
+            const auto deadline = juce::Time::getMillisecondCounter() + 5000;
+
+            for (int track = 0; track < benchmarkCase.numTracks; ++track)
+                while (! processor.isTrackFreezeReady(track) && juce::Time::getMillisecondCounter() < deadline)
+                    juce::Thread::sleep(1);
+        }
+
+        juce::AudioBuffer<float> buffer(2, benchmarkCase.blockSize);
+        juce::MidiBuffer midi;
+
+        for (int i = 0; i < 8; ++i)
+            processor.processBlock(buffer, midi);
+
+        const int numBlocks = juce::jmax(16, (int) std::ceil(seconds * benchmarkCase.sampleRate / benchmarkCase.blockSize));
+        std::vector<double> blockNanos;
+        blockNanos.reserve((size_t) numBlocks);
+
+        for (int i = 0; i < numBlocks; ++i)
+        {
+            const auto start = juce::Time::getHighResolutionTicks();
+            processor.processBlock(buffer, midi);
+            const auto end = juce::Time::getHighResolutionTicks();
+
+            blockNanos.push_back(juce::Time::highResolutionTicksToSeconds(end - start) * 1.0e9);
+        }
+
+        const double totalNanos = std::accumulate(blockNanos.begin(), blockNanos.end(), 0.0);
+        const double totalSamples = (double) numBlocks * benchmarkCase.blockSize;
+        const double audioNanos = totalSamples / benchmarkCase.sampleRate * 1.0e9;
+        const double blockDeadlineNanos = benchmarkCase.blockSize / benchmarkCase.sampleRate * 1.0e9;
+
+        std::sort(blockNanos.begin(), blockNanos.end());
+
+        auto* result = new juce::DynamicObject();
+        result->setProperty("blockSize", benchmarkCase.blockSize);
+        result->setProperty("sampleRate", benchmarkCase.sampleRate);
+        result->setProperty("tracks", benchmarkCase.numTracks);
+        result->setProperty("subBlock", benchmarkCase.subBlockSize);
+        result->setProperty("modulations", benchmarkCase.numModulations);
+        result->setProperty("frozen", benchmarkCase.frozen);
+        result->setProperty("pitch", benchmarkCase.pitch);
+        result->setProperty("interpolation", SampleInterpolator::getQualityName(benchmarkCase.interpolation));
+        result->setProperty("storage", SampleStore::getFormatName(benchmarkCase.storage));
+        result->setProperty("filter", getFilterModeName(benchmarkCase.filterMode));
+        result->setProperty("bitcrusher", benchmarkCase.bitcrusher);
+        result->setProperty("envelope", getEnvelopeShapeName(benchmarkCase.envelope));
+        result->setProperty("blocks", numBlocks);
+        result->setProperty("nsPerSample", totalNanos / totalSamples);
+        result->setProperty("realtimeFactor", audioNanos / juce::jmax(totalNanos, 1.0));
+        result->setProperty("blockNsP50", getPercentile(blockNanos, 50.0));
+        result->setProperty("blockNsP90", getPercentile(blockNanos, 90.0));
+        result->setProperty("blockNsP99", getPercentile(blockNanos, 99.0));
+        result->setProperty("blockNsMax", blockNanos.back());
+        result->setProperty("dspLoadP99", getPercentile(blockNanos, 99.0) / blockDeadlineNanos);
+        return juce::var(result);
+    }
+
+    /** @brief Parses a comma separated list of numbers. */
+    juce::Array<double> parseList(const juce::String& text)
+    {
+        juce::Array<double> values;
+
+        for (const auto& token : juce::StringArray::fromTokens(text, ",", {}))
+            if (token.trim().isNotEmpty())
+                values.add(token.trim().getDoubleValue());
+
+        return values;
+    }
+
+    void printUsage()
+    {
+        std::cout << "Usage: Audiovisual_Benchmark [--blocks <list>] [--rates <list>] [--tracks <list>]\n"
+                     "                             [--filters <list>] [--subblock <n>] [--modulations <n>] [--freeze] [--seconds <s>]\n"
+                     "                             [--pitch <st>] [--interpolation <name>] [--storage <format>] [--label <text>] [--out <file>]"
+                  << std::endl;
+    }
+}
+
+
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::Array<double> blockSizes { 16, 32, 64, 128, 256, 512, 1024, 2048, 4096 };
+    juce::Array<double> sampleRates { 44100.0, 48000.0, 96000.0 };
+    juce::Array<double> trackCounts { 1, 3, 5 };
+    juce::StringArray filterNames;
+    int subBlockSize = SampleAudioProcessor::defaultSubBlockSize;
+    int numModulations = 0;
+    bool frozen = false;
+    float pitch = 0.0f;
+    auto interpolation = SampleInterpolator::Quality::cubic;
+    auto storage = SampleStore::Format::float32;
+    double seconds = 0.5;
+    juce::String label;
+    juce::File outputFile;
+
+    for (auto mode : allFilterModes)
+        filterNames.add(getFilterModeName(mode));
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const juce::String arg(juce::CharPointer_UTF8(argv[i]));
+        const bool hasValue = i + 1 < argc;
+        auto nextValue = [&] { return juce::String(juce::CharPointer_UTF8(argv[++i])); };
+
+        if (arg == "--help" || arg == "-h")         { printUsage(); return 0; }
+        else if (arg == "--blocks" && hasValue)     blockSizes = parseList(nextValue());
+        else if (arg == "--rates" && hasValue)      sampleRates = parseList(nextValue());
+        else if (arg == "--tracks" && hasValue)     trackCounts = parseList(nextValue());
+        else if (arg == "--filters" && hasValue)    filterNames = juce::StringArray::fromTokens(nextValue(), ",", {});
+        else if (arg == "--subblock" && hasValue)   subBlockSize = juce::jlimit(1, 1024, nextValue().getIntValue());
+        else if (arg == "--modulations" && hasValue) numModulations = juce::jlimit(0, ModulationMatrix::maxSlots, nextValue().getIntValue());
+        else if (arg == "--freeze")                 frozen = true;
+        else if (arg == "--pitch" && hasValue)      pitch = nextValue().getFloatValue();
+        else if (arg == "--interpolation" && hasValue) interpolation = SampleInterpolator::getQualityFromName(nextValue());
+        else if (arg == "--storage" && hasValue)    storage = SampleStore::getFormatFromName(nextValue());
+        else if (arg == "--seconds" && hasValue)    seconds = nextValue().getDoubleValue();
+        else if (arg == "--label" && hasValue)      label = nextValue();
+        else if (arg == "--out" && hasValue)        outputFile = juce::File::getCurrentWorkingDirectory().getChildFile(nextValue());
+        else                                        { printUsage(); return 1; }
+    }
+
+    juce::Array<juce::var> results;
+
+    for (auto sampleRate : sampleRates)
+    {
+        for (auto blockSize : blockSizes)
+        {
+            for (auto numTracks : trackCounts)
+            {
+                for (auto mode : allFilterModes)
+                {
+                    if (! filterNames.contains(getFilterModeName(mode)))
+                        continue;
+
+                    for (bool bitcrusher : { false, true })
+                    {
+                        for (auto envelope : allEnvelopeShapes)
+                        {
+                            BenchmarkCase benchmarkCase;
+                            benchmarkCase.blockSize = juce::jlimit(1, 8192, (int) blockSize);
+                            benchmarkCase.sampleRate = sampleRate;
+                            benchmarkCase.numTracks = juce::jlimit(1, SampleAudioProcessor::NUM_SAMPLES, (int) numTracks);
+                            benchmarkCase.subBlockSize = subBlockSize;
+                            benchmarkCase.numModulations = numModulations;
+                            benchmarkCase.frozen = frozen;
+                            benchmarkCase.pitch = pitch;
+                            benchmarkCase.interpolation = interpolation;
+                            benchmarkCase.storage = storage;
+                            benchmarkCase.filterMode = mode;
+                            benchmarkCase.bitcrusher = bitcrusher;
+                            benchmarkCase.envelope = envelope;
+
+                            results.add(runCase(benchmarkCase, seconds));
+                        }
+                    }
+                }
+            }
+
+            std::cerr << "finished " << sampleRate << " Hz, block " << blockSize << std::endl;
+        }
+    }
+
+    auto* report = new juce::DynamicObject();
+    report->setProperty("label", label);
+    report->setProperty("date", juce::Time::getCurrentTime().toISO8601(true));
+    report->setProperty("cpu", juce::SystemStats::getCpuModel());
+    report->setProperty("numCpus", juce::SystemStats::getNumCpus());
+    report->setProperty("os", juce::SystemStats::getOperatingSystemName());
+    report->setProperty("results", results);
+
+    const auto json = juce::JSON::toString(juce::var(report));
+
+    if (outputFile == juce::File())
+        std::cout << json << std::endl;
+    else if (! outputFile.replaceWithText(json))
+        return 1;
+
+   #if AUDIOPLUGIN_RT_SAFETY_CHECKS
+    if (RealtimeSafetyChecker::getNumViolations() > 0)
+    {
+        std::cerr << RealtimeSafetyChecker::getNumViolations() << " realtime-safety violations in processBlock" << std::endl;
+        return 1;
+    }
+   #endif
+
+    return 0;
+}
@@ -0,0 +1,220 @@
+#pragma once
+
+#include "PluginProcessor.h"
+
+/**
+ * @file ToolScenarios.h
+ * @brief Deterministic test material and effect configurations shared by the command line tools.
+ */
+
+namespace ToolScenarios
+{
+    /** @brief Filter configurations that can be selected on a track. */
+    enum class FilterMode
+    {
+        none,
+        lowpass,
+        highpass,
+        lowpassHighpass,
+        bandpass,
+        notch,
+        peak
+    };
+
+    /** @brief All filter configurations, in the order they are reported. */
+    static constexpr FilterMode allFilterModes[] = { FilterMode::none, FilterMode::lowpass, FilterMode::highpass,
+                                                     FilterMode::lowpassHighpass, FilterMode::bandpass,
+                                                     FilterMode::notch, FilterMode::peak };
+
+    /** @brief Returns a short, stable name for a filter configuration. */
+    inline juce::String getFilterModeName(FilterMode mode)
+    {
+        switch (mode)
+        {
+            case FilterMode::none:            return "none";
+            case FilterMode::lowpass:         return "lpf";
+            case FilterMode::highpass:        return "hpf";
+            case FilterMode::lowpassHighpass: return "lpf+hpf";
+            case FilterMode::bandpass:        return "bpf";
+            case FilterMode::notch:           return "notch";
+            case FilterMode::peak:            return "peak";
+        }
+
+        return {};
+    }
+
+    /** @brief ADSR shapes used by the tools. */
+    enum class EnvelopeShape
+    {
+        percussive,
+        sustained,
+        swell
+    };
+
+    /** @brief All envelope shapes, in the order they are reported. */
+    static constexpr EnvelopeShape allEnvelopeShapes[] = { EnvelopeShape::percussive, EnvelopeShape::sustained, EnvelopeShape::swell };
+
+    /** @brief Returns a short, stable name for an envelope shape. */
+    inline juce::String getEnvelopeShapeName(EnvelopeShape shape)
+    {
+        switch (shape)
+        {
+            case EnvelopeShape::percussive: return "perc";
+            case EnvelopeShape::sustained:  return "sustain";
+            case EnvelopeShape::swell:      return "swell";
+        }
+
+        return {};
+    }
+
+    /**
+     * @brief Creates a decaying stereo noise burst with a tonal component.
+     * @param seed Random seed, so the same seed always gives the same sample.
+     * @param sampleRate Sample rate of the generated material.
+     * @param lengthSeconds Length of the burst.
+     * @return The generated buffer.
+     */
+    inline juce::AudioBuffer<float> makeTestSample(juce::int64 seed, double sampleRate, double lengthSeconds = 0.5)
+    {
+        juce::Random random(seed);
+        const int numSamples = juce::jmax(1, (int) (sampleRate * lengthSeconds));
+        const double frequency = 80.0 + 40.0 * (double) (seed % 8);
+
+        juce::AudioBuffer<float> buffer(2, numSamples);
+
+        for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+        {
+            auto* data = buffer.getWritePointer(channel);
+
+            for (int i = 0; i < numSamples; ++i)
+            {
+                const double t = i / sampleRate;
+                const double decay = std::exp(-6.0 * t / lengthSeconds);
+                const double tone = std::sin(juce::MathConstants<double>::twoPi * frequency * t);
+                data[i] = (float) (decay * (0.6 * tone + 0.4 * (random.nextDouble() * 2.0 - 1.0)));
+            }
+        }
+
+        return buffer;
+    }
+
+    /**
+     * @brief Enables one filter configuration on a track with fixed, mid-range settings.
+     * @param processor The processor to configure.
+     * @param track Track index.
+     * @param mode Filter configuration.
+     */
+    inline void applyFilterMode(SampleAudioProcessor& processor, int track, FilterMode mode)
+    {
+        processor.setFilterCutoff(track, 1800.0f);
+        processor.setHighpassCutoff(track, 250.0f);
+        processor.setBandPassCutoff(track, 1200.0f);
+        processor.setBandPassBandwidth(track, 400.0f);
+        processor.setNotchCutoff(track, 1000.0f);
+        processor.setNotchBandwidth(track, 150.0f);
+        processor.setPeakCutoff(track, 2500.0f);
+        processor.setPeakGain(track, 9.0f);
+        processor.setPeakQ(track, 1.5f);
+
+        processor.setNotchEnabled(track, false);
+        processor.setPeakEnabled(track, false);
+        processor.setBandPassEnabled(track, false);
+        processor.setFilterEnabled(track, mode == FilterMode::lowpass || mode == FilterMode::lowpassHighpass);
+        processor.setHighpassEnabled(track, mode == FilterMode::highpass || mode == FilterMode::lowpassHighpass);
+
+        if (mode == FilterMode::bandpass)
+            processor.setBandPassEnabled(track, true);
+        else if (mode == FilterMode::notch)
+            processor.setNotchEnabled(track, true);
+        else if (mode == FilterMode::peak)
+            processor.setPeakEnabled(track, true);
+    }
+
+    /**
+     * @brief Sets the bitcrusher of a track.
+     * @param processor The processor to configure.
+     * @param track Track index.
+     * @param enabled Whether the bitcrusher is active.
+     * @param bitDepth Bit depth used when enabled.
+     * @param downsample Downsampling factor used when enabled.
+     */
+    inline void applyBitcrusher(SampleAudioProcessor& processor, int track, bool enabled, int bitDepth = 6, float downsample = 4.0f)
+    {
+        processor.setBitcrusherEnabled(track, enabled);
+        processor.setBitDepth(track, bitDepth);
+        processor.setDownsampleRate(track, downsample);
+    }
+
+    /**
+     * @brief Sets the ADSR envelope of a track to one of the predefined shapes.
+     * @param processor The processor to configure.
+     * @param track Track index.
+     * @param shape Envelope shape.
+     */
+    inline void applyEnvelopeShape(SampleAudioProcessor& processor, int track, EnvelopeShape shape)
+    {
+        switch (shape)
+        {
+            case EnvelopeShape::percussive:
+                processor.setAdsrAttack(track, 0.001f);
+                processor.setAdsrDecay(track, 0.05f);
+                processor.setAdsrSustain(track, 0.3f);
+                processor.setAdsrRelease(track, 0.05f);
+                break;
+
+            case EnvelopeShape::sustained:
+                processor.setAdsrAttack(track, 0.01f);
+                processor.setAdsrDecay(track, 0.1f);
+                processor.setAdsrSustain(track, 1.0f);
+                processor.setAdsrRelease(track, 0.1f);
+                break;
+
+            case EnvelopeShape::swell:
+                processor.setAdsrAttack(track, 0.2f);
+                processor.setAdsrDecay(track, 0.2f);
+                processor.setAdsrSustain(track, 0.6f);
+                processor.setAdsrRelease(track, 0.4f);
+                break;
+        }
+    }
+
+    /**
+     * @brief Loads generated material into a track, starts it and sets its step pattern.
+     * @param processor The processor to configure.
+     * @param track Track index.
+     * @param sampleRate Sample rate of the generated material.
+     * @param pattern Bit mask of active steps, bit 0 being the first step.
+     */
+    inline void activateTrack(SampleAudioProcessor& processor, int track, double sampleRate, juce::uint32 pattern = 0xffff)
+    {
+        processor.loadSampleBuffer(makeTestSample(track + 1, sampleRate), track);
+        processor.isSamplePlaying[track] = true;
+
+        for (int step = 0; step < SampleAudioProcessor::NUM_STEPS; ++step)
+            processor.setStepState(track, step, (pattern >> step) & 1u);
+    }
+
+    /**
+     * @brief Routes a number of modulation slots over the active tracks, cycling through all sources and destinations.
+     * @param processor The processor to configure.
+     * @param numSlots Number of slots to fill, at most ModulationMatrix::maxSlots.
+     * @param numTracks Number of active tracks the slots are spread over.
+     */
+    inline void applyModulations(SampleAudioProcessor& processor, int numSlots, int numTracks)
+    {
+        auto& matrix = processor.getModulationMatrix();
+
+        for (int lfo = 0; lfo < ModulationMatrix::numLfos; ++lfo)
+            matrix.setLfo(lfo, static_cast<ModulationMatrix::LfoShape>(lfo % 4), 0.25f * (float) (lfo + 1));
+
+        for (int slot = 0; slot < juce::jmin(numSlots, ModulationMatrix::maxSlots); ++slot)
+        {
+            ModulationMatrix::Slot routing;
+            routing.source = slot % ModulationMatrix::numSources;
+            routing.destination = static_cast<ModulationMatrix::Destination>(slot % ModulationMatrix::numDestinations);
+            routing.track = slot % juce::jmax(1, numTracks);
+            routing.depth = 0.5f;
+            matrix.setSlot(slot, routing);
+        }
+    }
+}